@@ -21,6 +21,8 @@
 #define BATADV_NL_NAME "batadv"
 
 #define BATADV_NL_MCAST_GROUP_TPMETER	"tpmeter"
+#define BATADV_NL_MCAST_GROUP_EVENTS	"events"
+#define BATADV_NL_MCAST_GROUP_PING	"ping"
 
 /**
  * enum batadv_tt_client_flags - TT client specific flags
@@ -96,6 +98,86 @@ enum batadv_tt_client_flags {
  * @BATADV_ATTR_BLA_VID: BLA VLAN ID
  * @BATADV_ATTR_BLA_BACKBONE: BLA gateway originator MAC address
  * @BATADV_ATTR_BLA_CRC: BLA CRC
+ * @BATADV_ATTR_TPMETER_NUM_STREAMS: number of parallel tp_meter streams
+ * @BATADV_ATTR_TPMETER_BIDIRECTIONAL: Flag requesting that the remote node
+ *  also runs the tp_meter streams back towards the requester (only honoured if
+ *  tp_reverse is enabled on the remote node)
+ * @BATADV_ATTR_TPMETER_REVERSE_BYTES: amount of bytes received from the
+ *  remote node during a bidirectional run
+ * @BATADV_ATTR_TPMETER_STREAMS: nested list of per stream results
+ * @BATADV_ATTR_TPMETER_STREAM: nested result of a single stream
+ * @BATADV_ATTR_TPMETER_STREAM_ID: index of the stream inside the run
+ * @BATADV_ATTR_TPMETER_REVERSE: Flag indicating a stream sent by the remote
+ *  node
+ * @BATADV_ATTR_TPMETER_CC: congestion control of the tp_meter session (see
+ *  batadv_tp_meter_cc)
+ * @BATADV_ATTR_TPMETER_RATE: constant bitrate (kbit/s) of the tp_meter
+ *  session, the streams are only window limited if not given
+ * @BATADV_ATTR_TPMETER_RTT_MIN: smallest RTT (usecs) during run
+ * @BATADV_ATTR_TPMETER_RTT_MAX: biggest RTT (usecs) during run
+ * @BATADV_ATTR_TPMETER_RTT_AVG: average RTT (usecs) during run
+ * @BATADV_ATTR_TPMETER_RTT_P50: median RTT (usecs) during run
+ * @BATADV_ATTR_TPMETER_RTT_P99: 99th percentile of the RTT (usecs) during run
+ * @BATADV_ATTR_TPMETER_JITTER: smoothed RTT variation (usecs) during run
+ * @BATADV_ATTR_TPMETER_RTT_HIST: array of u32 RTT sample counters, entry i
+ *  counts RTTs in [2^i, 2^(i + 1)) usecs
+ * @BATADV_ATTR_TPMETER_JITTER_HIST: array of u32 counters of the difference
+ *  between consecutive RTTs, same buckets as BATADV_ATTR_TPMETER_RTT_HIST
+ * @BATADV_ATTR_STATS_ENABLED: Flag indicating that the latency statistics are
+ *  currently collected
+ * @BATADV_ATTR_STATS_STAGES: nested list of per stage latency statistics
+ * @BATADV_ATTR_STATS_STAGE: nested latency statistics of a single stage
+ * @BATADV_ATTR_STATS_STAGE_ID: stage of the statistics (see
+ *  batadv_stats_stage)
+ * @BATADV_ATTR_STATS_COUNT: number of latency samples of the stage
+ * @BATADV_ATTR_STATS_SUM: sum (nsecs) of all latency samples of the stage
+ * @BATADV_ATTR_STATS_HIST: array of u64 sample counters, entry i counts
+ *  latencies in [2^i, 2^(i + 1)) nsecs, the last entry also counts all
+ *  bigger latencies. The *_CYCLES stages count CPU cycles instead of nsecs
+ * @BATADV_ATTR_EVENT_TYPE: type of a mesh event (see batadv_event_type)
+ * @BATADV_ATTR_EVENT_SEQNO: per mesh interface sequence number of an event,
+ *  incremented by one for every event to allow the detection of lost events
+ * @BATADV_ATTR_PREV_ROUTER: MAC address of the previous next hop neighbor
+ * @BATADV_ATTR_PING_COOKIE: session cookie to match a ping session
+ * @BATADV_ATTR_PING_DESTS: nested list of BATADV_ATTR_ORIG_ADDRESS attributes
+ *  naming the destinations of a ping session
+ * @BATADV_ATTR_PING_COUNT: number of probes sent to each destination
+ *  (1 - 100000)
+ * @BATADV_ATTR_PING_INTERVAL: time (msecs) between two probe rounds
+ *  (10 - 60000)
+ * @BATADV_ATTR_PING_SIZE: size of a single probe
+ * @BATADV_ATTR_PING_RESULTS: nested list of per destination ping results
+ * @BATADV_ATTR_PING_RESULT: nested ping result of a single destination
+ * @BATADV_ATTR_PING_SENT: number of probes sent to the destination
+ * @BATADV_ATTR_PING_RECEIVED: number of replies received from the destination
+ * @BATADV_ATTR_PING_RTT_MIN: smallest RTT (usecs) of the destination
+ * @BATADV_ATTR_PING_RTT_MAX: biggest RTT (usecs) of the destination
+ * @BATADV_ATTR_PING_RTT_AVG: average RTT (usecs) of the destination
+ * @BATADV_ATTR_FILTER_ORIG: only dump entries belonging to this originator
+ * @BATADV_ATTR_FILTER_VID: only dump entries of this VLAN (as dumped in the
+ *  VID attribute of the table)
+ * @BATADV_ATTR_FILTER_PREFIX: only dump entries whose address starts with
+ *  this prefix. A 6 byte prefix is matched against MAC addresses, a 4 byte
+ *  prefix against IPv4 addresses
+ * @BATADV_ATTR_FILTER_PREFIX_LEN: number of significant bits of
+ *  BATADV_ATTR_FILTER_PREFIX, defaults to the full prefix
+ * @BATADV_ATTR_DAT_CACHE_IP4ADDRESS: IPv4 address of a DAT cache entry
+ * @BATADV_ATTR_DAT_CACHE_HWADDRESS: MAC address of a DAT cache entry
+ * @BATADV_ATTR_DAT_CACHE_VID: VLAN ID of a DAT cache entry
+ * @BATADV_ATTR_MCAST_FLAGS: multicast flags announced by an originator
+ * @BATADV_ATTR_NC_NEIGH_ADDRESS: MAC address of a network coding neighbor
+ * @BATADV_ATTR_NC_DIRECTION: direction of a network coding neighbor (see
+ *  batadv_nc_direction)
+ * @BATADV_ATTR_DUMP_SNAPSHOT: flag requesting a table dump rendered from a
+ *  single consistent snapshot taken when the dump starts
+ * @BATADV_ATTR_HARD_COUNTERS: nested list of the control plane traffic
+ *  counters of a hard interface (see batadv_hardif_counter)
+ * @BATADV_ATTR_CRYPTO_SIGN: number of OGM2s signed
+ * @BATADV_ATTR_CRYPTO_VERIFY: number of OGM2 signatures verified
+ * @BATADV_ATTR_CRYPTO_VERIFY_FAILED: number of OGM2s which failed the
+ *  signature verification
+ * @BATADV_ATTR_CRYPTO_KEY_CHANGE: number of OGM2s whose public key differs
+ *  from the one first seen for their originator
  * @__BATADV_ATTR_AFTER_LAST: internal use
  * @NUM_BATADV_ATTR: total number of batadv_nl_attrs available
  * @BATADV_ATTR_MAX: highest attribute number currently defined
@@ -138,6 +220,61 @@ enum batadv_nl_attrs {
 	BATADV_ATTR_BLA_CRC,
         BATADV_ATTR_SECRET_KEY,
         BATADV_ATTR_PRICE,
+	BATADV_ATTR_TPMETER_NUM_STREAMS,
+	BATADV_ATTR_TPMETER_BIDIRECTIONAL,
+	BATADV_ATTR_TPMETER_REVERSE_BYTES,
+	BATADV_ATTR_TPMETER_STREAMS,
+	BATADV_ATTR_TPMETER_STREAM,
+	BATADV_ATTR_TPMETER_STREAM_ID,
+	BATADV_ATTR_TPMETER_REVERSE,
+	BATADV_ATTR_TPMETER_CC,
+	BATADV_ATTR_TPMETER_RATE,
+	BATADV_ATTR_TPMETER_RTT_MIN,
+	BATADV_ATTR_TPMETER_RTT_MAX,
+	BATADV_ATTR_TPMETER_RTT_AVG,
+	BATADV_ATTR_TPMETER_RTT_P50,
+	BATADV_ATTR_TPMETER_RTT_P99,
+	BATADV_ATTR_TPMETER_JITTER,
+	BATADV_ATTR_TPMETER_RTT_HIST,
+	BATADV_ATTR_TPMETER_JITTER_HIST,
+	BATADV_ATTR_STATS_ENABLED,
+	BATADV_ATTR_STATS_STAGES,
+	BATADV_ATTR_STATS_STAGE,
+	BATADV_ATTR_STATS_STAGE_ID,
+	BATADV_ATTR_STATS_COUNT,
+	BATADV_ATTR_STATS_SUM,
+	BATADV_ATTR_STATS_HIST,
+	BATADV_ATTR_EVENT_TYPE,
+	BATADV_ATTR_EVENT_SEQNO,
+	BATADV_ATTR_PREV_ROUTER,
+	BATADV_ATTR_PING_COOKIE,
+	BATADV_ATTR_PING_DESTS,
+	BATADV_ATTR_PING_COUNT,
+	BATADV_ATTR_PING_INTERVAL,
+	BATADV_ATTR_PING_SIZE,
+	BATADV_ATTR_PING_RESULTS,
+	BATADV_ATTR_PING_RESULT,
+	BATADV_ATTR_PING_SENT,
+	BATADV_ATTR_PING_RECEIVED,
+	BATADV_ATTR_PING_RTT_MIN,
+	BATADV_ATTR_PING_RTT_MAX,
+	BATADV_ATTR_PING_RTT_AVG,
+	BATADV_ATTR_FILTER_ORIG,
+	BATADV_ATTR_FILTER_VID,
+	BATADV_ATTR_FILTER_PREFIX,
+	BATADV_ATTR_FILTER_PREFIX_LEN,
+	BATADV_ATTR_DAT_CACHE_IP4ADDRESS,
+	BATADV_ATTR_DAT_CACHE_HWADDRESS,
+	BATADV_ATTR_DAT_CACHE_VID,
+	BATADV_ATTR_MCAST_FLAGS,
+	BATADV_ATTR_NC_NEIGH_ADDRESS,
+	BATADV_ATTR_NC_DIRECTION,
+	BATADV_ATTR_DUMP_SNAPSHOT,
+	BATADV_ATTR_HARD_COUNTERS,
+	BATADV_ATTR_CRYPTO_SIGN,
+	BATADV_ATTR_CRYPTO_VERIFY,
+	BATADV_ATTR_CRYPTO_VERIFY_FAILED,
+	BATADV_ATTR_CRYPTO_KEY_CHANGE,
 	/* add attributes above here, update the policy in netlink.c */
 	__BATADV_ATTR_AFTER_LAST,
 	NUM_BATADV_ATTR = __BATADV_ATTR_AFTER_LAST,
@@ -160,6 +297,14 @@ enum batadv_nl_attrs {
  * @BATADV_CMD_GET_GATEWAYS: Query list of gateways
  * @BATADV_CMD_GET_BLA_CLAIM: Query list of bridge loop avoidance claims
  * @BATADV_CMD_GET_BLA_BACKBONE: Query list of bridge loop avoidance backbones
+ * @BATADV_CMD_GET_STATS: Query the per stage latency statistics
+ * @BATADV_CMD_EVENT: Mesh event sent to the events multicast group
+ * @BATADV_CMD_PING: Start a kernel driven ping session, its results are sent
+ *  to the ping multicast group
+ * @BATADV_CMD_PING_CANCEL: Cancel a running ping session
+ * @BATADV_CMD_GET_DAT_CACHE: Query list of DAT cache entries
+ * @BATADV_CMD_GET_MCAST_FLAGS: Query list of multicast flags of originators
+ * @BATADV_CMD_GET_NC_NODES: Query list of network coding neighbors
  * @__BATADV_CMD_AFTER_LAST: internal use
  * @BATADV_CMD_MAX: highest used command number
  */
@@ -181,6 +326,13 @@ enum batadv_nl_commands {
         BATADV_CMD_SET_SECRET_KEY,
         BATADV_CMD_GET_PRICE,
         BATADV_CMD_SET_PRICE,
+	BATADV_CMD_GET_STATS,
+	BATADV_CMD_EVENT,
+	BATADV_CMD_PING,
+	BATADV_CMD_PING_CANCEL,
+	BATADV_CMD_GET_DAT_CACHE,
+	BATADV_CMD_GET_MCAST_FLAGS,
+	BATADV_CMD_GET_NC_NODES,
 	/* add new commands above here */
 	__BATADV_CMD_AFTER_LAST,
 	BATADV_CMD_MAX = __BATADV_CMD_AFTER_LAST - 1
@@ -211,4 +363,146 @@ enum batadv_tp_meter_reason {
 	BATADV_TP_REASON_TOO_MANY		= 133,
 };
 
+/**
+ * enum batadv_tp_meter_cc - congestion control used by a tp meter session
+ * @BATADV_TP_CC_RENO: slow start and AIMD with NewReno fast recovery
+ * @BATADV_TP_CC_CUBIC: CUBIC window growth with multiplicative decrease
+ * @BATADV_TP_CC_BBR: window derived from the measured bottleneck bandwidth
+ *  and minimum RTT, loss is not interpreted as congestion
+ * @NUM_BATADV_TP_CC: number of congestion controls available
+ */
+enum batadv_tp_meter_cc {
+	BATADV_TP_CC_RENO,
+	BATADV_TP_CC_CUBIC,
+	BATADV_TP_CC_BBR,
+	NUM_BATADV_TP_CC,
+};
+
+/**
+ * enum batadv_stats_stage - stages covered by the latency statistics
+ * @BATADV_STATS_OGM_VERIFY: signature verification of a received OGM
+ * @BATADV_STATS_OGM_ROUTE: reception of an OGM until the route towards its
+ *  originator is updated
+ * @BATADV_STATS_TT_LOOKUP: translation table lookup of a unicast destination
+ * @BATADV_STATS_UNICAST_FWD: forwarding of a received unicast packet
+ * @BATADV_STATS_IFACE_TX: frame transmission on the mesh interface
+ * @BATADV_STATS_BCAST_QUEUE: time a broadcast waits in the queue before it is
+ *  sent for the first time
+ * @BATADV_STATS_FRAG_REASSEMBLY: first received fragment until all fragments
+ *  of a packet are available
+ * @BATADV_STATS_NC_HOLD: time a packet is held for network coding
+ * @BATADV_STATS_OGM_SIGN_CYCLES: CPU cycles spent in ed25519_sign() for an
+ *  own OGM2
+ * @BATADV_STATS_OGM_VERIFY_CYCLES: CPU cycles spent in ed25519_sign_open()
+ *  for a received OGM2
+ * @NUM_BATADV_STATS: number of stages available
+ */
+enum batadv_stats_stage {
+	BATADV_STATS_OGM_VERIFY,
+	BATADV_STATS_OGM_ROUTE,
+	BATADV_STATS_TT_LOOKUP,
+	BATADV_STATS_UNICAST_FWD,
+	BATADV_STATS_IFACE_TX,
+	BATADV_STATS_BCAST_QUEUE,
+	BATADV_STATS_FRAG_REASSEMBLY,
+	BATADV_STATS_NC_HOLD,
+	BATADV_STATS_OGM_SIGN_CYCLES,
+	BATADV_STATS_OGM_VERIFY_CYCLES,
+	NUM_BATADV_STATS,
+};
+
+/**
+ * enum batadv_event_type - mesh events sent to the events multicast group
+ * @BATADV_EVENT_ROUTE: the next hop towards an originator changed
+ * @BATADV_EVENT_ORIG_ADD: a new originator was added
+ * @BATADV_EVENT_ORIG_DEL: an originator was purged
+ * @BATADV_EVENT_TT_ADD: a global translation table entry was added or updated
+ * @BATADV_EVENT_TT_DEL: a global translation table entry was removed
+ * @BATADV_EVENT_TT_ROAM: a client roamed away from an originator
+ * @BATADV_EVENT_GW_CHANGE: the selected gateway changed
+ */
+enum batadv_event_type {
+	BATADV_EVENT_ROUTE,
+	BATADV_EVENT_ORIG_ADD,
+	BATADV_EVENT_ORIG_DEL,
+	BATADV_EVENT_TT_ADD,
+	BATADV_EVENT_TT_DEL,
+	BATADV_EVENT_TT_ROAM,
+	BATADV_EVENT_GW_CHANGE,
+};
+
+/**
+ * enum batadv_nc_direction - direction of a network coding neighbor
+ * @BATADV_NC_INGOING: the neighbor sends packets to the originator which can
+ *  be used for decoding
+ * @BATADV_NC_OUTGOING: the neighbor receives packets from the originator
+ *  which can be coded
+ */
+enum batadv_nc_direction {
+	BATADV_NC_INGOING,
+	BATADV_NC_OUTGOING,
+};
+
+/**
+ * enum batadv_hardif_counter - control plane traffic counters of a hard
+ *  interface, used as u64 attributes inside BATADV_ATTR_HARD_COUNTERS
+ * @BATADV_HARDIF_CNT_PAD: attribute used for padding for 64-bit alignment
+ * @BATADV_HARDIF_CNT_ELP_TX: transmitted ELP packets
+ * @BATADV_HARDIF_CNT_ELP_TX_BYTES: transmitted ELP bytes
+ * @BATADV_HARDIF_CNT_ELP_RX: received ELP packets
+ * @BATADV_HARDIF_CNT_ELP_RX_BYTES: received ELP bytes
+ * @BATADV_HARDIF_CNT_OGM_TX: transmitted B.A.T.M.A.N. IV OGM frames
+ * @BATADV_HARDIF_CNT_OGM_TX_BYTES: transmitted B.A.T.M.A.N. IV OGM bytes
+ * @BATADV_HARDIF_CNT_OGM_TX_AGGR: OGMs carried by the transmitted frames. The
+ *  aggregation ratio is this counter divided by BATADV_HARDIF_CNT_OGM_TX
+ * @BATADV_HARDIF_CNT_OGM_RX: received B.A.T.M.A.N. IV OGM frames
+ * @BATADV_HARDIF_CNT_OGM_RX_BYTES: received B.A.T.M.A.N. IV OGM bytes
+ * @BATADV_HARDIF_CNT_OGM_RX_AGGR: OGMs carried by the received frames
+ * @BATADV_HARDIF_CNT_OGM2_TX: transmitted OGM2 packets
+ * @BATADV_HARDIF_CNT_OGM2_TX_BYTES: transmitted OGM2 bytes
+ * @BATADV_HARDIF_CNT_OGM2_RX: received OGM2 packets
+ * @BATADV_HARDIF_CNT_OGM2_RX_BYTES: received OGM2 bytes
+ * @BATADV_HARDIF_CNT_SIG_TX_BYTES: ed25519 key and signature bytes included
+ *  in the transmitted OGM2 bytes
+ * @BATADV_HARDIF_CNT_SIG_RX_BYTES: ed25519 key and signature bytes included
+ *  in the received OGM2 bytes
+ * @BATADV_HARDIF_CNT_TVLV_TX: transmitted unicast TVLV packets (TT requests,
+ *  responses and roaming advertisements)
+ * @BATADV_HARDIF_CNT_TVLV_TX_BYTES: transmitted unicast TVLV bytes
+ * @BATADV_HARDIF_CNT_TVLV_RX: received unicast TVLV packets
+ * @BATADV_HARDIF_CNT_TVLV_RX_BYTES: received unicast TVLV bytes
+ * @__BATADV_HARDIF_CNT_AFTER_LAST: internal use
+ * @NUM_BATADV_HARDIF_CNT: total number of hard interface counters
+ * @BATADV_HARDIF_CNT_MAX: highest counter number currently defined
+ *
+ * Byte counters include the ethernet header.
+ */
+enum batadv_hardif_counter {
+	BATADV_HARDIF_CNT_PAD,
+	BATADV_HARDIF_CNT_ELP_TX,
+	BATADV_HARDIF_CNT_ELP_TX_BYTES,
+	BATADV_HARDIF_CNT_ELP_RX,
+	BATADV_HARDIF_CNT_ELP_RX_BYTES,
+	BATADV_HARDIF_CNT_OGM_TX,
+	BATADV_HARDIF_CNT_OGM_TX_BYTES,
+	BATADV_HARDIF_CNT_OGM_TX_AGGR,
+	BATADV_HARDIF_CNT_OGM_RX,
+	BATADV_HARDIF_CNT_OGM_RX_BYTES,
+	BATADV_HARDIF_CNT_OGM_RX_AGGR,
+	BATADV_HARDIF_CNT_OGM2_TX,
+	BATADV_HARDIF_CNT_OGM2_TX_BYTES,
+	BATADV_HARDIF_CNT_OGM2_RX,
+	BATADV_HARDIF_CNT_OGM2_RX_BYTES,
+	BATADV_HARDIF_CNT_SIG_TX_BYTES,
+	BATADV_HARDIF_CNT_SIG_RX_BYTES,
+	BATADV_HARDIF_CNT_TVLV_TX,
+	BATADV_HARDIF_CNT_TVLV_TX_BYTES,
+	BATADV_HARDIF_CNT_TVLV_RX,
+	BATADV_HARDIF_CNT_TVLV_RX_BYTES,
+	/* add counters above here */
+	__BATADV_HARDIF_CNT_AFTER_LAST,
+	NUM_BATADV_HARDIF_CNT = __BATADV_HARDIF_CNT_AFTER_LAST,
+	BATADV_HARDIF_CNT_MAX = __BATADV_HARDIF_CNT_AFTER_LAST - 1
+};
+
 #endif /* _UAPI_LINUX_BATMAN_ADV_H_ */
@@ -331,6 +331,8 @@ batadv_iv_ogm_orig_get(struct batadv_priv *bat_priv, const u8 *addr)
 	if (hash_added != 0)
 		goto free_orig_node_hash;
 
+	batadv_netlink_orig_notify(bat_priv, BATADV_EVENT_ORIG_ADD, addr);
+
 	return orig_node;
 
 free_orig_node_hash:
@@ -527,6 +529,9 @@ static void batadv_iv_ogm_send_to_if(struct batadv_forw_packet *forw_packet,
 		batadv_inc_counter(bat_priv, BATADV_CNT_MGMT_TX);
 		batadv_add_counter(bat_priv, BATADV_CNT_MGMT_TX_BYTES,
 				   skb->len + ETH_HLEN);
+		batadv_hardif_add_counter(hard_iface,
+					  BATADV_HARDIF_CNT_OGM_TX_AGGR,
+					  packet_num);
 		batadv_send_broadcast_skb(skb, hard_iface);
 	}
 }
@@ -1814,6 +1819,7 @@ static int batadv_iv_ogm_receive(struct sk_buff *skb,
 {
 	struct batadv_priv *bat_priv = netdev_priv(if_incoming->soft_iface);
 	struct batadv_ogm_packet *ogm_packet;
+	unsigned int packet_num = 0;
 	u8 *packet_pos;
 	int ogm_offset;
 	bool res;
@@ -1843,11 +1849,15 @@ static int batadv_iv_ogm_receive(struct sk_buff *skb,
 
 		ogm_offset += BATADV_OGM_HLEN;
 		ogm_offset += ntohs(ogm_packet->tvlv_len);
+		packet_num++;
 
 		packet_pos = skb->data + ogm_offset;
 		ogm_packet = (struct batadv_ogm_packet *)packet_pos;
 	}
 
+	batadv_hardif_add_counter(if_incoming, BATADV_HARDIF_CNT_OGM_RX_AGGR,
+				  packet_num);
+
 	ret = NET_RX_SUCCESS;
 
 free_skb:
@@ -2567,6 +2577,48 @@ next:
 	return curr_gw;
 }
 
+/**
+ * batadv_iv_gw_get_weight - compute the share of DHCP clients a GW should serve
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_node: the GW to compute the weight for
+ *
+ * Like the "fast connection" selection class, the advertised download
+ * bandwidth is scaled by the square of the path quality towards the GW.
+ *
+ * Return: the weight of the GW, 0 if it is not reachable
+ */
+static u32 batadv_iv_gw_get_weight(struct batadv_priv *bat_priv,
+				   struct batadv_gw_node *gw_node)
+{
+	struct batadv_neigh_ifinfo *router_ifinfo = NULL;
+	struct batadv_neigh_node *router;
+	u32 weight = 0;
+	u8 tq_avg;
+
+	router = batadv_orig_router_get(gw_node->orig_node, BATADV_IF_DEFAULT);
+	if (!router)
+		goto out;
+
+	router_ifinfo = batadv_neigh_ifinfo_get(router, BATADV_IF_DEFAULT);
+	if (!router_ifinfo)
+		goto out;
+
+	tq_avg = router_ifinfo->bat_iv.tq_avg;
+
+	/* the capped bandwidth times tq_avg^2 still fits into 32 bits */
+	weight = min_t(u32, gw_node->bandwidth_down, BATADV_GW_WEIGHT_MAX);
+	weight *= tq_avg * tq_avg;
+	weight /= BATADV_TQ_MAX_VALUE * BATADV_TQ_MAX_VALUE;
+
+out:
+	if (router)
+		batadv_neigh_node_put(router);
+	if (router_ifinfo)
+		batadv_neigh_ifinfo_put(router_ifinfo);
+
+	return weight;
+}
+
 static bool batadv_iv_gw_is_eligible(struct batadv_priv *bat_priv,
 				     struct batadv_orig_node *curr_gw_orig,
 				     struct batadv_orig_node *orig_node)
@@ -2836,6 +2888,7 @@ static struct batadv_algo_ops batadv_batman_iv __read_mostly = {
 		.init_sel_class = batadv_iv_init_sel_class,
 		.get_best_gw_node = batadv_iv_gw_get_best_gw_node,
 		.is_eligible = batadv_iv_gw_is_eligible,
+		.get_weight = batadv_iv_gw_get_weight,
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 		.print = batadv_iv_gw_print,
 #endif
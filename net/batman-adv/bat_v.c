@@ -785,6 +785,24 @@ next:
 	return curr_gw;
 }
 
+/**
+ * batadv_v_gw_get_weight - compute the share of DHCP clients a GW should serve
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_node: the GW to compute the weight for
+ *
+ * Return: the GW-metric of the GW, 0 if it is not reachable
+ */
+static u32 batadv_v_gw_get_weight(struct batadv_priv *bat_priv,
+				  struct batadv_gw_node *gw_node)
+{
+	u32 bw;
+
+	if (batadv_v_gw_throughput_get(gw_node, &bw) < 0)
+		return 0;
+
+	return bw;
+}
+
 /**
  * batadv_v_gw_is_eligible - check if a originator would be selected as GW
  * @bat_priv: the bat priv with all the soft interface information
@@ -1067,6 +1085,7 @@ static struct batadv_algo_ops batadv_batman_v __read_mostly = {
 		.show_sel_class = batadv_v_show_sel_class,
 		.get_best_gw_node = batadv_v_gw_get_best_gw_node,
 		.is_eligible = batadv_v_gw_is_eligible,
+		.get_weight = batadv_v_gw_get_weight,
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 		.print = batadv_v_gw_print,
 #endif
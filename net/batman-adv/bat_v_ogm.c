@@ -36,17 +36,21 @@
 #include <linux/slab.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
+#include <linux/timex.h>
 #include <linux/types.h>
 #include <linux/workqueue.h>
 
 #include "bat_algo.h"
 #include "hard-interface.h"
 #include "hash.h"
+#include "latency.h"
 #include "log.h"
+#include "netlink.h"
 #include "originator.h"
 #include "packet.h"
 #include "routing.h"
 #include "send.h"
+#include "trace.h"
 #include "translation-table.h"
 #include "tvlv.h"
 
@@ -82,9 +86,11 @@ struct batadv_orig_node *batadv_v_ogm_orig_get(struct batadv_priv *bat_priv,
 		/* remove refcnt for newly created orig_node and hash entry */
 		batadv_orig_node_put(orig_node);
 		batadv_orig_node_put(orig_node);
-		orig_node = NULL;
+		return NULL;
 	}
 
+	batadv_netlink_orig_notify(bat_priv, BATADV_EVENT_ORIG_ADD, addr);
+
 	return orig_node;
 }
 
@@ -145,6 +151,7 @@ static void batadv_v_ogm_send(struct work_struct *work)
 	ed25519_signature sig;
 	u16 sig_message_len = sizeof(struct batadv_ogm2_packet) - 73;
 	unsigned char message[sig_message_len];
+	cycles_t sign_start;
 
 	bat_v = container_of(work, struct batadv_priv_bat_v, ogm_wq.work);
 	bat_priv = container_of(bat_v, struct batadv_priv, bat_v);
@@ -182,7 +189,11 @@ static void batadv_v_ogm_send(struct work_struct *work)
 	memcpy(ogm_packet->batadv_public_key, batadv_return_public_key(), sizeof(ed25519_public_key));
 	//sign everything except the sig itself, ttl, throughput, and price
 	build_sig_message(ogm_packet, (unsigned char*)&message, sig_message_len);
+	sign_start = batadv_latency_cycles_start(bat_priv);
 	ed25519_sign(message, sig_message_len, *batadv_return_public_key(), *batadv_return_secret_key(), sig);
+	batadv_latency_cycles_end(bat_priv, BATADV_STATS_OGM_SIGN_CYCLES,
+				  sign_start);
+	batadv_inc_counter(bat_priv, BATADV_CNT_OGM2_SIGN);
 	memcpy(ogm_packet->ogm_ed25519_sig, sig, sizeof(ed25519_signature));
 
 	/* broadcast on every interface */
@@ -447,11 +458,6 @@ static int batadv_v_ogm_metric_update(struct batadv_priv *bat_priv,
 	if (!orig_ifinfo)
 		goto out;
 
-	if(strcmp(ogm2->batadv_public_key, orig_ifinfo->last_key) && orig_ifinfo->key_init)
-		batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
-			   "Drop packet: OGM from %pM\n has changed keys!",
-			   ogm2->orig);
-
 	seq_diff = ntohl(ogm2->seqno) - orig_ifinfo->last_real_seqno;
 
 	if (!hlist_empty(&orig_node->neigh_list) &&
@@ -678,6 +684,37 @@ static bool batadv_v_ogm_aggr_packet(int buff_pos, int packet_len,
 	       (next_buff_pos <= BATADV_MAX_AGGREGATION_BYTES);
 }
 
+/**
+ * batadv_v_ogm_key_check - account an OGM2 announcing a changed key
+ * @bat_priv: the bat priv with all the soft interface information
+ * @ogm2: OGM2 structure
+ * @orig_node: Originator structure for which the OGM has been received
+ *
+ * Compares the public key of the OGM2 with the first key seen for the
+ * originator. Called once per received OGM2, before it is processed for the
+ * default and the per hard interface routing tables.
+ */
+static void batadv_v_ogm_key_check(struct batadv_priv *bat_priv,
+				   const struct batadv_ogm2_packet *ogm2,
+				   struct batadv_orig_node *orig_node)
+{
+	struct batadv_orig_ifinfo *orig_ifinfo;
+
+	orig_ifinfo = batadv_orig_ifinfo_get(orig_node, BATADV_IF_DEFAULT);
+	if (!orig_ifinfo)
+		return;
+
+	if (orig_ifinfo->key_init &&
+	    memcmp(ogm2->batadv_public_key, orig_ifinfo->last_key,
+		   sizeof(ed25519_public_key))) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_OGM2_KEY_CHANGE);
+		batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
+			   "OGM from %pM has changed keys!\n", ogm2->orig);
+	}
+
+	batadv_orig_ifinfo_put(orig_ifinfo);
+}
+
 /**
  * batadv_v_ogm_process - process an incoming batman v OGM
  * @skb: the skb containing the OGM
@@ -695,10 +732,16 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 	struct batadv_hard_iface *hard_iface;
 	struct batadv_ogm2_packet *ogm_packet;
 	u32 ogm_throughput, link_throughput, path_throughput;
+	bool accepted = false;
+	u64 start, verify_start;
+	cycles_t verify_cycles;
+	bool sig_valid;
 	int ret;
 	u16 sig_message_len = sizeof(struct batadv_ogm2_packet) - 73;
 	unsigned char message[sig_message_len];
 
+	start = batadv_latency_start(bat_priv);
+
 	ethhdr = eth_hdr(skb);
 	ogm_packet = (struct batadv_ogm2_packet *)(skb->data + ogm_offset);
 
@@ -711,13 +754,27 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 		   ntohl(ogm_packet->seqno), ogm_throughput, ogm_packet->ttl,
 		   ogm_packet->version, ntohs(ogm_packet->tvlv_len));
 
+	trace_batadv_v_ogm_process_start(bat_priv, if_incoming,
+					 ethhdr->h_source, ogm_packet);
+
 	//OGM Sig verification TODO batches TODO network byte order is a thing
 	//sign everything except the sig itself, ttl, throughput, and price
 	build_sig_message(ogm_packet, (unsigned char*)&message, sig_message_len);
-	if (!ed25519_sign_open(message, sig_message_len, ogm_packet->batadv_public_key, ogm_packet->ogm_ed25519_sig)){
+	verify_start = batadv_latency_start(bat_priv);
+	verify_cycles = batadv_latency_cycles_start(bat_priv);
+	sig_valid = ed25519_sign_open(message, sig_message_len,
+				      ogm_packet->batadv_public_key,
+				      ogm_packet->ogm_ed25519_sig);
+	batadv_latency_cycles_end(bat_priv, BATADV_STATS_OGM_VERIFY_CYCLES,
+				  verify_cycles);
+	batadv_latency_end(bat_priv, BATADV_STATS_OGM_VERIFY, verify_start);
+	batadv_inc_counter(bat_priv, BATADV_CNT_OGM2_VERIFY);
+	trace_batadv_v_ogm_verify(bat_priv, ogm_packet, sig_valid);
+	if (!sig_valid) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_OGM2_VERIFY_FAILED);
 		batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
 			   "Drop packet: Failed OGM signiture verification!\n");
-		return;
+		goto out;
 	}
 	/* If the troughput metric is 0, immediately drop the packet. No need to
 	 * create orig_node / neigh_node for an unusable route.
@@ -725,7 +782,7 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 	if (ogm_throughput == 0) {
 		batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
 			   "Drop packet: originator packet with troughput metric of 0\n");
-		return;
+		goto out;
 	}
 
 	/* require ELP packets be to received from this neighbor first */
@@ -738,7 +795,9 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 
 	orig_node = batadv_v_ogm_orig_get(bat_priv, ogm_packet->orig);
 	if (!orig_node)
-		return;
+		goto out;
+
+	batadv_v_ogm_key_check(bat_priv, ogm_packet, orig_node);
 
 	neigh_node = batadv_neigh_node_get_or_create(orig_node, if_incoming,
 						     ethhdr->h_source);
@@ -759,6 +818,8 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 	batadv_v_ogm_process_per_outif(bat_priv, ethhdr, ogm_packet, orig_node,
 				       neigh_node, if_incoming,
 				       BATADV_IF_DEFAULT);
+	batadv_latency_end(bat_priv, BATADV_STATS_OGM_ROUTE, start);
+	accepted = true;
 
 	rcu_read_lock();
 	list_for_each_entry_rcu(hard_iface, &batadv_hardif_list, list) {
@@ -808,6 +869,8 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 	}
 	rcu_read_unlock();
 out:
+	trace_batadv_v_ogm_process_end(bat_priv, ogm_packet, accepted);
+
 	if (orig_node)
 		batadv_orig_node_put(orig_node);
 	if (neigh_node)
@@ -0,0 +1,828 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include "main.h"
+
+#include <linux/atomic.h>
+#include <linux/byteorder/generic.h>
+#include <linux/compiler.h>
+#include <linux/debugfs.h>
+#include <linux/errno.h>
+#include <linux/export.h>
+#include <linux/fs.h>
+#include <linux/if_ether.h>
+#include <linux/kernel.h>
+#include <linux/kref.h>
+#include <linux/list.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/netdevice.h>
+#include <linux/netlink.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
+#include <linux/rtnetlink.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/stat.h>
+#include <linux/stddef.h>
+#include <linux/string.h>
+#include <linux/timekeeping.h>
+#include <linux/types.h>
+#include <linux/vmalloc.h>
+
+#include "distributed-arp-table.h"
+#include "hash.h"
+#include "netlink.h"
+#include "originator.h"
+#include "translation-table.h"
+
+/* largest number of entries per table accepted for a single run */
+#define BATADV_BENCH_MAX_ENTRIES 1000000
+
+/* number of entries handled between two scheduling points */
+#define BATADV_BENCH_RESCHED 1024
+
+/* the synthetic MAC addresses use a locally administered prefix and the
+ * synthetic IPv4 addresses the reserved 240.0.0.0/4 range, followed by the
+ * address type and the 24 bit index of the entry
+ */
+#define BATADV_BENCH_ADDR_ORIG	0x01
+#define BATADV_BENCH_ADDR_TT	0x02
+#define BATADV_BENCH_ADDR_MISS	0x03
+
+/**
+ * struct batadv_bench - state of a single benchmark run
+ * @bat_priv: the bat priv with all the soft interface information
+ * @origs: synthetic originators, each one holding a reference
+ * @num_origs: number of originators stored in @origs
+ * @msg: scratch buffer the table dumps are rendered into
+ */
+struct batadv_bench {
+	struct batadv_priv *bat_priv;
+	struct batadv_orig_node **origs;
+	u32 num_origs;
+	struct sk_buff *msg;
+};
+
+/**
+ * struct batadv_bench_ops - table specific parts of a benchmark run
+ * @name: name of the table in the report
+ * @add: add the synthetic entry with the given index, false on failure
+ * @find: look up the entry with the given index, or a missing one instead
+ * @purge: run a purge pass over the table
+ * @dump: render the whole table into netlink messages
+ * @entry_size: memory allocated for a single entry in bytes
+ */
+struct batadv_bench_ops {
+	const char *name;
+	bool (*add)(struct batadv_bench *bench, u32 i);
+	void (*find)(struct batadv_bench *bench, u32 i, bool miss);
+	void (*purge)(struct batadv_bench *bench);
+	void (*dump)(struct batadv_bench *bench);
+	size_t (*entry_size)(struct batadv_bench *bench);
+};
+
+/**
+ * batadv_bench_addr - build the MAC address of a synthetic entry
+ * @addr: buffer to write the address to
+ * @type: address type (BATADV_BENCH_ADDR_*)
+ * @i: index of the entry
+ */
+static void batadv_bench_addr(u8 *addr, u8 type, u32 i)
+{
+	addr[0] = 0x02;
+	addr[1] = 0xbe;
+	addr[2] = type;
+	addr[3] = (i >> 16) & 0xff;
+	addr[4] = (i >> 8) & 0xff;
+	addr[5] = i & 0xff;
+}
+
+/**
+ * batadv_bench_resched - give other tasks a chance to run every few entries
+ * @i: index of the entry which was just handled
+ */
+static void batadv_bench_resched(u32 i)
+{
+	if (!(i % BATADV_BENCH_RESCHED))
+		cond_resched();
+}
+
+/**
+ * batadv_bench_orig_add - add a synthetic originator
+ * @bench: the benchmark run
+ * @i: index of the originator
+ *
+ * Return: true if the originator was added, false otherwise
+ */
+static bool batadv_bench_orig_add(struct batadv_bench *bench, u32 i)
+{
+	struct batadv_priv *bat_priv = bench->bat_priv;
+	struct batadv_orig_node *orig_node;
+	u8 addr[ETH_ALEN];
+	int hash_added;
+
+	batadv_bench_addr(addr, BATADV_BENCH_ADDR_ORIG, i);
+
+	orig_node = batadv_orig_node_new(bat_priv, addr);
+	if (!orig_node)
+		return false;
+
+	kref_get(&orig_node->refcount);
+	hash_added = batadv_hash_add(bat_priv->orig_hash, batadv_compare_orig,
+				     batadv_choose_orig, orig_node,
+				     &orig_node->hash_entry);
+	if (hash_added != 0) {
+		batadv_orig_node_put(orig_node);
+		batadv_orig_node_put(orig_node);
+		return false;
+	}
+
+	/* keep the reference of batadv_orig_node_new() for the run */
+	bench->origs[bench->num_origs++] = orig_node;
+
+	return true;
+}
+
+/**
+ * batadv_bench_orig_find - look up an originator
+ * @bench: the benchmark run
+ * @i: index of the originator
+ * @miss: look up an address which is not in the table
+ */
+static void batadv_bench_orig_find(struct batadv_bench *bench, u32 i, bool miss)
+{
+	struct batadv_orig_node *orig_node;
+	u8 addr[ETH_ALEN];
+
+	batadv_bench_addr(addr, miss ? BATADV_BENCH_ADDR_MISS :
+				       BATADV_BENCH_ADDR_ORIG, i);
+
+	orig_node = batadv_orig_hash_find(bench->bat_priv, addr);
+	if (orig_node)
+		batadv_orig_node_put(orig_node);
+}
+
+/**
+ * batadv_bench_orig_purge - run a purge pass over the originator table
+ * @bench: the benchmark run
+ */
+static void batadv_bench_orig_purge(struct batadv_bench *bench)
+{
+	batadv_purge_orig_ref(bench->bat_priv);
+}
+
+/**
+ * batadv_bench_orig_dump - render the originator table into netlink messages
+ * @bench: the benchmark run
+ *
+ * The routing algorithm specific dump is driven through a private callback
+ * which only carries the dump position, as no netlink socket is involved.
+ */
+static void batadv_bench_orig_dump(struct batadv_bench *bench)
+{
+	struct batadv_priv *bat_priv = bench->bat_priv;
+	struct netlink_callback cb;
+	struct nlmsghdr nlh;
+
+	if (!bat_priv->algo_ops->orig.dump)
+		return;
+
+	memset(&cb, 0, sizeof(cb));
+	memset(&nlh, 0, sizeof(nlh));
+	cb.skb = bench->msg;
+	cb.nlh = &nlh;
+
+	do {
+		skb_trim(bench->msg, 0);
+		bat_priv->algo_ops->orig.dump(bench->msg, &cb, bat_priv,
+					      BATADV_IF_DEFAULT);
+	} while (bench->msg->len);
+}
+
+/**
+ * batadv_bench_orig_entry_size - get the memory used by a single originator
+ * @bench: the benchmark run
+ *
+ * Return: size of the originator plus its untagged VLAN object in bytes
+ */
+static size_t batadv_bench_orig_entry_size(struct batadv_bench *bench)
+{
+	struct batadv_orig_node_vlan *vlan;
+	size_t size;
+
+	size = ksize(bench->origs[0]);
+
+	vlan = batadv_orig_node_vlan_get(bench->origs[0], BATADV_NO_FLAGS);
+	if (vlan) {
+		size += ksize(vlan);
+		batadv_orig_node_vlan_put(vlan);
+	}
+
+	return size;
+}
+
+/**
+ * batadv_bench_orig_clear - remove all synthetic originators
+ * @bench: the benchmark run
+ *
+ * The global translation table entries announced by the originators are
+ * removed together with them.
+ */
+static void batadv_bench_orig_clear(struct batadv_bench *bench)
+{
+	struct batadv_priv *bat_priv = bench->bat_priv;
+	struct batadv_orig_node *orig_node;
+	u32 i;
+
+	for (i = 0; i < bench->num_origs; i++) {
+		orig_node = bench->origs[i];
+
+		batadv_tt_global_del_orig(bat_priv, orig_node, -1,
+					  "benchmark finished");
+
+		/* the originator may already have been purged meanwhile */
+		if (batadv_hash_remove(bat_priv->orig_hash,
+				       batadv_compare_orig, batadv_choose_orig,
+				       orig_node))
+			batadv_orig_node_put(orig_node);
+
+		batadv_orig_node_put(orig_node);
+		batadv_bench_resched(i);
+	}
+
+	bench->num_origs = 0;
+}
+
+/**
+ * batadv_bench_tt_add - add a synthetic global translation table entry
+ * @bench: the benchmark run
+ * @i: index of the entry
+ *
+ * Each synthetic originator announces exactly one client.
+ *
+ * Return: true if the entry was added, false otherwise
+ */
+static bool batadv_bench_tt_add(struct batadv_bench *bench, u32 i)
+{
+	struct batadv_orig_node *orig_node;
+	u8 addr[ETH_ALEN];
+
+	if (i >= bench->num_origs)
+		return false;
+
+	orig_node = bench->origs[i];
+	batadv_bench_addr(addr, BATADV_BENCH_ADDR_TT, i);
+
+	return batadv_tt_global_add(bench->bat_priv, orig_node, addr,
+				    BATADV_NO_FLAGS, BATADV_NO_FLAGS,
+				    atomic_read(&orig_node->last_ttvn));
+}
+
+/**
+ * batadv_bench_tt_find - look up the destination of a client
+ * @bench: the benchmark run
+ * @i: index of the entry
+ * @miss: look up a client which is not in the table
+ */
+static void batadv_bench_tt_find(struct batadv_bench *bench, u32 i, bool miss)
+{
+	struct batadv_orig_node *orig_node;
+	u8 addr[ETH_ALEN];
+
+	batadv_bench_addr(addr, miss ? BATADV_BENCH_ADDR_MISS :
+				       BATADV_BENCH_ADDR_TT, i);
+
+	orig_node = batadv_transtable_search(bench->bat_priv, NULL, addr,
+					     BATADV_NO_FLAGS);
+	if (orig_node)
+		batadv_orig_node_put(orig_node);
+}
+
+/**
+ * batadv_bench_tt_purge - run a purge pass over the global translation table
+ * @bench: the benchmark run
+ */
+static void batadv_bench_tt_purge(struct batadv_bench *bench)
+{
+	batadv_tt_global_purge(bench->bat_priv);
+}
+
+/**
+ * batadv_bench_tt_dump - render the global translation table into netlink
+ *  messages
+ * @bench: the benchmark run
+ */
+static void batadv_bench_tt_dump(struct batadv_bench *bench)
+{
+	struct batadv_priv *bat_priv = bench->bat_priv;
+	struct batadv_hashtable *hash = bat_priv->tt.global_hash;
+	struct batadv_netlink_filter filter = { .vid = -1 };
+	u32 bucket = 0;
+	int idx = 0;
+	int sub = 0;
+
+	skb_trim(bench->msg, 0);
+
+	while (bucket < hash->size) {
+		if (batadv_tt_global_dump_bucket(bench->msg, 0, 0, bat_priv,
+						 &filter, &hash->table[bucket],
+						 &idx, &sub)) {
+			/* an empty message cannot take the entry either */
+			if (!bench->msg->len)
+				break;
+
+			skb_trim(bench->msg, 0);
+			continue;
+		}
+
+		bucket++;
+	}
+}
+
+/**
+ * batadv_bench_tt_entry_size - get the memory used by a single client
+ * @bench: the benchmark run
+ *
+ * Return: size of the global entry plus its originator list entry in bytes
+ */
+static size_t batadv_bench_tt_entry_size(struct batadv_bench *bench)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+	struct batadv_tt_global_entry *tt_global;
+	struct hlist_node *first;
+	u8 addr[ETH_ALEN];
+	size_t size;
+
+	batadv_bench_addr(addr, BATADV_BENCH_ADDR_TT, 0);
+
+	tt_global = batadv_tt_global_hash_find(bench->bat_priv, addr,
+					       BATADV_NO_FLAGS);
+	if (!tt_global)
+		return 0;
+
+	size = ksize(tt_global);
+
+	rcu_read_lock();
+	first = rcu_dereference(hlist_first_rcu(&tt_global->orig_list));
+	orig_entry = hlist_entry_safe(first, struct batadv_tt_orig_list_entry,
+				      list);
+	if (orig_entry)
+		size += ksize(orig_entry);
+	rcu_read_unlock();
+
+	batadv_tt_global_entry_put(tt_global);
+
+	return size;
+}
+
+#ifdef CONFIG_BATMAN_ADV_DAT
+
+/**
+ * batadv_bench_dat_ip - build the IPv4 address of a synthetic entry
+ * @type: address type (BATADV_BENCH_ADDR_*)
+ * @i: index of the entry
+ *
+ * Return: the IPv4 address in network byte order
+ */
+static __be32 batadv_bench_dat_ip(u8 type, u32 i)
+{
+	return htonl((0xf0 | type) << 24 | (i & 0xffffff));
+}
+
+/**
+ * batadv_bench_dat_add - add a synthetic DAT cache entry
+ * @bench: the benchmark run
+ * @i: index of the entry
+ *
+ * Return: always true, failed additions are caught by the lookups
+ */
+static bool batadv_bench_dat_add(struct batadv_bench *bench, u32 i)
+{
+	u8 addr[ETH_ALEN];
+
+	batadv_bench_addr(addr, BATADV_BENCH_ADDR_ORIG, i);
+	batadv_dat_entry_add(bench->bat_priv,
+			     batadv_bench_dat_ip(BATADV_BENCH_ADDR_ORIG, i),
+			     addr, BATADV_NO_FLAGS);
+
+	return true;
+}
+
+/**
+ * batadv_bench_dat_find - look up a DAT cache entry
+ * @bench: the benchmark run
+ * @i: index of the entry
+ * @miss: look up an IPv4 address which is not in the table
+ */
+static void batadv_bench_dat_find(struct batadv_bench *bench, u32 i, bool miss)
+{
+	struct batadv_dat_entry *dat_entry;
+	__be32 ip;
+
+	ip = batadv_bench_dat_ip(miss ? BATADV_BENCH_ADDR_MISS :
+					BATADV_BENCH_ADDR_ORIG, i);
+
+	dat_entry = batadv_dat_entry_hash_find(bench->bat_priv, ip,
+					       BATADV_NO_FLAGS);
+	if (dat_entry)
+		batadv_dat_entry_put(dat_entry);
+}
+
+/**
+ * batadv_bench_dat_purge - run a purge pass over the DAT cache
+ * @bench: the benchmark run
+ */
+static void batadv_bench_dat_purge(struct batadv_bench *bench)
+{
+	__batadv_dat_purge(bench->bat_priv, batadv_dat_to_purge);
+}
+
+/**
+ * batadv_bench_dat_dump - render the DAT cache into netlink messages
+ * @bench: the benchmark run
+ */
+static void batadv_bench_dat_dump(struct batadv_bench *bench)
+{
+	struct batadv_hashtable *hash = bench->bat_priv->dat.hash;
+	struct batadv_netlink_filter filter = { .vid = -1 };
+	u32 bucket = 0;
+	int idx = 0;
+
+	skb_trim(bench->msg, 0);
+
+	while (bucket < hash->size) {
+		if (batadv_dat_cache_dump_bucket(bench->msg, 0, 0, &filter,
+						 &hash->table[bucket], &idx)) {
+			/* an empty message cannot take the entry either */
+			if (!bench->msg->len)
+				break;
+
+			skb_trim(bench->msg, 0);
+			continue;
+		}
+
+		bucket++;
+	}
+}
+
+/**
+ * batadv_bench_dat_entry_size - get the memory used by a single DAT entry
+ * @bench: the benchmark run
+ *
+ * Return: size of the DAT cache entry in bytes
+ */
+static size_t batadv_bench_dat_entry_size(struct batadv_bench *bench)
+{
+	struct batadv_dat_entry *dat_entry;
+	__be32 ip = batadv_bench_dat_ip(BATADV_BENCH_ADDR_ORIG, 0);
+	size_t size;
+
+	dat_entry = batadv_dat_entry_hash_find(bench->bat_priv, ip,
+					       BATADV_NO_FLAGS);
+	if (!dat_entry)
+		return 0;
+
+	size = ksize(dat_entry);
+	batadv_dat_entry_put(dat_entry);
+
+	return size;
+}
+
+/**
+ * batadv_bench_dat_is_synthetic - check whether a DAT entry was added by a run
+ * @dat_entry: the entry to check
+ *
+ * Return: true if the entry belongs to the reserved benchmark range
+ */
+static bool batadv_bench_dat_is_synthetic(struct batadv_dat_entry *dat_entry)
+{
+	return (ntohl(dat_entry->ip) >> 28) == 0xf;
+}
+
+#endif /* CONFIG_BATMAN_ADV_DAT */
+
+static const struct batadv_bench_ops batadv_bench_tables[BATADV_BENCH_NUM] = {
+	[BATADV_BENCH_ORIG] = {
+		.name = "originators",
+		.add = batadv_bench_orig_add,
+		.find = batadv_bench_orig_find,
+		.purge = batadv_bench_orig_purge,
+		.dump = batadv_bench_orig_dump,
+		.entry_size = batadv_bench_orig_entry_size,
+	},
+	[BATADV_BENCH_TT_GLOBAL] = {
+		.name = "transtable_global",
+		.add = batadv_bench_tt_add,
+		.find = batadv_bench_tt_find,
+		.purge = batadv_bench_tt_purge,
+		.dump = batadv_bench_tt_dump,
+		.entry_size = batadv_bench_tt_entry_size,
+	},
+#ifdef CONFIG_BATMAN_ADV_DAT
+	[BATADV_BENCH_DAT] = {
+		.name = "dat_cache",
+		.add = batadv_bench_dat_add,
+		.find = batadv_bench_dat_find,
+		.purge = batadv_bench_dat_purge,
+		.dump = batadv_bench_dat_dump,
+		.entry_size = batadv_bench_dat_entry_size,
+	},
+#endif
+};
+
+/**
+ * batadv_bench_per_op - compute the mean time of an operation
+ * @start: timestamp taken before the first operation
+ * @num: number of operations
+ *
+ * Return: mean time per operation in nanoseconds
+ */
+static u64 batadv_bench_per_op(u64 start, u32 num)
+{
+	if (!num)
+		return 0;
+
+	return div_u64(ktime_get_ns() - start, num);
+}
+
+/**
+ * batadv_bench_lookup - time the lookups of all entries of a table
+ * @bench: the benchmark run
+ * @ops: the table to measure
+ * @num: number of entries in the table
+ * @miss: look up entries which are not in the table
+ *
+ * Return: mean time per lookup in nanoseconds
+ */
+static u64 batadv_bench_lookup(struct batadv_bench *bench,
+			       const struct batadv_bench_ops *ops, u32 num,
+			       bool miss)
+{
+	u64 start = ktime_get_ns();
+	u32 i;
+
+	for (i = 0; i < num; i++) {
+		ops->find(bench, i, miss);
+		batadv_bench_resched(i);
+	}
+
+	return batadv_bench_per_op(start, num);
+}
+
+/**
+ * batadv_bench_table - fill a table with synthetic entries and measure it
+ * @bench: the benchmark run
+ * @ops: the table to measure
+ * @size: number of entries to add
+ * @result: buffer for the measured costs
+ */
+static void batadv_bench_table(struct batadv_bench *bench,
+			       const struct batadv_bench_ops *ops, u32 size,
+			       struct batadv_bench_result *result)
+{
+	u64 start;
+	u32 num;
+
+	start = ktime_get_ns();
+	for (num = 0; num < size; num++) {
+		if (!ops->add(bench, num))
+			break;
+
+		batadv_bench_resched(num);
+	}
+
+	result->entries = num;
+	result->add_ns = batadv_bench_per_op(start, num);
+	if (!num)
+		return;
+
+	result->find_ns = batadv_bench_lookup(bench, ops, num, false);
+	result->miss_ns = batadv_bench_lookup(bench, ops, num, true);
+
+	start = ktime_get_ns();
+	ops->purge(bench);
+	result->purge_ns = batadv_bench_per_op(start, num);
+
+	start = ktime_get_ns();
+	ops->dump(bench);
+	result->dump_ns = batadv_bench_per_op(start, num);
+
+	result->entry_size = ops->entry_size(bench);
+}
+
+/**
+ * batadv_bench_run - measure the tables of a mesh interface
+ * @bat_priv: the bat priv with all the soft interface information
+ * @size: number of synthetic entries to add to each table
+ *
+ * The synthetic entries are removed again before returning. The run requires
+ * a mesh interface without hard interfaces, so the routing algorithm never
+ * sends or receives on behalf of the synthetic originators. No hard interface
+ * can be added while the run is in progress, see batadv_bench_running().
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+static int batadv_bench_run(struct batadv_priv *bat_priv, u32 size)
+{
+	struct batadv_bench_result *results = bat_priv->bench.results;
+	struct batadv_bench bench;
+	int ret = 0;
+	int i;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.bat_priv = bat_priv;
+
+	bench.origs = vzalloc(size * sizeof(*bench.origs));
+	if (!bench.origs)
+		return -ENOMEM;
+
+	bench.msg = alloc_skb(NLMSG_GOODSIZE, GFP_KERNEL);
+	if (!bench.msg) {
+		ret = -ENOMEM;
+		goto free_origs;
+	}
+
+	rtnl_lock();
+	if (bat_priv->num_ifaces)
+		ret = -EBUSY;
+	else
+		bat_priv->bench.running = true;
+	rtnl_unlock();
+
+	if (ret)
+		goto free_msg;
+
+	memset(results, 0, sizeof(bat_priv->bench.results));
+	bat_priv->bench.size = size;
+
+	for (i = 0; i < BATADV_BENCH_NUM; i++) {
+		if (!batadv_bench_tables[i].add)
+			continue;
+
+		batadv_bench_table(&bench, &batadv_bench_tables[i], size,
+				   &results[i]);
+	}
+
+#ifdef CONFIG_BATMAN_ADV_DAT
+	__batadv_dat_purge(bat_priv, batadv_bench_dat_is_synthetic);
+#endif
+	batadv_bench_orig_clear(&bench);
+
+	rtnl_lock();
+	bat_priv->bench.running = false;
+	rtnl_unlock();
+
+free_msg:
+	kfree_skb(bench.msg);
+free_origs:
+	vfree(bench.origs);
+
+	return ret;
+}
+
+/**
+ * batadv_bench_running - check whether a table benchmark is in progress
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * The caller must hold the RTNL lock.
+ *
+ * Return: true if a run is in progress on the mesh interface
+ */
+bool batadv_bench_running(struct batadv_priv *bat_priv)
+{
+	ASSERT_RTNL();
+
+	return bat_priv->bench.running;
+}
+
+/**
+ * batadv_bench_seq_print_text - print the results of the last run
+ * @seq: seq file to print on
+ * @offset: not used
+ *
+ * Return: always 0
+ */
+static int batadv_bench_seq_print_text(struct seq_file *seq, void *offset)
+{
+	struct net_device *net_dev = (struct net_device *)seq->private;
+	struct batadv_priv *bat_priv = netdev_priv(net_dev);
+	struct batadv_bench_result *result;
+	int i;
+
+	mutex_lock(&bat_priv->bench.lock);
+
+	if (!bat_priv->bench.size) {
+		seq_puts(seq,
+			 "No benchmark run yet, write the number of entries to start one\n");
+		goto out;
+	}
+
+	seq_printf(seq, "Entries per table: %u\n", bat_priv->bench.size);
+	seq_printf(seq, "%-18s %8s %9s %9s %9s %9s %9s %7s\n", "Table",
+		   "Entries", "Add(ns)", "Find(ns)", "Miss(ns)", "Purge(ns)",
+		   "Dump(ns)", "Bytes");
+
+	for (i = 0; i < BATADV_BENCH_NUM; i++) {
+		if (!batadv_bench_tables[i].name)
+			continue;
+
+		result = &bat_priv->bench.results[i];
+		seq_printf(seq, "%-18s %8u %9llu %9llu %9llu %9llu %9llu %7zu\n",
+			   batadv_bench_tables[i].name, result->entries,
+			   result->add_ns, result->find_ns, result->miss_ns,
+			   result->purge_ns, result->dump_ns,
+			   result->entry_size);
+	}
+
+out:
+	mutex_unlock(&bat_priv->bench.lock);
+	return 0;
+}
+
+static int batadv_bench_open(struct inode *inode, struct file *file)
+{
+	struct net_device *net_dev = (struct net_device *)inode->i_private;
+
+	return single_open(file, batadv_bench_seq_print_text, net_dev);
+}
+
+/**
+ * batadv_bench_write - start a benchmark run
+ * @file: the bench file
+ * @buf: userspace buffer holding the number of entries per table
+ * @count: length of @buf
+ * @ppos: file position, not used
+ *
+ * Return: @count on success or negative error number in case of failure
+ */
+static ssize_t batadv_bench_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	struct seq_file *seq = file->private_data;
+	struct net_device *net_dev = (struct net_device *)seq->private;
+	struct batadv_priv *bat_priv = netdev_priv(net_dev);
+	u32 size;
+	int ret;
+
+	ret = kstrtou32_from_user(buf, count, 0, &size);
+	if (ret < 0)
+		return ret;
+
+	if (size == 0 || size > BATADV_BENCH_MAX_ENTRIES)
+		return -EINVAL;
+
+	mutex_lock(&bat_priv->bench.lock);
+	ret = batadv_bench_run(bat_priv, size);
+	mutex_unlock(&bat_priv->bench.lock);
+
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+static const struct file_operations batadv_bench_fops = {
+	.owner = THIS_MODULE,
+	.open = batadv_bench_open,
+	.read = seq_read,
+	.write = batadv_bench_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * batadv_bench_init_debugfs - create the bench file of a mesh interface
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+int batadv_bench_init_debugfs(struct batadv_priv *bat_priv)
+{
+	struct dentry *file;
+
+	mutex_init(&bat_priv->bench.lock);
+
+	file = debugfs_create_file("bench", S_IFREG | 0644,
+				   bat_priv->debug_dir, bat_priv->soft_iface,
+				   &batadv_bench_fops);
+	if (!file)
+		return -ENOMEM;
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NET_BATMAN_ADV_BENCH_H_
+#define _NET_BATMAN_ADV_BENCH_H_
+
+#include "main.h"
+
+#include <linux/types.h>
+
+#ifdef CONFIG_BATMAN_ADV_BENCH
+
+bool batadv_bench_running(struct batadv_priv *bat_priv);
+int batadv_bench_init_debugfs(struct batadv_priv *bat_priv);
+
+#else
+
+static inline bool batadv_bench_running(struct batadv_priv *bat_priv)
+{
+	return false;
+}
+
+static inline int batadv_bench_init_debugfs(struct batadv_priv *bat_priv)
+{
+	return 0;
+}
+
+#endif
+
+#endif /* _NET_BATMAN_ADV_BENCH_H_ */
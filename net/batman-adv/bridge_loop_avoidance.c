@@ -34,11 +34,13 @@
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/lockdep.h>
+#include <linux/log2.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/seq_file.h>
+#include <linux/seqlock.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
@@ -191,7 +193,7 @@ static void batadv_claim_release(struct kref *ref)
 
 	spin_lock_bh(&claim->backbone_lock);
 	old_backbone_gw = claim->backbone_gw;
-	claim->backbone_gw = NULL;
+	WRITE_ONCE(claim->backbone_gw, NULL);
 	spin_unlock_bh(&claim->backbone_lock);
 
 	spin_lock_bh(&old_backbone_gw->crc_lock);
@@ -214,42 +216,84 @@ static void batadv_claim_put(struct batadv_bla_claim *claim)
 }
 
 /**
- * batadv_claim_hash_find - looks for a claim in the claim hash
+ * batadv_bla_claim_hash_protected - get the claim hash for modification
+ * @bla: bla private data of the soft interface
+ *
+ * The caller must hold the read side of bla->claim_hash_lock which keeps the
+ * claim hash from being replaced by a resize. Concurrent writers are only
+ * serialized by the list lock of the bucket they modify.
+ *
+ * Return: the current claim hash
+ */
+static struct batadv_hashtable *
+batadv_bla_claim_hash_protected(struct batadv_priv_bla *bla)
+{
+	rwlock_t *lock = &bla->claim_hash_lock;
+
+	return rcu_dereference_protected(bla->claim_hash,
+					 lockdep_is_held(lock));
+}
+
+/**
+ * batadv_claim_hash_find_rcu - looks for a claim without taking a reference
  * @bat_priv: the bat priv with all the soft interface information
  * @data: search data (may be local/static data)
  *
+ * The caller must hold rcu_read_lock(). The returned claim stays valid until
+ * the read side critical section ends but may already be unlinked from the
+ * hash. A lookup which raced with a resize of the claim hash is retried.
+ *
  * Return: claim if found or NULL otherwise.
  */
 static struct batadv_bla_claim *
-batadv_claim_hash_find(struct batadv_priv *bat_priv,
-		       struct batadv_bla_claim *data)
+batadv_claim_hash_find_rcu(struct batadv_priv *bat_priv,
+			   struct batadv_bla_claim *data)
 {
-	struct batadv_hashtable *hash = bat_priv->bla.claim_hash;
+	struct batadv_hashtable *hash;
 	struct hlist_head *head;
 	struct batadv_bla_claim *claim;
-	struct batadv_bla_claim *claim_tmp = NULL;
-	int index;
+	unsigned int seq;
+	u32 index;
 
-	if (!hash)
-		return NULL;
+	do {
+		seq = read_seqcount_begin(&bat_priv->bla.claim_hash_seq);
 
-	index = batadv_choose_claim(data, hash->size);
-	head = &hash->table[index];
+		hash = rcu_dereference(bat_priv->bla.claim_hash);
+		if (!hash)
+			return NULL;
 
-	rcu_read_lock();
-	hlist_for_each_entry_rcu(claim, head, hash_entry) {
-		if (!batadv_compare_claim(&claim->hash_entry, data))
-			continue;
+		index = batadv_choose_claim(data, hash->size);
+		head = &hash->table[index];
 
-		if (!kref_get_unless_zero(&claim->refcount))
-			continue;
+		hlist_for_each_entry_rcu(claim, head, hash_entry) {
+			if (batadv_compare_claim(&claim->hash_entry, data))
+				return claim;
+		}
+	} while (read_seqcount_retry(&bat_priv->bla.claim_hash_seq, seq));
 
-		claim_tmp = claim;
-		break;
-	}
+	return NULL;
+}
+
+/**
+ * batadv_claim_hash_find - looks for a claim in the claim hash
+ * @bat_priv: the bat priv with all the soft interface information
+ * @data: search data (may be local/static data)
+ *
+ * Return: claim if found or NULL otherwise.
+ */
+static struct batadv_bla_claim *
+batadv_claim_hash_find(struct batadv_priv *bat_priv,
+		       struct batadv_bla_claim *data)
+{
+	struct batadv_bla_claim *claim;
+
+	rcu_read_lock();
+	claim = batadv_claim_hash_find_rcu(bat_priv, data);
+	if (claim && !kref_get_unless_zero(&claim->refcount))
+		claim = NULL;
 	rcu_read_unlock();
 
-	return claim_tmp;
+	return claim;
 }
 
 /**
@@ -309,10 +353,12 @@ batadv_bla_del_backbone_claims(struct batadv_bla_backbone_gw *backbone_gw)
 	struct batadv_bla_claim *claim;
 	int i;
 	spinlock_t *list_lock;	/* protects write access to the hash lists */
+	struct batadv_priv_bla *bla = &backbone_gw->bat_priv->bla;
 
-	hash = backbone_gw->bat_priv->bla.claim_hash;
+	read_lock_bh(&bla->claim_hash_lock);
+	hash = batadv_bla_claim_hash_protected(bla);
 	if (!hash)
-		return;
+		goto unlock;
 
 	for (i = 0; i < hash->size; i++) {
 		head = &hash->table[i];
@@ -326,16 +372,39 @@ batadv_bla_del_backbone_claims(struct batadv_bla_backbone_gw *backbone_gw)
 
 			batadv_claim_put(claim);
 			hlist_del_rcu(&claim->hash_entry);
+			atomic_inc(&hash->generation);
+			atomic_dec(&bla->num_claims);
 		}
 		spin_unlock_bh(list_lock);
 	}
 
-	/* all claims gone, initialize CRC */
+unlock:
+	read_unlock_bh(&bla->claim_hash_lock);
+
+	/* all claims have been deleted, therefore reset the crc */
 	spin_lock_bh(&backbone_gw->crc_lock);
 	backbone_gw->crc = BATADV_BLA_CRC_INIT;
 	spin_unlock_bh(&backbone_gw->crc_lock);
 }
 
+/**
+ * batadv_bla_backbone_crc_get - get the current crc of a backbone gateway
+ * @backbone_gw: backbone gateway whose crc should be returned
+ *
+ * Return: crc16 checksum over all claims of backbone_gw
+ */
+static u16
+batadv_bla_backbone_crc_get(struct batadv_bla_backbone_gw *backbone_gw)
+{
+	u16 crc;
+
+	spin_lock_bh(&backbone_gw->crc_lock);
+	crc = backbone_gw->crc;
+	spin_unlock_bh(&backbone_gw->crc_lock);
+
+	return crc;
+}
+
 /**
  * batadv_bla_send_claim - sends a claim frame according to the provided info
  * @bat_priv: the bat priv with all the soft interface information
@@ -613,21 +682,21 @@ static void batadv_bla_answer_request(struct batadv_priv *bat_priv,
 	if (!backbone_gw)
 		return;
 
-	hash = bat_priv->bla.claim_hash;
-	for (i = 0; i < hash->size; i++) {
+	rcu_read_lock();
+	hash = rcu_dereference(bat_priv->bla.claim_hash);
+	for (i = 0; hash && i < hash->size; i++) {
 		head = &hash->table[i];
 
-		rcu_read_lock();
 		hlist_for_each_entry_rcu(claim, head, hash_entry) {
 			/* only own claims are interesting */
-			if (claim->backbone_gw != backbone_gw)
+			if (READ_ONCE(claim->backbone_gw) != backbone_gw)
 				continue;
 
 			batadv_bla_send_claim(bat_priv, claim->addr, claim->vid,
 					      BATADV_CLAIM_TYPE_CLAIM);
 		}
-		rcu_read_unlock();
 	}
+	rcu_read_unlock();
 
 	/* finally, send an announcement frame */
 	batadv_bla_send_announce(bat_priv, backbone_gw);
@@ -673,9 +742,7 @@ static void batadv_bla_send_announce(struct batadv_priv *bat_priv,
 	__be16 crc;
 
 	memcpy(mac, batadv_announce_mac, 4);
-	spin_lock_bh(&backbone_gw->crc_lock);
-	crc = htons(backbone_gw->crc);
-	spin_unlock_bh(&backbone_gw->crc_lock);
+	crc = htons(batadv_bla_backbone_crc_get(backbone_gw));
 	memcpy(&mac[4], &crc, 2);
 
 	batadv_bla_send_claim(bat_priv, mac, backbone_gw->vid,
@@ -694,8 +761,10 @@ static void batadv_bla_add_claim(struct batadv_priv *bat_priv,
 				 struct batadv_bla_backbone_gw *backbone_gw)
 {
 	struct batadv_bla_backbone_gw *old_backbone_gw;
+	struct batadv_priv_bla *bla = &bat_priv->bla;
 	struct batadv_bla_claim *claim;
 	struct batadv_bla_claim search_claim;
+	struct batadv_hashtable *hash;
 	bool remove_crc = false;
 	int hash_added;
 
@@ -722,10 +791,15 @@ static void batadv_bla_add_claim(struct batadv_priv *bat_priv,
 			   mac, batadv_print_vid(vid));
 
 		kref_get(&claim->refcount);
-		hash_added = batadv_hash_add(bat_priv->bla.claim_hash,
-					     batadv_compare_claim,
+
+		read_lock_bh(&bla->claim_hash_lock);
+		hash = batadv_bla_claim_hash_protected(bla);
+		hash_added = batadv_hash_add(hash, batadv_compare_claim,
 					     batadv_choose_claim, claim,
 					     &claim->hash_entry);
+		if (hash_added == 0)
+			atomic_inc(&bla->num_claims);
+		read_unlock_bh(&bla->claim_hash_lock);
 
 		if (unlikely(hash_added != 0)) {
 			/* only local changes happened. */
@@ -749,7 +823,7 @@ static void batadv_bla_add_claim(struct batadv_priv *bat_priv,
 	spin_lock_bh(&claim->backbone_lock);
 	old_backbone_gw = claim->backbone_gw;
 	kref_get(&backbone_gw->refcount);
-	claim->backbone_gw = backbone_gw;
+	WRITE_ONCE(claim->backbone_gw, backbone_gw);
 	spin_unlock_bh(&claim->backbone_lock);
 
 	if (remove_crc) {
@@ -801,6 +875,8 @@ static void batadv_bla_del_claim(struct batadv_priv *bat_priv,
 				 const u8 *mac, const unsigned short vid)
 {
 	struct batadv_bla_claim search_claim, *claim;
+	struct batadv_priv_bla *bla = &bat_priv->bla;
+	struct batadv_hashtable *hash;
 
 	ether_addr_copy(search_claim.addr, mac);
 	search_claim.vid = vid;
@@ -811,9 +887,14 @@ static void batadv_bla_del_claim(struct batadv_priv *bat_priv,
 	batadv_dbg(BATADV_DBG_BLA, bat_priv, "bla_del_claim(): %pM, vid %d\n",
 		   mac, batadv_print_vid(vid));
 
-	batadv_hash_remove(bat_priv->bla.claim_hash, batadv_compare_claim,
-			   batadv_choose_claim, claim);
-	batadv_claim_put(claim); /* reference from the hash is gone */
+	read_lock_bh(&bla->claim_hash_lock);
+	hash = batadv_bla_claim_hash_protected(bla);
+	if (batadv_hash_remove(hash, batadv_compare_claim,
+			       batadv_choose_claim, claim)) {
+		atomic_dec(&bla->num_claims);
+		batadv_claim_put(claim); /* reference from the hash is gone */
+	}
+	read_unlock_bh(&bla->claim_hash_lock);
 
 	/* don't need the reference from hash_find() anymore */
 	batadv_claim_put(claim);
@@ -851,9 +932,7 @@ static bool batadv_handle_announce(struct batadv_priv *bat_priv, u8 *an_addr,
 		   "handle_announce(): ANNOUNCE vid %d (sent by %pM)... CRC = %#.4x\n",
 		   batadv_print_vid(vid), backbone_gw->orig, crc);
 
-	spin_lock_bh(&backbone_gw->crc_lock);
-	backbone_crc = backbone_gw->crc;
-	spin_unlock_bh(&backbone_gw->crc_lock);
+	backbone_crc = batadv_bla_backbone_crc_get(backbone_gw);
 
 	if (backbone_crc != crc) {
 		batadv_dbg(BATADV_DBG_BLA, backbone_gw->bat_priv,
@@ -1248,6 +1327,7 @@ purge_now:
 			batadv_bla_del_backbone_claims(backbone_gw);
 
 			hlist_del_rcu(&backbone_gw->hash_entry);
+			atomic_inc(&hash->generation);
 			batadv_backbone_gw_put(backbone_gw);
 		}
 		spin_unlock_bh(list_lock);
@@ -1273,14 +1353,14 @@ static void batadv_bla_purge_claims(struct batadv_priv *bat_priv,
 	struct batadv_hashtable *hash;
 	int i;
 
-	hash = bat_priv->bla.claim_hash;
+	rcu_read_lock();
+	hash = rcu_dereference(bat_priv->bla.claim_hash);
 	if (!hash)
-		return;
+		goto unlock;
 
 	for (i = 0; i < hash->size; i++) {
 		head = &hash->table[i];
 
-		rcu_read_lock();
 		hlist_for_each_entry_rcu(claim, head, hash_entry) {
 			backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
 			if (now)
@@ -1305,8 +1385,10 @@ purge_now:
 skip:
 			batadv_backbone_gw_put(backbone_gw);
 		}
-		rcu_read_unlock();
 	}
+
+unlock:
+	rcu_read_unlock();
 }
 
 /**
@@ -1405,6 +1487,106 @@ void batadv_bla_status_update(struct net_device *net_dev)
 	batadv_hardif_put(primary_if);
 }
 
+/* The hash for claim and backbone hash receive the same key because they
+ * are getting initialized by hash_new with the same key. Reinitializing
+ * them with to different keys to allow nested locking without generating
+ * lockdep warnings
+ */
+static struct lock_class_key batadv_claim_hash_lock_class_key;
+static struct lock_class_key batadv_backbone_hash_lock_class_key;
+
+/**
+ * batadv_bla_claim_hash_size - get the claim hash size fitting a claim count
+ * @num_claims: number of claims to be stored
+ *
+ * Return: smallest power of two bucket count keeping the load per bucket at or
+ *  below BATADV_BLA_CLAIM_HASH_LOAD
+ */
+static u32 batadv_bla_claim_hash_size(u32 num_claims)
+{
+	u32 size = BATADV_BLA_CLAIM_HASH_MIN;
+
+	while (size < BATADV_BLA_CLAIM_HASH_MAX &&
+	       num_claims > size * BATADV_BLA_CLAIM_HASH_LOAD)
+		size <<= 1;
+
+	return size;
+}
+
+/**
+ * batadv_bla_claim_hash_resize - adapt the claim hash to the number of claims
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * The claim hash grows as soon as the average bucket holds more than
+ * BATADV_BLA_CLAIM_HASH_LOAD claims and shrinks again once it holds less than
+ * one. All claims are relinked into the new table while the write side of
+ * bla.claim_hash_lock blocks claim writers; concurrent lookups notice the move
+ * via bla.claim_hash_seq and retry. The old table is freed after an RCU grace
+ * period.
+ *
+ * Must only be called from the bla worker, which is the only context
+ * replacing the claim hash.
+ */
+static void batadv_bla_claim_hash_resize(struct batadv_priv *bat_priv)
+{
+	struct batadv_priv_bla *bla = &bat_priv->bla;
+	struct batadv_hashtable *old_hash, *new_hash;
+	struct batadv_bla_claim *claim;
+	struct hlist_node *node_tmp;
+	u32 num_claims, size, index;
+	u32 i;
+
+	old_hash = rcu_dereference_protected(bla->claim_hash, true);
+	if (!old_hash)
+		return;
+
+	num_claims = atomic_read(&bla->num_claims);
+	size = batadv_bla_claim_hash_size(num_claims);
+
+	if (size == old_hash->size)
+		return;
+
+	/* only shrink once the table is clearly oversized */
+	if (size < old_hash->size && num_claims >= old_hash->size)
+		return;
+
+	new_hash = batadv_hash_new(size);
+	if (!new_hash)
+		return;
+
+	batadv_hash_set_lock_class(new_hash,
+				   &batadv_claim_hash_lock_class_key);
+
+	batadv_dbg(BATADV_DBG_BLA, bat_priv,
+		   "bla_claim_hash_resize(): %u claims, resizing from %u to %u buckets\n",
+		   num_claims, old_hash->size, size);
+
+	write_lock_bh(&bla->claim_hash_lock);
+	write_seqcount_begin(&bla->claim_hash_seq);
+
+	for (i = 0; i < old_hash->size; i++) {
+		hlist_for_each_entry_safe(claim, node_tmp, &old_hash->table[i],
+					  hash_entry) {
+			hlist_del_rcu(&claim->hash_entry);
+
+			index = batadv_choose_claim(claim, size);
+			hlist_add_head_rcu(&claim->hash_entry,
+					   &new_hash->table[index]);
+		}
+	}
+
+	/* the relinked claims must not look unchanged to running dumps */
+	atomic_set(&new_hash->generation,
+		   atomic_read(&old_hash->generation) + 1);
+	rcu_assign_pointer(bla->claim_hash, new_hash);
+
+	write_seqcount_end(&bla->claim_hash_seq);
+	write_unlock_bh(&bla->claim_hash_lock);
+
+	synchronize_rcu();
+	batadv_hash_destroy(old_hash);
+}
+
 /**
  * batadv_bla_periodic_work - performs periodic bla work
  * @work: kernel work struct
@@ -1434,6 +1616,7 @@ static void batadv_bla_periodic_work(struct work_struct *work)
 
 	batadv_bla_purge_claims(bat_priv, primary_if, 0);
 	batadv_bla_purge_backbone_gw(bat_priv, 0);
+	batadv_bla_claim_hash_resize(bat_priv);
 
 	if (!atomic_read(&bat_priv->bridge_loop_avoidance))
 		goto out;
@@ -1502,13 +1685,78 @@ out:
 			   msecs_to_jiffies(BATADV_BLA_PERIOD_LENGTH));
 }
 
-/* The hash for claim and backbone hash receive the same key because they
- * are getting initialized by hash_new with the same key. Reinitializing
- * them with to different keys to allow nested locking without generating
- * lockdep warnings
+/**
+ * batadv_bla_duplist_new - allocate a broadcast duplicate filter
+ * @size: requested number of slots, rounded up to a power of two
+ *
+ * Return: the new filter with all slots expired or NULL on error
  */
-static struct lock_class_key batadv_claim_hash_lock_class_key;
-static struct lock_class_key batadv_backbone_hash_lock_class_key;
+static struct batadv_bcast_duplist *batadv_bla_duplist_new(u32 size)
+{
+	struct batadv_bcast_duplist *duplist;
+	unsigned long entrytime;
+	u32 i;
+
+	size = roundup_pow_of_two(max_t(u32, size, BATADV_DUPLIST_WAYS));
+
+	duplist = kzalloc(sizeof(*duplist) + size * sizeof(duplist->entries[0]),
+			  GFP_KERNEL);
+	if (!duplist)
+		return NULL;
+
+	duplist->mask = size / BATADV_DUPLIST_WAYS - 1;
+
+	entrytime = jiffies - msecs_to_jiffies(BATADV_DUPLIST_TIMEOUT) - 1;
+	for (i = 0; i < size; i++) {
+		atomic64_set(&duplist->entries[i].key, 0);
+		duplist->entries[i].entrytime = entrytime;
+	}
+
+	return duplist;
+}
+
+/**
+ * batadv_bla_duplist_replace - exchange the broadcast duplicate filter
+ * @bat_priv: the bat priv with all the soft interface information
+ * @duplist: the new filter, may be NULL
+ *
+ * The old filter is freed after an RCU grace period.
+ */
+static void batadv_bla_duplist_replace(struct batadv_priv *bat_priv,
+				       struct batadv_bcast_duplist *duplist)
+{
+	struct batadv_bcast_duplist *old_duplist;
+	spinlock_t *lock = &bat_priv->bla.bcast_duplist_lock;
+
+	spin_lock_bh(lock);
+	old_duplist = rcu_dereference_protected(bat_priv->bla.bcast_duplist,
+						lockdep_is_held(lock));
+	rcu_assign_pointer(bat_priv->bla.bcast_duplist, duplist);
+	spin_unlock_bh(lock);
+
+	if (old_duplist)
+		kfree_rcu(old_duplist, rcu);
+}
+
+/**
+ * batadv_bla_duplist_update - resize the broadcast duplicate filter
+ * @net_dev: the soft interface net device
+ *
+ * Recently seen broadcasts are forgotten when the filter is resized.
+ */
+void batadv_bla_duplist_update(struct net_device *net_dev)
+{
+	struct batadv_priv *bat_priv = netdev_priv(net_dev);
+	struct batadv_bcast_duplist *duplist;
+	u32 size;
+
+	size = atomic_read(&bat_priv->bla_duplist_size);
+	duplist = batadv_bla_duplist_new(size);
+	if (!duplist)
+		return;
+
+	batadv_bla_duplist_replace(bat_priv, duplist);
+}
 
 /**
  * batadv_bla_init - initialize all bla structures
@@ -1518,13 +1766,17 @@ static struct lock_class_key batadv_backbone_hash_lock_class_key;
  */
 int batadv_bla_init(struct batadv_priv *bat_priv)
 {
-	int i;
 	u8 claim_dest[ETH_ALEN] = {0xff, 0x43, 0x05, 0x00, 0x00, 0x00};
+	struct batadv_bcast_duplist *duplist;
+	struct batadv_hashtable *claim_hash;
 	struct batadv_hard_iface *primary_if;
 	u16 crc;
-	unsigned long entrytime;
+	u32 size;
 
 	spin_lock_init(&bat_priv->bla.bcast_duplist_lock);
+	rwlock_init(&bat_priv->bla.claim_hash_lock);
+	seqcount_init(&bat_priv->bla.claim_hash_seq);
+	atomic_set(&bat_priv->bla.num_claims, 0);
 
 	batadv_dbg(BATADV_DBG_BLA, bat_priv, "bla hash registering\n");
 
@@ -1541,25 +1793,30 @@ int batadv_bla_init(struct batadv_priv *bat_priv)
 	}
 
 	/* initialize the duplicate list */
-	entrytime = jiffies - msecs_to_jiffies(BATADV_DUPLIST_TIMEOUT);
-	for (i = 0; i < BATADV_DUPLIST_SIZE; i++)
-		bat_priv->bla.bcast_duplist[i].entrytime = entrytime;
-	bat_priv->bla.bcast_duplist_curr = 0;
+	if (!rcu_access_pointer(bat_priv->bla.bcast_duplist)) {
+		size = atomic_read(&bat_priv->bla_duplist_size);
+		duplist = batadv_bla_duplist_new(size);
+		if (!duplist)
+			return -ENOMEM;
+
+		rcu_assign_pointer(bat_priv->bla.bcast_duplist, duplist);
+	}
 
 	atomic_set(&bat_priv->bla.loopdetect_next,
 		   BATADV_BLA_LOOPDETECT_PERIODS);
 
-	if (bat_priv->bla.claim_hash)
+	if (rcu_access_pointer(bat_priv->bla.claim_hash))
 		return 0;
 
-	bat_priv->bla.claim_hash = batadv_hash_new(128);
+	claim_hash = batadv_hash_new(BATADV_BLA_CLAIM_HASH_MIN);
 	bat_priv->bla.backbone_hash = batadv_hash_new(32);
 
-	if (!bat_priv->bla.claim_hash || !bat_priv->bla.backbone_hash)
+	if (!claim_hash || !bat_priv->bla.backbone_hash)
 		return -ENOMEM;
 
-	batadv_hash_set_lock_class(bat_priv->bla.claim_hash,
+	batadv_hash_set_lock_class(claim_hash,
 				   &batadv_claim_hash_lock_class_key);
+	rcu_assign_pointer(bat_priv->bla.claim_hash, claim_hash);
 	batadv_hash_set_lock_class(bat_priv->bla.backbone_hash,
 				   &batadv_backbone_hash_lock_class_key);
 
@@ -1572,6 +1829,33 @@ int batadv_bla_init(struct batadv_priv *bat_priv)
 	return 0;
 }
 
+/**
+ * batadv_bla_bcast_fingerprint - compute a fingerprint of a broadcast payload
+ * @skb: skb containing the broadcast packet
+ * @payload_ptr: pointer to the start of the payload inside the skb head
+ *
+ * Only the first BATADV_DUPLIST_FP_LEN bytes of the payload are hashed,
+ * seeded with the payload length. These cover the Ethernet, IP and transport
+ * headers, including the IP and UDP/TCP checksums over the rest of the frame.
+ *
+ * Return: fingerprint of the broadcast payload
+ */
+static u32 batadv_bla_bcast_fingerprint(struct sk_buff *skb, u8 *payload_ptr)
+{
+	u8 buf[BATADV_DUPLIST_FP_LEN];
+	unsigned int offset, len;
+	const void *data;
+
+	offset = (unsigned int)(payload_ptr - skb->data);
+	len = min_t(unsigned int, skb->len - offset, sizeof(buf));
+
+	data = skb_header_pointer(skb, offset, len, buf);
+	if (!data)
+		return 0;
+
+	return jhash(data, len, skb->len - offset);
+}
+
 /**
  * batadv_bla_check_bcast_duplist - Check if a frame is in the broadcast dup.
  * @bat_priv: the bat priv with all the soft interface information
@@ -1581,66 +1865,84 @@ int batadv_bla_init(struct batadv_priv *bat_priv)
  * have sent the same packet because it is connected to the same backbone,
  * so we have to remove this duplicate.
  *
- * This is performed by checking the CRC, which will tell us
- * with a good chance that it is the same packet. If it is furthermore
+ * This is performed by checking a fingerprint of the payload, which will tell
+ * us with a good chance that it is the same packet. If it is furthermore
  * sent by another host, drop it. We allow equal packets from
  * the same host however as this might be intended.
  *
+ * The fingerprint selects a bucket of BATADV_DUPLIST_WAYS timestamped slots.
+ * Slots are read and written without any lock; a lost race only lets a
+ * duplicate pass, the same as when its slot was already recycled.
+ *
  * Return: true if a packet is in the duplicate list, false otherwise.
  */
 bool batadv_bla_check_bcast_duplist(struct batadv_priv *bat_priv,
 				    struct sk_buff *skb)
 {
-	int i, curr;
-	__be32 crc;
+	struct batadv_bcast_duplist_entry *entry, *bucket, *victim;
 	struct batadv_bcast_packet *bcast_packet;
-	struct batadv_bcast_duplist_entry *entry;
+	struct batadv_bcast_duplist *duplist;
+	unsigned long entrytime, victim_time;
+	u32 fingerprint, orig_hash;
 	bool ret = false;
+	u64 key;
+	int i;
 
 	bcast_packet = (struct batadv_bcast_packet *)skb->data;
 
-	/* calculate the crc ... */
-	crc = batadv_skb_crc32(skb, (u8 *)(bcast_packet + 1));
+	/* calculate the fingerprint ... */
+	fingerprint = batadv_bla_bcast_fingerprint(skb,
+						   (u8 *)(bcast_packet + 1));
+	orig_hash = jhash(bcast_packet->orig, ETH_ALEN, 0);
 
-	spin_lock_bh(&bat_priv->bla.bcast_duplist_lock);
+	rcu_read_lock();
+	duplist = rcu_dereference(bat_priv->bla.bcast_duplist);
+	if (!duplist)
+		goto out;
 
-	for (i = 0; i < BATADV_DUPLIST_SIZE; i++) {
-		curr = (bat_priv->bla.bcast_duplist_curr + i);
-		curr %= BATADV_DUPLIST_SIZE;
-		entry = &bat_priv->bla.bcast_duplist[curr];
+	bucket = &duplist->entries[(fingerprint & duplist->mask) *
+				   BATADV_DUPLIST_WAYS];
+	victim = &bucket[0];
+	victim_time = READ_ONCE(victim->entrytime);
 
-		/* we can stop searching if the entry is too old ;
-		 * later entries will be even older
-		 */
-		if (batadv_has_timed_out(entry->entrytime,
-					 BATADV_DUPLIST_TIMEOUT))
-			break;
+	for (i = 0; i < BATADV_DUPLIST_WAYS; i++) {
+		entry = &bucket[i];
+		entrytime = READ_ONCE(entry->entrytime);
+
+		/* remember the oldest slot for a new entry */
+		if (time_before(entrytime, victim_time)) {
+			victim = entry;
+			victim_time = entrytime;
+		}
 
-		if (entry->crc != crc)
+		if (batadv_has_timed_out(entrytime, BATADV_DUPLIST_TIMEOUT))
 			continue;
 
-		if (batadv_compare_eth(entry->orig, bcast_packet->orig))
+		key = atomic64_read(&entry->key);
+		if ((u32)(key >> 32) != fingerprint)
 			continue;
 
-		/* this entry seems to match: same crc, not too old,
+		/* same fingerprint from the same host: refresh its slot */
+		if ((u32)key == orig_hash) {
+			victim = entry;
+			break;
+		}
+
+		/* this entry seems to match: same fingerprint, not too old,
 		 * and from another gw. therefore return true to forbid it.
 		 */
 		ret = true;
 		goto out;
 	}
-	/* not found, add a new entry (overwrite the oldest entry)
-	 * and allow it, its the first occurrence.
+
+	/* not found, add a new entry (overwrite the oldest entry of the
+	 * bucket) and allow it, its the first occurrence.
 	 */
-	curr = (bat_priv->bla.bcast_duplist_curr + BATADV_DUPLIST_SIZE - 1);
-	curr %= BATADV_DUPLIST_SIZE;
-	entry = &bat_priv->bla.bcast_duplist[curr];
-	entry->crc = crc;
-	entry->entrytime = jiffies;
-	ether_addr_copy(entry->orig, bcast_packet->orig);
-	bat_priv->bla.bcast_duplist_curr = curr;
+	atomic64_set(&victim->key, ((u64)fingerprint << 32) | orig_hash);
+	WRITE_ONCE(victim->entrytime, jiffies);
 
 out:
-	spin_unlock_bh(&bat_priv->bla.bcast_duplist_lock);
+	rcu_read_unlock();
 
 	return ret;
 }
@@ -1727,21 +2029,24 @@ bool batadv_bla_is_backbone_gw(struct sk_buff *skb,
  */
 void batadv_bla_free(struct batadv_priv *bat_priv)
 {
+	struct batadv_hashtable *claim_hash;
 	struct batadv_hard_iface *primary_if;
 
 	cancel_delayed_work_sync(&bat_priv->bla.work);
 	primary_if = batadv_primary_if_get_selected(bat_priv);
 
-	if (bat_priv->bla.claim_hash) {
+	claim_hash = rcu_dereference_protected(bat_priv->bla.claim_hash, true);
+	if (claim_hash) {
 		batadv_bla_purge_claims(bat_priv, primary_if, 1);
-		batadv_hash_destroy(bat_priv->bla.claim_hash);
-		bat_priv->bla.claim_hash = NULL;
+		RCU_INIT_POINTER(bat_priv->bla.claim_hash, NULL);
+		batadv_hash_destroy(claim_hash);
 	}
 	if (bat_priv->bla.backbone_hash) {
 		batadv_bla_purge_backbone_gw(bat_priv, 1);
 		batadv_hash_destroy(bat_priv->bla.backbone_hash);
 		bat_priv->bla.backbone_hash = NULL;
 	}
+	batadv_bla_duplist_replace(bat_priv, NULL);
 	if (primary_if)
 		batadv_hardif_put(primary_if);
 }
@@ -1816,9 +2121,9 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 {
 	struct batadv_bla_backbone_gw *backbone_gw;
 	struct ethhdr *ethhdr;
-	struct batadv_bla_claim search_claim, *claim = NULL;
+	struct batadv_bla_claim search_claim, *claim;
 	struct batadv_hard_iface *primary_if;
-	bool own_claim;
+	bool own_claim = false;
 	bool ret;
 
 	ethhdr = eth_hdr(skb);
@@ -1840,9 +2145,22 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 
 	ether_addr_copy(search_claim.addr, ethhdr->h_source);
 	search_claim.vid = vid;
-	claim = batadv_claim_hash_find(bat_priv, &search_claim);
 
-	if (!claim) {
+	/* the claim and its backbone_gw are only accessed under RCU here to
+	 * avoid refcount updates on every frame
+	 */
+	rcu_read_lock();
+	claim = batadv_claim_hash_find_rcu(bat_priv, &search_claim);
+	backbone_gw = claim ? READ_ONCE(claim->backbone_gw) : NULL;
+	if (backbone_gw) {
+		own_claim = batadv_compare_eth(backbone_gw->orig,
+					       primary_if->net_dev->dev_addr);
+		if (own_claim)
+			claim->lasttime = jiffies;
+	}
+	rcu_read_unlock();
+
+	if (!backbone_gw) {
 		/* possible optimization: race for a claim */
 		/* No claim exists yet, claim it for us!
 		 */
@@ -1853,14 +2171,8 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	}
 
 	/* if it is our own claim ... */
-	backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
-	own_claim = batadv_compare_eth(backbone_gw->orig,
-				       primary_if->net_dev->dev_addr);
-	batadv_backbone_gw_put(backbone_gw);
-
 	if (own_claim) {
 		/* ... allow it in any case */
-		claim->lasttime = jiffies;
 		goto allow;
 	}
 
@@ -1895,8 +2207,6 @@ handled:
 out:
 	if (primary_if)
 		batadv_hardif_put(primary_if);
-	if (claim)
-		batadv_claim_put(claim);
 	return ret;
 }
 
@@ -1921,7 +2231,7 @@ bool batadv_bla_tx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		   unsigned short vid)
 {
 	struct ethhdr *ethhdr;
-	struct batadv_bla_claim search_claim, *claim = NULL;
+	struct batadv_bla_claim search_claim, *claim;
 	struct batadv_bla_backbone_gw *backbone_gw;
 	struct batadv_hard_iface *primary_if;
 	bool client_roamed;
@@ -1947,18 +2257,22 @@ bool batadv_bla_tx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	ether_addr_copy(search_claim.addr, ethhdr->h_source);
 	search_claim.vid = vid;
 
-	claim = batadv_claim_hash_find(bat_priv, &search_claim);
+	/* the claim and its backbone_gw are only accessed under RCU here to
+	 * avoid refcount updates on every frame
+	 */
+	rcu_read_lock();
+	claim = batadv_claim_hash_find_rcu(bat_priv, &search_claim);
+	backbone_gw = claim ? READ_ONCE(claim->backbone_gw) : NULL;
+	client_roamed = backbone_gw &&
+			batadv_compare_eth(backbone_gw->orig,
+					   primary_if->net_dev->dev_addr);
+	rcu_read_unlock();
 
 	/* if no claim exists, allow it. */
-	if (!claim)
+	if (!backbone_gw)
 		goto allow;
 
 	/* check if we are responsible. */
-	backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
-	client_roamed = batadv_compare_eth(backbone_gw->orig,
-					   primary_if->net_dev->dev_addr);
-	batadv_backbone_gw_put(backbone_gw);
-
 	if (client_roamed) {
 		/* if yes, the client has roamed and we have
 		 * to unclaim it.
@@ -1990,8 +2304,6 @@ handled:
 out:
 	if (primary_if)
 		batadv_hardif_put(primary_if);
-	if (claim)
-		batadv_claim_put(claim);
 	return ret;
 }
 
@@ -2007,9 +2319,9 @@ int batadv_bla_claim_table_seq_print_text(struct seq_file *seq, void *offset)
 {
 	struct net_device *net_dev = (struct net_device *)seq->private;
 	struct batadv_priv *bat_priv = netdev_priv(net_dev);
-	struct batadv_hashtable *hash = bat_priv->bla.claim_hash;
 	struct batadv_bla_backbone_gw *backbone_gw;
 	struct batadv_bla_claim *claim;
+	struct batadv_hashtable *hash;
 	struct batadv_hard_iface *primary_if;
 	struct hlist_head *head;
 	u16 backbone_crc;
@@ -2028,29 +2340,29 @@ int batadv_bla_claim_table_seq_print_text(struct seq_file *seq, void *offset)
 		   ntohs(bat_priv->bla.claim_dest.group));
 	seq_puts(seq,
 		 "   Client               VID      Originator        [o] (CRC   )\n");
-	for (i = 0; i < hash->size; i++) {
+
+	rcu_read_lock();
+	hash = rcu_dereference(bat_priv->bla.claim_hash);
+	for (i = 0; hash && i < hash->size; i++) {
 		head = &hash->table[i];
 
-		rcu_read_lock();
 		hlist_for_each_entry_rcu(claim, head, hash_entry) {
-			backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
+			backbone_gw = READ_ONCE(claim->backbone_gw);
+			if (!backbone_gw)
+				continue;
 
 			is_own = batadv_compare_eth(backbone_gw->orig,
 						    primary_addr);
 
-			spin_lock_bh(&backbone_gw->crc_lock);
-			backbone_crc = backbone_gw->crc;
-			spin_unlock_bh(&backbone_gw->crc_lock);
+			backbone_crc = batadv_bla_backbone_crc_get(backbone_gw);
 			seq_printf(seq, " * %pM on %5d by %pM [%c] (%#.4x)\n",
 				   claim->addr, batadv_print_vid(claim->vid),
 				   backbone_gw->orig,
 				   (is_own ? 'x' : ' '),
 				   backbone_crc);
-
-			batadv_backbone_gw_put(backbone_gw);
 		}
-		rcu_read_unlock();
 	}
+	rcu_read_unlock();
 out:
 	if (primary_if)
 		batadv_hardif_put(primary_if);
@@ -2075,11 +2387,17 @@ batadv_bla_claim_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 			    struct batadv_bla_claim *claim)
 {
 	u8 *primary_addr = primary_if->net_dev->dev_addr;
+	struct batadv_bla_backbone_gw *backbone_gw;
 	u16 backbone_crc;
 	bool is_own;
 	void *hdr;
 	int ret = -EINVAL;
 
+	/* claim is already being released, nothing left to dump */
+	backbone_gw = READ_ONCE(claim->backbone_gw);
+	if (!backbone_gw)
+		return 0;
+
 	hdr = genlmsg_put(msg, portid, seq, &batadv_netlink_family,
 			  NLM_F_MULTI, BATADV_CMD_GET_BLA_CLAIM);
 	if (!hdr) {
@@ -2087,12 +2405,9 @@ batadv_bla_claim_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 		goto out;
 	}
 
-	is_own = batadv_compare_eth(claim->backbone_gw->orig,
-				    primary_addr);
+	is_own = batadv_compare_eth(backbone_gw->orig, primary_addr);
 
-	spin_lock_bh(&claim->backbone_gw->crc_lock);
-	backbone_crc = claim->backbone_gw->crc;
-	spin_unlock_bh(&claim->backbone_gw->crc_lock);
+	backbone_crc = batadv_bla_backbone_crc_get(backbone_gw);
 
 	if (is_own)
 		if (nla_put_flag(msg, BATADV_ATTR_BLA_OWN)) {
@@ -2103,7 +2418,7 @@ batadv_bla_claim_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 	if (nla_put(msg, BATADV_ATTR_BLA_ADDRESS, ETH_ALEN, claim->addr) ||
 	    nla_put_u16(msg, BATADV_ATTR_BLA_VID, claim->vid) ||
 	    nla_put(msg, BATADV_ATTR_BLA_BACKBONE, ETH_ALEN,
-		    claim->backbone_gw->orig) ||
+		    backbone_gw->orig) ||
 	    nla_put_u16(msg, BATADV_ATTR_BLA_CRC,
 			backbone_crc)) {
 		genlmsg_cancel(msg, hdr);
@@ -2187,7 +2502,6 @@ int batadv_bla_claim_dump(struct sk_buff *msg, struct netlink_callback *cb)
 	}
 
 	bat_priv = netdev_priv(soft_iface);
-	hash = bat_priv->bla.claim_hash;
 
 	primary_if = batadv_primary_if_get_selected(bat_priv);
 	if (!primary_if || primary_if->if_status != BATADV_IF_ACTIVE) {
@@ -2195,7 +2509,23 @@ int batadv_bla_claim_dump(struct sk_buff *msg, struct netlink_callback *cb)
 		goto out;
 	}
 
-	while (bucket < hash->size) {
+	rcu_read_lock();
+	hash = rcu_dereference(bat_priv->bla.claim_hash);
+	if (hash) {
+		cb->seq = batadv_hash_dump_seq(hash);
+
+		/* a resize moved all claims to other buckets, restart the
+		 * dump on the new table. The generation of the new table
+		 * differs, so the messages get flagged with NLM_F_DUMP_INTR
+		 */
+		if (cb->args[2] && cb->args[2] != hash->size) {
+			bucket = 0;
+			idx = 0;
+		}
+		cb->args[2] = hash->size;
+	}
+
+	while (hash && bucket < hash->size) {
 		head = &hash->table[bucket];
 
 		if (batadv_bla_claim_dump_bucket(msg, portid,
@@ -2204,6 +2534,7 @@ int batadv_bla_claim_dump(struct sk_buff *msg, struct netlink_callback *cb)
 			break;
 		bucket++;
 	}
+	rcu_read_unlock();
 
 	cb->args[0] = bucket;
 	cb->args[1] = idx;
@@ -2268,9 +2599,7 @@ int batadv_bla_backbone_table_seq_print_text(struct seq_file *seq, void *offset)
 			if (is_own)
 				continue;
 
-			spin_lock_bh(&backbone_gw->crc_lock);
-			backbone_crc = backbone_gw->crc;
-			spin_unlock_bh(&backbone_gw->crc_lock);
+			backbone_crc = batadv_bla_backbone_crc_get(backbone_gw);
 
 			seq_printf(seq, " * %pM on %5d %4i.%03is (%#.4x)\n",
 				   backbone_gw->orig,
@@ -2318,9 +2647,7 @@ batadv_bla_backbone_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 
 	is_own = batadv_compare_eth(backbone_gw->orig, primary_addr);
 
-	spin_lock_bh(&backbone_gw->crc_lock);
-	backbone_crc = backbone_gw->crc;
-	spin_unlock_bh(&backbone_gw->crc_lock);
+	backbone_crc = batadv_bla_backbone_crc_get(backbone_gw);
 
 	msecs = jiffies_to_msecs(jiffies - backbone_gw->lasttime);
 
@@ -2425,6 +2752,8 @@ int batadv_bla_backbone_dump(struct sk_buff *msg, struct netlink_callback *cb)
 		goto out;
 	}
 
+	cb->seq = batadv_hash_dump_seq(hash);
+
 	while (bucket < hash->size) {
 		head = &hash->table[bucket];
 
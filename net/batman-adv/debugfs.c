@@ -34,6 +34,7 @@
 #include <net/net_namespace.h>
 
 #include "bat_algo.h"
+#include "bench.h"
 #include "bridge_loop_avoidance.h"
 #include "distributed-arp-table.h"
 #include "gateway_client.h"
@@ -393,6 +394,9 @@ int batadv_debugfs_add_meshif(struct net_device *dev)
 	if (batadv_nc_init_debugfs(bat_priv) < 0)
 		goto rem_attr;
 
+	if (batadv_bench_init_debugfs(bat_priv) < 0)
+		goto rem_attr;
+
 	return 0;
 rem_attr:
 	debugfs_remove_recursive(bat_priv->debug_dir);
@@ -27,6 +27,9 @@
 #include "originator.h"
 #include "packet.h"
 
+struct batadv_netlink_filter;
+struct hlist_head;
+struct netlink_callback;
 struct seq_file;
 struct sk_buff;
 
@@ -80,6 +83,20 @@ batadv_dat_init_own_addr(struct batadv_priv *bat_priv,
 int batadv_dat_init(struct batadv_priv *bat_priv);
 void batadv_dat_free(struct batadv_priv *bat_priv);
 int batadv_dat_cache_seq_print_text(struct seq_file *seq, void *offset);
+int batadv_dat_cache_dump(struct sk_buff *msg, struct netlink_callback *cb);
+int
+batadv_dat_cache_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
+			     const struct batadv_netlink_filter *filter,
+			     struct hlist_head *head, int *idx_s);
+struct batadv_dat_entry *
+batadv_dat_entry_hash_find(struct batadv_priv *bat_priv, __be32 ip,
+			   unsigned short vid);
+void batadv_dat_entry_add(struct batadv_priv *bat_priv, __be32 ip,
+			  u8 *mac_addr, unsigned short vid);
+void batadv_dat_entry_put(struct batadv_dat_entry *dat_entry);
+bool batadv_dat_to_purge(struct batadv_dat_entry *dat_entry);
+void __batadv_dat_purge(struct batadv_priv *bat_priv,
+			bool (*to_purge)(struct batadv_dat_entry *));
 
 /**
  * batadv_dat_inc_counter - increment the correct DAT packet counter
@@ -173,6 +190,12 @@ static inline void batadv_dat_inc_counter(struct batadv_priv *bat_priv,
 {
 }
 
+static inline int
+batadv_dat_cache_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	return -EOPNOTSUPP;
+}
+
 #endif /* CONFIG_BATMAN_ADV_DAT */
 
 #endif /* _NET_BATMAN_ADV_DISTRIBUTED_ARP_TABLE_H_ */
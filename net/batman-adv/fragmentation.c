@@ -34,11 +34,13 @@
 #include <linux/string.h>
 
 #include "hard-interface.h"
+#include "latency.h"
 #include "originator.h"
 #include "packet.h"
 #include "routing.h"
 #include "send.h"
 #include "soft-interface.h"
+#include "trace.h"
 
 /**
  * batadv_frag_clear_chain - delete entries in the fragment buffer chain
@@ -186,6 +188,7 @@ static bool batadv_frag_insert_packet(struct batadv_orig_node *orig_node,
 		hlist_add_head(&frag_entry_new->list, &chain->fragment_list);
 		chain->size = skb->len - hdr_size;
 		chain->timestamp = jiffies;
+		chain->start_time = batadv_latency_start(orig_node->bat_priv);
 		chain->total_size = ntohs(frag_packet->total_size);
 		ret = true;
 		goto out;
@@ -233,6 +236,10 @@ out:
 		/* All fragments received. Hand over chain to caller. */
 		hlist_move_list(&chain->fragment_list, chain_out);
 		chain->size = 0;
+
+		batadv_latency_end(orig_node->bat_priv,
+				   BATADV_STATS_FRAG_REASSEMBLY,
+				   chain->start_time);
 	}
 
 err_unlock:
@@ -264,6 +271,10 @@ batadv_frag_merge_packets(struct hlist_head *chain)
 	struct sk_buff *skb_out;
 	int size, hdr_size = sizeof(struct batadv_frag_packet);
 	bool dropped = false;
+	u8 orig[ETH_ALEN] __aligned(2);
+	u8 num_frags = 1;
+	u16 total_size;
+	u16 seqno;
 
 	/* Remove first entry, as this is the destination for the rest of the
 	 * fragments.
@@ -276,6 +287,11 @@ batadv_frag_merge_packets(struct hlist_head *chain)
 	packet = (struct batadv_frag_packet *)skb_out->data;
 	size = ntohs(packet->total_size);
 
+	/* the header is gone once the fragments are merged */
+	ether_addr_copy(orig, packet->orig);
+	seqno = ntohs(packet->seqno);
+	total_size = size;
+
 	/* Make room for the rest of the fragments. */
 	if (pskb_expand_head(skb_out, 0, size - skb_out->len, GFP_ATOMIC) < 0) {
 		kfree_skb(skb_out);
@@ -298,9 +314,12 @@ batadv_frag_merge_packets(struct hlist_head *chain)
 		size = entry->skb->len - hdr_size;
 		memcpy(skb_put(skb_out, size), entry->skb->data + hdr_size,
 		       size);
+		num_frags++;
 	}
 
 free:
+	trace_batadv_frag_merge(orig, seqno, total_size, num_frags, !dropped);
+
 	/* Locking is not needed, because 'chain' is not part of any orig. */
 	batadv_frag_clear_chain(chain, dropped);
 	return skb_out;
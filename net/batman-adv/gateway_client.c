@@ -28,9 +28,12 @@
 #include <linux/in.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/jhash.h>
+#include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/list.h>
+#include <linux/lockdep.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/rculist.h>
@@ -82,6 +85,272 @@ static void batadv_gw_node_release(struct kref *ref)
 	kfree_rcu(gw_node, rcu);
 }
 
+/**
+ * batadv_gw_client_bucket - get the client hash bucket of a DHCP client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: MAC address of the DHCP client
+ *
+ * Return: the bucket of batadv_priv_gw::client_hash the client belongs to
+ */
+static struct hlist_head *
+batadv_gw_client_bucket(struct batadv_priv *bat_priv, const u8 *addr)
+{
+	u32 index = jhash(addr, ETH_ALEN, 0) % BATADV_GW_CLIENT_HASH_SIZE;
+
+	return &bat_priv->gw.client_hash[index];
+}
+
+/**
+ * batadv_gw_client_find - look up the gateway binding of a DHCP client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: MAC address of the DHCP client
+ *
+ * The caller must hold rcu_read_lock() or batadv_priv_gw::client_lock.
+ *
+ * Return: the binding of the client or NULL if it is not bound to a gateway
+ */
+static struct batadv_gw_client *
+batadv_gw_client_find(struct batadv_priv *bat_priv, const u8 *addr)
+{
+	struct hlist_head *head = batadv_gw_client_bucket(bat_priv, addr);
+	struct batadv_gw_client *client;
+
+	hlist_for_each_entry_rcu(client, head, hash_entry) {
+		if (batadv_compare_eth(client->addr, addr))
+			return client;
+	}
+
+	return NULL;
+}
+
+/**
+ * batadv_gw_client_get_gw - get the gateway a DHCP client is bound to
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: MAC address of the DHCP client
+ *
+ * The binding is refreshed, because this is only called for DHCP requests
+ * of the client.
+ *
+ * Return: the gateway of the client or NULL if the client is not bound or its
+ * gateway is not available anymore
+ */
+static struct batadv_gw_node *
+batadv_gw_client_get_gw(struct batadv_priv *bat_priv, const u8 *addr)
+{
+	struct batadv_orig_node *orig_node = NULL;
+	struct batadv_gw_client *client;
+	struct batadv_gw_node *gw_node;
+
+	rcu_read_lock();
+	client = batadv_gw_client_find(bat_priv, addr);
+	if (client) {
+		client->lasttime = jiffies;
+		orig_node = batadv_orig_hash_find(bat_priv, client->gw_addr);
+	}
+	rcu_read_unlock();
+
+	if (!orig_node)
+		return NULL;
+
+	gw_node = batadv_gw_node_get(bat_priv, orig_node);
+	batadv_orig_node_put(orig_node);
+
+	return gw_node;
+}
+
+/**
+ * batadv_gw_client_evict - forget the DHCP client which was silent the longest
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * The caller must hold batadv_priv_gw::client_lock.
+ */
+static void batadv_gw_client_evict(struct batadv_priv *bat_priv)
+{
+	struct batadv_gw_client *client, *oldest = NULL;
+	int i;
+
+	lockdep_assert_held(&bat_priv->gw.client_lock);
+
+	for (i = 0; i < BATADV_GW_CLIENT_HASH_SIZE; i++) {
+		hlist_for_each_entry(client, &bat_priv->gw.client_hash[i],
+				     hash_entry) {
+			if (!oldest ||
+			    time_before(client->lasttime, oldest->lasttime))
+				oldest = client;
+		}
+	}
+
+	if (!oldest)
+		return;
+
+	hlist_del_rcu(&oldest->hash_entry);
+	kfree_rcu(oldest, rcu);
+	bat_priv->gw.num_clients--;
+}
+
+/**
+ * batadv_gw_client_bind - bind a DHCP client to a gateway
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: MAC address of the DHCP client
+ * @gw_addr: originator address of the gateway serving the client
+ *
+ * If the table is full the client which was silent the longest is dropped to
+ * make room for the new one.
+ */
+static void batadv_gw_client_bind(struct batadv_priv *bat_priv,
+				  const u8 *addr, const u8 *gw_addr)
+{
+	struct batadv_gw_client *client, *old_client;
+
+	client = kzalloc(sizeof(*client), GFP_ATOMIC);
+	if (!client)
+		return;
+
+	ether_addr_copy(client->addr, addr);
+	ether_addr_copy(client->gw_addr, gw_addr);
+	client->lasttime = jiffies;
+
+	spin_lock_bh(&bat_priv->gw.client_lock);
+	old_client = batadv_gw_client_find(bat_priv, addr);
+	if (old_client) {
+		hlist_replace_rcu(&old_client->hash_entry, &client->hash_entry);
+		kfree_rcu(old_client, rcu);
+	} else {
+		if (bat_priv->gw.num_clients >= BATADV_GW_CLIENT_MAX)
+			batadv_gw_client_evict(bat_priv);
+
+		hlist_add_head_rcu(&client->hash_entry,
+				   batadv_gw_client_bucket(bat_priv, addr));
+		bat_priv->gw.num_clients++;
+	}
+	spin_unlock_bh(&bat_priv->gw.client_lock);
+}
+
+/**
+ * batadv_gw_client_purge - forget DHCP clients which were silent for too long
+ * @bat_priv: the bat priv with all the soft interface information
+ * @all: whether all client bindings shall be removed regardless of their age
+ */
+void batadv_gw_client_purge(struct batadv_priv *bat_priv, bool all)
+{
+	struct batadv_gw_client *client;
+	struct hlist_node *node_tmp;
+	int i;
+
+	spin_lock_bh(&bat_priv->gw.client_lock);
+	for (i = 0; i < BATADV_GW_CLIENT_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(client, node_tmp,
+					  &bat_priv->gw.client_hash[i],
+					  hash_entry) {
+			if (!all &&
+			    !batadv_has_timed_out(client->lasttime,
+						  BATADV_GW_CLIENT_TIMEOUT))
+				continue;
+
+			hlist_del_rcu(&client->hash_entry);
+			kfree_rcu(client, rcu);
+			bat_priv->gw.num_clients--;
+		}
+	}
+	spin_unlock_bh(&bat_priv->gw.client_lock);
+}
+
+/**
+ * batadv_gw_weighted_get - pick a gateway for a DHCP client by gateway weight
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: MAC address of the DHCP client
+ *
+ * The client address is mapped onto the sum of all gateway weights, so that
+ * each gateway gets a share of the clients proportional to its weight.
+ *
+ * Return: the chosen gateway or NULL if no gateway has a non-zero weight
+ */
+static struct batadv_gw_node *
+batadv_gw_weighted_get(struct batadv_priv *bat_priv, const u8 *addr)
+{
+	struct batadv_algo_gw_ops *ops = &bat_priv->algo_ops->gw;
+	struct batadv_gw_node *gw_node, *next_gw = NULL;
+	u64 total = 0, pos;
+	u32 weight;
+
+	if (!ops->get_weight)
+		return NULL;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(gw_node, &bat_priv->gw.gateway_list, list)
+		total += min_t(u32, ops->get_weight(bat_priv, gw_node),
+			       BATADV_GW_WEIGHT_MAX);
+
+	if (!total)
+		goto unlock;
+
+	pos = ((u64)jhash(addr, ETH_ALEN, 0) * total) >> 32;
+
+	hlist_for_each_entry_rcu(gw_node, &bat_priv->gw.gateway_list, list) {
+		weight = min_t(u32, ops->get_weight(bat_priv, gw_node),
+			       BATADV_GW_WEIGHT_MAX);
+		if (pos >= weight) {
+			pos -= weight;
+			continue;
+		}
+
+		if (kref_get_unless_zero(&gw_node->refcount))
+			next_gw = gw_node;
+		break;
+	}
+
+unlock:
+	rcu_read_unlock();
+
+	return next_gw;
+}
+
+/**
+ * batadv_gw_get_client_orig - get the gateway serving a DHCP client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @client_addr: MAC address of the DHCP client
+ *
+ * If gw_distribute is enabled each DHCP client is bound to one of the known
+ * gateways, picked with a probability proportional to the gateway weight
+ * (its advertised bandwidth scaled by the path quality towards it). A client
+ * sticks to its gateway as long as it keeps sending DHCP requests and the
+ * gateway stays available, so that renewals reach the server which handed
+ * out the lease. Otherwise the currently selected gateway is used.
+ *
+ * Return: the orig_node of the gateway or NULL if no gateway is available
+ */
+struct batadv_orig_node *
+batadv_gw_get_client_orig(struct batadv_priv *bat_priv, const u8 *client_addr)
+{
+	struct batadv_orig_node *orig_node;
+	struct batadv_gw_node *gw_node;
+
+	if (!atomic_read(&bat_priv->gw_distribute))
+		return batadv_gw_get_selected_orig(bat_priv);
+
+	/* keep the client on its gateway while it still offers its service */
+	gw_node = batadv_gw_client_get_gw(bat_priv, client_addr);
+	if (gw_node)
+		goto out;
+
+	gw_node = batadv_gw_weighted_get(bat_priv, client_addr);
+	if (!gw_node)
+		return batadv_gw_get_selected_orig(bat_priv);
+
+	batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
+		   "Binding DHCP client %pM to gateway %pM\n",
+		   client_addr, gw_node->orig_node->orig);
+
+	batadv_gw_client_bind(bat_priv, client_addr, gw_node->orig_node->orig);
+
+out:
+	orig_node = gw_node->orig_node;
+	kref_get(&orig_node->refcount);
+	batadv_gw_node_put(gw_node);
+
+	return orig_node;
+}
+
 /**
  * batadv_gw_node_put - decrement the gw_node refcounter and possibly release it
  * @gw_node: gateway node to free
@@ -139,6 +408,7 @@ static void batadv_gw_select(struct batadv_priv *bat_priv,
 			     struct batadv_gw_node *new_gw_node)
 {
 	struct batadv_gw_node *curr_gw_node;
+	bool changed;
 
 	spin_lock_bh(&bat_priv->gw.list_lock);
 
@@ -147,11 +417,18 @@ static void batadv_gw_select(struct batadv_priv *bat_priv,
 
 	curr_gw_node = rcu_dereference_protected(bat_priv->gw.curr_gw, 1);
 	rcu_assign_pointer(bat_priv->gw.curr_gw, new_gw_node);
+	changed = curr_gw_node != new_gw_node;
 
 	if (curr_gw_node)
 		batadv_gw_node_put(curr_gw_node);
 
 	spin_unlock_bh(&bat_priv->gw.list_lock);
+
+	if (!changed)
+		return;
+
+	batadv_netlink_gw_notify(bat_priv, new_gw_node ?
+				 new_gw_node->orig_node->orig : NULL);
 }
 
 /**
@@ -481,6 +758,8 @@ void batadv_gw_node_free(struct batadv_priv *bat_priv)
 		batadv_gw_node_put(gw_node);
 	}
 	spin_unlock_bh(&bat_priv->gw.list_lock);
+
+	batadv_gw_client_purge(bat_priv, true);
 }
 
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
@@ -692,7 +971,8 @@ batadv_gw_dhcp_recipient_get(struct sk_buff *skb, unsigned int *header_len,
  *
  * Check if the skb is a DHCP request and if it is sent to the current best GW
  * server. Due to topology changes it may be the case that the GW server
- * previously selected is not the best one anymore.
+ * previously selected is not the best one anymore. If gw_distribute is enabled
+ * the gateway the DHCP client is bound to is used instead of the selected one.
  *
  * This call might reallocate skb data.
  * Must be invoked only when the DHCP packet is going TO a DHCP SERVER.
@@ -733,7 +1013,11 @@ bool batadv_gw_out_of_range(struct batadv_priv *bat_priv,
 		curr_tq_avg = BATADV_TQ_MAX_VALUE;
 		break;
 	case BATADV_GW_MODE_CLIENT:
-		curr_gw = batadv_gw_get_selected_gw_node(bat_priv);
+		if (atomic_read(&bat_priv->gw_distribute))
+			curr_gw = batadv_gw_client_get_gw(bat_priv,
+							  ethhdr->h_source);
+		if (!curr_gw)
+			curr_gw = batadv_gw_get_selected_gw_node(bat_priv);
 		if (!curr_gw)
 			goto out;
 
@@ -32,6 +32,9 @@ void batadv_gw_reselect(struct batadv_priv *bat_priv);
 void batadv_gw_election(struct batadv_priv *bat_priv);
 struct batadv_orig_node *
 batadv_gw_get_selected_orig(struct batadv_priv *bat_priv);
+struct batadv_orig_node *
+batadv_gw_get_client_orig(struct batadv_priv *bat_priv, const u8 *client_addr);
+void batadv_gw_client_purge(struct batadv_priv *bat_priv, bool all);
 void batadv_gw_check_election(struct batadv_priv *bat_priv,
 			      struct batadv_orig_node *orig_node);
 void batadv_gw_node_update(struct batadv_priv *bat_priv,
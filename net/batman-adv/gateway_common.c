@@ -253,14 +253,23 @@ static void batadv_gw_tvlv_ogm_handler_v1(struct batadv_priv *bat_priv,
  */
 void batadv_gw_init(struct batadv_priv *bat_priv)
 {
+	int i;
+
+	for (i = 0; i < BATADV_GW_CLIENT_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&bat_priv->gw.client_hash[i]);
+
 	if (bat_priv->algo_ops->gw.init_sel_class)
 		bat_priv->algo_ops->gw.init_sel_class(bat_priv);
 	else
 		atomic_set(&bat_priv->gw.sel_class, 1);
 
+	/* the gateway election depends on the path quality, which can change
+	 * with every ogm even if the announced bandwidth stays the same
+	 */
 	batadv_tvlv_handler_register(bat_priv, batadv_gw_tvlv_ogm_handler_v1,
 				     NULL, BATADV_TVLV_GW, 1,
-				     BATADV_TVLV_HANDLER_OGM_CIFNOTFND);
+				     BATADV_TVLV_HANDLER_OGM_CIFNOTFND |
+				     BATADV_TVLV_HANDLER_OGM_REPEAT);
 }
 
 /**
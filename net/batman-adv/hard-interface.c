@@ -30,20 +30,25 @@
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
 #include <linux/printk.h>
+#include <linux/rcupdate.h>
 #include <linux/rculist.h>
 #include <linux/rtnetlink.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <net/net_namespace.h>
 #include <net/rtnetlink.h>
+#include <uapi/linux/batman_adv.h>
 
 #include "bat_v.h"
+#include "bench.h"
 #include "bridge_loop_avoidance.h"
 #include "debugfs.h"
 #include "distributed-arp-table.h"
 #include "gateway_client.h"
 #include "log.h"
+#include "multicast.h"
 #include "originator.h"
 #include "packet.h"
 #include "send.h"
@@ -51,6 +56,19 @@
 #include "sysfs.h"
 #include "translation-table.h"
 
+/**
+ * batadv_hardif_free_rcu - free the hard interface and its counters
+ * @rcu: rcu pointer of the hard interface
+ */
+static void batadv_hardif_free_rcu(struct rcu_head *rcu)
+{
+	struct batadv_hard_iface *hard_iface;
+
+	hard_iface = container_of(rcu, struct batadv_hard_iface, rcu);
+	free_percpu(hard_iface->counters);
+	kfree(hard_iface);
+}
+
 /**
  * batadv_hardif_release - release hard interface from lists and queue for
  *  free after rcu grace period
@@ -63,7 +81,82 @@ void batadv_hardif_release(struct kref *ref)
 	hard_iface = container_of(ref, struct batadv_hard_iface, refcount);
 	dev_put(hard_iface->net_dev);
 
-	kfree_rcu(hard_iface, rcu);
+	call_rcu(&hard_iface->rcu, batadv_hardif_free_rcu);
+}
+
+/**
+ * batadv_hardif_count_ctrl - account a control plane packet of a hard
+ *  interface
+ * @hard_iface: the hard interface the packet was sent or received on
+ * @packet_type: batman-adv packet type of the packet
+ * @len: length of the packet including the ethernet header
+ * @tx: whether the packet was sent (true) or received (false)
+ *
+ * Packets which are not part of the control plane are ignored.
+ */
+void batadv_hardif_count_ctrl(struct batadv_hard_iface *hard_iface,
+			      u8 packet_type, unsigned int len, bool tx)
+{
+	size_t cnt, cnt_bytes;
+
+	switch (packet_type) {
+	case BATADV_ELP:
+		cnt = tx ? BATADV_HARDIF_CNT_ELP_TX : BATADV_HARDIF_CNT_ELP_RX;
+		cnt_bytes = tx ? BATADV_HARDIF_CNT_ELP_TX_BYTES :
+				 BATADV_HARDIF_CNT_ELP_RX_BYTES;
+		break;
+	case BATADV_IV_OGM:
+		cnt = tx ? BATADV_HARDIF_CNT_OGM_TX : BATADV_HARDIF_CNT_OGM_RX;
+		cnt_bytes = tx ? BATADV_HARDIF_CNT_OGM_TX_BYTES :
+				 BATADV_HARDIF_CNT_OGM_RX_BYTES;
+		break;
+	case BATADV_OGM2:
+		cnt = tx ? BATADV_HARDIF_CNT_OGM2_TX :
+			   BATADV_HARDIF_CNT_OGM2_RX;
+		cnt_bytes = tx ? BATADV_HARDIF_CNT_OGM2_TX_BYTES :
+				 BATADV_HARDIF_CNT_OGM2_RX_BYTES;
+
+		/* every OGM2 carries the public key and its signature */
+		batadv_hardif_add_counter(hard_iface,
+					  tx ? BATADV_HARDIF_CNT_SIG_TX_BYTES :
+					       BATADV_HARDIF_CNT_SIG_RX_BYTES,
+					  sizeof(ed25519_public_key) +
+					  sizeof(ed25519_signature));
+		break;
+	case BATADV_UNICAST_TVLV:
+		cnt = tx ? BATADV_HARDIF_CNT_TVLV_TX :
+			   BATADV_HARDIF_CNT_TVLV_RX;
+		cnt_bytes = tx ? BATADV_HARDIF_CNT_TVLV_TX_BYTES :
+				 BATADV_HARDIF_CNT_TVLV_RX_BYTES;
+		break;
+	default:
+		return;
+	}
+
+	batadv_hardif_inc_counter(hard_iface, cnt);
+	batadv_hardif_add_counter(hard_iface, cnt_bytes, len);
+}
+
+/**
+ * batadv_hardif_sum_counter - sum up the cpu local values of a control plane
+ *  counter of a hard interface
+ * @hard_iface: the hard interface to read the counter of
+ * @idx: the counter to sum up (see batadv_hardif_counter)
+ *
+ * Return: sum of all cpu local counters
+ */
+u64 batadv_hardif_sum_counter(struct batadv_hard_iface *hard_iface,
+			      size_t idx)
+{
+	u64 *counters, sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		counters = per_cpu_ptr(hard_iface->counters, cpu);
+		sum += counters[idx];
+	}
+
+	return sum;
 }
 
 struct batadv_hard_iface *
@@ -726,6 +819,13 @@ int batadv_hardif_enable_interface(struct batadv_hard_iface *hard_iface,
 		goto err_dev;
 	}
 
+	if (batadv_bench_running(netdev_priv(soft_iface))) {
+		pr_err("Can't add interface to batman mesh interface %s: table benchmark in progress\n",
+		       soft_iface->name);
+		ret = -EBUSY;
+		goto err_dev;
+	}
+
 	/* check if the interface is enslaved in another virtual one and
 	 * in that case unlink it first
 	 */
@@ -876,9 +976,15 @@ batadv_hardif_add_interface(struct net_device *net_dev)
 	if (!hard_iface)
 		goto release_dev;
 
+	hard_iface->counters = __alloc_percpu(sizeof(u64) *
+					      NUM_BATADV_HARDIF_CNT,
+					      __alignof__(u64));
+	if (!hard_iface->counters)
+		goto free_if;
+
 	ret = batadv_sysfs_add_hardif(&hard_iface->hardif_obj, net_dev);
 	if (ret)
-		goto free_if;
+		goto free_counters;
 
 	hard_iface->if_num = -1;
 	hard_iface->net_dev = net_dev;
@@ -910,6 +1016,8 @@ batadv_hardif_add_interface(struct net_device *net_dev)
 
 free_sysfs:
 	batadv_sysfs_del_hardif(&hard_iface->hardif_obj);
+free_counters:
+	free_percpu(hard_iface->counters);
 free_if:
 	kfree(hard_iface);
 release_dev:
@@ -964,6 +1072,13 @@ static int batadv_hard_if_event(struct notifier_block *this,
 		return NOTIFY_DONE;
 	}
 
+	/* a bridge on top of the soft interface was added or removed */
+	if (batadv_softif_is_valid(net_dev) && event == NETDEV_CHANGEUPPER) {
+		bat_priv = netdev_priv(net_dev);
+		batadv_mcast_mla_update_trigger(bat_priv);
+		return NOTIFY_DONE;
+	}
+
 	hard_iface = batadv_hardif_get_by_netdev(net_dev);
 	if (!hard_iface && (event == NETDEV_REGISTER ||
 			    event == NETDEV_POST_TYPE_CHANGE))
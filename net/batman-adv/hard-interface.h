@@ -23,6 +23,7 @@
 #include <linux/compiler.h>
 #include <linux/kref.h>
 #include <linux/notifier.h>
+#include <linux/percpu.h>
 #include <linux/rcupdate.h>
 #include <linux/stddef.h>
 #include <linux/types.h>
@@ -80,6 +81,10 @@ void batadv_update_min_mtu(struct net_device *soft_iface);
 void batadv_hardif_release(struct kref *ref);
 int batadv_hardif_no_broadcast(struct batadv_hard_iface *if_outgoing,
 			       u8 *orig_addr, u8 *orig_neigh);
+void batadv_hardif_count_ctrl(struct batadv_hard_iface *hard_iface,
+			      u8 packet_type, unsigned int len, bool tx);
+u64 batadv_hardif_sum_counter(struct batadv_hard_iface *hard_iface,
+			      size_t idx);
 
 /**
  * batadv_hardif_put - decrement the hard interface refcounter and possibly
@@ -91,6 +96,22 @@ static inline void batadv_hardif_put(struct batadv_hard_iface *hard_iface)
 	kref_put(&hard_iface->refcount, batadv_hardif_release);
 }
 
+/**
+ * batadv_hardif_add_counter - add to a control plane counter of a hard
+ *  interface
+ * @hard_iface: the hard interface the traffic was seen on
+ * @idx: the counter to increase (see batadv_hardif_counter)
+ * @count: value to add
+ */
+static inline void
+batadv_hardif_add_counter(struct batadv_hard_iface *hard_iface, size_t idx,
+			  size_t count)
+{
+	this_cpu_add(hard_iface->counters[idx], count);
+}
+
+#define batadv_hardif_inc_counter(h, i) batadv_hardif_add_counter(h, i, 1)
+
 static inline struct batadv_hard_iface *
 batadv_primary_if_get_selected(struct batadv_priv *bat_priv)
 {
@@ -60,6 +60,7 @@ struct batadv_hashtable *batadv_hash_new(u32 size)
 		goto free_table;
 
 	hash->size = size;
+	atomic_set(&hash->generation, 0);
 	batadv_hash_init(hash);
 	return hash;
 
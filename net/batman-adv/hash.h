@@ -20,6 +20,7 @@
 
 #include "main.h"
 
+#include <linux/atomic.h>
 #include <linux/compiler.h>
 #include <linux/list.h>
 #include <linux/rculist.h>
@@ -49,6 +50,7 @@ struct batadv_hashtable {
 	struct hlist_head *table;   /* the hashtable itself with the buckets */
 	spinlock_t *list_locks;     /* spinlock for each hash list entry */
 	u32 size;		    /* size of hashtable */
+	atomic_t generation;	    /* changes on every add/remove */
 };
 
 /* allocates and clears the hash */
@@ -103,6 +105,7 @@ static inline int batadv_hash_add(struct batadv_hashtable *hash,
 
 	/* no duplicate found in list, add new element */
 	hlist_add_head_rcu(data_node, head);
+	atomic_inc(&hash->generation);
 
 	ret = 0;
 
@@ -138,6 +141,7 @@ static inline void *batadv_hash_remove(struct batadv_hashtable *hash,
 
 		data_save = node;
 		hlist_del_rcu(node);
+		atomic_inc(&hash->generation);
 		break;
 	}
 	spin_unlock_bh(&hash->list_locks[index]);
@@ -145,4 +149,18 @@ static inline void *batadv_hash_remove(struct batadv_hashtable *hash,
 	return data_save;
 }
 
+/**
+ * batadv_hash_dump_seq - get the netlink dump sequence of a hash table
+ * @hash: the hash table being dumped
+ *
+ * Dumps store this value in cb->seq so that netlink can flag (and the
+ * snapshot mode can retry) dumps which raced with additions or removals.
+ *
+ * Return: a non-zero value which changes whenever the members of @hash change
+ */
+static inline unsigned int batadv_hash_dump_seq(struct batadv_hashtable *hash)
+{
+	return atomic_read(&hash->generation) << 1 | 1;
+}
+
 #endif /* _NET_BATMAN_ADV_HASH_H_ */
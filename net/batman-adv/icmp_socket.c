@@ -28,8 +28,9 @@
 #include <linux/fs.h>
 #include <linux/if_ether.h>
 #include <linux/kernel.h>
-#include <linux/list.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/netdevice.h>
 #include <linux/pkt_sched.h>
 #include <linux/poll.h>
@@ -41,6 +42,8 @@
 #include <linux/stddef.h>
 #include <linux/string.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
 #include <linux/wait.h>
 
 #include "hard-interface.h"
@@ -49,6 +52,9 @@
 #include "packet.h"
 #include "send.h"
 
+/* distance between two packet slots of a socket client ring */
+#define BATADV_ICMP_SLOT_SIZE ALIGN(sizeof(struct batadv_icmp_ring_slot), 8)
+
 static struct batadv_socket_client *batadv_socket_client_hash[256];
 
 static void batadv_socket_add_packet(struct batadv_socket_client *socket_client,
@@ -60,10 +66,60 @@ void batadv_socket_init(void)
 	memset(batadv_socket_client_hash, 0, sizeof(batadv_socket_client_hash));
 }
 
+/**
+ * batadv_socket_slot - get the ring slot of a packet counter value
+ * @socket_client: the socket client owning the ring
+ * @n: value of the head or tail counter
+ *
+ * Return: the packet slot the counter value refers to
+ */
+static struct batadv_icmp_ring_slot *
+batadv_socket_slot(struct batadv_socket_client *socket_client, u32 n)
+{
+	u8 *slots = (u8 *)socket_client->ring + PAGE_SIZE;
+
+	n &= BATADV_ICMP_RING_SLOTS - 1;
+
+	return (struct batadv_icmp_ring_slot *)(slots +
+						n * BATADV_ICMP_SLOT_SIZE);
+}
+
+/**
+ * batadv_socket_queued - get the number of packets waiting in the ring
+ * @socket_client: the socket client owning the ring
+ *
+ * Return: the number of packets not consumed yet. A tail corrupted by
+ * userspace is treated as a full ring
+ */
+static u32 batadv_socket_queued(struct batadv_socket_client *socket_client)
+{
+	u32 head = smp_load_acquire(&socket_client->head);
+	u32 queued = head - READ_ONCE(socket_client->ring->tail);
+
+	return min_t(u32, queued, BATADV_ICMP_RING_SLOTS);
+}
+
+/**
+ * batadv_socket_ready - check whether a waiting reader has to be woken up
+ * @socket_client: the socket client owning the ring
+ *
+ * Return: true if the number of queued packets reached the watermark
+ */
+static bool batadv_socket_ready(struct batadv_socket_client *socket_client)
+{
+	u32 watermark = READ_ONCE(socket_client->ring->watermark);
+
+	watermark = clamp_t(u32, watermark, 1, BATADV_ICMP_RING_SLOTS);
+
+	return batadv_socket_queued(socket_client) >= watermark;
+}
+
 static int batadv_socket_open(struct inode *inode, struct file *file)
 {
 	unsigned int i;
 	struct batadv_socket_client *socket_client;
+	struct batadv_icmp_ring *ring;
+	size_t ring_size;
 
 	if (!try_module_get(THIS_MODULE))
 		return -EBUSY;
@@ -76,7 +132,22 @@ static int batadv_socket_open(struct inode *inode, struct file *file)
 		return -ENOMEM;
 	}
 
+	ring_size = PAGE_SIZE + BATADV_ICMP_RING_SLOTS * BATADV_ICMP_SLOT_SIZE;
+	ring = vmalloc_user(ring_size);
+	if (!ring) {
+		kfree(socket_client);
+		module_put(THIS_MODULE);
+		return -ENOMEM;
+	}
+
+	ring->watermark = 1;
+	ring->slot_num = BATADV_ICMP_RING_SLOTS;
+	ring->slot_size = BATADV_ICMP_SLOT_SIZE;
+
 	for (i = 0; i < ARRAY_SIZE(batadv_socket_client_hash); i++) {
+		if (i == BATADV_PING_UID)
+			continue;
+
 		if (!batadv_socket_client_hash[i]) {
 			batadv_socket_client_hash[i] = socket_client;
 			break;
@@ -85,16 +156,18 @@ static int batadv_socket_open(struct inode *inode, struct file *file)
 
 	if (i == ARRAY_SIZE(batadv_socket_client_hash)) {
 		pr_err("Error - can't add another packet client: maximum number of clients reached\n");
+		vfree(ring);
 		kfree(socket_client);
 		module_put(THIS_MODULE);
 		return -EXFULL;
 	}
 
-	INIT_LIST_HEAD(&socket_client->queue_list);
-	socket_client->queue_len = 0;
+	socket_client->ring = ring;
+	socket_client->head = 0;
 	socket_client->index = i;
 	socket_client->bat_priv = inode->i_private;
 	spin_lock_init(&socket_client->lock);
+	mutex_init(&socket_client->read_lock);
 	init_waitqueue_head(&socket_client->queue_wait);
 
 	file->private_data = socket_client;
@@ -105,66 +178,86 @@ static int batadv_socket_open(struct inode *inode, struct file *file)
 static int batadv_socket_release(struct inode *inode, struct file *file)
 {
 	struct batadv_socket_client *client = file->private_data;
-	struct batadv_socket_packet *packet, *tmp;
 
 	spin_lock_bh(&client->lock);
-
-	/* for all packets in the queue ... */
-	list_for_each_entry_safe(packet, tmp, &client->queue_list, list) {
-		list_del(&packet->list);
-		kfree(packet);
-	}
-
 	batadv_socket_client_hash[client->index] = NULL;
 	spin_unlock_bh(&client->lock);
 
+	vfree(client->ring);
 	kfree(client);
 	module_put(THIS_MODULE);
 
 	return 0;
 }
 
-static ssize_t batadv_socket_read(struct file *file, char __user *buf,
-				  size_t count, loff_t *ppos)
+/**
+ * batadv_socket_read_iter - read queued icmp packets from the ring
+ * @iocb: the kernel io control block of the read request
+ * @to: the destination buffers
+ *
+ * Every segment of @to receives a single packet, truncated to the segment
+ * size. A plain read() therefore returns one packet while readv() fetches a
+ * batch of packets with a single system call.
+ *
+ * Return: number of bytes copied or error code
+ */
+static ssize_t batadv_socket_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
-	struct batadv_socket_client *socket_client = file->private_data;
-	struct batadv_socket_packet *socket_packet;
-	size_t packet_len;
+	struct file *file = iocb->ki_filp;
+	struct batadv_socket_client *client = file->private_data;
+	struct batadv_icmp_ring *ring = client->ring;
+	struct batadv_icmp_ring_slot *slot;
+	size_t seg_len, packet_len;
+	ssize_t copied = 0;
+	u32 head, tail;
 	int error;
 
-	if ((file->f_flags & O_NONBLOCK) && (socket_client->queue_len == 0))
-		return -EAGAIN;
-
-	if ((!buf) || (count < sizeof(struct batadv_icmp_packet)))
+	if (iov_iter_single_seg_count(to) < sizeof(struct batadv_icmp_packet))
 		return -EINVAL;
 
-	if (!access_ok(VERIFY_WRITE, buf, count))
-		return -EFAULT;
+	if (file->f_flags & O_NONBLOCK) {
+		if (!batadv_socket_queued(client))
+			return -EAGAIN;
+	} else {
+		error = wait_event_interruptible(client->queue_wait,
+						 batadv_socket_ready(client));
+		if (error)
+			return error;
+	}
 
-	error = wait_event_interruptible(socket_client->queue_wait,
-					 socket_client->queue_len);
+	mutex_lock(&client->read_lock);
 
-	if (error)
-		return error;
+	head = smp_load_acquire(&client->head);
+	tail = head - batadv_socket_queued(client);
 
-	spin_lock_bh(&socket_client->lock);
+	while (tail != head) {
+		seg_len = iov_iter_single_seg_count(to);
+		if (!seg_len)
+			break;
 
-	socket_packet = list_first_entry(&socket_client->queue_list,
-					 struct batadv_socket_packet, list);
-	list_del(&socket_packet->list);
-	socket_client->queue_len--;
+		slot = batadv_socket_slot(client, tail);
+		packet_len = min_t(size_t, READ_ONCE(slot->len),
+				   sizeof(slot->packet));
+		packet_len = min(packet_len, seg_len);
 
-	spin_unlock_bh(&socket_client->lock);
+		if (copy_to_iter(slot->packet, packet_len, to) != packet_len) {
+			if (!copied)
+				copied = -EFAULT;
+			break;
+		}
 
-	packet_len = min(count, socket_packet->icmp_len);
-	error = copy_to_user(buf, &socket_packet->icmp_packet, packet_len);
+		/* the rest of the segment is left untouched */
+		iov_iter_advance(to, seg_len - packet_len);
+		copied += packet_len;
+		tail++;
+	}
 
-	kfree(socket_packet);
+	/* the slots may only be reused after the packets were copied */
+	smp_store_release(&ring->tail, tail);
 
-	if (error)
-		return -EFAULT;
+	mutex_unlock(&client->read_lock);
 
-	return packet_len;
+	return copied;
 }
 
 static ssize_t batadv_socket_write(struct file *file, const char __user *buff,
@@ -298,19 +391,34 @@ static unsigned int batadv_socket_poll(struct file *file, poll_table *wait)
 
 	poll_wait(file, &socket_client->queue_wait, wait);
 
-	if (socket_client->queue_len > 0)
+	if (batadv_socket_ready(socket_client))
 		return POLLIN | POLLRDNORM;
 
 	return 0;
 }
 
+/**
+ * batadv_socket_mmap - map the packet ring into the address space of a client
+ * @file: the icmp socket file
+ * @vma: the memory area the ring is mapped to
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+static int batadv_socket_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct batadv_socket_client *socket_client = file->private_data;
+
+	return remap_vmalloc_range(vma, socket_client->ring, vma->vm_pgoff);
+}
+
 static const struct file_operations batadv_fops = {
 	.owner = THIS_MODULE,
 	.open = batadv_socket_open,
 	.release = batadv_socket_release,
-	.read = batadv_socket_read,
+	.read_iter = batadv_socket_read_iter,
 	.write = batadv_socket_write,
 	.poll = batadv_socket_poll,
+	.mmap = batadv_socket_mmap,
 	.llseek = no_llseek,
 };
 
@@ -338,28 +446,21 @@ err:
  * @socket_client: the socket this packet belongs to
  * @icmph: pointer to the header of the icmp packet
  * @icmp_len: total length of the icmp packet
+ *
+ * The packet is dropped when the ring of the socket client is full. Waiting
+ * readers are only woken up when the number of queued packets reached the
+ * watermark of the ring.
  */
 static void batadv_socket_add_packet(struct batadv_socket_client *socket_client,
 				     struct batadv_icmp_header *icmph,
 				     size_t icmp_len)
 {
-	struct batadv_socket_packet *socket_packet;
+	struct batadv_icmp_ring *ring = socket_client->ring;
+	struct batadv_icmp_ring_slot *slot;
+	u32 head, queued, watermark;
+	bool wake;
 	size_t len;
 
-	socket_packet = kmalloc(sizeof(*socket_packet), GFP_ATOMIC);
-
-	if (!socket_packet)
-		return;
-
-	len = icmp_len;
-	/* check the maximum length before filling the buffer */
-	if (len > sizeof(socket_packet->icmp_packet))
-		len = sizeof(socket_packet->icmp_packet);
-
-	INIT_LIST_HEAD(&socket_packet->list);
-	memcpy(&socket_packet->icmp_packet, icmph, len);
-	socket_packet->icmp_len = len;
-
 	spin_lock_bh(&socket_client->lock);
 
 	/* while waiting for the lock the socket_client could have been
@@ -367,26 +468,35 @@ static void batadv_socket_add_packet(struct batadv_socket_client *socket_client,
 	 */
 	if (!batadv_socket_client_hash[icmph->uid]) {
 		spin_unlock_bh(&socket_client->lock);
-		kfree(socket_packet);
 		return;
 	}
 
-	list_add_tail(&socket_packet->list, &socket_client->queue_list);
-	socket_client->queue_len++;
+	/* pairs with the release of the tail after the packets were copied */
+	head = socket_client->head;
+	queued = head - smp_load_acquire(&ring->tail);
+	if (queued >= BATADV_ICMP_RING_SLOTS) {
+		WRITE_ONCE(ring->dropped, ring->dropped + 1);
+		spin_unlock_bh(&socket_client->lock);
+		return;
+	}
+
+	len = min_t(size_t, icmp_len, sizeof(slot->packet));
+	slot = batadv_socket_slot(socket_client, head);
+	memcpy(slot->packet, icmph, len);
+	slot->len = len;
 
-	if (socket_client->queue_len > 100) {
-		socket_packet = list_first_entry(&socket_client->queue_list,
-						 struct batadv_socket_packet,
-						 list);
+	head++;
+	smp_store_release(&socket_client->head, head);
+	smp_store_release(&ring->head, head);
 
-		list_del(&socket_packet->list);
-		kfree(socket_packet);
-		socket_client->queue_len--;
-	}
+	watermark = READ_ONCE(ring->watermark);
+	watermark = clamp_t(u32, watermark, 1, BATADV_ICMP_RING_SLOTS);
+	wake = queued + 1 >= watermark;
 
 	spin_unlock_bh(&socket_client->lock);
 
-	wake_up(&socket_client->queue_wait);
+	if (wake && wq_has_sleeper(&socket_client->queue_wait))
+		wake_up(&socket_client->queue_wait);
 }
 
 /**
@@ -0,0 +1,124 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency.h"
+#include "main.h"
+
+#include <linux/atomic.h>
+#include <linux/cpumask.h>
+#include <linux/errno.h>
+#include <linux/percpu.h>
+#include <linux/skbuff.h>
+#include <linux/string.h>
+#include <net/netlink.h>
+#include <uapi/linux/batman_adv.h>
+
+/**
+ * batadv_latency_init - allocate the per-CPU latency histograms
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+int batadv_latency_init(struct batadv_priv *bat_priv)
+{
+	size_t len = sizeof(struct batadv_latency_hist) * NUM_BATADV_STATS;
+
+	bat_priv->latency = __alloc_percpu(len, __alignof__(u64));
+	if (!bat_priv->latency)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/**
+ * batadv_latency_free - free the per-CPU latency histograms
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+void batadv_latency_free(struct batadv_priv *bat_priv)
+{
+	free_percpu(bat_priv->latency);
+	bat_priv->latency = NULL;
+}
+
+/**
+ * batadv_latency_sum - sum up the per-CPU histograms of a stage
+ * @bat_priv: the bat priv with all the soft interface information
+ * @stage: the stage to sum up
+ * @hist: buffer to store the summed up histogram in
+ */
+static void batadv_latency_sum(struct batadv_priv *bat_priv,
+			       enum batadv_stats_stage stage,
+			       struct batadv_latency_hist *hist)
+{
+	const struct batadv_latency_hist *cpu_hist;
+	int cpu, i;
+
+	memset(hist, 0, sizeof(*hist));
+
+	for_each_possible_cpu(cpu) {
+		cpu_hist = per_cpu_ptr(bat_priv->latency, cpu) + stage;
+
+		hist->count += cpu_hist->count;
+		hist->sum += cpu_hist->sum;
+
+		for (i = 0; i < BATADV_LATENCY_BUCKETS; i++)
+			hist->buckets[i] += cpu_hist->buckets[i];
+	}
+}
+
+/**
+ * batadv_latency_put - fill the latency histograms into a netlink message
+ * @msg: netlink message to be sent back
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: 0 on success, < 0 on error
+ */
+int batadv_latency_put(struct sk_buff *msg, struct batadv_priv *bat_priv)
+{
+	struct batadv_latency_hist hist;
+	struct nlattr *stages, *entry;
+	int stage;
+
+	if (atomic_read(&bat_priv->latency_stats) &&
+	    nla_put_flag(msg, BATADV_ATTR_STATS_ENABLED))
+		return -EMSGSIZE;
+
+	stages = nla_nest_start(msg, BATADV_ATTR_STATS_STAGES);
+	if (!stages)
+		return -EMSGSIZE;
+
+	for (stage = 0; stage < NUM_BATADV_STATS; stage++) {
+		batadv_latency_sum(bat_priv, stage, &hist);
+
+		entry = nla_nest_start(msg, BATADV_ATTR_STATS_STAGE);
+		if (!entry)
+			return -EMSGSIZE;
+
+		if (nla_put_u8(msg, BATADV_ATTR_STATS_STAGE_ID, stage) ||
+		    nla_put_u64_64bit(msg, BATADV_ATTR_STATS_COUNT, hist.count,
+				      BATADV_ATTR_PAD) ||
+		    nla_put_u64_64bit(msg, BATADV_ATTR_STATS_SUM, hist.sum,
+				      BATADV_ATTR_PAD) ||
+		    nla_put(msg, BATADV_ATTR_STATS_HIST, sizeof(hist.buckets),
+			    hist.buckets))
+			return -EMSGSIZE;
+
+		nla_nest_end(msg, entry);
+	}
+
+	nla_nest_end(msg, stages);
+
+	return 0;
+}
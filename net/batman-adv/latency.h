@@ -0,0 +1,141 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NET_BATMAN_ADV_LATENCY_H_
+#define _NET_BATMAN_ADV_LATENCY_H_
+
+#include "main.h"
+
+#include <linux/atomic.h>
+#include <linux/bitops.h>
+#include <linux/compiler.h>
+#include <linux/jiffies.h>
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/time.h>
+#include <linux/timekeeping.h>
+#include <linux/timex.h>
+#include <linux/types.h>
+#include <uapi/linux/batman_adv.h>
+
+struct sk_buff;
+
+int batadv_latency_init(struct batadv_priv *bat_priv);
+void batadv_latency_free(struct batadv_priv *bat_priv);
+int batadv_latency_put(struct sk_buff *msg, struct batadv_priv *bat_priv);
+
+/**
+ * batadv_latency_add - account a latency sample of a stage
+ * @bat_priv: the bat priv with all the soft interface information
+ * @stage: the stage the sample belongs to
+ * @nsecs: the measured latency in nsecs
+ */
+static inline void batadv_latency_add(struct batadv_priv *bat_priv,
+				      enum batadv_stats_stage stage, u64 nsecs)
+{
+	unsigned int bucket = nsecs ? fls64(nsecs) - 1 : 0;
+
+	bucket = min_t(unsigned int, bucket, BATADV_LATENCY_BUCKETS - 1);
+
+	this_cpu_inc(bat_priv->latency[stage].count);
+	this_cpu_add(bat_priv->latency[stage].sum, nsecs);
+	this_cpu_inc(bat_priv->latency[stage].buckets[bucket]);
+}
+
+/**
+ * batadv_latency_start - get the start timestamp of a measurement
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: current monotonic time in nsecs or 0 if the latency statistics are
+ * disabled
+ */
+static inline u64 batadv_latency_start(struct batadv_priv *bat_priv)
+{
+	if (likely(!atomic_read(&bat_priv->latency_stats)))
+		return 0;
+
+	return ktime_get_ns();
+}
+
+/**
+ * batadv_latency_end - account the time since the start of a measurement
+ * @bat_priv: the bat priv with all the soft interface information
+ * @stage: the stage which was measured
+ * @start: timestamp returned by batadv_latency_start()
+ */
+static inline void batadv_latency_end(struct batadv_priv *bat_priv,
+				      enum batadv_stats_stage stage, u64 start)
+{
+	if (likely(!start))
+		return;
+
+	batadv_latency_add(bat_priv, stage, ktime_get_ns() - start);
+}
+
+/**
+ * batadv_latency_cycles_start - get the start cycle count of a measurement
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: current CPU cycle counter or 0 if the latency statistics are
+ * disabled. Architectures without a cycle counter always return 0.
+ */
+static inline cycles_t batadv_latency_cycles_start(struct batadv_priv *bat_priv)
+{
+	if (likely(!atomic_read(&bat_priv->latency_stats)))
+		return 0;
+
+	return get_cycles();
+}
+
+/**
+ * batadv_latency_cycles_end - account the CPU cycles since the start of a
+ *  measurement
+ * @bat_priv: the bat priv with all the soft interface information
+ * @stage: the stage which was measured
+ * @start: cycle count returned by batadv_latency_cycles_start()
+ */
+static inline void batadv_latency_cycles_end(struct batadv_priv *bat_priv,
+					     enum batadv_stats_stage stage,
+					     cycles_t start)
+{
+	if (likely(!start))
+		return;
+
+	batadv_latency_add(bat_priv, stage, get_cycles() - start);
+}
+
+/**
+ * batadv_latency_end_jiffies - account the time since a jiffies timestamp
+ * @bat_priv: the bat priv with all the soft interface information
+ * @stage: the stage which was measured
+ * @start: jiffies at the start of the stage
+ *
+ * Used for stages whose start is already tracked in jiffies; the samples
+ * only have a resolution of one jiffy.
+ */
+static inline void batadv_latency_end_jiffies(struct batadv_priv *bat_priv,
+					      enum batadv_stats_stage stage,
+					      unsigned long start)
+{
+	u64 nsecs;
+
+	if (likely(!atomic_read(&bat_priv->latency_stats)))
+		return;
+
+	nsecs = (u64)jiffies_to_usecs(jiffies - start) * NSEC_PER_USEC;
+	batadv_latency_add(bat_priv, stage, nsecs);
+}
+
+#endif /* _NET_BATMAN_ADV_LATENCY_H_ */
@@ -19,82 +19,506 @@
 #include "main.h"
 
 #include <linux/compiler.h>
+#include <linux/cpumask.h>
+#include <linux/ctype.h>
 #include <linux/debugfs.h>
 #include <linux/errno.h>
 #include <linux/export.h>
 #include <linux/fcntl.h>
 #include <linux/fs.h>
+#include <linux/if_ether.h>
+#include <linux/irqflags.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 #include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/poll.h>
 #include <linux/sched.h> /* for linux/wait.h */
 #include <linux/slab.h>
-#include <linux/spinlock.h>
 #include <linux/stddef.h>
+#include <linux/string.h>
+#include <linux/topology.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
 #include <linux/wait.h>
 #include <stdarg.h>
 
-#define BATADV_LOG_BUFF_MASK (batadv_log_buff_len - 1)
+/* maximum space a single record may occupy in a ring */
+#define BATADV_LOG_REC_MAX 512
+/* records are kept 8 byte aligned inside the ring */
+#define BATADV_LOG_REC_ALIGN 8
+/* maximum length of a conversion specification including '%' and '\0' */
+#define BATADV_LOG_SPEC_LEN 16
+
+static unsigned int batadv_log_ring_size = BATADV_LOG_BUF_LEN;
+module_param_named(log_ring_size, batadv_log_ring_size, uint, 0644);
+MODULE_PARM_DESC(log_ring_size,
+		 "Size of each per-CPU debug log ring in bytes");
+
+/**
+ * enum batadv_log_rec_type - type of a record stored in a debug log ring
+ * @BATADV_LOG_REC_PAD: unused space up to the end of the ring buffer
+ * @BATADV_LOG_REC_BIN: format string pointer followed by the binary arguments
+ * @BATADV_LOG_REC_TEXT: message already formatted when it was logged
+ */
+enum batadv_log_rec_type {
+	BATADV_LOG_REC_PAD,
+	BATADV_LOG_REC_BIN,
+	BATADV_LOG_REC_TEXT,
+};
+
+/**
+ * struct batadv_log_rec - header of a record stored in a debug log ring
+ * @len: length of the record including header and padding
+ * @type: type of the record (see enum batadv_log_rec_type)
+ * @reserved: reserved for future use
+ * @msecs: jiffies (in ms) at the time the record was written
+ * @time: monotonic timestamp used to merge the per-CPU rings
+ * @fmt: format string the binary arguments are decoded with
+ */
+struct batadv_log_rec {
+	u16 len;
+	u8 type;
+	u8 reserved;
+	u32 msecs;
+	u64 time;
+	const char *fmt;
+};
 
-static const int batadv_log_buff_len = BATADV_LOG_BUF_LEN;
+/**
+ * enum batadv_log_arg - binary representation of a format argument
+ * @BATADV_LOG_ARG_INVALID: argument cannot be stored in binary form
+ * @BATADV_LOG_ARG_INT: integer or character, stored as u64
+ * @BATADV_LOG_ARG_PTR: pointer value which is not dereferenced, stored as u64
+ * @BATADV_LOG_ARG_STR: NUL terminated string, copied inline
+ * @BATADV_LOG_ARG_BYTES: fixed length object (MAC/IP address), copied inline
+ */
+enum batadv_log_arg {
+	BATADV_LOG_ARG_INVALID,
+	BATADV_LOG_ARG_INT,
+	BATADV_LOG_ARG_PTR,
+	BATADV_LOG_ARG_STR,
+	BATADV_LOG_ARG_BYTES,
+};
 
-static char *batadv_log_char_addr(struct batadv_priv_debug_log *debug_log,
-				  size_t idx)
+/**
+ * struct batadv_log_spec - parsed printf conversion specification
+ * @arg: binary representation of the argument
+ * @arg_len: length of the inline copy for BATADV_LOG_ARG_BYTES
+ * @qualifier: length qualifier ('H' for hh, 'L' for ll) or 0
+ * @is_signed: whether an integer argument is signed
+ */
+struct batadv_log_spec {
+	enum batadv_log_arg arg;
+	size_t arg_len;
+	char qualifier;
+	bool is_signed;
+};
+
+/**
+ * batadv_log_parse_spec - parse a single printf conversion specification
+ * @fmt: format string pointing behind the '%' character
+ * @spec: buffer to store the parsed specification in
+ *
+ * Return: length of the specification without the leading '%' or 0 if it
+ * cannot be stored in binary form
+ */
+static size_t batadv_log_parse_spec(const char *fmt,
+				    struct batadv_log_spec *spec)
 {
-	return &debug_log->log_buff[idx & BATADV_LOG_BUFF_MASK];
+	const char *p = fmt;
+	char conv;
+
+	spec->arg = BATADV_LOG_ARG_INVALID;
+	spec->qualifier = 0;
+	spec->is_signed = false;
+
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		p++;
+		while (isdigit(*p))
+			p++;
+	}
+
+	switch (*p) {
+	case 'h':
+	case 'l':
+		spec->qualifier = *p++;
+		if (*p == spec->qualifier) {
+			spec->qualifier = toupper(*p);
+			p++;
+		}
+		break;
+	case 'z':
+	case 't':
+		spec->qualifier = *p++;
+		break;
+	}
+
+	conv = *p;
+	if (!conv)
+		return 0;
+	p++;
+
+	switch (conv) {
+	case 'd':
+	case 'i':
+	case 'c':
+		spec->is_signed = true;
+		/* fall through */
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+		spec->arg = BATADV_LOG_ARG_INT;
+		break;
+	case 's':
+		if (!spec->qualifier)
+			spec->arg = BATADV_LOG_ARG_STR;
+		break;
+	case 'p':
+		if (spec->qualifier)
+			break;
+
+		if (*p == 'M' || *p == 'm') {
+			spec->arg = BATADV_LOG_ARG_BYTES;
+			spec->arg_len = ETH_ALEN;
+		} else if ((*p == 'I' || *p == 'i') && p[1] == '4') {
+			spec->arg = BATADV_LOG_ARG_BYTES;
+			spec->arg_len = 4;
+		} else if ((*p == 'I' || *p == 'i') && p[1] == '6') {
+			spec->arg = BATADV_LOG_ARG_BYTES;
+			spec->arg_len = 16;
+		} else if (!isalnum(*p) || *p == 'K' || *p == 'x') {
+			/* only the pointer value itself is printed */
+			spec->arg = BATADV_LOG_ARG_PTR;
+		}
+
+		/* vsprintf consumes all alphanumeric extension characters */
+		while (isalnum(*p))
+			p++;
+		break;
+	}
+
+	if (spec->arg == BATADV_LOG_ARG_INVALID)
+		return 0;
+
+	if (p - fmt + 2 > BATADV_LOG_SPEC_LEN)
+		return 0;
+
+	return p - fmt;
 }
 
-static void batadv_emit_log_char(struct batadv_priv_debug_log *debug_log,
-				 char c)
+/**
+ * batadv_log_encode - store the arguments of a log message in binary form
+ * @buf: buffer to store the arguments in
+ * @size: size of @buf
+ * @fmt: format string of the log message
+ * @args: arguments of the log message
+ *
+ * Return: number of bytes written to @buf or a negative error code if the
+ * message has to be stored as formatted text instead
+ */
+static int batadv_log_encode(u8 *buf, size_t size, const char *fmt,
+			     va_list args)
 {
-	char *char_addr;
+	struct batadv_log_spec spec;
+	size_t pos = 0;
+	const void *ptr;
+	size_t len;
+	u64 val;
+
+	while (*fmt) {
+		if (*fmt++ != '%')
+			continue;
+
+		if (*fmt == '%') {
+			fmt++;
+			continue;
+		}
+
+		len = batadv_log_parse_spec(fmt, &spec);
+		if (!len)
+			return -EINVAL;
+		fmt += len;
+
+		switch (spec.arg) {
+		case BATADV_LOG_ARG_INT:
+			switch (spec.qualifier) {
+			case 'L':
+				val = va_arg(args, long long);
+				break;
+			case 'l':
+				val = va_arg(args, long);
+				break;
+			case 'z':
+				val = va_arg(args, size_t);
+				break;
+			case 't':
+				val = va_arg(args, ptrdiff_t);
+				break;
+			default:
+				if (spec.is_signed)
+					val = va_arg(args, int);
+				else
+					val = va_arg(args, unsigned int);
+				break;
+			}
+
+			ptr = &val;
+			len = sizeof(val);
+			break;
+		case BATADV_LOG_ARG_PTR:
+			val = (unsigned long)va_arg(args, void *);
+			ptr = &val;
+			len = sizeof(val);
+			break;
+		case BATADV_LOG_ARG_STR:
+			ptr = va_arg(args, const char *);
+			if (!ptr || pos >= size)
+				return -EINVAL;
+
+			len = strnlen(ptr, size - pos) + 1;
+			break;
+		case BATADV_LOG_ARG_BYTES:
+			ptr = va_arg(args, const void *);
+			if (!ptr)
+				return -EINVAL;
+
+			len = spec.arg_len;
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		if (pos + len > size)
+			return -ENOSPC;
+
+		memcpy(buf + pos, ptr, len);
+		pos += len;
+	}
 
-	char_addr = batadv_log_char_addr(debug_log, debug_log->log_end);
-	*char_addr = c;
-	debug_log->log_end++;
+	return pos;
+}
 
-	if (debug_log->log_end - debug_log->log_start > batadv_log_buff_len)
-		debug_log->log_start = debug_log->log_end - batadv_log_buff_len;
+/**
+ * batadv_log_print_int - print an integer argument of a binary record
+ * @buf: buffer to print into
+ * @size: size of @buf
+ * @spec_fmt: conversion specification (including '%')
+ * @spec: parsed conversion specification
+ * @val: stored integer value
+ *
+ * Return: number of characters written to @buf
+ */
+static int batadv_log_print_int(char *buf, size_t size, const char *spec_fmt,
+				const struct batadv_log_spec *spec, u64 val)
+{
+	switch (spec->qualifier) {
+	case 'L':
+		return scnprintf(buf, size, spec_fmt, (long long)val);
+	case 'l':
+	case 'z':
+	case 't':
+		return scnprintf(buf, size, spec_fmt, (long)val);
+	default:
+		return scnprintf(buf, size, spec_fmt, (int)val);
+	}
 }
 
-__printf(2, 3)
-static int batadv_fdebug_log(struct batadv_priv_debug_log *debug_log,
-			     const char *fmt, ...)
+/**
+ * batadv_log_decode - format a binary record
+ * @buf: buffer to write the formatted message to
+ * @size: size of @buf
+ * @fmt: format string of the record
+ * @data: binary arguments of the record
+ *
+ * Return: number of characters written to @buf (without the trailing '\0')
+ */
+static size_t batadv_log_decode(char *buf, size_t size, const char *fmt,
+				const u8 *data)
 {
-	va_list args;
-	static char debug_log_buf[256];
-	char *p;
+	char spec_fmt[BATADV_LOG_SPEC_LEN];
+	struct batadv_log_spec spec;
+	size_t pos = 0;
+	size_t len;
+	u64 val;
 
-	if (!debug_log)
+	if (!size)
 		return 0;
 
-	spin_lock_bh(&debug_log->lock);
-	va_start(args, fmt);
-	vscnprintf(debug_log_buf, sizeof(debug_log_buf), fmt, args);
-	va_end(args);
+	while (*fmt && pos + 1 < size) {
+		if (*fmt != '%') {
+			buf[pos++] = *fmt++;
+			continue;
+		}
+
+		if (fmt[1] == '%') {
+			buf[pos++] = '%';
+			fmt += 2;
+			continue;
+		}
+
+		fmt++;
+		len = batadv_log_parse_spec(fmt, &spec);
+		spec_fmt[0] = '%';
+		memcpy(spec_fmt + 1, fmt, len);
+		spec_fmt[len + 1] = '\0';
+		fmt += len;
+
+		switch (spec.arg) {
+		case BATADV_LOG_ARG_INT:
+			memcpy(&val, data, sizeof(val));
+			data += sizeof(val);
+			pos += batadv_log_print_int(buf + pos, size - pos,
+						    spec_fmt, &spec, val);
+			break;
+		case BATADV_LOG_ARG_PTR:
+			memcpy(&val, data, sizeof(val));
+			data += sizeof(val);
+			pos += scnprintf(buf + pos, size - pos, spec_fmt,
+					 (void *)(unsigned long)val);
+			break;
+		case BATADV_LOG_ARG_STR:
+			pos += scnprintf(buf + pos, size - pos, spec_fmt,
+					 (const char *)data);
+			data += strlen((const char *)data) + 1;
+			break;
+		case BATADV_LOG_ARG_BYTES:
+			pos += scnprintf(buf + pos, size - pos, spec_fmt, data);
+			data += spec.arg_len;
+			break;
+		default:
+			/* cannot happen: the record was encoded successfully */
+			return pos;
+		}
+	}
+
+	buf[pos] = '\0';
+	return pos;
+}
+
+/**
+ * batadv_log_reserve - reserve space for a new record in the local ring
+ * @debug_log: debug log the ring belongs to
+ * @ring: ring of the current CPU
+ *
+ * Has to be called with interrupts disabled. If the record would not fit
+ * contiguously at the end of the buffer, the remaining space is covered by a
+ * padding record and the new record starts at the beginning of the buffer.
+ *
+ * Return: pointer to BATADV_LOG_REC_MAX bytes of space for the new record or
+ * NULL if the ring is full
+ */
+static struct batadv_log_rec *
+batadv_log_reserve(struct batadv_priv_debug_log *debug_log,
+		   struct batadv_log_ring *ring)
+{
+	unsigned long size = debug_log->size;
+	unsigned long tail = smp_load_acquire(&ring->tail);
+	unsigned long head = ring->head;
+	unsigned long offset = head & (size - 1);
+	struct batadv_log_rec *rec;
+	unsigned long pad = 0;
+
+	if (offset + BATADV_LOG_REC_MAX > size)
+		pad = size - offset;
+
+	if (head + pad + BATADV_LOG_REC_MAX - tail > size) {
+		WRITE_ONCE(ring->dropped, ring->dropped + 1);
+		return NULL;
+	}
 
-	for (p = debug_log_buf; *p != 0; p++)
-		batadv_emit_log_char(debug_log, *p);
+	if (pad) {
+		rec = (struct batadv_log_rec *)(ring->buff + offset);
+		rec->len = pad;
+		rec->type = BATADV_LOG_REC_PAD;
 
-	spin_unlock_bh(&debug_log->lock);
+		/* publish the padding right away, the record comes later */
+		smp_store_release(&ring->head, head + pad);
+		offset = 0;
+	}
 
-	wake_up(&debug_log->queue_wait);
+	return (struct batadv_log_rec *)(ring->buff + offset);
+}
 
-	return 0;
+/**
+ * batadv_log_vwrite - append a log message to the ring of the current CPU
+ * @debug_log: debug log to write to
+ * @fmt: format string of the message
+ * @args: arguments of the message
+ *
+ * Messages are stored as format string pointer plus binary arguments and only
+ * formatted when the log is read. Arguments which cannot be stored that way
+ * (e.g. pointer extensions dereferencing arbitrary objects) make the message
+ * fall back to a text record formatted right away.
+ */
+static void batadv_log_vwrite(struct batadv_priv_debug_log *debug_log,
+			      const char *fmt, va_list args)
+{
+	struct batadv_log_ring *ring;
+	struct batadv_log_rec *rec;
+	unsigned long flags;
+	va_list args_bin;
+	int len;
+
+	BUILD_BUG_ON(BATADV_LOG_REC_MAX > U16_MAX);
+	BUILD_BUG_ON(BATADV_LOG_REC_MAX > BATADV_LOG_BUF_LEN_MIN);
+	BUILD_BUG_ON(sizeof(struct batadv_log_rec) + BATADV_LOG_LINE_LEN >
+		     BATADV_LOG_REC_MAX);
+
+	if (!debug_log)
+		return;
+
+	local_irq_save(flags);
+
+	ring = this_cpu_ptr(debug_log->rings);
+	rec = batadv_log_reserve(debug_log, ring);
+	if (!rec) {
+		local_irq_restore(flags);
+		return;
+	}
+
+	va_copy(args_bin, args);
+	len = batadv_log_encode((u8 *)(rec + 1),
+				BATADV_LOG_REC_MAX - sizeof(*rec), fmt,
+				args_bin);
+	va_end(args_bin);
+
+	if (len >= 0) {
+		rec->type = BATADV_LOG_REC_BIN;
+	} else {
+		rec->type = BATADV_LOG_REC_TEXT;
+		len = vscnprintf((char *)(rec + 1), BATADV_LOG_LINE_LEN, fmt,
+				 args) + 1;
+	}
+
+	rec->len = ALIGN(sizeof(*rec) + len, BATADV_LOG_REC_ALIGN);
+	rec->msecs = jiffies_to_msecs(jiffies);
+	rec->time = ktime_get_mono_fast_ns();
+	rec->fmt = fmt;
+
+	smp_store_release(&ring->head, ring->head + rec->len);
+
+	local_irq_restore(flags);
+
+	if (wq_has_sleeper(&debug_log->queue_wait))
+		wake_up(&debug_log->queue_wait);
 }
 
 int batadv_debug_log(struct batadv_priv *bat_priv, const char *fmt, ...)
 {
 	va_list args;
-	char tmp_log_buf[256];
 
 	va_start(args, fmt);
-	vscnprintf(tmp_log_buf, sizeof(tmp_log_buf), fmt, args);
-	batadv_fdebug_log(bat_priv->debug_log, "[%10u] %s",
-			  jiffies_to_msecs(jiffies), tmp_log_buf);
+	batadv_log_vwrite(bat_priv->debug_log, fmt, args);
 	va_end(args);
 
 	return 0;
@@ -116,9 +540,127 @@ static int batadv_log_release(struct inode *inode, struct file *file)
 	return 0;
 }
 
+/**
+ * batadv_log_peek - get the oldest unread record of a ring
+ * @debug_log: debug log the ring belongs to
+ * @ring: ring to check
+ *
+ * Padding records in front of the oldest record are consumed.
+ *
+ * Return: the oldest unread record or NULL if the ring is empty
+ */
+static struct batadv_log_rec *
+batadv_log_peek(struct batadv_priv_debug_log *debug_log,
+		struct batadv_log_ring *ring)
+{
+	unsigned long head = smp_load_acquire(&ring->head);
+	unsigned long mask = debug_log->size - 1;
+	struct batadv_log_rec *rec;
+
+	while (ring->tail != head) {
+		rec = (struct batadv_log_rec *)(ring->buff +
+						(ring->tail & mask));
+		if (rec->type != BATADV_LOG_REC_PAD)
+			return rec;
+
+		smp_store_release(&ring->tail, ring->tail + rec->len);
+	}
+
+	return NULL;
+}
+
+/**
+ * batadv_log_fill_line - decode the next line for the reader
+ * @debug_log: debug log to read from
+ *
+ * The per-CPU rings are merged by taking the record with the oldest
+ * timestamp first. Records dropped on a full ring are reported as an extra
+ * line. A message truncated to the line length still ends with a newline so
+ * that it is not merged with the next one. Has to be called with
+ * debug_log->read_lock held.
+ *
+ * Return: true if a new line was stored in debug_log->line, false if all
+ * rings are empty
+ */
+static bool batadv_log_fill_line(struct batadv_priv_debug_log *debug_log)
+{
+	struct batadv_log_ring *ring, *oldest_ring = NULL;
+	size_t size = sizeof(debug_log->line);
+	struct batadv_log_rec *rec, *oldest = NULL;
+	char *line = debug_log->line;
+	unsigned long dropped;
+	size_t len;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(debug_log->rings, cpu);
+
+		dropped = READ_ONCE(ring->dropped);
+		if (dropped != ring->dropped_seen) {
+			len = scnprintf(line, size,
+					"[%10u] %lu log messages dropped on cpu %d\n",
+					jiffies_to_msecs(jiffies),
+					dropped - ring->dropped_seen, cpu);
+			ring->dropped_seen = dropped;
+			goto out;
+		}
+
+		rec = batadv_log_peek(debug_log, ring);
+		if (!rec)
+			continue;
+
+		if (!oldest || rec->time < oldest->time) {
+			oldest = rec;
+			oldest_ring = ring;
+		}
+	}
+
+	if (!oldest)
+		return false;
+
+	len = scnprintf(line, size, "[%10u] ", oldest->msecs);
+	if (oldest->type == BATADV_LOG_REC_TEXT)
+		len += scnprintf(line + len, size - len, "%s",
+				 (const char *)(oldest + 1));
+	else
+		len += batadv_log_decode(line + len, size - len, oldest->fmt,
+					 (const u8 *)(oldest + 1));
+
+	if (line[len - 1] != '\n') {
+		if (len == size - 1)
+			len--;
+		line[len++] = '\n';
+		line[len] = '\0';
+	}
+
+	smp_store_release(&oldest_ring->tail, oldest_ring->tail + oldest->len);
+
+out:
+	debug_log->line_pos = 0;
+	debug_log->line_len = len;
+
+	return true;
+}
+
 static bool batadv_log_empty(struct batadv_priv_debug_log *debug_log)
 {
-	return !(debug_log->log_start - debug_log->log_end);
+	struct batadv_log_ring *ring;
+	int cpu;
+
+	if (READ_ONCE(debug_log->line_pos) != READ_ONCE(debug_log->line_len))
+		return false;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(debug_log->rings, cpu);
+
+		if (READ_ONCE(ring->dropped) != ring->dropped_seen)
+			return false;
+
+		if (smp_load_acquire(&ring->head) != READ_ONCE(ring->tail))
+			return false;
+	}
+
+	return true;
 }
 
 static ssize_t batadv_log_read(struct file *file, char __user *buf,
@@ -126,9 +668,9 @@ static ssize_t batadv_log_read(struct file *file, char __user *buf,
 {
 	struct batadv_priv *bat_priv = file->private_data;
 	struct batadv_priv_debug_log *debug_log = bat_priv->debug_log;
-	int error, i = 0;
-	char *char_addr;
-	char c;
+	int error = 0;
+	size_t i = 0;
+	size_t len;
 
 	if ((file->f_flags & O_NONBLOCK) && batadv_log_empty(debug_log))
 		return -EAGAIN;
@@ -142,38 +684,44 @@ static ssize_t batadv_log_read(struct file *file, char __user *buf,
 	if (!access_ok(VERIFY_WRITE, buf, count))
 		return -EFAULT;
 
-	error = wait_event_interruptible(debug_log->queue_wait,
-					 (!batadv_log_empty(debug_log)));
+	while (i == 0) {
+		error = wait_event_interruptible(debug_log->queue_wait,
+						 !batadv_log_empty(debug_log));
 
-	if (error)
-		return error;
+		if (error)
+			return error;
 
-	spin_lock_bh(&debug_log->lock);
+		mutex_lock(&debug_log->read_lock);
 
-	while ((!error) && (i < count) &&
-	       (debug_log->log_start != debug_log->log_end)) {
-		char_addr = batadv_log_char_addr(debug_log,
-						 debug_log->log_start);
-		c = *char_addr;
+		while (i < count) {
+			if (debug_log->line_pos == debug_log->line_len &&
+			    !batadv_log_fill_line(debug_log))
+				break;
 
-		debug_log->log_start++;
+			len = min(count - i,
+				  debug_log->line_len - debug_log->line_pos);
+			if (copy_to_user(buf + i,
+					 debug_log->line + debug_log->line_pos,
+					 len)) {
+				error = -EFAULT;
+				break;
+			}
 
-		spin_unlock_bh(&debug_log->lock);
+			debug_log->line_pos += len;
+			i += len;
+		}
 
-		error = __put_user(c, buf);
+		mutex_unlock(&debug_log->read_lock);
 
-		spin_lock_bh(&debug_log->lock);
+		if (error)
+			return error;
 
-		buf++;
-		i++;
+		/* only padding was consumed */
+		if (i == 0 && (file->f_flags & O_NONBLOCK))
+			return -EAGAIN;
 	}
 
-	spin_unlock_bh(&debug_log->lock);
-
-	if (!error)
-		return i;
-
-	return error;
+	return i;
 }
 
 static unsigned int batadv_log_poll(struct file *file, poll_table *wait)
@@ -197,19 +745,73 @@ static const struct file_operations batadv_log_fops = {
 	.llseek         = no_llseek,
 };
 
+/**
+ * batadv_log_free - free a debug log and all its rings
+ * @debug_log: debug log to free
+ */
+static void batadv_log_free(struct batadv_priv_debug_log *debug_log)
+{
+	int cpu;
+
+	if (!debug_log)
+		return;
+
+	if (debug_log->rings) {
+		for_each_possible_cpu(cpu)
+			kfree(per_cpu_ptr(debug_log->rings, cpu)->buff);
+
+		free_percpu(debug_log->rings);
+	}
+
+	kfree(debug_log);
+}
+
+/**
+ * batadv_log_ring_size_get - get the configured per-CPU ring size
+ *
+ * Return: the log_ring_size module parameter rounded up to a power of 2 and
+ * clamped to the supported range
+ */
+static unsigned long batadv_log_ring_size_get(void)
+{
+	unsigned long size = READ_ONCE(batadv_log_ring_size);
+
+	size = clamp_t(unsigned long, size, BATADV_LOG_BUF_LEN_MIN,
+		       BATADV_LOG_BUF_LEN_MAX);
+
+	return roundup_pow_of_two(size);
+}
+
 int batadv_debug_log_setup(struct batadv_priv *bat_priv)
 {
+	struct batadv_priv_debug_log *debug_log;
+	struct batadv_log_ring *ring;
 	struct dentry *d;
+	int cpu;
 
 	if (!bat_priv->debug_dir)
 		goto err;
 
-	bat_priv->debug_log = kzalloc(sizeof(*bat_priv->debug_log), GFP_ATOMIC);
-	if (!bat_priv->debug_log)
+	debug_log = kzalloc(sizeof(*debug_log), GFP_KERNEL);
+	if (!debug_log)
 		goto err;
 
-	spin_lock_init(&bat_priv->debug_log->lock);
-	init_waitqueue_head(&bat_priv->debug_log->queue_wait);
+	debug_log->size = batadv_log_ring_size_get();
+	debug_log->rings = alloc_percpu(struct batadv_log_ring);
+	if (!debug_log->rings)
+		goto err_free;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(debug_log->rings, cpu);
+		ring->buff = kmalloc_node(debug_log->size, GFP_KERNEL,
+					  cpu_to_node(cpu));
+		if (!ring->buff)
+			goto err_free;
+	}
+
+	mutex_init(&debug_log->read_lock);
+	init_waitqueue_head(&debug_log->queue_wait);
+	bat_priv->debug_log = debug_log;
 
 	d = debugfs_create_file("log", 0400, bat_priv->debug_dir, bat_priv,
 				&batadv_log_fops);
@@ -218,12 +820,14 @@ int batadv_debug_log_setup(struct batadv_priv *bat_priv)
 
 	return 0;
 
+err_free:
+	batadv_log_free(debug_log);
 err:
 	return -ENOMEM;
 }
 
 void batadv_debug_log_cleanup(struct batadv_priv *bat_priv)
 {
-	kfree(bat_priv->debug_log);
+	batadv_log_free(bat_priv->debug_log);
 	bat_priv->debug_log = NULL;
 }
@@ -57,12 +57,14 @@
 #include "gateway_common.h"
 #include "hard-interface.h"
 #include "icmp_socket.h"
+#include "latency.h"
 #include "log.h"
 #include "multicast.h"
 #include "netlink.h"
 #include "network-coding.h"
 #include "originator.h"
 #include "packet.h"
+#include "ping.h"
 #include "routing.h"
 #include "send.h"
 #include "soft-interface.h"
@@ -112,6 +114,7 @@ static int __init batadv_init(void)
 	batadv_v_init();
 	batadv_iv_init();
 	batadv_nc_init();
+	batadv_mcast_module_init();
 	batadv_tp_meter_init();
 
 	batadv_event_workqueue = create_singlethread_workqueue("bat_events");
@@ -166,6 +169,7 @@ int batadv_mesh_init(struct net_device *soft_iface)
 	spin_lock_init(&bat_priv->tt.last_changeset_lock);
 	spin_lock_init(&bat_priv->tt.commit_lock);
 	spin_lock_init(&bat_priv->gw.list_lock);
+	spin_lock_init(&bat_priv->gw.client_lock);
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	spin_lock_init(&bat_priv->mcast.want_lists_lock);
 #endif
@@ -173,6 +177,7 @@ int batadv_mesh_init(struct net_device *soft_iface)
 	spin_lock_init(&bat_priv->tvlv.handler_list_lock);
 	spin_lock_init(&bat_priv->softif_vlan_list_lock);
 	spin_lock_init(&bat_priv->tp_list_lock);
+	spin_lock_init(&bat_priv->ping_list_lock);
 
 	INIT_HLIST_HEAD(&bat_priv->forw_bat_list);
 	INIT_HLIST_HEAD(&bat_priv->forw_bcast_list);
@@ -185,13 +190,17 @@ int batadv_mesh_init(struct net_device *soft_iface)
 	INIT_LIST_HEAD(&bat_priv->tt.changes_list);
 	INIT_HLIST_HEAD(&bat_priv->tt.req_list);
 	INIT_LIST_HEAD(&bat_priv->tt.roam_list);
-#ifdef CONFIG_BATMAN_ADV_MCAST
-	INIT_HLIST_HEAD(&bat_priv->mcast.mla_list);
-#endif
 	INIT_HLIST_HEAD(&bat_priv->tvlv.container_list);
 	INIT_HLIST_HEAD(&bat_priv->tvlv.handler_list);
 	INIT_HLIST_HEAD(&bat_priv->softif_vlan_list);
 	INIT_HLIST_HEAD(&bat_priv->tp_list);
+	INIT_HLIST_HEAD(&bat_priv->tp_reverse_list);
+	INIT_HLIST_HEAD(&bat_priv->tp_notify_list);
+	INIT_HLIST_HEAD(&bat_priv->ping_list);
+
+	ret = batadv_latency_init(bat_priv);
+	if (ret < 0)
+		goto err;
 
 	ret = batadv_v_mesh_init(bat_priv);
 	if (ret < 0)
@@ -238,6 +247,8 @@ void batadv_mesh_free(struct net_device *soft_iface)
 
 	batadv_purge_outstanding_packets(bat_priv, NULL);
 
+	batadv_ping_free(bat_priv);
+	batadv_tp_meter_free(bat_priv);
 	batadv_gw_node_free(bat_priv);
 
 	batadv_v_mesh_free(bat_priv);
@@ -265,6 +276,9 @@ void batadv_mesh_free(struct net_device *soft_iface)
 	free_percpu(bat_priv->bat_counters);
 	bat_priv->bat_counters = NULL;
 
+	atomic_set(&bat_priv->latency_stats, 0);
+	batadv_latency_free(bat_priv);
+
 	atomic_set(&bat_priv->mesh_state, BATADV_MESH_INACTIVE);
 }
 
@@ -484,6 +498,7 @@ int batadv_batman_skb_recv(struct sk_buff *skb, struct net_device *dev,
 	memset(skb->cb, 0, sizeof(struct batadv_skb_cb));
 
 	idx = batadv_ogm_packet->packet_type;
+	batadv_hardif_count_ctrl(hard_iface, idx, skb->len + ETH_HLEN, false);
 	(*batadv_rx_handler[idx])(skb, hard_iface);
 
 	batadv_hardif_put(hard_iface);
@@ -518,11 +533,16 @@ static void batadv_recv_handler_init(void)
 	BUILD_BUG_ON(sizeof(struct batadv_icmp_header) != 20);
 	BUILD_BUG_ON(sizeof(struct batadv_icmp_packet) != 20);
 	BUILD_BUG_ON(sizeof(struct batadv_icmp_packet_rr) != 116);
+	BUILD_BUG_ON(sizeof(struct batadv_icmp_tp_packet) != 28);
+	BUILD_BUG_ON(sizeof(struct batadv_icmp_tp_ack_packet) != 32);
+	BUILD_BUG_ON(sizeof(struct batadv_icmp_tp_sack) != 8);
+	BUILD_BUG_ON(sizeof(struct batadv_icmp_tp_req_packet) != 32);
 	BUILD_BUG_ON(sizeof(struct batadv_unicast_packet) != 10);
 	BUILD_BUG_ON(sizeof(struct batadv_unicast_4addr_packet) != 18);
 	BUILD_BUG_ON(sizeof(struct batadv_frag_packet) != 20);
 	BUILD_BUG_ON(sizeof(struct batadv_bcast_packet) != 14);
 	BUILD_BUG_ON(sizeof(struct batadv_coded_packet) != 46);
+	BUILD_BUG_ON(sizeof(struct batadv_mcast_packet) != 10);
 	BUILD_BUG_ON(sizeof(struct batadv_unicast_tvlv_packet) != 20);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_hdr) != 4);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_gateway_data) != 8);
@@ -49,6 +49,7 @@
 #define BATADV_TT_WORK_PERIOD 5000 /* 5 seconds */
 #define BATADV_ORIG_WORK_PERIOD 1000 /* 1 second */
 #define BATADV_MCAST_WORK_PERIOD 500 /* 0.5 seconds */
+#define BATADV_MCAST_MLA_HASH_SIZE 32
 #define BATADV_DAT_ENTRY_TIMEOUT (5 * 60000) /* 5 mins in milliseconds */
 /* sliding packet range of received originator messages in sequence numbers
  * (should be a multiple of our word size)
@@ -57,6 +58,11 @@
 /* milliseconds we have to keep pending tt_req */
 #define BATADV_TT_REQUEST_TIMEOUT 3000
 
+/* maximum time (in milliseconds) unchanged OGM tvlv containers are not passed
+ * to their handlers
+ */
+#define BATADV_TVLV_DIGEST_TIMEOUT 10000
+
 #define BATADV_TQ_GLOBAL_WINDOW_SIZE 5
 #define BATADV_TQ_LOCAL_BIDRECT_SEND_MINIMUM 1
 #define BATADV_TQ_LOCAL_BIDRECT_RECV_MINIMUM 1
@@ -94,7 +100,14 @@
 
 #define BATADV_NUM_WORDS BITS_TO_LONGS(BATADV_TQ_LOCAL_WINDOW_SIZE)
 
-#define BATADV_LOG_BUF_LEN 8192	  /* has to be a power of 2 */
+/* default size of each per-CPU debug log ring, has to be a power of 2 */
+#define BATADV_LOG_BUF_LEN 16384
+#define BATADV_LOG_BUF_LEN_MIN 4096
+#define BATADV_LOG_BUF_LEN_MAX (1 << 20)
+/* maximum length of a single decoded debug log line */
+#define BATADV_LOG_LINE_LEN 256
+/* length of the "[%10u] " timestamp prefix of each decoded line */
+#define BATADV_LOG_PREFIX_LEN 13
 
 /* number of packets to send for broadcasts on different interface types */
 #define BATADV_NUM_BCASTS_DEFAULT 1
@@ -126,8 +139,15 @@
 #define BATADV_BLA_WAIT_PERIODS		3
 #define BATADV_BLA_LOOPDETECT_PERIODS	6
 #define BATADV_BLA_LOOPDETECT_TIMEOUT	3000	/* 3 seconds */
-
-#define BATADV_DUPLIST_SIZE		16
+#define BATADV_BLA_CLAIM_HASH_MIN	128
+#define BATADV_BLA_CLAIM_HASH_MAX	16384
+#define BATADV_BLA_CLAIM_HASH_LOAD	4	/* claims per bucket */
+
+#define BATADV_DUPLIST_SIZE		256	/* default number of slots */
+#define BATADV_DUPLIST_SIZE_MIN		16
+#define BATADV_DUPLIST_SIZE_MAX		4096
+#define BATADV_DUPLIST_WAYS		4	/* slots per bucket */
+#define BATADV_DUPLIST_FP_LEN		96	/* bytes of payload hashed */
 #define BATADV_DUPLIST_TIMEOUT		500	/* 500 ms */
 /* don't reset again within 30 seconds */
 #define BATADV_RESET_PROTECTION_MS 30000
@@ -135,10 +155,95 @@
 
 #define BATADV_NC_NODE_TIMEOUT 10000 /* Milliseconds */
 
+/* default and maximum number of destinations a multicast packet may be sent
+ * to via a batman-adv multicast packet before falling back to flooding
+ */
+#define BATADV_MCAST_FANOUT_DEFAULT 16
+#define BATADV_MCAST_FANOUT_MAX 64
+
+/**
+ * BATADV_TP_MAX_NUM - maximum number of simultaneously active tp streams
+ */
+#define BATADV_TP_MAX_NUM 32
+
+/**
+ * BATADV_TP_MAX_STREAMS - maximum number of parallel streams per direction of
+ *  a single tp session
+ */
+#define BATADV_TP_MAX_STREAMS 8
+
+/**
+ * BATADV_TP_HIST_BUCKETS - number of power of two buckets of the tp meter
+ *  latency histograms (usecs)
+ */
+#define BATADV_TP_HIST_BUCKETS 32
+
+/**
+ * BATADV_LATENCY_BUCKETS - number of power of two buckets of the per stage
+ *  latency histograms (nsecs)
+ */
+#define BATADV_LATENCY_BUCKETS 32
+
+/**
+ * BATADV_TP_REORDER_WIN - number of segments following the last in-order
+ *  received one which the tp meter receiver keeps track of
+ */
+#define BATADV_TP_REORDER_WIN 1024
+
+/**
+ * BATADV_TP_MAX_SACK - maximum number of SACK blocks carried by a tp meter ACK
+ */
+#define BATADV_TP_MAX_SACK 4
+
+/**
+ * BATADV_PING_MAX_NUM - maximum number of simultaneously active ping sessions
+ */
+#define BATADV_PING_MAX_NUM 8
+
+/**
+ * BATADV_PING_MAX_DESTS - maximum number of destinations of a ping session
+ */
+#define BATADV_PING_MAX_DESTS 1024
+
+/**
+ * BATADV_PING_MAX_COUNT - maximum number of probe rounds of a ping session
+ */
+#define BATADV_PING_MAX_COUNT 100000
+
+/**
+ * BATADV_PING_MIN_INTERVAL - minimum time (msecs) between two probe rounds of
+ *  a ping session
+ */
+#define BATADV_PING_MIN_INTERVAL 10
+
+/**
+ * BATADV_PING_MAX_INTERVAL - maximum time (msecs) between two probe rounds of
+ *  a ping session
+ */
+#define BATADV_PING_MAX_INTERVAL 60000
+
+/**
+ * BATADV_PING_MAX_SIZE - maximum size of a ping probe
+ */
+#define BATADV_PING_MAX_SIZE ETH_DATA_LEN
+
+/**
+ * BATADV_PING_TIMEOUT - time (msecs) to wait for replies after the last probe
+ *  round of a ping session
+ */
+#define BATADV_PING_TIMEOUT 1000
+
+/**
+ * BATADV_PING_UID - icmp uid of the kernel ping probes, never assigned to an
+ *  icmp socket client
+ */
+#define BATADV_PING_UID 255
+
 /**
- * BATADV_TP_MAX_NUM - maximum number of simultaneously active tp sessions
+ * BATADV_TVLV_TYPE_NUM - number of possible tvlv types, size of the tvlv
+ *  handler table
  */
-#define BATADV_TP_MAX_NUM 5
+#define BATADV_TVLV_TYPE_NUM 256
 
 enum batadv_mesh_state {
 	BATADV_MESH_INACTIVE,
@@ -148,6 +253,7 @@ enum batadv_mesh_state {
 
 #define BATADV_BCAST_QUEUE_LEN		256
 #define BATADV_BATMAN_QUEUE_LEN	256
+#define BATADV_ICMP_RING_SLOTS		256
 
 enum batadv_uev_action {
 	BATADV_UEV_ADD = 0,
@@ -162,6 +268,10 @@ enum batadv_uev_type {
 };
 
 #define BATADV_GW_THRESHOLD	50
+#define BATADV_GW_CLIENT_HASH_SIZE	64
+#define BATADV_GW_CLIENT_TIMEOUT	86400000	/* 24 hours */
+#define BATADV_GW_CLIENT_MAX		1024
+#define BATADV_GW_WEIGHT_MAX		U16_MAX
 
 /* Number of fragment chains for each orig_node */
 #define BATADV_FRAG_BUFFER_COUNT 8
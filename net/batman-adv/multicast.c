@@ -31,14 +31,17 @@
 #include <linux/igmp.h>
 #include <linux/in.h>
 #include <linux/in6.h>
+#include <linux/init.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/jhash.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/lockdep.h>
 #include <linux/netdevice.h>
+#include <linux/netlink.h>
 #include <linux/printk.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
@@ -51,14 +54,23 @@
 #include <linux/types.h>
 #include <linux/workqueue.h>
 #include <net/addrconf.h>
+#include <net/genetlink.h>
 #include <net/if_inet6.h>
 #include <net/ip.h>
 #include <net/ipv6.h>
+#include <net/netlink.h>
+#include <net/sock.h>
+#include <uapi/linux/batman_adv.h>
 
 #include "hard-interface.h"
 #include "hash.h"
 #include "log.h"
+#include "netlink.h"
+#include "originator.h"
 #include "packet.h"
+#include "routing.h"
+#include "send.h"
+#include "soft-interface.h"
 #include "translation-table.h"
 #include "tvlv.h"
 
@@ -100,14 +112,79 @@ static struct net_device *batadv_mcast_get_bridge(struct net_device *soft_iface)
 	return upper;
 }
 
+/**
+ * batadv_mcast_mla_hash_init - initialize a hash of multicast addresses
+ * @mcast_hash: the BATADV_MCAST_MLA_HASH_SIZE buckets to initialize
+ */
+static void batadv_mcast_mla_hash_init(struct hlist_head *mcast_hash)
+{
+	int i;
+
+	for (i = 0; i < BATADV_MCAST_MLA_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&mcast_hash[i]);
+}
+
+/**
+ * batadv_mcast_mla_hash_bucket - get the bucket of a multicast address
+ * @mcast_hash: the hash of multicast addresses
+ * @mcast_addr: the multicast address to get the bucket for
+ *
+ * Return: the bucket of @mcast_hash the given address belongs to.
+ */
+static struct hlist_head *
+batadv_mcast_mla_hash_bucket(struct hlist_head *mcast_hash,
+			     const u8 *mcast_addr)
+{
+	u32 index = jhash(mcast_addr, ETH_ALEN, 0);
+
+	return &mcast_hash[index % BATADV_MCAST_MLA_HASH_SIZE];
+}
+
+/**
+ * batadv_mcast_mla_hash_add - add a multicast address entry to a hash
+ * @mcast_hash: the hash of multicast addresses to add to
+ * @mcast_entry: the entry to add
+ */
+static void batadv_mcast_mla_hash_add(struct hlist_head *mcast_hash,
+				      struct batadv_hw_addr *mcast_entry)
+{
+	struct hlist_head *head;
+
+	head = batadv_mcast_mla_hash_bucket(mcast_hash, mcast_entry->addr);
+	hlist_add_head(&mcast_entry->list, head);
+}
+
+/**
+ * batadv_mcast_mla_is_duplicate - check whether an address is in a hash
+ * @mcast_addr: the multicast address to check
+ * @mcast_hash: the hash with multicast addresses to search in
+ *
+ * Return: true if the given address is already in the given hash.
+ * Otherwise returns false.
+ */
+static bool batadv_mcast_mla_is_duplicate(u8 *mcast_addr,
+					  struct hlist_head *mcast_hash)
+{
+	struct batadv_hw_addr *mcast_entry;
+	struct hlist_head *head;
+
+	head = batadv_mcast_mla_hash_bucket(mcast_hash, mcast_addr);
+
+	hlist_for_each_entry(mcast_entry, head, list)
+		if (batadv_compare_eth(mcast_entry->addr, mcast_addr))
+			return true;
+
+	return false;
+}
+
 /**
  * batadv_mcast_mla_softif_get - get softif multicast listeners
  * @dev: the device to collect multicast addresses from
- * @mcast_list: a list to put found addresses into
+ * @mcast_hash: a hash to put found addresses into
  *
  * Collects multicast addresses of multicast listeners residing
  * on this kernel on the given soft interface, dev, in
- * the given mcast_list. In general, multicast listeners provided by
+ * the given mcast_hash. In general, multicast listeners provided by
  * your multicast receiving applications run directly on this node.
  *
  * If there is a bridge interface on top of dev, collects from that one
@@ -116,10 +193,10 @@ static struct net_device *batadv_mcast_get_bridge(struct net_device *soft_iface)
  * enslaved bat0.
  *
  * Return: -ENOMEM on memory allocation error or the number of
- * items added to the mcast_list otherwise.
+ * items added to the mcast_hash otherwise.
  */
 static int batadv_mcast_mla_softif_get(struct net_device *dev,
-				       struct hlist_head *mcast_list)
+				       struct hlist_head *mcast_hash)
 {
 	struct net_device *bridge = batadv_mcast_get_bridge(dev);
 	struct netdev_hw_addr *mc_list_entry;
@@ -128,6 +205,10 @@ static int batadv_mcast_mla_softif_get(struct net_device *dev,
 
 	netif_addr_lock_bh(bridge ? bridge : dev);
 	netdev_for_each_mc_addr(mc_list_entry, bridge ? bridge : dev) {
+		if (batadv_mcast_mla_is_duplicate(mc_list_entry->addr,
+						  mcast_hash))
+			continue;
+
 		new = kmalloc(sizeof(*new), GFP_ATOMIC);
 		if (!new) {
 			ret = -ENOMEM;
@@ -135,7 +216,7 @@ static int batadv_mcast_mla_softif_get(struct net_device *dev,
 		}
 
 		ether_addr_copy(new->addr, mc_list_entry->addr);
-		hlist_add_head(&new->list, mcast_list);
+		batadv_mcast_mla_hash_add(mcast_hash, new);
 		ret++;
 	}
 	netif_addr_unlock_bh(bridge ? bridge : dev);
@@ -146,26 +227,6 @@ static int batadv_mcast_mla_softif_get(struct net_device *dev,
 	return ret;
 }
 
-/**
- * batadv_mcast_mla_is_duplicate - check whether an address is in a list
- * @mcast_addr: the multicast address to check
- * @mcast_list: the list with multicast addresses to search in
- *
- * Return: true if the given address is already in the given list.
- * Otherwise returns false.
- */
-static bool batadv_mcast_mla_is_duplicate(u8 *mcast_addr,
-					  struct hlist_head *mcast_list)
-{
-	struct batadv_hw_addr *mcast_entry;
-
-	hlist_for_each_entry(mcast_entry, mcast_list, list)
-		if (batadv_compare_eth(mcast_entry->addr, mcast_addr))
-			return true;
-
-	return false;
-}
-
 /**
  * batadv_mcast_mla_br_addr_cpy - copy a bridge multicast address
  * @dst: destination to write to - a multicast MAC address
@@ -193,18 +254,18 @@ static void batadv_mcast_mla_br_addr_cpy(char *dst, const struct br_ip *src)
 /**
  * batadv_mcast_mla_bridge_get - get bridged-in multicast listeners
  * @dev: a bridge slave whose bridge to collect multicast addresses from
- * @mcast_list: a list to put found addresses into
+ * @mcast_hash: a hash to put found addresses into
  *
  * Collects multicast addresses of multicast listeners residing
  * on foreign, non-mesh devices which we gave access to our mesh via
  * a bridge on top of the given soft interface, dev, in the given
- * mcast_list.
+ * mcast_hash.
  *
  * Return: -ENOMEM on memory allocation error or the number of
- * items added to the mcast_list otherwise.
+ * items added to the mcast_hash otherwise.
  */
 static int batadv_mcast_mla_bridge_get(struct net_device *dev,
-				       struct hlist_head *mcast_list)
+				       struct hlist_head *mcast_hash)
 {
 	struct list_head bridge_mcast_list = LIST_HEAD_INIT(bridge_mcast_list);
 	struct br_ip_list *br_ip_entry, *tmp;
@@ -221,7 +282,7 @@ static int batadv_mcast_mla_bridge_get(struct net_device *dev,
 
 	list_for_each_entry(br_ip_entry, &bridge_mcast_list, list) {
 		batadv_mcast_mla_br_addr_cpy(mcast_addr, &br_ip_entry->addr);
-		if (batadv_mcast_mla_is_duplicate(mcast_addr, mcast_list))
+		if (batadv_mcast_mla_is_duplicate(mcast_addr, mcast_hash))
 			continue;
 
 		new = kmalloc(sizeof(*new), GFP_ATOMIC);
@@ -231,7 +292,7 @@ static int batadv_mcast_mla_bridge_get(struct net_device *dev,
 		}
 
 		ether_addr_copy(new->addr, mcast_addr);
-		hlist_add_head(&new->list, mcast_list);
+		batadv_mcast_mla_hash_add(mcast_hash, new);
 	}
 
 out:
@@ -244,92 +305,110 @@ out:
 }
 
 /**
- * batadv_mcast_mla_list_free - free a list of multicast addresses
- * @mcast_list: the list to free
+ * batadv_mcast_mla_hash_free - free a hash of multicast addresses
+ * @mcast_hash: the hash to free
  *
- * Removes and frees all items in the given mcast_list.
+ * Removes and frees all items in the given mcast_hash.
  */
-static void batadv_mcast_mla_list_free(struct hlist_head *mcast_list)
+static void batadv_mcast_mla_hash_free(struct hlist_head *mcast_hash)
 {
 	struct batadv_hw_addr *mcast_entry;
 	struct hlist_node *tmp;
+	int i;
 
-	hlist_for_each_entry_safe(mcast_entry, tmp, mcast_list, list) {
-		hlist_del(&mcast_entry->list);
-		kfree(mcast_entry);
+	for (i = 0; i < BATADV_MCAST_MLA_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(mcast_entry, tmp, &mcast_hash[i],
+					  list) {
+			hlist_del(&mcast_entry->list);
+			kfree(mcast_entry);
+		}
 	}
 }
 
 /**
  * batadv_mcast_mla_tt_retract - clean up multicast listener announcements
  * @bat_priv: the bat priv with all the soft interface information
- * @mcast_list: a list of addresses which should _not_ be removed
+ * @mcast_hash: a hash of addresses which should _not_ be removed
  *
  * Retracts the announcement of any multicast listener from the
- * translation table except the ones listed in the given mcast_list.
+ * translation table except the ones listed in the given mcast_hash.
  *
- * If mcast_list is NULL then all are retracted.
+ * If mcast_hash is NULL then all are retracted.
  *
  * Do not call outside of the mcast worker! (or cancel mcast worker first)
  */
 static void batadv_mcast_mla_tt_retract(struct batadv_priv *bat_priv,
-					struct hlist_head *mcast_list)
+					struct hlist_head *mcast_hash)
 {
 	struct batadv_hw_addr *mcast_entry;
 	struct hlist_node *tmp;
+	int i;
+
+	for (i = 0; i < BATADV_MCAST_MLA_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(mcast_entry, tmp,
+					  &bat_priv->mcast.mla_hash[i], list) {
+			if (mcast_hash &&
+			    batadv_mcast_mla_is_duplicate(mcast_entry->addr,
+							  mcast_hash))
+				continue;
 
-	WARN_ON(delayed_work_pending(&bat_priv->mcast.work));
-
-	hlist_for_each_entry_safe(mcast_entry, tmp, &bat_priv->mcast.mla_list,
-				  list) {
-		if (mcast_list &&
-		    batadv_mcast_mla_is_duplicate(mcast_entry->addr,
-						  mcast_list))
-			continue;
-
-		batadv_tt_local_remove(bat_priv, mcast_entry->addr,
-				       BATADV_NO_FLAGS,
-				       "mcast TT outdated", false);
+			batadv_tt_local_remove(bat_priv, mcast_entry->addr,
+					       BATADV_NO_FLAGS,
+					       "mcast TT outdated", false);
 
-		hlist_del(&mcast_entry->list);
-		kfree(mcast_entry);
+			hlist_del(&mcast_entry->list);
+			kfree(mcast_entry);
+		}
 	}
 }
 
 /**
  * batadv_mcast_mla_tt_add - add multicast listener announcements
  * @bat_priv: the bat priv with all the soft interface information
- * @mcast_list: a list of addresses which are going to get added
+ * @mcast_hash: a hash of addresses which are going to get added
  *
- * Adds multicast listener announcements from the given mcast_list to the
+ * Adds multicast listener announcements from the given mcast_hash to the
  * translation table if they have not been added yet.
  *
  * Do not call outside of the mcast worker! (or cancel mcast worker first)
+ *
+ * Return: false if a listener could not be added to the translation table,
+ *  true otherwise
  */
-static void batadv_mcast_mla_tt_add(struct batadv_priv *bat_priv,
-				    struct hlist_head *mcast_list)
+static bool batadv_mcast_mla_tt_add(struct batadv_priv *bat_priv,
+				    struct hlist_head *mcast_hash)
 {
+	struct hlist_head *mla_hash = bat_priv->mcast.mla_hash;
 	struct batadv_hw_addr *mcast_entry;
 	struct hlist_node *tmp;
+	bool ret = true;
+	int i;
 
-	WARN_ON(delayed_work_pending(&bat_priv->mcast.work));
-
-	if (!mcast_list)
-		return;
+	if (!mcast_hash)
+		return true;
 
-	hlist_for_each_entry_safe(mcast_entry, tmp, mcast_list, list) {
-		if (batadv_mcast_mla_is_duplicate(mcast_entry->addr,
-						  &bat_priv->mcast.mla_list))
-			continue;
+	for (i = 0; i < BATADV_MCAST_MLA_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(mcast_entry, tmp, &mcast_hash[i],
+					  list) {
+			if (batadv_mcast_mla_is_duplicate(mcast_entry->addr,
+							  mla_hash))
+				continue;
 
-		if (!batadv_tt_local_add(bat_priv->soft_iface,
-					 mcast_entry->addr, BATADV_NO_FLAGS,
-					 BATADV_NULL_IFINDEX, BATADV_NO_MARK))
-			continue;
+			if (!batadv_tt_local_add(bat_priv->soft_iface,
+						 mcast_entry->addr,
+						 BATADV_NO_FLAGS,
+						 BATADV_NULL_IFINDEX,
+						 BATADV_NO_MARK)) {
+				ret = false;
+				continue;
+			}
 
-		hlist_del(&mcast_entry->list);
-		hlist_add_head(&mcast_entry->list, &bat_priv->mcast.mla_list);
+			hlist_del(&mcast_entry->list);
+			batadv_mcast_mla_hash_add(mla_hash, mcast_entry);
+		}
 	}
+
+	return ret;
 }
 
 /**
@@ -454,19 +533,21 @@ batadv_mcast_bridge_log(struct batadv_priv *bat_priv, bool bridged,
 static void batadv_mcast_flags_log(struct batadv_priv *bat_priv, u8 flags)
 {
 	u8 old_flags = bat_priv->mcast.flags;
-	char str_old_flags[] = "[...]";
+	char str_old_flags[] = "[....]";
 
-	sprintf(str_old_flags, "[%c%c%c]",
+	sprintf(str_old_flags, "[%c%c%c%c]",
 		(old_flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES) ? 'U' : '.',
 		(old_flags & BATADV_MCAST_WANT_ALL_IPV4) ? '4' : '.',
-		(old_flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.');
+		(old_flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.',
+		(old_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA) ? 'P' : '.');
 
 	batadv_dbg(BATADV_DBG_MCAST, bat_priv,
-		   "Changing multicast flags from '%s' to '[%c%c%c]'\n",
+		   "Changing multicast flags from '%s' to '[%c%c%c%c]'\n",
 		   bat_priv->mcast.enabled ? str_old_flags : "<undefined>",
 		   (flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES) ? 'U' : '.',
 		   (flags & BATADV_MCAST_WANT_ALL_IPV4) ? '4' : '.',
-		   (flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.');
+		   (flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.',
+		   (flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA) ? 'P' : '.');
 }
 
 /**
@@ -487,7 +568,7 @@ static bool batadv_mcast_mla_tvlv_update(struct batadv_priv *bat_priv)
 	struct net_device *dev = bat_priv->soft_iface;
 	bool bridged;
 
-	mcast_data.flags = BATADV_NO_FLAGS;
+	mcast_data.flags = BATADV_MCAST_HAVE_MC_PTYPE_CAPA;
 	memset(mcast_data.reserved, 0, sizeof(mcast_data.reserved));
 
 	bridged = batadv_mcast_has_bridge(bat_priv);
@@ -551,34 +632,42 @@ update:
  * Updates the own multicast listener announcements in the translation
  * table as well as the own, announced multicast tvlv container.
  *
- * Note that non-conflicting reads and writes to bat_priv->mcast.mla_list
+ * Note that non-conflicting reads and writes to bat_priv->mcast.mla_hash
  * in batadv_mcast_mla_tt_retract() and batadv_mcast_mla_tt_add() are
  * ensured by the non-parallel execution of the worker this function
  * belongs to.
+ *
+ * Return: false if the listeners could not be collected or not all of them
+ *  could be announced, true otherwise
  */
-static void __batadv_mcast_mla_update(struct batadv_priv *bat_priv)
+static bool __batadv_mcast_mla_update(struct batadv_priv *bat_priv)
 {
 	struct net_device *soft_iface = bat_priv->soft_iface;
-	struct hlist_head mcast_list = HLIST_HEAD_INIT;
+	struct hlist_head mcast_hash[BATADV_MCAST_MLA_HASH_SIZE];
+	bool success = false;
 	int ret;
 
+	batadv_mcast_mla_hash_init(mcast_hash);
+
 	if (!batadv_mcast_mla_tvlv_update(bat_priv))
 		goto update;
 
-	ret = batadv_mcast_mla_softif_get(soft_iface, &mcast_list);
+	ret = batadv_mcast_mla_softif_get(soft_iface, mcast_hash);
 	if (ret < 0)
 		goto out;
 
-	ret = batadv_mcast_mla_bridge_get(soft_iface, &mcast_list);
+	ret = batadv_mcast_mla_bridge_get(soft_iface, mcast_hash);
 	if (ret < 0)
 		goto out;
 
 update:
-	batadv_mcast_mla_tt_retract(bat_priv, &mcast_list);
-	batadv_mcast_mla_tt_add(bat_priv, &mcast_list);
+	batadv_mcast_mla_tt_retract(bat_priv, mcast_hash);
+	success = batadv_mcast_mla_tt_add(bat_priv, mcast_hash);
 
 out:
-	batadv_mcast_mla_list_free(&mcast_list);
+	batadv_mcast_mla_hash_free(mcast_hash);
+
+	return success;
 }
 
 /**
@@ -588,20 +677,42 @@ out:
  * Updates the own multicast listener announcements in the translation
  * table as well as the own, announced multicast tvlv container.
  *
- * In the end, reschedules the work timer.
+ * In the end, reschedules the work timer if a bridge is on top of the soft
+ * interface or if the update failed. Otherwise the next update is scheduled on
+ * demand via batadv_mcast_mla_update_trigger().
  */
 static void batadv_mcast_mla_update(struct work_struct *work)
 {
 	struct delayed_work *delayed_work;
 	struct batadv_priv_mcast *priv_mcast;
 	struct batadv_priv *bat_priv;
+	bool success;
 
 	delayed_work = to_delayed_work(work);
 	priv_mcast = container_of(delayed_work, struct batadv_priv_mcast, work);
 	bat_priv = container_of(priv_mcast, struct batadv_priv, mcast);
 
-	__batadv_mcast_mla_update(bat_priv);
-	batadv_mcast_start_timer(bat_priv);
+	success = __batadv_mcast_mla_update(bat_priv);
+
+	/* the bridge neither notifies us about changes of its snooped
+	 * listeners nor about a changed querier state, keep polling it.
+	 * A failed update is retried as no event might follow it
+	 */
+	if (bat_priv->mcast.bridged || !success)
+		batadv_mcast_start_timer(bat_priv);
+}
+
+/**
+ * batadv_mcast_mla_update_trigger - schedule an immediate MLA update
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * To be called whenever the multicast listeners of the soft interface or
+ * the bridge on top of it might have changed. Safe to call from atomic
+ * context.
+ */
+void batadv_mcast_mla_update_trigger(struct batadv_priv *bat_priv)
+{
+	mod_delayed_work(batadv_event_workqueue, &bat_priv->mcast.work, 0);
 }
 
 /**
@@ -926,7 +1037,9 @@ batadv_mcast_forw_unsnoop_node_get(struct batadv_priv *bat_priv)
  *
  * Return: the forwarding mode as enum batadv_forw_mode and in case of
  * BATADV_FORW_SINGLE set the orig to the single originator the skb
- * should be forwarded to.
+ * should be forwarded to. BATADV_FORW_MCAST is returned if there are no
+ * more than multicast_fanout listeners and all nodes are able to handle
+ * batman-adv multicast packets.
  */
 enum batadv_forw_mode
 batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
@@ -968,10 +1081,369 @@ batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	case 0:
 		return BATADV_FORW_NONE;
 	default:
+		if (!unsnoop_count &&
+		    total_count <= atomic_read(&bat_priv->multicast_fanout) &&
+		    !atomic_read(&bat_priv->mcast.num_no_mc_ptype_capa))
+			return BATADV_FORW_MCAST;
+
 		return BATADV_FORW_ALL;
 	}
 }
 
+/**
+ * batadv_mcast_forw_dest_add - add an originator to a destination list
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ * @dests: the destination list to add to
+ * @num_dests: number of entries in @dests, increased if @orig is added
+ * @max_dests: the capacity of @dests
+ * @orig: the originator to add
+ *
+ * Adds @orig to @dests and increases its refcount, unless it is listed
+ * already. If @dests is full then @orig gets an individual unicast copy of
+ * @skb instead.
+ */
+static void batadv_mcast_forw_dest_add(struct batadv_priv *bat_priv,
+				       struct sk_buff *skb,
+				       unsigned short vid,
+				       struct batadv_orig_node **dests,
+				       int *num_dests, int max_dests,
+				       struct batadv_orig_node *orig)
+{
+	struct sk_buff *newskb;
+	int i;
+
+	for (i = 0; i < *num_dests; i++) {
+		if (dests[i] == orig)
+			return;
+	}
+
+	if (*num_dests < max_dests) {
+		if (!kref_get_unless_zero(&orig->refcount))
+			return;
+
+		dests[(*num_dests)++] = orig;
+		return;
+	}
+
+	newskb = skb_copy(skb, GFP_ATOMIC);
+	if (!newskb)
+		return;
+
+	batadv_send_skb_unicast(bat_priv, newskb, BATADV_UNICAST, 0, orig, vid);
+}
+
+/**
+ * batadv_mcast_forw_tt_dests_get - collect listeners announced via TT
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ * @dests: the destination list to add to
+ * @num_dests: number of entries in @dests
+ * @max_dests: the capacity of @dests
+ *
+ * Adds all originators which announced the multicast destination address
+ * of @skb via their translation table to @dests.
+ */
+static void
+batadv_mcast_forw_tt_dests_get(struct batadv_priv *bat_priv,
+			       struct sk_buff *skb, unsigned short vid,
+			       struct batadv_orig_node **dests,
+			       int *num_dests, int max_dests)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+	struct batadv_tt_global_entry *tt_global;
+	const u8 *addr = eth_hdr(skb)->h_dest;
+
+	tt_global = batadv_tt_global_hash_find(bat_priv, addr, BATADV_NO_FLAGS);
+	if (!tt_global)
+		return;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_entry, &tt_global->orig_list, list)
+		batadv_mcast_forw_dest_add(bat_priv, skb, vid, dests, num_dests,
+					   max_dests, orig_entry->orig_node);
+	rcu_read_unlock();
+
+	batadv_tt_global_entry_put(tt_global);
+}
+
+/**
+ * batadv_mcast_forw_want_all_dests_get - collect nodes wanting all traffic
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ * @dests: the destination list to add to
+ * @num_dests: number of entries in @dests
+ * @max_dests: the capacity of @dests
+ *
+ * Adds all originators which want all IPv4 or IPv6 multicast traffic,
+ * depending on the protocol of @skb, to @dests.
+ */
+static void
+batadv_mcast_forw_want_all_dests_get(struct batadv_priv *bat_priv,
+				     struct sk_buff *skb, unsigned short vid,
+				     struct batadv_orig_node **dests,
+				     int *num_dests, int max_dests)
+{
+	struct batadv_orig_node *orig_node;
+
+	rcu_read_lock();
+	switch (ntohs(eth_hdr(skb)->h_proto)) {
+	case ETH_P_IP:
+		hlist_for_each_entry_rcu(orig_node,
+					 &bat_priv->mcast.want_all_ipv4_list,
+					 mcast_want_all_ipv4_node)
+			batadv_mcast_forw_dest_add(bat_priv, skb, vid, dests,
+						   num_dests, max_dests,
+						   orig_node);
+		break;
+	case ETH_P_IPV6:
+		hlist_for_each_entry_rcu(orig_node,
+					 &bat_priv->mcast.want_all_ipv6_list,
+					 mcast_want_all_ipv6_node)
+			batadv_mcast_forw_dest_add(bat_priv, skb, vid, dests,
+						   num_dests, max_dests,
+						   orig_node);
+		break;
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * batadv_mcast_forw_same_router - check whether two routers are identical
+ * @neigh1: the first router to compare
+ * @neigh2: the second router to compare
+ *
+ * Router entries are maintained per originator. Two of them describe the
+ * same next hop if they share the outgoing interface and the neighbor
+ * address.
+ *
+ * Return: true if both routers describe the same next hop, false otherwise.
+ */
+static bool batadv_mcast_forw_same_router(struct batadv_neigh_node *neigh1,
+					  struct batadv_neigh_node *neigh2)
+{
+	if (neigh1->if_incoming != neigh2->if_incoming)
+		return false;
+
+	return batadv_compare_eth(neigh1->addr, neigh2->addr);
+}
+
+/**
+ * batadv_mcast_forw_group_send - send a multicast packet to one next hop
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the packet to send a copy of
+ * @hdr_size: size of the header in front of the ethernet frame in @skb
+ * @orig_addr: the originator address for the multicast packet header
+ * @ttl: the time to live for the multicast packet header
+ * @vid: the vlan identifier
+ * @group: the destinations reachable via @neigh_node
+ * @num_group: number of entries in @group
+ * @neigh_node: the next hop to send the multicast packet to
+ *
+ * If the resulting multicast packet would exceed the MTU of the outgoing
+ * interface then each destination of @group gets an individual unicast copy
+ * instead.
+ *
+ * Return: true if at least one copy was handed to the outgoing interface,
+ * false otherwise.
+ */
+static bool
+batadv_mcast_forw_group_send(struct batadv_priv *bat_priv,
+			     struct sk_buff *skb, int hdr_size,
+			     const u8 *orig_addr, u8 ttl, unsigned short vid,
+			     struct batadv_orig_node **group, int num_group,
+			     struct batadv_neigh_node *neigh_node)
+{
+	int mcast_hdr_size = BATADV_MCAST_HLEN(num_group);
+	struct batadv_mcast_packet *mcast_packet;
+	struct sk_buff *newskb;
+	bool sent = false;
+	int i, ret;
+	u8 *dest;
+
+	if (skb->len - hdr_size + mcast_hdr_size <=
+	    neigh_node->if_incoming->net_dev->mtu)
+		goto send_mcast;
+
+	for (i = 0; i < num_group; i++) {
+		newskb = skb_copy(skb, GFP_ATOMIC);
+		if (!newskb)
+			break;
+
+		skb_pull(newskb, hdr_size);
+		skb_reset_mac_header(newskb);
+
+		ret = batadv_send_skb_unicast(bat_priv, newskb, BATADV_UNICAST,
+					      0, group[i], vid);
+		if (ret == NET_XMIT_SUCCESS)
+			sent = true;
+	}
+
+	return sent;
+
+send_mcast:
+	newskb = skb_copy(skb, GFP_ATOMIC);
+	if (!newskb)
+		return false;
+
+	skb_pull(newskb, hdr_size);
+
+	if (batadv_skb_head_push(newskb, mcast_hdr_size) < 0) {
+		kfree_skb(newskb);
+		return false;
+	}
+
+	mcast_packet = (struct batadv_mcast_packet *)newskb->data;
+	mcast_packet->packet_type = BATADV_MCAST;
+	mcast_packet->version = BATADV_COMPAT_VERSION;
+	mcast_packet->ttl = ttl;
+	mcast_packet->num_dests = num_group;
+	ether_addr_copy(mcast_packet->orig, orig_addr);
+
+	dest = (u8 *)(mcast_packet + 1);
+	for (i = 0; i < num_group; i++, dest += ETH_ALEN)
+		ether_addr_copy(dest, group[i]->orig);
+
+	/* padding to keep the payload 4 bytes boundary aligned */
+	if (num_group % 2)
+		eth_zero_addr(dest);
+
+	return batadv_send_unicast_skb(newskb, neigh_node) == NET_XMIT_SUCCESS;
+}
+
+/**
+ * batadv_mcast_forw_dests_send - send a multicast packet per next hop
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the packet to send copies of
+ * @hdr_size: size of the header in front of the ethernet frame in @skb
+ * @orig_addr: the originator address for the multicast packet header
+ * @ttl: the time to live for the multicast packet header
+ * @dests: the destination originators
+ * @num_dests: number of entries in @dests
+ * @recv_if: interface the packet was received on, NULL if originated locally
+ *
+ * Groups the destinations by the next hop batadv_find_router() chooses for
+ * them and transmits a single batman-adv multicast packet per next hop. Each
+ * copy only lists the destinations reachable via this next hop. @skb itself
+ * is not consumed.
+ */
+static void batadv_mcast_forw_dests_send(struct batadv_priv *bat_priv,
+					 struct sk_buff *skb, int hdr_size,
+					 const u8 *orig_addr, u8 ttl,
+					 struct batadv_orig_node **dests,
+					 int num_dests,
+					 struct batadv_hard_iface *recv_if)
+{
+	struct batadv_neigh_node **routers;
+	struct batadv_orig_node **group;
+	unsigned short vid;
+	int i, j, num_group;
+
+	routers = kcalloc(num_dests, sizeof(*routers), GFP_ATOMIC);
+	group = kmalloc_array(num_dests, sizeof(*group), GFP_ATOMIC);
+	if (!routers || !group)
+		goto out;
+
+	vid = batadv_get_vid(skb, hdr_size);
+
+	for (i = 0; i < num_dests; i++)
+		routers[i] = batadv_find_router(bat_priv, dests[i], recv_if);
+
+	for (i = 0; i < num_dests; i++) {
+		if (!routers[i])
+			continue;
+
+		group[0] = dests[i];
+		num_group = 1;
+
+		for (j = i + 1; j < num_dests; j++) {
+			if (!routers[j] ||
+			    !batadv_mcast_forw_same_router(routers[i],
+							   routers[j]))
+				continue;
+
+			group[num_group++] = dests[j];
+			batadv_neigh_node_put(routers[j]);
+			routers[j] = NULL;
+		}
+
+		if (batadv_mcast_forw_group_send(bat_priv, skb, hdr_size,
+						 orig_addr, ttl, vid, group,
+						 num_group, routers[i]) &&
+		    recv_if) {
+			batadv_inc_counter(bat_priv, BATADV_CNT_FORWARD);
+			batadv_add_counter(bat_priv, BATADV_CNT_FORWARD_BYTES,
+					   skb->len - hdr_size + ETH_HLEN);
+		}
+
+		batadv_neigh_node_put(routers[i]);
+		routers[i] = NULL;
+	}
+
+out:
+	kfree(group);
+	kfree(routers);
+}
+
+/**
+ * batadv_mcast_forw_send - send a multicast packet to its listeners
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ *
+ * Sends @skb to all originators which announced a matching multicast
+ * listener or which want all multicast traffic of its IP family. They are
+ * listed in the header of batman-adv multicast packets, one per next hop.
+ * Consumes the provided skb.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure or if no primary
+ * interface is selected, NET_XMIT_SUCCESS otherwise.
+ */
+int batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+			   unsigned short vid)
+{
+	struct batadv_hard_iface *primary_if;
+	struct batadv_orig_node **dests;
+	int i, max_dests, num_dests = 0;
+	int ret = NET_XMIT_DROP;
+
+	primary_if = batadv_primary_if_get_selected(bat_priv);
+	if (!primary_if)
+		goto free_skb;
+
+	max_dests = atomic_read(&bat_priv->multicast_fanout);
+	dests = kmalloc_array(max_dests, sizeof(*dests), GFP_ATOMIC);
+	if (!dests)
+		goto put_primary_if;
+
+	batadv_mcast_forw_tt_dests_get(bat_priv, skb, vid, dests, &num_dests,
+				       max_dests);
+	batadv_mcast_forw_want_all_dests_get(bat_priv, skb, vid, dests,
+					     &num_dests, max_dests);
+
+	batadv_mcast_forw_dests_send(bat_priv, skb, 0,
+				     primary_if->net_dev->dev_addr, BATADV_TTL,
+				     dests, num_dests, NULL);
+
+	for (i = 0; i < num_dests; i++)
+		batadv_orig_node_put(dests[i]);
+
+	kfree(dests);
+	consume_skb(skb);
+	skb = NULL;
+	ret = NET_XMIT_SUCCESS;
+
+put_primary_if:
+	batadv_hardif_put(primary_if);
+free_skb:
+	kfree_skb(skb);
+
+	return ret;
+}
+
 /**
  * batadv_mcast_want_unsnoop_update - update unsnoop counter and list
  * @bat_priv: the bat priv with all the soft interface information
@@ -1107,6 +1579,40 @@ static void batadv_mcast_want_ipv6_update(struct batadv_priv *bat_priv,
 	}
 }
 
+/**
+ * batadv_mcast_have_mc_ptype_update - update multicast packet capability count
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig: the orig_node which multicast state might have changed of
+ * @mcast_flags: flags indicating the new multicast state
+ *
+ * If the BATADV_MCAST_HAVE_MC_PTYPE_CAPA flag of this originator, orig, has
+ * toggled or if this is a new originator without it then this method updates
+ * the counter of nodes unable to handle batman-adv multicast packets.
+ *
+ * Caller needs to hold orig->mcast_handler_lock.
+ */
+static void batadv_mcast_have_mc_ptype_update(struct batadv_priv *bat_priv,
+					      struct batadv_orig_node *orig,
+					      u8 mcast_flags)
+{
+	bool orig_initialized = test_bit(BATADV_ORIG_CAPA_HAS_MCAST,
+					 &orig->capa_initialized);
+
+	lockdep_assert_held(&orig->mcast_handler_lock);
+
+	/* switched from flag unset to set */
+	if (mcast_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA &&
+	    !(orig->mcast_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA)) {
+		if (orig_initialized)
+			atomic_dec(&bat_priv->mcast.num_no_mc_ptype_capa);
+	/* switched from flag set to unset or new node without flag */
+	} else if (!(mcast_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA) &&
+		   (orig->mcast_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA ||
+		    !orig_initialized)) {
+		atomic_inc(&bat_priv->mcast.num_no_mc_ptype_capa);
+	}
+}
+
 /**
  * batadv_mcast_tvlv_ogm_handler - process incoming multicast tvlv container
  * @bat_priv: the bat priv with all the soft interface information
@@ -1130,6 +1636,8 @@ static void batadv_mcast_tvlv_ogm_handler(struct batadv_priv *bat_priv,
 		mcast_flags = *(u8 *)tvlv_value;
 
 	spin_lock_bh(&orig->mcast_handler_lock);
+	batadv_mcast_have_mc_ptype_update(bat_priv, orig, mcast_flags);
+
 	orig_initialized = test_bit(BATADV_ORIG_CAPA_HAS_MCAST,
 				    &orig->capa_initialized);
 
@@ -1163,12 +1671,134 @@ static void batadv_mcast_tvlv_ogm_handler(struct batadv_priv *bat_priv,
 	spin_unlock_bh(&orig->mcast_handler_lock);
 }
 
+/**
+ * batadv_mcast_recv_packet - process a received batman-adv multicast packet
+ * @skb: the received multicast packet
+ * @recv_if: interface that the skb is received on
+ *
+ * Forwards a copy of the packet to every next hop towards the other listed
+ * destinations and hands the packet to the soft interface if we are one of
+ * these destinations ourselves.
+ *
+ * Return: NET_RX_SUCCESS if the packet was delivered locally, NET_RX_DROP
+ * otherwise.
+ */
+static int batadv_mcast_recv_packet(struct sk_buff *skb,
+				    struct batadv_hard_iface *recv_if)
+{
+	struct batadv_priv *bat_priv = netdev_priv(recv_if->soft_iface);
+	struct batadv_orig_node **dests = NULL, *orig_node = NULL;
+	struct batadv_mcast_packet *mcast_packet;
+	int hdr_size = sizeof(*mcast_packet);
+	int ret = NET_RX_DROP;
+	int i, num_dests = 0;
+	bool is_for_me = false;
+	struct ethhdr *ethhdr;
+	u8 *dest;
+
+	/* drop packet if it has not necessary minimum size */
+	if (unlikely(!pskb_may_pull(skb, hdr_size)))
+		goto free_skb;
+
+	ethhdr = eth_hdr(skb);
+
+	/* packet with multicast indication but non-unicast recipient */
+	if (!is_valid_ether_addr(ethhdr->h_dest))
+		goto free_skb;
+
+	/* packet with broadcast/multicast sender address */
+	if (is_multicast_ether_addr(ethhdr->h_source))
+		goto free_skb;
+
+	/* not for me */
+	if (!batadv_is_my_mac(bat_priv, ethhdr->h_dest))
+		goto free_skb;
+
+	mcast_packet = (struct batadv_mcast_packet *)skb->data;
+	hdr_size = BATADV_MCAST_HLEN(mcast_packet->num_dests);
+
+	if (unlikely(!pskb_may_pull(skb, hdr_size)))
+		goto free_skb;
+
+	/* skb->data might have been reallocated by pskb_may_pull() */
+	mcast_packet = (struct batadv_mcast_packet *)skb->data;
+
+	/* ignore multicast packets originated by myself */
+	if (batadv_is_my_mac(bat_priv, mcast_packet->orig))
+		goto free_skb;
+
+	if (mcast_packet->ttl >= 2) {
+		dests = kmalloc_array(mcast_packet->num_dests, sizeof(*dests),
+				      GFP_ATOMIC);
+		if (!dests)
+			goto free_skb;
+	}
+
+	dest = (u8 *)(mcast_packet + 1);
+	for (i = 0; i < mcast_packet->num_dests; i++, dest += ETH_ALEN) {
+		if (batadv_is_my_mac(bat_priv, dest)) {
+			is_for_me = true;
+			continue;
+		}
+
+		if (!dests)
+			continue;
+
+		dests[num_dests] = batadv_orig_hash_find(bat_priv, dest);
+		if (dests[num_dests])
+			num_dests++;
+	}
+
+	if (num_dests) {
+		batadv_skb_set_priority(skb, hdr_size);
+		batadv_mcast_forw_dests_send(bat_priv, skb, hdr_size,
+					     mcast_packet->orig,
+					     mcast_packet->ttl - 1, dests,
+					     num_dests, recv_if);
+	}
+
+	if (!is_for_me)
+		goto free_skb;
+
+	orig_node = batadv_orig_hash_find(bat_priv, mcast_packet->orig);
+
+	batadv_interface_rx(recv_if->soft_iface, skb, hdr_size, orig_node);
+	ret = NET_RX_SUCCESS;
+	goto out;
+
+free_skb:
+	kfree_skb(skb);
+out:
+	for (i = 0; i < num_dests; i++)
+		batadv_orig_node_put(dests[i]);
+
+	kfree(dests);
+
+	if (orig_node)
+		batadv_orig_node_put(orig_node);
+
+	return ret;
+}
+
+/**
+ * batadv_mcast_module_init - one-time initialization for multicast packets
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+int __init batadv_mcast_module_init(void)
+{
+	return batadv_recv_handler_register(BATADV_MCAST,
+					    batadv_mcast_recv_packet);
+}
+
 /**
  * batadv_mcast_init - initialize the multicast optimizations structures
  * @bat_priv: the bat priv with all the soft interface information
  */
 void batadv_mcast_init(struct batadv_priv *bat_priv)
 {
+	batadv_mcast_mla_hash_init(bat_priv->mcast.mla_hash);
+
 	batadv_tvlv_handler_register(bat_priv, batadv_mcast_tvlv_ogm_handler,
 				     NULL, BATADV_TVLV_MCAST, 2,
 				     BATADV_TVLV_HANDLER_OGM_CIFNOTFND);
@@ -1206,10 +1836,11 @@ static void batadv_mcast_flags_print_header(struct batadv_priv *bat_priv,
 		shadowing6 = '?';
 	}
 
-	seq_printf(seq, "Multicast flags (own flags: [%c%c%c])\n",
+	seq_printf(seq, "Multicast flags (own flags: [%c%c%c%c])\n",
 		   (flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES) ? 'U' : '.',
 		   (flags & BATADV_MCAST_WANT_ALL_IPV4) ? '4' : '.',
-		   (flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.');
+		   (flags & BATADV_MCAST_WANT_ALL_IPV6) ? '6' : '.',
+		   (flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA) ? 'P' : '.');
 	seq_printf(seq, "* Bridged [U]\t\t\t\t%c\n", bridged ? 'U' : '.');
 	seq_printf(seq, "* No IGMP/MLD Querier [4/6]:\t\t%c/%c\n",
 		   querier4, querier6);
@@ -1263,13 +1894,15 @@ int batadv_mcast_flags_seq_print_text(struct seq_file *seq, void *offset)
 
 			flags = orig_node->mcast_flags;
 
-			seq_printf(seq, "%pM [%c%c%c]\n", orig_node->orig,
+			seq_printf(seq, "%pM [%c%c%c%c]\n", orig_node->orig,
 				   (flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES)
 				   ? 'U' : '.',
 				   (flags & BATADV_MCAST_WANT_ALL_IPV4)
 				   ? '4' : '.',
 				   (flags & BATADV_MCAST_WANT_ALL_IPV6)
-				   ? '6' : '.');
+				   ? '6' : '.',
+				   (flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA)
+				   ? 'P' : '.');
 		}
 		rcu_read_unlock();
 	}
@@ -1280,6 +1913,161 @@ int batadv_mcast_flags_seq_print_text(struct seq_file *seq, void *offset)
 }
 #endif
 
+/**
+ * batadv_mcast_flags_dump_entry - dump the mcast flags of one originator
+ * @msg: Netlink message to dump into
+ * @portid: Port making netlink request
+ * @seq: Sequence number of netlink message
+ * @orig_node: the originator to dump
+ *
+ * The flags attribute is left out if the originator does not support
+ * multicast optimizations.
+ *
+ * Return: Error code, or 0 on success
+ */
+static int
+batadv_mcast_flags_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
+			      struct batadv_orig_node *orig_node)
+{
+	void *hdr;
+
+	hdr = genlmsg_put(msg, portid, seq, &batadv_netlink_family,
+			  NLM_F_MULTI, BATADV_CMD_GET_MCAST_FLAGS);
+	if (!hdr)
+		return -ENOBUFS;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, orig_node->orig))
+		goto nla_put_failure;
+
+	if (test_bit(BATADV_ORIG_CAPA_HAS_MCAST, &orig_node->capabilities) &&
+	    nla_put_u32(msg, BATADV_ATTR_MCAST_FLAGS, orig_node->mcast_flags))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return 0;
+
+ nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+/**
+ * batadv_mcast_flags_dump_bucket - dump the mcast flags of one hash bucket
+ * @msg: Netlink message to dump into
+ * @portid: Port making netlink request
+ * @seq: Sequence number of netlink message
+ * @filter: filter selecting the originators to dump
+ * @head: Pointer to the list containing the originators
+ * @idx_s: Number of entries to skip
+ *
+ * Return: Error code, or 0 on success
+ */
+static int
+batadv_mcast_flags_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
+			       const struct batadv_netlink_filter *filter,
+			       struct hlist_head *head, int *idx_s)
+{
+	struct batadv_orig_node *orig_node;
+	int idx = 0;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_node, head, hash_entry) {
+		if (idx++ < *idx_s)
+			continue;
+
+		if (!test_bit(BATADV_ORIG_CAPA_HAS_MCAST,
+			      &orig_node->capa_initialized))
+			continue;
+
+		if (!batadv_netlink_filter_orig(filter, orig_node->orig) ||
+		    !batadv_netlink_filter_prefix(filter, orig_node->orig,
+						  ETH_ALEN))
+			continue;
+
+		if (batadv_mcast_flags_dump_entry(msg, portid, seq,
+						  orig_node)) {
+			rcu_read_unlock();
+			*idx_s = idx - 1;
+			return -EMSGSIZE;
+		}
+	}
+	rcu_read_unlock();
+
+	*idx_s = 0;
+	return 0;
+}
+
+/**
+ * batadv_mcast_flags_dump - dump the mcast flags of other nodes into a message
+ * @msg: Netlink message to dump into
+ * @cb: Parameters from query
+ *
+ * Return: Error code, or length of message on success
+ */
+int batadv_mcast_flags_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	struct net *net = sock_net(cb->skb->sk);
+	struct batadv_hard_iface *primary_if = NULL;
+	struct batadv_netlink_filter filter;
+	struct net_device *soft_iface;
+	struct batadv_priv *bat_priv;
+	struct batadv_hashtable *hash;
+	struct hlist_head *head;
+	int ret;
+	int ifindex;
+	int bucket = cb->args[0];
+	int idx = cb->args[1];
+	int portid = NETLINK_CB(cb->skb).portid;
+
+	ifindex = batadv_netlink_get_ifindex(cb->nlh, BATADV_ATTR_MESH_IFINDEX);
+	if (!ifindex)
+		return -EINVAL;
+
+	if (batadv_netlink_filter_get(cb->nlh, &filter))
+		return -EINVAL;
+
+	soft_iface = dev_get_by_index(net, ifindex);
+	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	bat_priv = netdev_priv(soft_iface);
+
+	primary_if = batadv_primary_if_get_selected(bat_priv);
+	if (!primary_if || primary_if->if_status != BATADV_IF_ACTIVE) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	hash = bat_priv->orig_hash;
+	cb->seq = batadv_hash_dump_seq(hash);
+
+	while (bucket < hash->size) {
+		head = &hash->table[bucket];
+
+		if (batadv_mcast_flags_dump_bucket(msg, portid,
+						   cb->nlh->nlmsg_seq, &filter,
+						   head, &idx))
+			break;
+
+		bucket++;
+	}
+
+	ret = msg->len;
+
+out:
+	if (primary_if)
+		batadv_hardif_put(primary_if);
+	if (soft_iface)
+		dev_put(soft_iface);
+
+	cb->args[0] = bucket;
+	cb->args[1] = idx;
+
+	return ret;
+}
+
 /**
  * batadv_mcast_free - free the multicast optimizations structures
  * @bat_priv: the bat priv with all the soft interface information
@@ -1309,6 +2097,10 @@ void batadv_mcast_purge_orig(struct batadv_orig_node *orig)
 	    test_bit(BATADV_ORIG_CAPA_HAS_MCAST, &orig->capa_initialized))
 		atomic_dec(&bat_priv->mcast.num_disabled);
 
+	if (!(orig->mcast_flags & BATADV_MCAST_HAVE_MC_PTYPE_CAPA) &&
+	    test_bit(BATADV_ORIG_CAPA_HAS_MCAST, &orig->capa_initialized))
+		atomic_dec(&bat_priv->mcast.num_no_mc_ptype_capa);
+
 	batadv_mcast_want_unsnoop_update(bat_priv, orig, BATADV_NO_FLAGS);
 	batadv_mcast_want_ipv4_update(bat_priv, orig, BATADV_NO_FLAGS);
 	batadv_mcast_want_ipv6_update(bat_priv, orig, BATADV_NO_FLAGS);
@@ -20,8 +20,11 @@
 
 #include "main.h"
 
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+
+struct netlink_callback;
 struct seq_file;
-struct sk_buff;
 
 /**
  * enum batadv_forw_mode - the way a packet should be forwarded as
@@ -30,11 +33,14 @@ struct sk_buff;
  * @BATADV_FORW_SINGLE: forward the packet to a single node (currently via the
  *  BATMAN unicast routing protocol)
  * @BATADV_FORW_NONE: don't forward, drop it
+ * @BATADV_FORW_MCAST: forward the packet to a list of nodes via batman-adv
+ *  multicast packets carrying their addresses
  */
 enum batadv_forw_mode {
 	BATADV_FORW_ALL,
 	BATADV_FORW_SINGLE,
 	BATADV_FORW_NONE,
+	BATADV_FORW_MCAST,
 };
 
 #ifdef CONFIG_BATMAN_ADV_MCAST
@@ -43,10 +49,19 @@ enum batadv_forw_mode
 batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		       struct batadv_orig_node **mcast_single_orig);
 
+int batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+			   unsigned short vid);
+
+int batadv_mcast_module_init(void);
+
+void batadv_mcast_mla_update_trigger(struct batadv_priv *bat_priv);
+
 void batadv_mcast_init(struct batadv_priv *bat_priv);
 
 int batadv_mcast_flags_seq_print_text(struct seq_file *seq, void *offset);
 
+int batadv_mcast_flags_dump(struct sk_buff *msg, struct netlink_callback *cb);
+
 void batadv_mcast_free(struct batadv_priv *bat_priv);
 
 void batadv_mcast_purge_orig(struct batadv_orig_node *orig_node);
@@ -60,11 +75,35 @@ batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	return BATADV_FORW_ALL;
 }
 
+static inline int
+batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+		       unsigned short vid)
+{
+	kfree_skb(skb);
+	return NET_XMIT_DROP;
+}
+
+static inline int batadv_mcast_module_init(void)
+{
+	return 0;
+}
+
+static inline void
+batadv_mcast_mla_update_trigger(struct batadv_priv *bat_priv)
+{
+}
+
 static inline int batadv_mcast_init(struct batadv_priv *bat_priv)
 {
 	return 0;
 }
 
+static inline int
+batadv_mcast_flags_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	return -EOPNOTSUPP;
+}
+
 static inline void batadv_mcast_free(struct batadv_priv *bat_priv)
 {
 }
@@ -21,6 +21,7 @@
 #include <linux/atomic.h>
 #include <linux/byteorder/generic.h>
 #include <linux/cache.h>
+#include <linux/err.h>
 #include <linux/errno.h>
 #include <linux/export.h>
 #include <linux/fs.h>
@@ -28,13 +29,16 @@
 #include <linux/if_ether.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/printk.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/skbuff.h>
+#include <linux/slab.h>
 #include <linux/stddef.h>
+#include <linux/time.h>
 #include <linux/types.h>
 #include <net/genetlink.h>
 #include <net/netlink.h>
@@ -43,10 +47,15 @@
 
 #include "bat_algo.h"
 #include "bridge_loop_avoidance.h"
+#include "distributed-arp-table.h"
 #include "gateway_client.h"
 #include "hard-interface.h"
+#include "latency.h"
+#include "multicast.h"
+#include "network-coding.h"
 #include "originator.h"
 #include "packet.h"
+#include "ping.h"
 #include "soft-interface.h"
 #include "tp_meter.h"
 #include "translation-table.h"
@@ -57,10 +66,14 @@ struct genl_family batadv_netlink_family;
 /* multicast groups */
 enum batadv_netlink_multicast_groups {
 	BATADV_NL_MCGRP_TPMETER,
+	BATADV_NL_MCGRP_EVENTS,
+	BATADV_NL_MCGRP_PING,
 };
 
 static const struct genl_multicast_group batadv_netlink_mcgrps[] = {
 	[BATADV_NL_MCGRP_TPMETER] = { .name = BATADV_NL_MCAST_GROUP_TPMETER },
+	[BATADV_NL_MCGRP_EVENTS] = { .name = BATADV_NL_MCAST_GROUP_EVENTS },
+	[BATADV_NL_MCGRP_PING] = { .name = BATADV_NL_MCAST_GROUP_PING },
 };
 
 static const struct nla_policy batadv_netlink_policy[NUM_BATADV_ATTR] = {
@@ -99,6 +112,88 @@ static const struct nla_policy batadv_netlink_policy[NUM_BATADV_ATTR] = {
 	[BATADV_ATTR_BLA_CRC]		= { .type = NLA_U16 },
 	[BATADV_ATTR_SECRET_KEY]	= { .type = NLA_NUL_STRING },
 	[BATADV_ATTR_PRICE]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_NUM_STREAMS]	= { .type = NLA_U8 },
+	[BATADV_ATTR_TPMETER_BIDIRECTIONAL]	= { .type = NLA_FLAG },
+	[BATADV_ATTR_TPMETER_REVERSE_BYTES]	= { .type = NLA_U64 },
+	[BATADV_ATTR_TPMETER_STREAMS]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_TPMETER_STREAM]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_TPMETER_STREAM_ID]	= { .type = NLA_U8 },
+	[BATADV_ATTR_TPMETER_REVERSE]	= { .type = NLA_FLAG },
+	[BATADV_ATTR_TPMETER_CC]	= { .type = NLA_U8 },
+	[BATADV_ATTR_TPMETER_RATE]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_MIN]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_MAX]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_AVG]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_P50]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_P99]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_JITTER]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_HIST]	= { .type = NLA_BINARY },
+	[BATADV_ATTR_TPMETER_JITTER_HIST]	= { .type = NLA_BINARY },
+	[BATADV_ATTR_STATS_ENABLED]	= { .type = NLA_FLAG },
+	[BATADV_ATTR_STATS_STAGES]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_STATS_STAGE]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_STATS_STAGE_ID]	= { .type = NLA_U8 },
+	[BATADV_ATTR_STATS_COUNT]	= { .type = NLA_U64 },
+	[BATADV_ATTR_STATS_SUM]		= { .type = NLA_U64 },
+	[BATADV_ATTR_STATS_HIST]	= { .type = NLA_BINARY },
+	[BATADV_ATTR_EVENT_TYPE]	= { .type = NLA_U8 },
+	[BATADV_ATTR_EVENT_SEQNO]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PREV_ROUTER]	= { .len = ETH_ALEN },
+	[BATADV_ATTR_PING_COOKIE]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_DESTS]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_PING_COUNT]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_INTERVAL]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_SIZE]		= { .type = NLA_U16 },
+	[BATADV_ATTR_PING_RESULTS]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_PING_RESULT]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_PING_SENT]		= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_RECEIVED]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_RTT_MIN]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_RTT_MAX]	= { .type = NLA_U32 },
+	[BATADV_ATTR_PING_RTT_AVG]	= { .type = NLA_U32 },
+	[BATADV_ATTR_FILTER_ORIG]	= { .len = ETH_ALEN },
+	[BATADV_ATTR_FILTER_VID]	= { .type = NLA_U16 },
+	[BATADV_ATTR_FILTER_PREFIX]	= {
+		.type = NLA_BINARY,
+		.len = BATADV_NL_FILTER_PREFIX_MAX,
+	},
+	[BATADV_ATTR_FILTER_PREFIX_LEN]	= { .type = NLA_U8 },
+	[BATADV_ATTR_DAT_CACHE_IP4ADDRESS] = { .type = NLA_U32 },
+	[BATADV_ATTR_DAT_CACHE_HWADDRESS] = { .len = ETH_ALEN },
+	[BATADV_ATTR_DAT_CACHE_VID]	= { .type = NLA_U16 },
+	[BATADV_ATTR_MCAST_FLAGS]	= { .type = NLA_U32 },
+	[BATADV_ATTR_NC_NEIGH_ADDRESS]	= { .len = ETH_ALEN },
+	[BATADV_ATTR_NC_DIRECTION]	= { .type = NLA_U8 },
+	[BATADV_ATTR_DUMP_SNAPSHOT]	= { .type = NLA_FLAG },
+	[BATADV_ATTR_HARD_COUNTERS]	= { .type = NLA_NESTED },
+	[BATADV_ATTR_CRYPTO_SIGN]	= { .type = NLA_U64 },
+	[BATADV_ATTR_CRYPTO_VERIFY]	= { .type = NLA_U64 },
+	[BATADV_ATTR_CRYPTO_VERIFY_FAILED] = { .type = NLA_U64 },
+	[BATADV_ATTR_CRYPTO_KEY_CHANGE]	= { .type = NLA_U64 },
+};
+
+/* upper bound for the size of the attributes of a single mesh event */
+#define BATADV_NL_EVENT_SIZE 256
+
+/* attempts to take a snapshot which did not race with table changes */
+#define BATADV_NL_SNAPSHOT_TRIES 3
+
+/* upper bound for the number of skbs buffered by a single snapshot */
+#define BATADV_NL_SNAPSHOT_MAX_SKBS 4096
+
+/* cb->args slot holding the snapshot, the table dumps only use the first */
+#define BATADV_NL_SNAPSHOT_ARG 5
+
+/**
+ * struct batadv_netlink_snapshot - pre-rendered copy of a table dump
+ * @msgs: skbs holding the messages rendered when the dump started
+ * @offset: offset of the next message to hand out in the head of @msgs
+ * @intr: the table kept changing while the snapshot was rendered
+ */
+struct batadv_netlink_snapshot {
+	struct sk_buff_head msgs;
+	unsigned int offset;
+	bool intr;
 };
 
 /**
@@ -116,6 +211,60 @@ batadv_netlink_get_ifindex(const struct nlmsghdr *nlh, int attrtype)
 	return attr ? nla_get_u32(attr) : 0;
 }
 
+/**
+ * batadv_netlink_filter_get - Extract the dump filter from a message
+ * @nlh: Message header
+ * @filter: pointer to store the filter
+ *
+ * Return: 0 on success or -EINVAL if a filter attribute is malformed
+ */
+int batadv_netlink_filter_get(const struct nlmsghdr *nlh,
+			      struct batadv_netlink_filter *filter)
+{
+	struct nlattr *attr;
+
+	memset(filter, 0, sizeof(*filter));
+	filter->vid = -1;
+
+	attr = nlmsg_find_attr(nlh, GENL_HDRLEN, BATADV_ATTR_FILTER_ORIG);
+	if (attr) {
+		if (nla_len(attr) != ETH_ALEN)
+			return -EINVAL;
+
+		ether_addr_copy(filter->orig, nla_data(attr));
+		filter->has_orig = true;
+	}
+
+	attr = nlmsg_find_attr(nlh, GENL_HDRLEN, BATADV_ATTR_FILTER_VID);
+	if (attr) {
+		if (nla_len(attr) < sizeof(u16))
+			return -EINVAL;
+
+		filter->vid = nla_get_u16(attr);
+	}
+
+	attr = nlmsg_find_attr(nlh, GENL_HDRLEN, BATADV_ATTR_FILTER_PREFIX);
+	if (attr) {
+		if (!nla_len(attr) || nla_len(attr) > sizeof(filter->prefix))
+			return -EINVAL;
+
+		filter->prefix_size = nla_len(attr);
+		filter->prefix_len = filter->prefix_size * BITS_PER_BYTE;
+		memcpy(filter->prefix, nla_data(attr), filter->prefix_size);
+	}
+
+	attr = nlmsg_find_attr(nlh, GENL_HDRLEN, BATADV_ATTR_FILTER_PREFIX_LEN);
+	if (attr) {
+		if (nla_len(attr) < sizeof(u8) || !filter->prefix_size ||
+		    nla_get_u8(attr) > filter->prefix_len)
+			return -EINVAL;
+
+		filter->prefix_len = nla_get_u8(attr);
+	}
+
+	return 0;
+}
+
 /**
  * batadv_netlink_mesh_info_put - fill in generic information about mesh
  *  interface
@@ -208,146 +357,872 @@ batadv_netlink_get_mesh_info(struct sk_buff *skb, struct genl_info *info)
 		goto out;
 	}
 
-	msg_head = genlmsg_put(msg, info->snd_portid, info->snd_seq,
-			       &batadv_netlink_family, 0,
-			       BATADV_CMD_GET_MESH_INFO);
-	if (!msg_head) {
-		ret = -ENOBUFS;
+	msg_head = genlmsg_put(msg, info->snd_portid, info->snd_seq,
+			       &batadv_netlink_family, 0,
+			       BATADV_CMD_GET_MESH_INFO);
+	if (!msg_head) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	ret = batadv_netlink_mesh_info_put(msg, soft_iface);
+
+ out:
+	if (soft_iface)
+		dev_put(soft_iface);
+
+	if (ret) {
+		if (msg)
+			nlmsg_free(msg);
+		return ret;
+	}
+
+	genlmsg_end(msg, msg_head);
+	return genlmsg_reply(msg, info);
+}
+
+#ifdef CONFIG_BATMAN_ADV_BATMAN_V
+/**
+ * batadv_netlink_crypto_put - fill the OGM2 signature counters into a message
+ * @msg: netlink message to be sent back
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: 0 on success, < 0 on error
+ */
+static int batadv_netlink_crypto_put(struct sk_buff *msg,
+				     struct batadv_priv *bat_priv)
+{
+	u64 sign, verify, verify_failed, key_change;
+
+	sign = batadv_sum_counter(bat_priv, BATADV_CNT_OGM2_SIGN);
+	verify = batadv_sum_counter(bat_priv, BATADV_CNT_OGM2_VERIFY);
+	verify_failed = batadv_sum_counter(bat_priv,
+					   BATADV_CNT_OGM2_VERIFY_FAILED);
+	key_change = batadv_sum_counter(bat_priv, BATADV_CNT_OGM2_KEY_CHANGE);
+
+	if (nla_put_u64_64bit(msg, BATADV_ATTR_CRYPTO_SIGN, sign,
+			      BATADV_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_CRYPTO_VERIFY, verify,
+			      BATADV_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_CRYPTO_VERIFY_FAILED,
+			      verify_failed, BATADV_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_CRYPTO_KEY_CHANGE, key_change,
+			      BATADV_ATTR_PAD))
+		return -EMSGSIZE;
+
+	return 0;
+}
+#else
+static int batadv_netlink_crypto_put(struct sk_buff *msg,
+				     struct batadv_priv *bat_priv)
+{
+	return 0;
+}
+#endif
+
+/**
+ * batadv_netlink_get_stats - handle incoming BATADV_CMD_GET_STATS netlink
+ *  request
+ * @skb: received netlink message
+ * @info: receiver information
+ *
+ * Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_get_stats(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net *net = genl_info_net(info);
+	struct net_device *soft_iface;
+	struct sk_buff *msg = NULL;
+	void *msg_head;
+	int ifindex;
+	int ret;
+
+	if (!info->attrs[BATADV_ATTR_MESH_IFINDEX])
+		return -EINVAL;
+
+	ifindex = nla_get_u32(info->attrs[BATADV_ATTR_MESH_IFINDEX]);
+	if (!ifindex)
+		return -EINVAL;
+
+	soft_iface = dev_get_by_index(net, ifindex);
+	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	msg_head = genlmsg_put(msg, info->snd_portid, info->snd_seq,
+			       &batadv_netlink_family, 0,
+			       BATADV_CMD_GET_STATS);
+	if (!msg_head) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	if (nla_put_u32(msg, BATADV_ATTR_MESH_IFINDEX, soft_iface->ifindex)) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	ret = batadv_latency_put(msg, netdev_priv(soft_iface));
+	if (ret)
+		goto out;
+
+	ret = batadv_netlink_crypto_put(msg, netdev_priv(soft_iface));
+
+ out:
+	if (soft_iface)
+		dev_put(soft_iface);
+
+	if (ret) {
+		if (msg)
+			nlmsg_free(msg);
+		return ret;
+	}
+
+	genlmsg_end(msg, msg_head);
+	return genlmsg_reply(msg, info);
+}
+
+/**
+ * batadv_netlink_tp_meter_put - Fill information of started tp_meter session
+ * @msg: netlink message to be sent back
+ * @cookie: tp meter session cookie
+ *
+ *  Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tp_meter_put(struct sk_buff *msg, u32 cookie)
+{
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_COOKIE, cookie))
+		return -ENOBUFS;
+
+	return 0;
+}
+
+/**
+ * batadv_netlink_tpmeter_put_latency - Fill tp_meter RTT statistics
+ * @msg: netlink message to be sent back
+ * @lat: RTT statistics to report
+ *
+ *  Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tpmeter_put_latency(struct sk_buff *msg,
+				   const struct batadv_tp_latency *lat)
+{
+	u32 avg, p50, p99;
+
+	if (!lat->samples)
+		return 0;
+
+	avg = div_u64(lat->rtt_sum, lat->samples);
+	p50 = batadv_tp_hist_percentile(lat->rtt_hist, 50);
+	p99 = batadv_tp_hist_percentile(lat->rtt_hist, 99);
+
+	/* the percentiles are estimated from the histogram buckets */
+	p50 = clamp_t(u32, p50, lat->rtt_min, lat->rtt_max);
+	p99 = clamp_t(u32, p99, lat->rtt_min, lat->rtt_max);
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_MIN, lat->rtt_min) ||
+	    nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_MAX, lat->rtt_max) ||
+	    nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_AVG, avg) ||
+	    nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_P50, p50) ||
+	    nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_P99, p99) ||
+	    nla_put_u32(msg, BATADV_ATTR_TPMETER_JITTER, lat->jitter >> 4))
+		return -EMSGSIZE;
+
+	return 0;
+}
+
+/**
+ * batadv_netlink_tpmeter_put_streams - Fill per stream tp_meter results
+ * @msg: netlink message to be sent back
+ * @group: tp_meter session holding the stream results
+ *
+ *  Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tpmeter_put_streams(struct sk_buff *msg,
+				   const struct batadv_tp_group *group)
+{
+	const struct batadv_tp_stream_result *res;
+	struct nlattr *streams, *stream;
+	u64 reverse_bytes = 0;
+	bool reverse = false;
+	u8 i;
+
+	streams = nla_nest_start(msg, BATADV_ATTR_TPMETER_STREAMS);
+	if (!streams)
+		return -EMSGSIZE;
+
+	for (i = 0; i < group->num_streams; i++) {
+		res = &group->results[i];
+
+		stream = nla_nest_start(msg, BATADV_ATTR_TPMETER_STREAM);
+		if (!stream)
+			return -EMSGSIZE;
+
+		if (nla_put_u8(msg, BATADV_ATTR_TPMETER_STREAM_ID, i) ||
+		    nla_put_u8(msg, BATADV_ATTR_TPMETER_RESULT, res->reason) ||
+		    nla_put_u32(msg, BATADV_ATTR_TPMETER_TEST_TIME,
+				res->test_time) ||
+		    nla_put_u64_64bit(msg, BATADV_ATTR_TPMETER_BYTES,
+				      res->bytes, BATADV_ATTR_PAD))
+			return -EMSGSIZE;
+
+		if (res->reverse &&
+		    nla_put_flag(msg, BATADV_ATTR_TPMETER_REVERSE))
+			return -EMSGSIZE;
+
+		if (batadv_netlink_tpmeter_put_latency(msg, &res->lat))
+			return -EMSGSIZE;
+
+		nla_nest_end(msg, stream);
+
+		if (!res->reverse)
+			continue;
+
+		reverse = true;
+		reverse_bytes += res->bytes;
+	}
+
+	nla_nest_end(msg, streams);
+
+	if (reverse &&
+	    nla_put_u64_64bit(msg, BATADV_ATTR_TPMETER_REVERSE_BYTES,
+			      reverse_bytes, BATADV_ATTR_PAD))
+		return -EMSGSIZE;
+
+	if (!group->lat.samples)
+		return 0;
+
+	if (batadv_netlink_tpmeter_put_latency(msg, &group->lat))
+		return -EMSGSIZE;
+
+	if (nla_put(msg, BATADV_ATTR_TPMETER_RTT_HIST,
+		    sizeof(group->lat.rtt_hist), group->lat.rtt_hist) ||
+	    nla_put(msg, BATADV_ATTR_TPMETER_JITTER_HIST,
+		    sizeof(group->lat.jitter_hist), group->lat.jitter_hist))
+		return -EMSGSIZE;
+
+	return 0;
+}
+
+/**
+ * batadv_netlink_tpmeter_notify - send tp_meter result via netlink to client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst: destination of tp_meter session
+ * @result: reason for tp meter session stop
+ * @test_time: total time ot the tp_meter session
+ * @total_bytes: bytes acked to the receiver
+ * @cookie: cookie of tp_meter session
+ * @group: tp_meter session with per stream results, NULL if the session
+ *  could not be started
+ *
+ * Return: 0 on success, < 0 on error
+ */
+int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
+				  u8 result, u32 test_time, u64 total_bytes,
+				  u32 cookie,
+				  const struct batadv_tp_group *group)
+{
+	struct sk_buff *msg;
+	void *hdr;
+	int ret;
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = genlmsg_put(msg, 0, 0, &batadv_netlink_family, 0,
+			  BATADV_CMD_TP_METER);
+	if (!hdr) {
+		ret = -ENOBUFS;
+		goto err_genlmsg;
+	}
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_COOKIE, cookie))
+		goto nla_put_failure;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_TEST_TIME, test_time))
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(msg, BATADV_ATTR_TPMETER_BYTES, total_bytes,
+			      BATADV_ATTR_PAD))
+		goto nla_put_failure;
+
+	if (nla_put_u8(msg, BATADV_ATTR_TPMETER_RESULT, result))
+		goto nla_put_failure;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, dst))
+		goto nla_put_failure;
+
+	if (group && batadv_netlink_tpmeter_put_streams(msg, group))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+
+	genlmsg_multicast_netns(&batadv_netlink_family,
+				dev_net(bat_priv->soft_iface), msg, 0,
+				BATADV_NL_MCGRP_TPMETER, GFP_KERNEL);
+
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	ret = -EMSGSIZE;
+
+err_genlmsg:
+	nlmsg_free(msg);
+	return ret;
+}
+
+/**
+ * batadv_netlink_event_new - prepare a mesh event message
+ * @bat_priv: the bat priv with all the soft interface information
+ * @type: type of the event (see batadv_event_type)
+ * @hdr: pointer to store the generic netlink header of the message
+ *
+ * The event sequence number is only consumed when a message is built. A
+ * listener therefore sees a gap in the sequence numbers whenever an event was
+ * lost on its way, either here or when its socket buffer overflowed.
+ *
+ * Return: the message with the common event attributes or NULL if nobody is
+ * subscribed to the events multicast group or the message could not be built
+ */
+static struct sk_buff *batadv_netlink_event_new(struct batadv_priv *bat_priv,
+						u8 type, void **hdr)
+{
+	struct net *net = dev_net(bat_priv->soft_iface);
+	struct sk_buff *msg;
+	u32 seqno;
+
+	if (!genl_has_listeners(&batadv_netlink_family, net,
+				BATADV_NL_MCGRP_EVENTS))
+		return NULL;
+
+	seqno = atomic_inc_return(&bat_priv->event_seqno);
+
+	msg = nlmsg_new(BATADV_NL_EVENT_SIZE, GFP_ATOMIC);
+	if (!msg)
+		return NULL;
+
+	*hdr = genlmsg_put(msg, 0, 0, &batadv_netlink_family, 0,
+			   BATADV_CMD_EVENT);
+	if (!*hdr)
+		goto err;
+
+	if (nla_put_u32(msg, BATADV_ATTR_MESH_IFINDEX,
+			bat_priv->soft_iface->ifindex) ||
+	    nla_put_u8(msg, BATADV_ATTR_EVENT_TYPE, type) ||
+	    nla_put_u32(msg, BATADV_ATTR_EVENT_SEQNO, seqno))
+		goto err;
+
+	return msg;
+
+err:
+	nlmsg_free(msg);
+	return NULL;
+}
+
+/**
+ * batadv_netlink_event_send - send a mesh event to the events multicast group
+ * @bat_priv: the bat priv with all the soft interface information
+ * @msg: the message prepared by batadv_netlink_event_new()
+ * @hdr: generic netlink header of the message
+ */
+static void batadv_netlink_event_send(struct batadv_priv *bat_priv,
+				      struct sk_buff *msg, void *hdr)
+{
+	genlmsg_end(msg, hdr);
+
+	genlmsg_multicast_netns(&batadv_netlink_family,
+				dev_net(bat_priv->soft_iface), msg, 0,
+				BATADV_NL_MCGRP_EVENTS, GFP_ATOMIC);
+}
+
+/**
+ * batadv_netlink_route_notify - send a route change event
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: originator whose next hop changed
+ * @recv_if: the outgoing interface the route is valid for
+ * @old_router: previous next hop, NULL if there was no route
+ * @new_router: new next hop, NULL if the route was removed
+ */
+void batadv_netlink_route_notify(struct batadv_priv *bat_priv,
+				 struct batadv_orig_node *orig_node,
+				 struct batadv_hard_iface *recv_if,
+				 struct batadv_neigh_node *old_router,
+				 struct batadv_neigh_node *new_router)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = batadv_netlink_event_new(bat_priv, BATADV_EVENT_ROUTE, &hdr);
+	if (!msg)
+		return;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, orig_node->orig))
+		goto nla_put_failure;
+
+	if (recv_if != BATADV_IF_DEFAULT &&
+	    nla_put_u32(msg, BATADV_ATTR_HARD_IFINDEX,
+			recv_if->net_dev->ifindex))
+		goto nla_put_failure;
+
+	if (new_router &&
+	    nla_put(msg, BATADV_ATTR_ROUTER, ETH_ALEN, new_router->addr))
+		goto nla_put_failure;
+
+	if (old_router &&
+	    nla_put(msg, BATADV_ATTR_PREV_ROUTER, ETH_ALEN, old_router->addr))
+		goto nla_put_failure;
+
+	batadv_netlink_event_send(bat_priv, msg, hdr);
+	return;
+
+nla_put_failure:
+	nlmsg_free(msg);
+}
+
+/**
+ * batadv_netlink_orig_notify - send an originator add or remove event
+ * @bat_priv: the bat priv with all the soft interface information
+ * @type: BATADV_EVENT_ORIG_ADD or BATADV_EVENT_ORIG_DEL
+ * @orig: address of the originator
+ */
+void batadv_netlink_orig_notify(struct batadv_priv *bat_priv, u8 type,
+				const u8 *orig)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = batadv_netlink_event_new(bat_priv, type, &hdr);
+	if (!msg)
+		return;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, orig)) {
+		nlmsg_free(msg);
+		return;
+	}
+
+	batadv_netlink_event_send(bat_priv, msg, hdr);
+}
+
+/**
+ * batadv_netlink_tt_notify - send a global translation table event
+ * @bat_priv: the bat priv with all the soft interface information
+ * @type: BATADV_EVENT_TT_ADD, BATADV_EVENT_TT_DEL or BATADV_EVENT_TT_ROAM
+ * @addr: mac address of the client
+ * @vid: VLAN identifier of the client
+ * @orig: address of the originator announcing the client
+ * @flags: TT flags of the client
+ */
+void batadv_netlink_tt_notify(struct batadv_priv *bat_priv, u8 type,
+			      const u8 *addr, unsigned short vid,
+			      const u8 *orig, u16 flags)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = batadv_netlink_event_new(bat_priv, type, &hdr);
+	if (!msg)
+		return;
+
+	if (nla_put(msg, BATADV_ATTR_TT_ADDRESS, ETH_ALEN, addr) ||
+	    nla_put_u16(msg, BATADV_ATTR_TT_VID, vid) ||
+	    nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, orig) ||
+	    nla_put_u32(msg, BATADV_ATTR_TT_FLAGS, flags)) {
+		nlmsg_free(msg);
+		return;
+	}
+
+	batadv_netlink_event_send(bat_priv, msg, hdr);
+}
+
+/**
+ * batadv_netlink_gw_notify - send a gateway change event
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_orig: address of the newly selected gateway, NULL if the gateway was
+ *  deselected
+ */
+void batadv_netlink_gw_notify(struct batadv_priv *bat_priv, const u8 *gw_orig)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = batadv_netlink_event_new(bat_priv, BATADV_EVENT_GW_CHANGE, &hdr);
+	if (!msg)
+		return;
+
+	if (gw_orig &&
+	    nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, gw_orig)) {
+		nlmsg_free(msg);
+		return;
+	}
+
+	batadv_netlink_event_send(bat_priv, msg, hdr);
+}
+
+/**
+ * batadv_netlink_ping_result_size - get the message size of a ping result
+ *
+ * Return: space needed for the attributes of a single destination
+ */
+static size_t batadv_netlink_ping_result_size(void)
+{
+	/* nest, originator address, counters and RTTs */
+	return nla_total_size(0) + nla_total_size(ETH_ALEN) +
+	       5 * nla_total_size(sizeof(u32));
+}
+
+/**
+ * batadv_netlink_ping_put_result - put the result of a ping destination
+ * @msg: netlink message to put the result into
+ * @dest: the ping destination
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+static int batadv_netlink_ping_put_result(struct sk_buff *msg,
+					  const struct batadv_ping_dest *dest)
+{
+	struct nlattr *result;
+	u64 rtt_avg = 0;
+	u64 rtt_min = 0;
+
+	if (dest->received) {
+		rtt_avg = div_u64(dest->rtt_sum, dest->received);
+		rtt_min = dest->rtt_min;
+	}
+
+	result = nla_nest_start(msg, BATADV_ATTR_PING_RESULT);
+	if (!result)
+		return -EMSGSIZE;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, dest->addr) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_SENT, dest->sent) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_RECEIVED, dest->received) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_RTT_MIN,
+			div_u64(rtt_min, NSEC_PER_USEC)) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_RTT_MAX,
+			div_u64(dest->rtt_max, NSEC_PER_USEC)) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_RTT_AVG,
+			div_u64(rtt_avg, NSEC_PER_USEC))) {
+		nla_nest_cancel(msg, result);
+		return -EMSGSIZE;
+	}
+
+	nla_nest_end(msg, result);
+
+	return 0;
+}
+
+/**
+ * batadv_netlink_ping_notify - send the results of a ping session via netlink
+ * @bat_priv: the bat priv with all the soft interface information
+ * @ping_vars: the finished ping session
+ *
+ * Return: 0 on success, < 0 on error
+ */
+int batadv_netlink_ping_notify(struct batadv_priv *bat_priv,
+			       struct batadv_ping_vars *ping_vars)
+{
+	struct nlattr *results;
+	struct sk_buff *msg;
+	size_t size;
+	void *hdr;
+	int ret;
+	u16 i;
+
+	size = nla_total_size(sizeof(u32)) * 2 + nla_total_size(0) +
+	       ping_vars->num_dests * batadv_netlink_ping_result_size();
+
+	msg = genlmsg_new(size, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = genlmsg_put(msg, 0, 0, &batadv_netlink_family, 0,
+			  BATADV_CMD_PING);
+	if (!hdr) {
+		ret = -ENOBUFS;
+		goto err_genlmsg;
+	}
+
+	if (nla_put_u32(msg, BATADV_ATTR_MESH_IFINDEX,
+			bat_priv->soft_iface->ifindex) ||
+	    nla_put_u32(msg, BATADV_ATTR_PING_COOKIE, ping_vars->cookie))
+		goto nla_put_failure;
+
+	results = nla_nest_start(msg, BATADV_ATTR_PING_RESULTS);
+	if (!results)
+		goto nla_put_failure;
+
+	/* late replies may still be accounted */
+	spin_lock_bh(&ping_vars->lock);
+	for (i = 0; i < ping_vars->num_dests; i++) {
+		if (batadv_netlink_ping_put_result(msg, &ping_vars->dests[i]))
+			break;
+	}
+	spin_unlock_bh(&ping_vars->lock);
+
+	if (i < ping_vars->num_dests)
+		goto nla_put_failure;
+
+	nla_nest_end(msg, results);
+	genlmsg_end(msg, hdr);
+
+	genlmsg_multicast_netns(&batadv_netlink_family,
+				dev_net(bat_priv->soft_iface), msg, 0,
+				BATADV_NL_MCGRP_PING, GFP_KERNEL);
+
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	ret = -EMSGSIZE;
+
+err_genlmsg:
+	nlmsg_free(msg);
+	return ret;
+}
+
+/**
+ * batadv_netlink_tp_meter_start - Start a new tp_meter session
+ * @skb: received netlink message
+ * @info: receiver information
+ *
+ * Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net *net = genl_info_net(info);
+	struct net_device *soft_iface;
+	struct batadv_priv *bat_priv;
+	struct sk_buff *msg = NULL;
+	struct nlattr *attr;
+	u8 cc = BATADV_TP_CC_RENO;
+	u8 num_streams = 1;
+	u32 rate = 0;
+	bool bidirectional;
+	u32 test_length;
+	void *msg_head;
+	int ifindex;
+	u32 cookie;
+	u8 *dst;
+	int ret;
+
+	if (!info->attrs[BATADV_ATTR_MESH_IFINDEX])
+		return -EINVAL;
+
+	if (!info->attrs[BATADV_ATTR_ORIG_ADDRESS])
+		return -EINVAL;
+
+	if (!info->attrs[BATADV_ATTR_TPMETER_TEST_TIME])
+		return -EINVAL;
+
+	ifindex = nla_get_u32(info->attrs[BATADV_ATTR_MESH_IFINDEX]);
+	if (!ifindex)
+		return -EINVAL;
+
+	dst = nla_data(info->attrs[BATADV_ATTR_ORIG_ADDRESS]);
+
+	test_length = nla_get_u32(info->attrs[BATADV_ATTR_TPMETER_TEST_TIME]);
+
+	if (info->attrs[BATADV_ATTR_TPMETER_NUM_STREAMS]) {
+		attr = info->attrs[BATADV_ATTR_TPMETER_NUM_STREAMS];
+		num_streams = nla_get_u8(attr);
+	}
+
+	if (!num_streams || num_streams > BATADV_TP_MAX_STREAMS)
+		return -EINVAL;
+
+	attr = info->attrs[BATADV_ATTR_TPMETER_BIDIRECTIONAL];
+	bidirectional = nla_get_flag(attr);
+
+	if (info->attrs[BATADV_ATTR_TPMETER_CC])
+		cc = nla_get_u8(info->attrs[BATADV_ATTR_TPMETER_CC]);
+
+	if (cc >= NUM_BATADV_TP_CC)
+		return -EINVAL;
+
+	if (info->attrs[BATADV_ATTR_TPMETER_RATE])
+		rate = nla_get_u32(info->attrs[BATADV_ATTR_TPMETER_RATE]);
+
+	soft_iface = dev_get_by_index(net, ifindex);
+	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	msg_head = genlmsg_put(msg, info->snd_portid, info->snd_seq,
+			       &batadv_netlink_family, 0,
+			       BATADV_CMD_TP_METER);
+	if (!msg_head) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	bat_priv = netdev_priv(soft_iface);
+	batadv_tp_start(bat_priv, dst, test_length, num_streams, bidirectional,
+			cc, rate, &cookie);
+
+	ret = batadv_netlink_tp_meter_put(msg, cookie);
+
+ out:
+	if (soft_iface)
+		dev_put(soft_iface);
+
+	if (ret) {
+		if (msg)
+			nlmsg_free(msg);
+		return ret;
+	}
+
+	genlmsg_end(msg, msg_head);
+	return genlmsg_reply(msg, info);
+}
+
+/**
+ * batadv_netlink_tp_meter_start - Cancel a running tp_meter session
+ * @skb: received netlink message
+ * @info: receiver information
+ *
+ * Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tp_meter_cancel(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net *net = genl_info_net(info);
+	struct net_device *soft_iface;
+	struct batadv_priv *bat_priv;
+	int ifindex;
+	u8 *dst;
+	int ret = 0;
+
+	if (!info->attrs[BATADV_ATTR_MESH_IFINDEX])
+		return -EINVAL;
+
+	if (!info->attrs[BATADV_ATTR_ORIG_ADDRESS])
+		return -EINVAL;
+
+	ifindex = nla_get_u32(info->attrs[BATADV_ATTR_MESH_IFINDEX]);
+	if (!ifindex)
+		return -EINVAL;
+
+	dst = nla_data(info->attrs[BATADV_ATTR_ORIG_ADDRESS]);
+
+	soft_iface = dev_get_by_index(net, ifindex);
+	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
+		ret = -ENODEV;
 		goto out;
 	}
 
-	ret = batadv_netlink_mesh_info_put(msg, soft_iface);
+	bat_priv = netdev_priv(soft_iface);
+	batadv_tp_stop(bat_priv, dst, BATADV_TP_REASON_CANCEL);
 
- out:
+out:
 	if (soft_iface)
 		dev_put(soft_iface);
 
-	if (ret) {
-		if (msg)
-			nlmsg_free(msg);
-		return ret;
-	}
-
-	genlmsg_end(msg, msg_head);
-	return genlmsg_reply(msg, info);
-}
-
-/**
- * batadv_netlink_tp_meter_put - Fill information of started tp_meter session
- * @msg: netlink message to be sent back
- * @cookie: tp meter session cookie
- *
- *  Return: 0 on success, < 0 on error
- */
-static int
-batadv_netlink_tp_meter_put(struct sk_buff *msg, u32 cookie)
-{
-	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_COOKIE, cookie))
-		return -ENOBUFS;
-
-	return 0;
+	return ret;
 }
 
 /**
- * batadv_netlink_tpmeter_notify - send tp_meter result via netlink to client
- * @bat_priv: the bat priv with all the soft interface information
- * @dst: destination of tp_meter session
- * @result: reason for tp meter session stop
- * @test_time: total time ot the tp_meter session
- * @total_bytes: bytes acked to the receiver
- * @cookie: cookie of tp_meter session
+ * batadv_netlink_ping_parse_dests - collect the destinations of a ping session
+ * @attr: the BATADV_ATTR_PING_DESTS attribute
+ * @num_dests: pointer to store the number of destinations
  *
- * Return: 0 on success, < 0 on error
+ * Return: array of originator addresses or error pointer
  */
-int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
-				  u8 result, u32 test_time, u64 total_bytes,
-				  u32 cookie)
+static u8 *batadv_netlink_ping_parse_dests(const struct nlattr *attr,
+					   u16 *num_dests)
 {
-	struct sk_buff *msg;
-	void *hdr;
-	int ret;
+	const struct nlattr *dest;
+	unsigned int num = 0;
+	u8 *dests;
+	int rem;
 
-	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
-	if (!msg)
-		return -ENOMEM;
+	nla_for_each_nested(dest, attr, rem) {
+		if (nla_type(dest) != BATADV_ATTR_ORIG_ADDRESS ||
+		    nla_len(dest) != ETH_ALEN)
+			return ERR_PTR(-EINVAL);
 
-	hdr = genlmsg_put(msg, 0, 0, &batadv_netlink_family, 0,
-			  BATADV_CMD_TP_METER);
-	if (!hdr) {
-		ret = -ENOBUFS;
-		goto err_genlmsg;
+		num++;
 	}
 
-	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_COOKIE, cookie))
-		goto nla_put_failure;
-
-	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_TEST_TIME, test_time))
-		goto nla_put_failure;
-
-	if (nla_put_u64_64bit(msg, BATADV_ATTR_TPMETER_BYTES, total_bytes,
-			      BATADV_ATTR_PAD))
-		goto nla_put_failure;
-
-	if (nla_put_u8(msg, BATADV_ATTR_TPMETER_RESULT, result))
-		goto nla_put_failure;
-
-	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, dst))
-		goto nla_put_failure;
-
-	genlmsg_end(msg, hdr);
+	if (!num || num > BATADV_PING_MAX_DESTS)
+		return ERR_PTR(-EINVAL);
 
-	genlmsg_multicast_netns(&batadv_netlink_family,
-				dev_net(bat_priv->soft_iface), msg, 0,
-				BATADV_NL_MCGRP_TPMETER, GFP_KERNEL);
+	dests = kmalloc_array(num, ETH_ALEN, GFP_KERNEL);
+	if (!dests)
+		return ERR_PTR(-ENOMEM);
 
-	return 0;
+	num = 0;
+	nla_for_each_nested(dest, attr, rem)
+		ether_addr_copy(&dests[num++ * ETH_ALEN], nla_data(dest));
 
-nla_put_failure:
-	genlmsg_cancel(msg, hdr);
-	ret = -EMSGSIZE;
+	*num_dests = num;
 
-err_genlmsg:
-	nlmsg_free(msg);
-	return ret;
+	return dests;
 }
 
 /**
- * batadv_netlink_tp_meter_start - Start a new tp_meter session
+ * batadv_netlink_ping_start - Start a new ping session
  * @skb: received netlink message
  * @info: receiver information
  *
  * Return: 0 on success, < 0 on error
  */
 static int
-batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
+batadv_netlink_ping_start(struct sk_buff *skb, struct genl_info *info)
 {
 	struct net *net = genl_info_net(info);
 	struct net_device *soft_iface;
 	struct batadv_priv *bat_priv;
 	struct sk_buff *msg = NULL;
-	u32 test_length;
+	struct nlattr *attr;
+	u32 interval = 1000;
+	u8 *dests = NULL;
+	u16 num_dests;
+	u32 count = 1;
 	void *msg_head;
+	u16 size = 0;
 	int ifindex;
 	u32 cookie;
-	u8 *dst;
 	int ret;
 
 	if (!info->attrs[BATADV_ATTR_MESH_IFINDEX])
 		return -EINVAL;
 
-	if (!info->attrs[BATADV_ATTR_ORIG_ADDRESS])
-		return -EINVAL;
-
-	if (!info->attrs[BATADV_ATTR_TPMETER_TEST_TIME])
+	if (!info->attrs[BATADV_ATTR_PING_DESTS])
 		return -EINVAL;
 
 	ifindex = nla_get_u32(info->attrs[BATADV_ATTR_MESH_IFINDEX]);
 	if (!ifindex)
 		return -EINVAL;
 
-	dst = nla_data(info->attrs[BATADV_ATTR_ORIG_ADDRESS]);
+	if (info->attrs[BATADV_ATTR_PING_COUNT])
+		count = nla_get_u32(info->attrs[BATADV_ATTR_PING_COUNT]);
 
-	test_length = nla_get_u32(info->attrs[BATADV_ATTR_TPMETER_TEST_TIME]);
+	if (info->attrs[BATADV_ATTR_PING_INTERVAL])
+		interval = nla_get_u32(info->attrs[BATADV_ATTR_PING_INTERVAL]);
+
+	if (info->attrs[BATADV_ATTR_PING_SIZE])
+		size = nla_get_u16(info->attrs[BATADV_ATTR_PING_SIZE]);
 
 	soft_iface = dev_get_by_index(net, ifindex);
 	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
@@ -355,6 +1230,14 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 		goto out;
 	}
 
+	attr = info->attrs[BATADV_ATTR_PING_DESTS];
+	dests = batadv_netlink_ping_parse_dests(attr, &num_dests);
+	if (IS_ERR(dests)) {
+		ret = PTR_ERR(dests);
+		dests = NULL;
+		goto out;
+	}
+
 	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
 	if (!msg) {
 		ret = -ENOMEM;
@@ -362,19 +1245,24 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 	}
 
 	msg_head = genlmsg_put(msg, info->snd_portid, info->snd_seq,
-			       &batadv_netlink_family, 0,
-			       BATADV_CMD_TP_METER);
+			       &batadv_netlink_family, 0, BATADV_CMD_PING);
 	if (!msg_head) {
 		ret = -ENOBUFS;
 		goto out;
 	}
 
 	bat_priv = netdev_priv(soft_iface);
-	batadv_tp_start(bat_priv, dst, test_length, &cookie);
+	ret = batadv_ping_start(bat_priv, dests, num_dests, count, interval,
+				size, &cookie);
+	if (ret < 0)
+		goto out;
 
-	ret = batadv_netlink_tp_meter_put(msg, cookie);
+	if (nla_put_u32(msg, BATADV_ATTR_PING_COOKIE, cookie))
+		ret = -ENOBUFS;
 
  out:
+	kfree(dests);
+
 	if (soft_iface)
 		dev_put(soft_iface);
 
@@ -389,33 +1277,33 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 }
 
 /**
- * batadv_netlink_tp_meter_start - Cancel a running tp_meter session
+ * batadv_netlink_ping_cancel - Cancel a running ping session
  * @skb: received netlink message
  * @info: receiver information
  *
  * Return: 0 on success, < 0 on error
  */
 static int
-batadv_netlink_tp_meter_cancel(struct sk_buff *skb, struct genl_info *info)
+batadv_netlink_ping_cancel(struct sk_buff *skb, struct genl_info *info)
 {
 	struct net *net = genl_info_net(info);
 	struct net_device *soft_iface;
 	struct batadv_priv *bat_priv;
 	int ifindex;
-	u8 *dst;
-	int ret = 0;
+	u32 cookie;
+	int ret;
 
 	if (!info->attrs[BATADV_ATTR_MESH_IFINDEX])
 		return -EINVAL;
 
-	if (!info->attrs[BATADV_ATTR_ORIG_ADDRESS])
+	if (!info->attrs[BATADV_ATTR_PING_COOKIE])
 		return -EINVAL;
 
 	ifindex = nla_get_u32(info->attrs[BATADV_ATTR_MESH_IFINDEX]);
 	if (!ifindex)
 		return -EINVAL;
 
-	dst = nla_data(info->attrs[BATADV_ATTR_ORIG_ADDRESS]);
+	cookie = nla_get_u32(info->attrs[BATADV_ATTR_PING_COOKIE]);
 
 	soft_iface = dev_get_by_index(net, ifindex);
 	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
@@ -424,7 +1312,7 @@ batadv_netlink_tp_meter_cancel(struct sk_buff *skb, struct genl_info *info)
 	}
 
 	bat_priv = netdev_priv(soft_iface);
-	batadv_tp_stop(bat_priv, dst, BATADV_TP_REASON_CANCEL);
+	ret = batadv_ping_stop(bat_priv, cookie);
 
 out:
 	if (soft_iface)
@@ -433,6 +1321,40 @@ out:
 	return ret;
 }
 
+/**
+ * batadv_netlink_hardif_counters_put - add the control plane counters of a
+ *  hard interface to a message
+ * @msg: Netlink message to dump into
+ * @hard_iface: Hard interface to dump
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+static int
+batadv_netlink_hardif_counters_put(struct sk_buff *msg,
+				   struct batadv_hard_iface *hard_iface)
+{
+	struct nlattr *counters;
+	u64 value;
+	int i;
+
+	counters = nla_nest_start(msg, BATADV_ATTR_HARD_COUNTERS);
+	if (!counters)
+		return -EMSGSIZE;
+
+	for (i = BATADV_HARDIF_CNT_PAD + 1; i < NUM_BATADV_HARDIF_CNT; i++) {
+		value = batadv_hardif_sum_counter(hard_iface, i);
+
+		if (nla_put_u64_64bit(msg, i, value, BATADV_HARDIF_CNT_PAD)) {
+			nla_nest_cancel(msg, counters);
+			return -EMSGSIZE;
+		}
+	}
+
+	nla_nest_end(msg, counters);
+
+	return 0;
+}
+
 /**
  * batadv_netlink_dump_hardif_entry - Dump one hard interface into a message
  * @msg: Netlink message to dump into
@@ -467,6 +1389,9 @@ batadv_netlink_dump_hardif_entry(struct sk_buff *msg, u32 portid, u32 seq,
 			goto nla_put_failure;
 	}
 
+	if (batadv_netlink_hardif_counters_put(msg, hard_iface))
+		goto nla_put_failure;
+
 	genlmsg_end(msg, hdr);
 	return 0;
 
@@ -686,6 +1611,236 @@ batadv_netlink_dump_hardifs(struct sk_buff *msg, struct netlink_callback *cb)
 	return msg->len;
 }
 
+/* table dumps which can be served through batadv_netlink_dump() */
+static int (* const batadv_netlink_dumps[])(struct sk_buff *msg,
+					    struct netlink_callback *cb) = {
+	[BATADV_CMD_GET_ROUTING_ALGOS] = batadv_algo_dump,
+	[BATADV_CMD_GET_HARDIFS] = batadv_netlink_dump_hardifs,
+	[BATADV_CMD_GET_TRANSTABLE_LOCAL] = batadv_tt_local_dump,
+	[BATADV_CMD_GET_TRANSTABLE_GLOBAL] = batadv_tt_global_dump,
+	[BATADV_CMD_GET_ORIGINATORS] = batadv_orig_dump,
+	[BATADV_CMD_GET_NEIGHBORS] = batadv_hardif_neigh_dump,
+	[BATADV_CMD_GET_GATEWAYS] = batadv_gw_dump,
+	[BATADV_CMD_GET_BLA_CLAIM] = batadv_bla_claim_dump,
+	[BATADV_CMD_GET_BLA_BACKBONE] = batadv_bla_backbone_dump,
+	[BATADV_CMD_GET_DAT_CACHE] = batadv_dat_cache_dump,
+	[BATADV_CMD_GET_MCAST_FLAGS] = batadv_mcast_flags_dump,
+	[BATADV_CMD_GET_NC_NODES] = batadv_nc_nodes_dump,
+};
+
+/**
+ * batadv_netlink_snapshot_render - render a complete table dump into skbs
+ * @cb: Parameters from query
+ * @dump: the table dump to render
+ * @snapshot: the snapshot to fill
+ *
+ * The dump is driven to its end on a private copy of @cb without returning to
+ * userspace in between. The dump sequence (cb->seq) reported by each round is
+ * compared to detect additions or removals which raced with the rendering.
+ *
+ * Return: 0 on a consistent snapshot, 1 if the table changed meanwhile or a
+ * negative error code
+ */
+static int
+batadv_netlink_snapshot_render(struct netlink_callback *cb,
+			       int (*dump)(struct sk_buff *msg,
+					   struct netlink_callback *cb),
+			       struct batadv_netlink_snapshot *snapshot)
+{
+	struct netlink_callback snap_cb = *cb;
+	unsigned int seq = 0;
+	struct sk_buff *skb;
+	bool changed = false;
+	bool first = true;
+	int ret;
+
+	memset(snap_cb.args, 0, sizeof(snap_cb.args));
+	snap_cb.seq = 0;
+	snap_cb.prev_seq = 0;
+
+	while (true) {
+		if (skb_queue_len(&snapshot->msgs) >=
+		    BATADV_NL_SNAPSHOT_MAX_SKBS)
+			return -E2BIG;
+
+		skb = alloc_skb(NLMSG_GOODSIZE, GFP_KERNEL);
+		if (!skb)
+			return -ENOMEM;
+
+		ret = dump(skb, &snap_cb);
+
+		if (first)
+			seq = snap_cb.seq;
+		else if (snap_cb.seq != seq)
+			changed = true;
+		first = false;
+
+		if (ret <= 0 || !skb->len) {
+			kfree_skb(skb);
+			break;
+		}
+
+		skb_queue_tail(&snapshot->msgs, skb);
+	}
+
+	if (ret < 0)
+		return ret;
+
+	return changed;
+}
+
+/**
+ * batadv_netlink_snapshot_take - take a consistent snapshot of a table dump
+ * @cb: Parameters from query
+ * @dump: the table dump to render
+ *
+ * The snapshot is rendered again as long as it raced with table changes, at
+ * most BATADV_NL_SNAPSHOT_TRIES times. If the table never settles, the last
+ * snapshot is used and its messages are flagged with NLM_F_DUMP_INTR.
+ *
+ * Return: the snapshot or an error pointer
+ */
+static struct batadv_netlink_snapshot *
+batadv_netlink_snapshot_take(struct netlink_callback *cb,
+			     int (*dump)(struct sk_buff *msg,
+					 struct netlink_callback *cb))
+{
+	struct batadv_netlink_snapshot *snapshot;
+	int tries;
+	int ret;
+
+	snapshot = kzalloc(sizeof(*snapshot), GFP_KERNEL);
+	if (!snapshot)
+		return ERR_PTR(-ENOMEM);
+
+	skb_queue_head_init(&snapshot->msgs);
+
+	for (tries = 0; tries < BATADV_NL_SNAPSHOT_TRIES; tries++) {
+		skb_queue_purge(&snapshot->msgs);
+
+		ret = batadv_netlink_snapshot_render(cb, dump, snapshot);
+		if (ret <= 0)
+			break;
+	}
+
+	if (ret < 0) {
+		skb_queue_purge(&snapshot->msgs);
+		kfree(snapshot);
+		return ERR_PTR(ret);
+	}
+
+	snapshot->intr = ret > 0;
+
+	return snapshot;
+}
+
+/**
+ * batadv_netlink_snapshot_fill - hand out the messages of a snapshot
+ * @msg: Netlink message to dump into
+ * @snapshot: the snapshot to read from
+ *
+ * Return: Error code, or length of message on success
+ */
+static int
+batadv_netlink_snapshot_fill(struct sk_buff *msg,
+			     struct batadv_netlink_snapshot *snapshot)
+{
+	struct nlmsghdr *nlh;
+	struct sk_buff *skb;
+	unsigned int len;
+
+	while ((skb = skb_peek(&snapshot->msgs))) {
+		while (snapshot->offset < skb->len) {
+			nlh = (struct nlmsghdr *)(skb->data + snapshot->offset);
+			len = min_t(unsigned int, NLMSG_ALIGN(nlh->nlmsg_len),
+				    skb->len - snapshot->offset);
+
+			if (skb_tailroom(msg) < len)
+				return msg->len ? msg->len : -EMSGSIZE;
+
+			if (snapshot->intr)
+				nlh->nlmsg_flags |= NLM_F_DUMP_INTR;
+
+			memcpy(skb_put(msg, len), nlh, len);
+			snapshot->offset += len;
+		}
+
+		skb_unlink(skb, &snapshot->msgs);
+		kfree_skb(skb);
+		snapshot->offset = 0;
+	}
+
+	return msg->len;
+}
+
+/**
+ * batadv_netlink_dump - dump a table, optionally from a snapshot
+ * @msg: Netlink message to dump into
+ * @cb: Parameters from query
+ *
+ * Without BATADV_ATTR_DUMP_SNAPSHOT the table is walked live across the dump
+ * rounds and messages following a table change are flagged with
+ * NLM_F_DUMP_INTR. With it, the whole table is rendered into a snapshot on
+ * the first round and the following rounds only copy from it.
+ *
+ * Return: Error code, or length of message on success
+ */
+static int batadv_netlink_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	int (*dump)(struct sk_buff *msg, struct netlink_callback *cb);
+	struct batadv_netlink_snapshot *snapshot;
+	struct genlmsghdr *genlhdr = nlmsg_data(cb->nlh);
+	int ret;
+
+	if (genlhdr->cmd >= ARRAY_SIZE(batadv_netlink_dumps) ||
+	    !batadv_netlink_dumps[genlhdr->cmd])
+		return -EOPNOTSUPP;
+
+	dump = batadv_netlink_dumps[genlhdr->cmd];
+
+	if (!nlmsg_find_attr(cb->nlh, GENL_HDRLEN, BATADV_ATTR_DUMP_SNAPSHOT)) {
+		ret = dump(msg, cb);
+		if (ret > 0)
+			nl_dump_check_consistent(cb, nlmsg_hdr(msg));
+
+		return ret;
+	}
+
+	snapshot = (struct batadv_netlink_snapshot *)
+		   cb->args[BATADV_NL_SNAPSHOT_ARG];
+	if (!snapshot) {
+		snapshot = batadv_netlink_snapshot_take(cb, dump);
+		if (IS_ERR(snapshot))
+			return PTR_ERR(snapshot);
+
+		cb->args[BATADV_NL_SNAPSHOT_ARG] = (long)snapshot;
+	}
+
+	return batadv_netlink_snapshot_fill(msg, snapshot);
+}
+
+/**
+ * batadv_netlink_dump_done - release the snapshot of a finished table dump
+ * @cb: Parameters from query
+ *
+ * Return: always 0
+ */
+static int batadv_netlink_dump_done(struct netlink_callback *cb)
+{
+	struct batadv_netlink_snapshot *snapshot;
+
+	snapshot = (struct batadv_netlink_snapshot *)
+		   cb->args[BATADV_NL_SNAPSHOT_ARG];
+	if (!snapshot)
+		return 0;
+
+	skb_queue_purge(&snapshot->msgs);
+	kfree(snapshot);
+	cb->args[BATADV_NL_SNAPSHOT_ARG] = 0;
+
+	return 0;
+}
+
 static const struct genl_ops batadv_netlink_ops[] = {
 	{
 		.cmd = BATADV_CMD_GET_MESH_INFO,
@@ -705,59 +1860,101 @@ static const struct genl_ops batadv_netlink_ops[] = {
 		.policy = batadv_netlink_policy,
 		.doit = batadv_netlink_tp_meter_cancel,
 	},
+	{
+		.cmd = BATADV_CMD_PING,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.doit = batadv_netlink_ping_start,
+	},
+	{
+		.cmd = BATADV_CMD_PING_CANCEL,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.doit = batadv_netlink_ping_cancel,
+	},
 	{
 		.cmd = BATADV_CMD_GET_ROUTING_ALGOS,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_algo_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_HARDIFS,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_netlink_dump_hardifs,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_TRANSTABLE_LOCAL,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_tt_local_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_TRANSTABLE_GLOBAL,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_tt_global_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_ORIGINATORS,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_orig_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_NEIGHBORS,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_hardif_neigh_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_GATEWAYS,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_gw_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_BLA_CLAIM,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_bla_claim_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_GET_BLA_BACKBONE,
 		.flags = GENL_ADMIN_PERM,
 		.policy = batadv_netlink_policy,
-		.dumpit = batadv_bla_backbone_dump,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
+	},
+	{
+		.cmd = BATADV_CMD_GET_DAT_CACHE,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
+	},
+	{
+		.cmd = BATADV_CMD_GET_MCAST_FLAGS,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
+	},
+	{
+		.cmd = BATADV_CMD_GET_NC_NODES,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.dumpit = batadv_netlink_dump,
+		.done = batadv_netlink_dump_done,
 	},
 	{
 		.cmd = BATADV_CMD_SET_SECRET_KEY,
@@ -783,6 +1980,12 @@ static const struct genl_ops batadv_netlink_ops[] = {
 		.policy = batadv_netlink_policy,
 		.doit = batadv_get_price,
 	},
+	{
+		.cmd = BATADV_CMD_GET_STATS,
+		.flags = GENL_ADMIN_PERM,
+		.policy = batadv_netlink_policy,
+		.doit = batadv_netlink_get_stats,
+	},
 
 };
 
@@ -20,18 +20,127 @@
 
 #include "main.h"
 
+#include <linux/bitops.h>
+#include <linux/if_ether.h>
+#include <linux/string.h>
 #include <linux/types.h>
 #include <net/genetlink.h>
 
+struct batadv_hard_iface;
+struct batadv_neigh_node;
+struct batadv_orig_node;
+struct batadv_ping_vars;
+struct batadv_tp_group;
 struct nlmsghdr;
 
+/* longest prefix accepted by the dump filter */
+#define BATADV_NL_FILTER_PREFIX_MAX ETH_ALEN
+
+/**
+ * struct batadv_netlink_filter - server side filter of a table dump
+ * @orig: only dump entries belonging to this originator
+ * @has_orig: whether @orig is set
+ * @vid: only dump entries of this VLAN, negative to dump all VLANs
+ * @prefix: only dump entries whose address starts with this prefix
+ * @prefix_size: size of @prefix in bytes, 0 if no prefix is set
+ * @prefix_len: number of significant bits of @prefix
+ */
+struct batadv_netlink_filter {
+	u8 orig[ETH_ALEN];
+	bool has_orig;
+	int vid;
+	u8 prefix[BATADV_NL_FILTER_PREFIX_MAX];
+	unsigned int prefix_size;
+	unsigned int prefix_len;
+};
+
 void batadv_netlink_register(void);
 void batadv_netlink_unregister(void);
 int batadv_netlink_get_ifindex(const struct nlmsghdr *nlh, int attrtype);
+int batadv_netlink_filter_get(const struct nlmsghdr *nlh,
+			      struct batadv_netlink_filter *filter);
+
+/**
+ * batadv_netlink_filter_orig - check an originator against a dump filter
+ * @filter: the dump filter
+ * @orig: address of the originator
+ *
+ * Return: true if the entry passes the filter
+ */
+static inline bool
+batadv_netlink_filter_orig(const struct batadv_netlink_filter *filter,
+			   const u8 *orig)
+{
+	return !filter->has_orig || batadv_compare_eth(filter->orig, orig);
+}
+
+/**
+ * batadv_netlink_filter_vid - check a VLAN against a dump filter
+ * @filter: the dump filter
+ * @vid: VLAN identifier of the entry
+ *
+ * Return: true if the entry passes the filter
+ */
+static inline bool
+batadv_netlink_filter_vid(const struct batadv_netlink_filter *filter,
+			  unsigned short vid)
+{
+	return filter->vid < 0 || filter->vid == vid;
+}
+
+/**
+ * batadv_netlink_filter_prefix - check an address against a dump filter
+ * @filter: the dump filter
+ * @addr: the address of the entry
+ * @size: size of @addr in bytes
+ *
+ * Return: true if the entry passes the filter. Addresses of a different size
+ * than the prefix never match.
+ */
+static inline bool
+batadv_netlink_filter_prefix(const struct batadv_netlink_filter *filter,
+			     const void *addr, unsigned int size)
+{
+	unsigned int bytes = filter->prefix_len / BITS_PER_BYTE;
+	unsigned int bits = filter->prefix_len % BITS_PER_BYTE;
+	const u8 *a = addr;
+	u8 mask;
+
+	if (!filter->prefix_size)
+		return true;
+
+	if (filter->prefix_size != size)
+		return false;
+
+	if (memcmp(a, filter->prefix, bytes) != 0)
+		return false;
+
+	if (!bits)
+		return true;
+
+	mask = 0xff << (BITS_PER_BYTE - bits);
+
+	return !((a[bytes] ^ filter->prefix[bytes]) & mask);
+}
 
 int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
 				  u8 result, u32 test_time, u64 total_bytes,
-				  u32 cookie);
+				  u32 cookie,
+				  const struct batadv_tp_group *group);
+
+void batadv_netlink_route_notify(struct batadv_priv *bat_priv,
+				 struct batadv_orig_node *orig_node,
+				 struct batadv_hard_iface *recv_if,
+				 struct batadv_neigh_node *old_router,
+				 struct batadv_neigh_node *new_router);
+void batadv_netlink_orig_notify(struct batadv_priv *bat_priv, u8 type,
+				const u8 *orig);
+void batadv_netlink_tt_notify(struct batadv_priv *bat_priv, u8 type,
+			      const u8 *addr, unsigned short vid,
+			      const u8 *orig, u16 flags);
+void batadv_netlink_gw_notify(struct batadv_priv *bat_priv, const u8 *gw_orig);
+int batadv_netlink_ping_notify(struct batadv_priv *bat_priv,
+			       struct batadv_ping_vars *ping_vars);
 
 extern struct genl_family batadv_netlink_family;
 
@@ -36,6 +36,7 @@
 #include <linux/list.h>
 #include <linux/lockdep.h>
 #include <linux/netdevice.h>
+#include <linux/netlink.h>
 #include <linux/printk.h>
 #include <linux/random.h>
 #include <linux/rculist.h>
@@ -47,14 +48,22 @@
 #include <linux/stddef.h>
 #include <linux/string.h>
 #include <linux/workqueue.h>
+#include <net/genetlink.h>
+#include <net/netlink.h>
+#include <net/sock.h>
+#include <uapi/linux/batman_adv.h>
 
 #include "hard-interface.h"
 #include "hash.h"
+#include "latency.h"
 #include "log.h"
+#include "netlink.h"
 #include "originator.h"
 #include "packet.h"
 #include "routing.h"
 #include "send.h"
+#include "soft-interface.h"
+#include "trace.h"
 #include "tvlv.h"
 
 static struct lock_class_key batadv_nc_coding_hash_lock_class_key;
@@ -652,6 +661,9 @@ static bool batadv_nc_fwd_flush(struct batadv_priv *bat_priv,
 	    !batadv_has_timed_out(nc_packet->timestamp, timeout))
 		return false;
 
+	batadv_latency_end_jiffies(bat_priv, BATADV_STATS_NC_HOLD,
+				   nc_packet->timestamp);
+
 	/* Send packet */
 	batadv_inc_counter(bat_priv, BATADV_CNT_FORWARD);
 	batadv_add_counter(bat_priv, BATADV_CNT_FORWARD_BYTES,
@@ -1213,6 +1225,11 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 				   skb_dest->len + ETH_HLEN);
 	}
 
+	trace_batadv_nc_code(bat_priv, coded_packet, first_dest->addr,
+			     jiffies_to_msecs(jiffies - nc_packet->timestamp));
+	batadv_latency_end_jiffies(bat_priv, BATADV_STATS_NC_HOLD,
+				   nc_packet->timestamp);
+
 	/* skb_src is now coded into skb_dest, so free it */
 	consume_skb(skb_src);
 
@@ -1989,3 +2006,206 @@ out:
 	return -ENOMEM;
 }
 #endif
+
+/**
+ * batadv_nc_nodes_dump_entry - dump one network coding neighbor into a message
+ * @msg: Netlink message to dump into
+ * @portid: Port making netlink request
+ * @seq: Sequence number of netlink message
+ * @orig_node: the originator the neighbor belongs to
+ * @nc_node: the network coding neighbor to dump
+ * @direction: whether @nc_node is an ingoing or outgoing neighbor
+ *
+ * Return: Error code, or 0 on success
+ */
+static int
+batadv_nc_nodes_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
+			   struct batadv_orig_node *orig_node,
+			   struct batadv_nc_node *nc_node,
+			   enum batadv_nc_direction direction)
+{
+	unsigned int last_seen_msecs;
+	void *hdr;
+
+	last_seen_msecs = jiffies_to_msecs(jiffies - nc_node->last_seen);
+
+	hdr = genlmsg_put(msg, portid, seq, &batadv_netlink_family,
+			  NLM_F_MULTI, BATADV_CMD_GET_NC_NODES);
+	if (!hdr)
+		return -ENOBUFS;
+
+	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, orig_node->orig) ||
+	    nla_put(msg, BATADV_ATTR_NC_NEIGH_ADDRESS, ETH_ALEN,
+		    nc_node->addr) ||
+	    nla_put_u8(msg, BATADV_ATTR_NC_DIRECTION, direction) ||
+	    nla_put_u32(msg, BATADV_ATTR_LAST_SEEN_MSECS, last_seen_msecs)) {
+		genlmsg_cancel(msg, hdr);
+		return -EMSGSIZE;
+	}
+
+	genlmsg_end(msg, hdr);
+	return 0;
+}
+
+/**
+ * batadv_nc_nodes_dump_orig - dump the network coding neighbors of an orig
+ * @msg: Netlink message to dump into
+ * @portid: Port making netlink request
+ * @seq: Sequence number of netlink message
+ * @orig_node: the originator whose neighbors are dumped
+ * @sub_s: Number of neighbors to skip
+ *
+ * The ingoing neighbors are dumped first, followed by the outgoing ones.
+ * Must be called under rcu_read_lock().
+ *
+ * Return: Error code, or 0 on success
+ */
+static int
+batadv_nc_nodes_dump_orig(struct sk_buff *msg, u32 portid, u32 seq,
+			  struct batadv_orig_node *orig_node, int *sub_s)
+{
+	struct batadv_nc_node *nc_node;
+	int sub = 0;
+
+	list_for_each_entry_rcu(nc_node, &orig_node->in_coding_list, list) {
+		if (sub++ < *sub_s)
+			continue;
+
+		if (batadv_nc_nodes_dump_entry(msg, portid, seq, orig_node,
+					       nc_node, BATADV_NC_INGOING)) {
+			*sub_s = sub - 1;
+			return -EMSGSIZE;
+		}
+	}
+
+	list_for_each_entry_rcu(nc_node, &orig_node->out_coding_list, list) {
+		if (sub++ < *sub_s)
+			continue;
+
+		if (batadv_nc_nodes_dump_entry(msg, portid, seq, orig_node,
+					       nc_node, BATADV_NC_OUTGOING)) {
+			*sub_s = sub - 1;
+			return -EMSGSIZE;
+		}
+	}
+
+	*sub_s = 0;
+	return 0;
+}
+
+/**
+ * batadv_nc_nodes_dump_bucket - dump the nc neighbors of one hash bucket
+ * @msg: Netlink message to dump into
+ * @portid: Port making netlink request
+ * @seq: Sequence number of netlink message
+ * @filter: filter selecting the originators to dump
+ * @head: Pointer to the list containing the originators
+ * @idx_s: Number of originators to skip
+ * @sub_s: Number of neighbors to skip of the first dumped originator
+ *
+ * Return: Error code, or 0 on success
+ */
+static int
+batadv_nc_nodes_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
+			    const struct batadv_netlink_filter *filter,
+			    struct hlist_head *head, int *idx_s, int *sub_s)
+{
+	struct batadv_orig_node *orig_node;
+	int idx = 0;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_node, head, hash_entry) {
+		if (idx++ < *idx_s)
+			continue;
+
+		if (!batadv_netlink_filter_orig(filter, orig_node->orig) ||
+		    !batadv_netlink_filter_prefix(filter, orig_node->orig,
+						  ETH_ALEN))
+			continue;
+
+		if (batadv_nc_nodes_dump_orig(msg, portid, seq, orig_node,
+					      sub_s)) {
+			rcu_read_unlock();
+			*idx_s = idx - 1;
+			return -EMSGSIZE;
+		}
+	}
+	rcu_read_unlock();
+
+	*idx_s = 0;
+	*sub_s = 0;
+	return 0;
+}
+
+/**
+ * batadv_nc_nodes_dump - dump the network coding neighbors into a message
+ * @msg: Netlink message to dump into
+ * @cb: Parameters from query
+ *
+ * Return: Error code, or length of message on success
+ */
+int batadv_nc_nodes_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	struct net *net = sock_net(cb->skb->sk);
+	struct batadv_hard_iface *primary_if = NULL;
+	struct batadv_netlink_filter filter;
+	struct net_device *soft_iface;
+	struct batadv_priv *bat_priv;
+	struct batadv_hashtable *hash;
+	struct hlist_head *head;
+	int ret;
+	int ifindex;
+	int bucket = cb->args[0];
+	int idx = cb->args[1];
+	int sub = cb->args[2];
+	int portid = NETLINK_CB(cb->skb).portid;
+
+	ifindex = batadv_netlink_get_ifindex(cb->nlh, BATADV_ATTR_MESH_IFINDEX);
+	if (!ifindex)
+		return -EINVAL;
+
+	if (batadv_netlink_filter_get(cb->nlh, &filter))
+		return -EINVAL;
+
+	soft_iface = dev_get_by_index(net, ifindex);
+	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	bat_priv = netdev_priv(soft_iface);
+
+	primary_if = batadv_primary_if_get_selected(bat_priv);
+	if (!primary_if || primary_if->if_status != BATADV_IF_ACTIVE) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	hash = bat_priv->orig_hash;
+	cb->seq = batadv_hash_dump_seq(hash);
+
+	while (bucket < hash->size) {
+		head = &hash->table[bucket];
+
+		if (batadv_nc_nodes_dump_bucket(msg, portid,
+						cb->nlh->nlmsg_seq, &filter,
+						head, &idx, &sub))
+			break;
+
+		bucket++;
+	}
+
+	ret = msg->len;
+
+out:
+	if (primary_if)
+		batadv_hardif_put(primary_if);
+	if (soft_iface)
+		dev_put(soft_iface);
+
+	cb->args[0] = bucket;
+	cb->args[1] = idx;
+	cb->args[2] = sub;
+
+	return ret;
+}
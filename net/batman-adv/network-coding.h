@@ -24,6 +24,7 @@
 
 struct batadv_ogm_packet;
 struct net_device;
+struct netlink_callback;
 struct seq_file;
 struct sk_buff;
 
@@ -52,6 +53,7 @@ void batadv_nc_skb_store_sniffed_unicast(struct batadv_priv *bat_priv,
 					 struct sk_buff *skb);
 int batadv_nc_nodes_seq_print_text(struct seq_file *seq, void *offset);
 int batadv_nc_init_debugfs(struct batadv_priv *bat_priv);
+int batadv_nc_nodes_dump(struct sk_buff *msg, struct netlink_callback *cb);
 
 #else /* ifdef CONFIG_BATMAN_ADV_NC */
 
@@ -127,6 +129,12 @@ static inline int batadv_nc_init_debugfs(struct batadv_priv *bat_priv)
 	return 0;
 }
 
+static inline int
+batadv_nc_nodes_dump(struct sk_buff *msg, struct netlink_callback *cb)
+{
+	return -EOPNOTSUPP;
+}
+
 #endif /* ifdef CONFIG_BATMAN_ADV_NC */
 
 #endif /* _NET_BATMAN_ADV_NETWORK_CODING_H_ */
@@ -1313,6 +1313,10 @@ static void _batadv_purge_orig(struct batadv_priv *bat_priv)
 			if (batadv_purge_orig_node(bat_priv, orig_node)) {
 				batadv_gw_node_delete(bat_priv, orig_node);
 				hlist_del_rcu(&orig_node->hash_entry);
+				atomic_inc(&hash->generation);
+				batadv_netlink_orig_notify(bat_priv,
+						BATADV_EVENT_ORIG_DEL,
+						orig_node->orig);
 				batadv_tt_global_del_orig(orig_node->bat_priv,
 							  orig_node, -1,
 							  "originator timed out");
@@ -1326,6 +1330,7 @@ static void _batadv_purge_orig(struct batadv_priv *bat_priv)
 		spin_unlock_bh(list_lock);
 	}
 
+	batadv_gw_client_purge(bat_priv, false);
 	batadv_gw_election(bat_priv);
 }
 
@@ -1483,6 +1488,7 @@ int batadv_orig_dump(struct sk_buff *msg, struct netlink_callback *cb)
 		goto out;
 	}
 
+	cb->seq = batadv_hash_dump_seq(bat_priv->orig_hash);
 	bat_priv->algo_ops->orig.dump(msg, cb, bat_priv, hardif);
 
 	ret = msg->len;
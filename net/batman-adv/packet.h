@@ -31,6 +31,7 @@
  * @BATADV_CODED: network coded packets
  * @BATADV_ELP: echo location packets for B.A.T.M.A.N. V
  * @BATADV_OGM2: originator messages for B.A.T.M.A.N. V
+ * @BATADV_MCAST: multicast packet with a list of destination originators
  *
  * @BATADV_UNICAST: unicast packets carrying unicast payload traffic
  * @BATADV_UNICAST_FRAG: unicast packets carrying a fragment of the original
@@ -47,6 +48,7 @@ enum batadv_packettype {
 	BATADV_CODED            = 0x02,
 	BATADV_ELP		= 0x03,
 	BATADV_OGM2		= 0x04,
+	BATADV_MCAST		= 0x05,
 	/* 0x40 - 0x7f: unicast */
 #define BATADV_UNICAST_MIN     0x40
 	BATADV_UNICAST          = 0x40,
@@ -105,11 +107,14 @@ enum batadv_icmp_packettype {
  *  224.0.0.0/24 or ff02::1
  * @BATADV_MCAST_WANT_ALL_IPV4: we want all IPv4 multicast packets
  * @BATADV_MCAST_WANT_ALL_IPV6: we want all IPv6 multicast packets
+ * @BATADV_MCAST_HAVE_MC_PTYPE_CAPA: we can parse, receive and forward
+ *  batman-adv multicast packets with a destination list
  */
 enum batadv_mcast_flags {
 	BATADV_MCAST_WANT_ALL_UNSNOOPABLES	= BIT(0),
 	BATADV_MCAST_WANT_ALL_IPV4		= BIT(1),
 	BATADV_MCAST_WANT_ALL_IPV6		= BIT(2),
+	BATADV_MCAST_HAVE_MC_PTYPE_CAPA		= BIT(3),
 };
 
 /* tt data subtypes */
@@ -314,10 +319,10 @@ struct batadv_icmp_packet {
  * @subtype: TP packet subtype (see batadv_icmp_tp_subtype)
  * @session: TP session identifier
  * @seqno: the TP sequence number
- * @timestamp: time when the packet has been sent. This value is filled in a
- *  TP_MSG and echoed back in the next TP_ACK so that the sender can compute the
- *  RTT. Since it is read only by the host which wrote it, there is no need to
- *  store it using network order
+ * @timestamp: time (usecs) when the packet has been sent. This value is filled
+ *  in a TP_MSG and echoed back in the next TP_ACK so that the sender can
+ *  compute the RTT. Since it is read only by the host which wrote it, there is
+ *  no need to store it using network order
  */
 struct batadv_icmp_tp_packet {
 	u8  packet_type;
@@ -333,14 +338,104 @@ struct batadv_icmp_tp_packet {
 	__be32 timestamp;
 };
 
+/**
+ * struct batadv_icmp_tp_ack_packet - ICMP TP Meter acknowledgment packet
+ * @packet_type: batman-adv packet type, part of the general header
+ * @version: batman-adv protocol version, part of the genereal header
+ * @ttl: time to live for this packet, part of the genereal header
+ * @msg_type: ICMP packet type
+ * @dst: address of the destination node
+ * @orig: address of the source node
+ * @uid: local ICMP socket identifier
+ * @subtype: TP packet subtype (BATADV_TP_ACK)
+ * @session: TP session identifier
+ * @seqno: the cumulative ACK
+ * @timestamp: the timestamp echoed back from the acknowledged TP_MSG
+ * @num_sack: number of batadv_icmp_tp_sack blocks following the packet
+ * @reserved: not used - useful for alignment purposes
+ *
+ * Starts with the same fields as batadv_icmp_tp_packet. Only the announced
+ * number of SACK blocks is parsed, any further bytes (e.g. ethernet padding)
+ * are ignored.
+ */
+struct batadv_icmp_tp_ack_packet {
+	u8  packet_type;
+	u8  version;
+	u8  ttl;
+	u8  msg_type; /* see ICMP message types above */
+	u8  dst[ETH_ALEN];
+	u8  orig[ETH_ALEN];
+	u8  uid;
+	u8  subtype;
+	u8  session[2];
+	__be32 seqno;
+	__be32 timestamp;
+	u8  num_sack;
+	u8  reserved[3];
+};
+
+/**
+ * struct batadv_icmp_tp_sack - ICMP TP Meter selective acknowledgment block
+ * @start: seqno of the first received byte of the range
+ * @end: seqno following the last received byte of the range
+ *
+ * A TP_ACK may be followed by num_sack of these blocks reporting the ranges
+ * received after a gap. A first block lying below the cumulative ACK reports
+ * a duplicate segment instead (D-SACK, see RFC2883)
+ */
+struct batadv_icmp_tp_sack {
+	__be32 start;
+	__be32 end;
+};
+
+/**
+ * struct batadv_icmp_tp_req_packet - ICMP TP Meter reverse request packet
+ * @packet_type: batman-adv packet type, part of the general header
+ * @version: batman-adv protocol version, part of the genereal header
+ * @ttl: time to live for this packet, part of the genereal header
+ * @msg_type: ICMP packet type
+ * @dst: address of the destination node
+ * @orig: address of the source node
+ * @uid: local ICMP socket identifier
+ * @subtype: TP packet subtype (see batadv_icmp_tp_subtype)
+ * @session: TP session identifier of the first requested stream
+ * @test_length: requested test length in milliseconds
+ * @num_streams: number of streams the destination has to send back
+ * @cc: congestion control of the requested streams (see batadv_tp_meter_cc)
+ * @reserved: not used - useful for alignment purposes
+ * @rate: constant bitrate (kbit/s) of the requested streams, 0 if window
+ *  limited
+ */
+struct batadv_icmp_tp_req_packet {
+	u8  packet_type;
+	u8  version;
+	u8  ttl;
+	u8  msg_type; /* see ICMP message types above */
+	u8  dst[ETH_ALEN];
+	u8  orig[ETH_ALEN];
+	u8  uid;
+	u8  subtype;
+	u8  session[2];
+	__be32 test_length;
+	u8  num_streams;
+	u8  cc;
+	u8  reserved[2];
+	__be32 rate;
+};
+
 /**
  * enum batadv_icmp_tp_subtype - ICMP TP Meter packet subtypes
  * @BATADV_TP_MSG: Msg from sender to receiver
  * @BATADV_TP_ACK: acknowledgment from receiver to sender
+ * @BATADV_TP_REVERSE_REQ: request to send streams back to the requester
+ * @BATADV_TP_REVERSE_CANCEL: request to stop the streams sent back to the
+ *  requester
  */
 enum batadv_icmp_tp_subtype {
 	BATADV_TP_MSG	= 0,
 	BATADV_TP_ACK,
+	BATADV_TP_REVERSE_REQ,
+	BATADV_TP_REVERSE_CANCEL,
 };
 
 #define BATADV_RR_LEN 16
@@ -373,6 +468,39 @@ struct batadv_icmp_packet_rr {
 
 #define BATADV_ICMP_MAX_PACKET_SIZE	sizeof(struct batadv_icmp_packet_rr)
 
+/**
+ * struct batadv_icmp_ring - header of the mmap()able ICMP socket ring
+ * @head: number of packets written to the ring by the kernel
+ * @tail: number of packets consumed from the ring
+ * @watermark: number of queued packets at which a waiting reader is woken up
+ * @dropped: number of packets dropped because the ring was full
+ * @slot_num: number of packet slots in the ring, a power of two
+ * @slot_size: distance between two packet slots
+ *
+ * @head and @tail are free running counters. The header occupies the first
+ * page of the mapping, the packet slot for counter value n starts at
+ * PAGE_SIZE + (n & (slot_num - 1)) * slot_size. Only @tail and @watermark
+ * may be written by userspace.
+ */
+struct batadv_icmp_ring {
+	u32 head;
+	u32 tail;
+	u32 watermark;
+	u32 dropped;
+	u32 slot_num;
+	u32 slot_size;
+};
+
+/**
+ * struct batadv_icmp_ring_slot - packet slot of the ICMP socket ring
+ * @len: length of the ICMP packet
+ * @packet: the ICMP packet
+ */
+struct batadv_icmp_ring_slot {
+	u16 len;
+	u8  packet[BATADV_ICMP_MAX_PACKET_SIZE];
+};
+
 /* All packet headers in front of an ethernet header have to be completely
  * divisible by 2 but not by 4 to make the payload after the ethernet
  * header again 4 bytes boundary aligned.
@@ -511,8 +639,36 @@ struct batadv_coded_packet {
 	__be16 coded_len;
 };
 
+/**
+ * struct batadv_mcast_packet - multicast packet with a destination list
+ * @packet_type: batman-adv packet type, part of the general header
+ * @version: batman-adv protocol version, part of the genereal header
+ * @ttl: time to live for this packet, part of the genereal header
+ * @num_dests: number of destination originators following this header
+ * @orig: originator of the multicast packet
+ *
+ * The header is followed by @num_dests originator addresses. Each node
+ * forwards one copy per next hop, carrying only the destinations reachable
+ * via that next hop. The list is padded to an even number of entries (see
+ * BATADV_MCAST_HLEN()) to keep the payload after the following ethernet
+ * header 4 bytes boundary aligned.
+ */
+struct batadv_mcast_packet {
+	u8 packet_type;
+	u8 version;  /* batman version field */
+	u8 ttl;
+	u8 num_dests;
+	u8 orig[ETH_ALEN];
+	/* followed by: u8 dests[num_dests][ETH_ALEN] + padding */
+};
+
 #pragma pack()
 
+/* length of a multicast packet header including its destination list */
+#define BATADV_MCAST_HLEN(num_dests) \
+	(sizeof(struct batadv_mcast_packet) + \
+	 ((((num_dests) + 1) & ~1) * ETH_ALEN))
+
 /**
  * struct batadv_unicast_tvlv_packet - generic unicast packet with tvlv payload
  * @packet_type: batman-adv packet type, part of the general header
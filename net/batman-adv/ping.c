@@ -0,0 +1,455 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ping.h"
+#include "main.h"
+
+#include <linux/atomic.h>
+#include <linux/byteorder/generic.h>
+#include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/etherdevice.h>
+#include <linux/if_ether.h>
+#include <linux/jiffies.h>
+#include <linux/kernel.h>
+#include <linux/kref.h>
+#include <linux/list.h>
+#include <linux/netdevice.h>
+#include <linux/pkt_sched.h>
+#include <linux/random.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/stddef.h>
+#include <linux/string.h>
+#include <linux/timekeeping.h>
+#include <linux/workqueue.h>
+
+#include "hard-interface.h"
+#include "log.h"
+#include "netlink.h"
+#include "originator.h"
+#include "packet.h"
+#include "send.h"
+
+/**
+ * struct batadv_ping_probe - payload identifying a kernel ping probe
+ * @cookie: cookie of the ping session
+ * @dest: index of the destination inside the ping session
+ * @time: time (nsecs) the probe was sent at
+ *
+ * The payload is echoed back unmodified by the destination.
+ */
+struct batadv_ping_probe {
+	__be32 cookie;
+	__be16 dest;
+	u64 time;
+} __packed;
+
+/**
+ * batadv_ping_probe_offset - get the position of the probe payload
+ * @len: length of the icmp packet
+ *
+ * Forwarders record the route of echo packets at least as big as a route
+ * record packet in the rr array. The payload is placed behind this array in
+ * such packets to keep it intact.
+ *
+ * Return: offset of the probe payload inside the icmp packet
+ */
+static size_t batadv_ping_probe_offset(size_t len)
+{
+	if (len >= sizeof(struct batadv_icmp_packet_rr))
+		return sizeof(struct batadv_icmp_packet_rr);
+
+	return sizeof(struct batadv_icmp_packet);
+}
+
+/**
+ * batadv_ping_vars_release - release batadv_ping_vars after rcu grace period
+ * @ref: kref pointer of the batadv_ping_vars
+ */
+static void batadv_ping_vars_release(struct kref *ref)
+{
+	struct batadv_ping_vars *ping_vars;
+
+	ping_vars = container_of(ref, struct batadv_ping_vars, refcount);
+
+	kfree_rcu(ping_vars, rcu);
+}
+
+/**
+ * batadv_ping_vars_put - decrement the batadv_ping_vars refcounter and
+ *  possibly release it
+ * @ping_vars: the ping session to be free'd
+ */
+static void batadv_ping_vars_put(struct batadv_ping_vars *ping_vars)
+{
+	kref_put(&ping_vars->refcount, batadv_ping_vars_release);
+}
+
+/**
+ * batadv_ping_find - find a ping session by its cookie
+ * @bat_priv: the bat priv with all the soft interface information
+ * @cookie: cookie of the ping session
+ *
+ * Return: the ping session with increased refcounter or NULL if not found
+ */
+static struct batadv_ping_vars *batadv_ping_find(struct batadv_priv *bat_priv,
+						 u32 cookie)
+{
+	struct batadv_ping_vars *pos, *ping_vars = NULL;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(pos, &bat_priv->ping_list, list) {
+		if (pos->cookie != cookie)
+			continue;
+
+		if (!kref_get_unless_zero(&pos->refcount))
+			continue;
+
+		ping_vars = pos;
+		break;
+	}
+	rcu_read_unlock();
+
+	return ping_vars;
+}
+
+/**
+ * batadv_ping_send_probe - send a single probe of a ping session
+ * @ping_vars: the ping session
+ * @primary_if: the primary interface of the mesh
+ * @index: index of the destination inside the ping session
+ *
+ * Probes which cannot be sent are accounted as lost.
+ */
+static void batadv_ping_send_probe(struct batadv_ping_vars *ping_vars,
+				   struct batadv_hard_iface *primary_if,
+				   u16 index)
+{
+	struct batadv_priv *bat_priv = ping_vars->bat_priv;
+	struct batadv_ping_dest *dest = &ping_vars->dests[index];
+	struct batadv_icmp_packet *icmp_packet;
+	struct batadv_orig_node *orig_node;
+	struct batadv_ping_probe *probe;
+	struct sk_buff *skb;
+	size_t offset;
+
+	spin_lock_bh(&ping_vars->lock);
+	dest->sent++;
+	spin_unlock_bh(&ping_vars->lock);
+
+	orig_node = batadv_orig_hash_find(bat_priv, dest->addr);
+	if (!orig_node)
+		return;
+
+	skb = netdev_alloc_skb_ip_align(NULL, ping_vars->size + ETH_HLEN);
+	if (!skb)
+		goto out;
+
+	skb->priority = TC_PRIO_CONTROL;
+	skb_reserve(skb, ETH_HLEN);
+	icmp_packet = (struct batadv_icmp_packet *)skb_put(skb,
+							   ping_vars->size);
+	memset(icmp_packet, 0, ping_vars->size);
+
+	icmp_packet->packet_type = BATADV_ICMP;
+	icmp_packet->version = BATADV_COMPAT_VERSION;
+	icmp_packet->ttl = BATADV_TTL;
+	icmp_packet->msg_type = BATADV_ECHO_REQUEST;
+	ether_addr_copy(icmp_packet->dst, dest->addr);
+	ether_addr_copy(icmp_packet->orig, primary_if->net_dev->dev_addr);
+	icmp_packet->uid = BATADV_PING_UID;
+	icmp_packet->seqno = htons(ping_vars->round);
+
+	offset = batadv_ping_probe_offset(ping_vars->size);
+	probe = (struct batadv_ping_probe *)((u8 *)icmp_packet + offset);
+	probe->cookie = htonl(ping_vars->cookie);
+	probe->dest = htons(index);
+	probe->time = ktime_get_ns();
+
+	batadv_send_skb_to_orig(skb, orig_node, NULL);
+
+out:
+	batadv_orig_node_put(orig_node);
+}
+
+/**
+ * batadv_ping_finish - remove a ping session and report its results
+ * @ping_vars: the ping session to finish
+ */
+static void batadv_ping_finish(struct batadv_ping_vars *ping_vars)
+{
+	struct batadv_priv *bat_priv = ping_vars->bat_priv;
+
+	spin_lock_bh(&bat_priv->ping_list_lock);
+	/* batadv_ping_free() already took the session over */
+	if (hlist_unhashed(&ping_vars->list)) {
+		spin_unlock_bh(&bat_priv->ping_list_lock);
+		return;
+	}
+	hlist_del_init_rcu(&ping_vars->list);
+	spin_unlock_bh(&bat_priv->ping_list_lock);
+
+	batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
+		   "Ping session %u finished after %u rounds\n",
+		   ping_vars->cookie, ping_vars->round);
+
+	batadv_netlink_ping_notify(bat_priv, ping_vars);
+
+	/* drop list reference */
+	batadv_ping_vars_put(ping_vars);
+}
+
+/**
+ * batadv_ping_work - send the next probe round or finish the session
+ * @work: delayed work of the ping session
+ *
+ * One probe is sent to every destination per round. The session is finished
+ * BATADV_PING_TIMEOUT msecs after the last round or on the next run after it
+ * was cancelled.
+ */
+static void batadv_ping_work(struct work_struct *work)
+{
+	struct delayed_work *delayed_work = to_delayed_work(work);
+	struct batadv_ping_vars *ping_vars;
+	struct batadv_hard_iface *primary_if;
+	unsigned int delay;
+	u16 i;
+
+	ping_vars = container_of(delayed_work, struct batadv_ping_vars, work);
+
+	if (READ_ONCE(ping_vars->cancelled) ||
+	    ping_vars->round >= ping_vars->count) {
+		batadv_ping_finish(ping_vars);
+		return;
+	}
+
+	primary_if = batadv_primary_if_get_selected(ping_vars->bat_priv);
+	if (primary_if) {
+		for (i = 0; i < ping_vars->num_dests; i++)
+			batadv_ping_send_probe(ping_vars, primary_if, i);
+
+		batadv_hardif_put(primary_if);
+	}
+
+	ping_vars->round++;
+
+	if (ping_vars->round < ping_vars->count)
+		delay = ping_vars->interval;
+	else
+		delay = BATADV_PING_TIMEOUT;
+
+	queue_delayed_work(batadv_event_workqueue, &ping_vars->work,
+			   msecs_to_jiffies(delay));
+}
+
+/**
+ * batadv_ping_start - start a kernel driven ping session
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dests: array of originator addresses to probe
+ * @num_dests: number of entries in @dests
+ * @count: number of probes sent to each destination
+ * @interval: time (msecs) between two probe rounds
+ * @size: size of a single probe
+ * @cookie: pointer to store the cookie of the new session
+ *
+ * Return: 0 on success or negative error number in case of failure
+ */
+int batadv_ping_start(struct batadv_priv *bat_priv, const u8 *dests,
+		      u16 num_dests, u32 count, u32 interval, u16 size,
+		      u32 *cookie)
+{
+	struct batadv_ping_vars *ping_vars, *pos;
+	size_t min_size;
+	unsigned int num = 0;
+	u16 i;
+
+	if (!num_dests || num_dests > BATADV_PING_MAX_DESTS)
+		return -EINVAL;
+
+	if (!count || count > BATADV_PING_MAX_COUNT)
+		return -EINVAL;
+
+	if (interval < BATADV_PING_MIN_INTERVAL ||
+	    interval > BATADV_PING_MAX_INTERVAL)
+		return -EINVAL;
+
+	/* the probe payload has to fit behind the (route record) header */
+	min_size = batadv_ping_probe_offset(size) +
+		   sizeof(struct batadv_ping_probe);
+	size = clamp_t(size_t, size, min_size, BATADV_PING_MAX_SIZE);
+
+	if (atomic_read(&bat_priv->mesh_state) != BATADV_MESH_ACTIVE)
+		return -ENETDOWN;
+
+	ping_vars = kzalloc(sizeof(*ping_vars) +
+			    num_dests * sizeof(ping_vars->dests[0]),
+			    GFP_KERNEL);
+	if (!ping_vars)
+		return -ENOMEM;
+
+	for (i = 0; i < num_dests; i++) {
+		ether_addr_copy(ping_vars->dests[i].addr, &dests[i * ETH_ALEN]);
+		ping_vars->dests[i].rtt_min = U64_MAX;
+	}
+
+	ping_vars->bat_priv = bat_priv;
+	ping_vars->num_dests = num_dests;
+	ping_vars->count = count;
+	ping_vars->interval = interval;
+	ping_vars->size = size;
+	spin_lock_init(&ping_vars->lock);
+	INIT_DELAYED_WORK(&ping_vars->work, batadv_ping_work);
+	kref_init(&ping_vars->refcount);
+
+	spin_lock_bh(&bat_priv->ping_list_lock);
+	hlist_for_each_entry(pos, &bat_priv->ping_list, list)
+		num++;
+
+	if (num >= BATADV_PING_MAX_NUM) {
+		spin_unlock_bh(&bat_priv->ping_list_lock);
+		kfree(ping_vars);
+		return -EBUSY;
+	}
+
+	/* cookies only need to be unique among the running sessions */
+	do {
+		get_random_bytes(&ping_vars->cookie,
+				 sizeof(ping_vars->cookie));
+		hlist_for_each_entry(pos, &bat_priv->ping_list, list) {
+			if (pos->cookie == ping_vars->cookie)
+				break;
+		}
+	} while (pos);
+
+	hlist_add_head_rcu(&ping_vars->list, &bat_priv->ping_list);
+	*cookie = ping_vars->cookie;
+	queue_delayed_work(batadv_event_workqueue, &ping_vars->work, 0);
+	spin_unlock_bh(&bat_priv->ping_list_lock);
+
+	batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
+		   "Ping session %u started: %u destinations, %u probes each\n",
+		   *cookie, num_dests, count);
+
+	return 0;
+}
+
+/**
+ * batadv_ping_stop - cancel a running ping session
+ * @bat_priv: the bat priv with all the soft interface information
+ * @cookie: cookie of the ping session
+ *
+ * No further probes are sent and the results collected so far are reported
+ * when the session worker runs the next time.
+ *
+ * Return: 0 on success or -ENOENT if no session with @cookie is running
+ */
+int batadv_ping_stop(struct batadv_priv *bat_priv, u32 cookie)
+{
+	struct batadv_ping_vars *ping_vars;
+
+	ping_vars = batadv_ping_find(bat_priv, cookie);
+	if (!ping_vars)
+		return -ENOENT;
+
+	WRITE_ONCE(ping_vars->cancelled, true);
+	batadv_ping_vars_put(ping_vars);
+
+	return 0;
+}
+
+/**
+ * batadv_ping_recv - account an echo reply to a kernel ping probe
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the linearized icmp packet
+ *
+ * The skb is not consumed.
+ */
+void batadv_ping_recv(struct batadv_priv *bat_priv, struct sk_buff *skb)
+{
+	struct batadv_icmp_packet *icmp_packet;
+	struct batadv_ping_vars *ping_vars;
+	struct batadv_ping_probe *probe;
+	struct batadv_ping_dest *dest;
+	size_t offset;
+	u64 rtt;
+	u16 index;
+
+	icmp_packet = (struct batadv_icmp_packet *)skb->data;
+	if (icmp_packet->msg_type != BATADV_ECHO_REPLY)
+		return;
+
+	offset = batadv_ping_probe_offset(skb->len);
+	if (skb->len < offset + sizeof(*probe))
+		return;
+
+	probe = (struct batadv_ping_probe *)(skb->data + offset);
+
+	ping_vars = batadv_ping_find(bat_priv, ntohl(probe->cookie));
+	if (!ping_vars)
+		return;
+
+	index = ntohs(probe->dest);
+	if (index >= ping_vars->num_dests)
+		goto out;
+
+	dest = &ping_vars->dests[index];
+	if (!batadv_compare_eth(dest->addr, icmp_packet->orig))
+		goto out;
+
+	rtt = ktime_get_ns() - probe->time;
+
+	spin_lock_bh(&ping_vars->lock);
+	/* ignore duplicated replies */
+	if (dest->received < dest->sent) {
+		dest->received++;
+		dest->rtt_sum += rtt;
+		dest->rtt_min = min(dest->rtt_min, rtt);
+		dest->rtt_max = max(dest->rtt_max, rtt);
+	}
+	spin_unlock_bh(&ping_vars->lock);
+
+out:
+	batadv_ping_vars_put(ping_vars);
+}
+
+/**
+ * batadv_ping_free - stop all ping sessions of a mesh interface
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+void batadv_ping_free(struct batadv_priv *bat_priv)
+{
+	struct batadv_ping_vars *ping_vars;
+
+	while (true) {
+		spin_lock_bh(&bat_priv->ping_list_lock);
+		ping_vars = hlist_entry_safe(bat_priv->ping_list.first,
+					     struct batadv_ping_vars, list);
+		if (ping_vars)
+			hlist_del_init_rcu(&ping_vars->list);
+		spin_unlock_bh(&bat_priv->ping_list_lock);
+
+		if (!ping_vars)
+			break;
+
+		cancel_delayed_work_sync(&ping_vars->work);
+
+		/* drop list reference */
+		batadv_ping_vars_put(ping_vars);
+	}
+}
@@ -0,0 +1,32 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NET_BATMAN_ADV_PING_H_
+#define _NET_BATMAN_ADV_PING_H_
+
+#include "main.h"
+
+#include <linux/types.h>
+
+struct sk_buff;
+
+int batadv_ping_start(struct batadv_priv *bat_priv, const u8 *dests,
+		      u16 num_dests, u32 count, u32 interval, u16 size,
+		      u32 *cookie);
+int batadv_ping_stop(struct batadv_priv *bat_priv, u32 cookie);
+void batadv_ping_recv(struct batadv_priv *bat_priv, struct sk_buff *skb);
+void batadv_ping_free(struct batadv_priv *bat_priv);
+
+#endif /* _NET_BATMAN_ADV_PING_H_ */
@@ -40,13 +40,17 @@
 #include "fragmentation.h"
 #include "hard-interface.h"
 #include "icmp_socket.h"
+#include "latency.h"
 #include "log.h"
+#include "netlink.h"
 #include "network-coding.h"
 #include "originator.h"
 #include "packet.h"
+#include "ping.h"
 #include "send.h"
 #include "soft-interface.h"
 #include "tp_meter.h"
+#include "trace.h"
 #include "translation-table.h"
 #include "tvlv.h"
 
@@ -112,6 +116,11 @@ static void _batadv_update_route(struct batadv_priv *bat_priv,
 			   curr_router->addr);
 	}
 
+	trace_batadv_route_update(bat_priv, orig_node, recv_if, curr_router,
+				  neigh_node);
+	batadv_netlink_route_notify(bat_priv, orig_node, recv_if, curr_router,
+				    neigh_node);
+
 	/* decrease refcount of previous best neighbor */
 	if (curr_router)
 		batadv_neigh_node_put(curr_router);
@@ -237,6 +246,12 @@ static int batadv_recv_my_icmp_packet(struct batadv_priv *bat_priv,
 		if (skb_linearize(skb) < 0)
 			break;
 
+		icmph = (struct batadv_icmp_header *)skb->data;
+		if (icmph->uid == BATADV_PING_UID) {
+			batadv_ping_recv(bat_priv, skb);
+			break;
+		}
+
 		batadv_socket_receive_packet(icmph, skb->len);
 		break;
 	case BATADV_ECHO_REQUEST:
@@ -672,6 +687,7 @@ static int batadv_route_unicast_packet(struct sk_buff *skb,
 				       struct batadv_hard_iface *recv_if)
 {
 	struct batadv_priv *bat_priv = netdev_priv(recv_if->soft_iface);
+	u64 start = batadv_latency_start(bat_priv);
 	struct batadv_orig_node *orig_node = NULL;
 	struct batadv_unicast_packet *unicast_packet;
 	struct ethhdr *ethhdr = eth_hdr(skb);
@@ -737,6 +753,8 @@ put_orig_node:
 free_skb:
 	kfree_skb(skb);
 
+	batadv_latency_end(bat_priv, BATADV_STATS_UNICAST_FWD, start);
+
 	return ret;
 }
 
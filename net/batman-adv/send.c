@@ -44,6 +44,7 @@
 #include "fragmentation.h"
 #include "gateway_client.h"
 #include "hard-interface.h"
+#include "latency.h"
 #include "log.h"
 #include "network-coding.h"
 #include "originator.h"
@@ -109,6 +110,9 @@ int batadv_send_skb_packet(struct sk_buff *skb,
 
 	skb->dev = hard_iface->net_dev;
 
+	batadv_hardif_count_ctrl(hard_iface, skb_network_header(skb)[0],
+				 skb->len, true);
+
 	/* Save a clone of the skb to use when decoding coded packets */
 	batadv_nc_skb_store_for_decoding(bat_priv, skb);
 
@@ -430,18 +434,19 @@ int batadv_send_skb_via_tt_generic(struct batadv_priv *bat_priv,
  * @skb: payload to send
  * @vid: the vid to be used to search the translation table
  *
- * Look up the currently selected gateway. Wrap the given skb into a batman-adv
- * unicast header and send this frame to this gateway node.
+ * Look up the gateway serving the sender of the given skb. Wrap the given skb
+ * into a batman-adv unicast header and send this frame to this gateway node.
  *
  * Return: NET_XMIT_DROP in case of error or NET_XMIT_SUCCESS otherwise.
  */
 int batadv_send_skb_via_gw(struct batadv_priv *bat_priv, struct sk_buff *skb,
 			   unsigned short vid)
 {
+	struct ethhdr *ethhdr = (struct ethhdr *)skb->data;
 	struct batadv_orig_node *orig_node;
 	int ret;
 
-	orig_node = batadv_gw_get_selected_orig(bat_priv);
+	orig_node = batadv_gw_get_client_orig(bat_priv, ethhdr->h_source);
 	ret = batadv_send_skb_unicast(bat_priv, skb, BATADV_UNICAST_4ADDR,
 				      BATADV_P_DATA, orig_node, vid);
 
@@ -773,6 +778,7 @@ int batadv_add_bcast_packet_to_list(struct batadv_priv *bat_priv,
 
 	forw_packet->skb = newskb;
 	forw_packet->own = own_packet;
+	forw_packet->queue_time = batadv_latency_start(bat_priv);
 
 	INIT_DELAYED_WORK(&forw_packet->delayed_work,
 			  batadv_send_outstanding_bcast_packet);
@@ -820,6 +826,10 @@ static void batadv_send_outstanding_bcast_packet(struct work_struct *work)
 
 	bcast_packet = (struct batadv_bcast_packet *)forw_packet->skb->data;
 
+	if (forw_packet->num_packets == 0)
+		batadv_latency_end(bat_priv, BATADV_STATS_BCAST_QUEUE,
+				   forw_packet->queue_time);
+
 	/* rebroadcast packet */
 	rcu_read_lock();
 	list_for_each_entry_rcu(hard_iface, &batadv_hardif_list, list) {
@@ -56,6 +56,7 @@
 #include "gateway_client.h"
 #include "gateway_common.h"
 #include "hard-interface.h"
+#include "latency.h"
 #include "multicast.h"
 #include "network-coding.h"
 #include "originator.h"
@@ -124,7 +125,7 @@ static int batadv_interface_release(struct net_device *dev)
  *
  * Return: sum of all cpu-local counters
  */
-static u64 batadv_sum_counter(struct batadv_priv *bat_priv,  size_t idx)
+u64 batadv_sum_counter(struct batadv_priv *bat_priv, size_t idx)
 {
 	u64 *counters, sum = 0;
 	int cpu;
@@ -195,11 +196,16 @@ static int batadv_interface_change_mtu(struct net_device *dev, int new_mtu)
  * @dev: registered network device to modify
  *
  * We do not actually need to set any rx filters for the virtual batman
- * soft interface. However a dummy handler enables a user to set static
- * multicast listeners for instance.
+ * soft interface. However this handler enables a user to set static
+ * multicast listeners for instance. It is invoked whenever the multicast
+ * address list of the device changes, therefore update our multicast
+ * listener announcements.
  */
 static void batadv_interface_set_rx_mode(struct net_device *dev)
 {
+	struct batadv_priv *bat_priv = netdev_priv(dev);
+
+	batadv_mcast_mla_update_trigger(bat_priv);
 }
 
 static int batadv_interface_tx(struct sk_buff *skb,
@@ -223,13 +229,16 @@ static int batadv_interface_tx(struct sk_buff *skb,
 	unsigned short vid;
 	u32 seqno;
 	int gw_mode;
-	enum batadv_forw_mode forw_mode;
+	enum batadv_forw_mode forw_mode = BATADV_FORW_ALL;
 	struct batadv_orig_node *mcast_single_orig = NULL;
 	int network_offset = ETH_HLEN;
+	u64 start = 0;
 
 	if (atomic_read(&bat_priv->mesh_state) != BATADV_MESH_ACTIVE)
 		goto dropped;
 
+	start = batadv_latency_start(bat_priv);
+
 	netif_trans_update(soft_iface);
 	vid = batadv_get_vid(skb, 0);
 	ethhdr = eth_hdr(skb);
@@ -317,7 +326,8 @@ send:
 			if (forw_mode == BATADV_FORW_NONE)
 				goto dropped;
 
-			if (forw_mode == BATADV_FORW_SINGLE)
+			if (forw_mode == BATADV_FORW_SINGLE ||
+			    forw_mode == BATADV_FORW_MCAST)
 				do_bcast = false;
 		}
 	}
@@ -377,6 +387,8 @@ send:
 			ret = batadv_send_skb_unicast(bat_priv, skb,
 						      BATADV_UNICAST, 0,
 						      mcast_single_orig, vid);
+		} else if (forw_mode == BATADV_FORW_MCAST) {
+			ret = batadv_mcast_forw_send(bat_priv, skb, vid);
 		} else {
 			if (batadv_dat_snoop_outgoing_arp_request(bat_priv,
 								  skb))
@@ -404,6 +416,8 @@ end:
 		batadv_orig_node_put(mcast_single_orig);
 	if (primary_if)
 		batadv_hardif_put(primary_if);
+
+	batadv_latency_end(bat_priv, BATADV_STATS_IFACE_TX, start);
 	return NETDEV_TX_OK;
 }
 
@@ -800,8 +814,12 @@ static int batadv_softif_init_late(struct net_device *dev)
 
 	atomic_set(&bat_priv->aggregated_ogms, 1);
 	atomic_set(&bat_priv->bonding, 0);
+	atomic_set(&bat_priv->gw_distribute, 0);
+	atomic_set(&bat_priv->tp_reverse, 0);
+	atomic_set(&bat_priv->latency_stats, 0);
 #ifdef CONFIG_BATMAN_ADV_BLA
 	atomic_set(&bat_priv->bridge_loop_avoidance, 1);
+	atomic_set(&bat_priv->bla_duplist_size, BATADV_DUPLIST_SIZE);
 #endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 	atomic_set(&bat_priv->distributed_arp_table, 1);
@@ -813,10 +831,12 @@ static int batadv_softif_init_late(struct net_device *dev)
 	bat_priv->mcast.querier_ipv6.shadowing = false;
 	bat_priv->mcast.flags = BATADV_NO_FLAGS;
 	atomic_set(&bat_priv->multicast_mode, 1);
+	atomic_set(&bat_priv->multicast_fanout, BATADV_MCAST_FANOUT_DEFAULT);
 	atomic_set(&bat_priv->mcast.num_disabled, 0);
 	atomic_set(&bat_priv->mcast.num_want_all_unsnoopables, 0);
 	atomic_set(&bat_priv->mcast.num_want_all_ipv4, 0);
 	atomic_set(&bat_priv->mcast.num_want_all_ipv6, 0);
+	atomic_set(&bat_priv->mcast.num_no_mc_ptype_capa, 0);
 #endif
 	atomic_set(&bat_priv->gw.mode, BATADV_GW_MODE_OFF);
 	atomic_set(&bat_priv->gw.bandwidth_down, 100);
@@ -1150,6 +1170,12 @@ static const struct {
 	{ "tt_response_rx" },
 	{ "tt_roam_adv_tx" },
 	{ "tt_roam_adv_rx" },
+#ifdef CONFIG_BATMAN_ADV_BATMAN_V
+	{ "ogm2_sign" },
+	{ "ogm2_verify" },
+	{ "ogm2_verify_failed" },
+	{ "ogm2_key_change" },
+#endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 	{ "dat_get_tx" },
 	{ "dat_get_rx" },
@@ -28,6 +28,7 @@ struct net;
 struct sk_buff;
 
 int batadv_skb_head_push(struct sk_buff *skb, unsigned int len);
+u64 batadv_sum_counter(struct batadv_priv *bat_priv, size_t idx);
 void batadv_interface_rx(struct net_device *soft_iface,
 			 struct sk_buff *skb, int hdr_size,
 			 struct batadv_orig_node *orig_node);
@@ -669,6 +669,9 @@ BATADV_ATTR_SIF_BOOL(aggregated_ogms, 0644, NULL);
 BATADV_ATTR_SIF_BOOL(bonding, 0644, NULL);
 #ifdef CONFIG_BATMAN_ADV_BLA
 BATADV_ATTR_SIF_BOOL(bridge_loop_avoidance, 0644, batadv_bla_status_update);
+BATADV_ATTR_SIF_UINT(bla_duplist_size, bla_duplist_size, 0644,
+		     BATADV_DUPLIST_SIZE_MIN, BATADV_DUPLIST_SIZE_MAX,
+		     batadv_bla_duplist_update);
 #endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 BATADV_ATTR_SIF_BOOL(distributed_arp_table, 0644, batadv_dat_status_update);
@@ -684,8 +687,13 @@ static BATADV_ATTR(gw_sel_class, 0644, batadv_show_gw_sel_class,
 		   batadv_store_gw_sel_class);
 static BATADV_ATTR(gw_bandwidth, 0644, batadv_show_gw_bwidth,
 		   batadv_store_gw_bwidth);
+BATADV_ATTR_SIF_BOOL(gw_distribute, 0644, NULL);
+BATADV_ATTR_SIF_BOOL(latency_stats, 0644, NULL);
+BATADV_ATTR_SIF_BOOL(tp_reverse, 0644, NULL);
 #ifdef CONFIG_BATMAN_ADV_MCAST
 BATADV_ATTR_SIF_BOOL(multicast_mode, 0644, NULL);
+BATADV_ATTR_SIF_UINT(multicast_fanout, multicast_fanout, 0644, 1,
+		     BATADV_MCAST_FANOUT_MAX, NULL);
 #endif
 #ifdef CONFIG_BATMAN_ADV_DEBUG
 BATADV_ATTR_SIF_UINT(log_level, log_level, 0644, 0, BATADV_DBG_ALL, NULL);
@@ -701,12 +709,14 @@ static struct batadv_attribute *batadv_mesh_attrs[] = {
 	&batadv_attr_bonding,
 #ifdef CONFIG_BATMAN_ADV_BLA
 	&batadv_attr_bridge_loop_avoidance,
+	&batadv_attr_bla_duplist_size,
 #endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 	&batadv_attr_distributed_arp_table,
 #endif
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	&batadv_attr_multicast_mode,
+	&batadv_attr_multicast_fanout,
 #endif
 	&batadv_attr_fragmentation,
 	&batadv_attr_routing_algo,
@@ -715,6 +725,9 @@ static struct batadv_attribute *batadv_mesh_attrs[] = {
 	&batadv_attr_hop_penalty,
 	&batadv_attr_gw_sel_class,
 	&batadv_attr_gw_bandwidth,
+	&batadv_attr_gw_distribute,
+	&batadv_attr_latency_stats,
+	&batadv_attr_tp_reverse,
 #ifdef CONFIG_BATMAN_ADV_DEBUG
 	&batadv_attr_log_level,
 #endif
@@ -19,19 +19,26 @@
 #include "main.h"
 
 #include <linux/atomic.h>
+#include <linux/bitmap.h>
+#include <linux/bitops.h>
 #include <linux/bug.h>
 #include <linux/byteorder/generic.h>
 #include <linux/cache.h>
 #include <linux/compiler.h>
+#include <linux/delay.h>
 #include <linux/err.h>
 #include <linux/etherdevice.h>
 #include <linux/fs.h>
+#include <linux/gfp.h>
 #include <linux/if_ether.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
 #include <linux/netdevice.h>
 #include <linux/param.h>
 #include <linux/printk.h>
@@ -44,6 +51,8 @@
 #include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
+#include <linux/time.h>
+#include <linux/timekeeping.h>
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
@@ -62,6 +71,12 @@
  */
 #define BATADV_TP_DEF_TEST_LENGTH 10000
 
+/**
+ * BATADV_TP_MAX_REVERSE_LENGTH - Maximum test length of the streams sent back
+ *  on request of a remote node in milliseconds
+ */
+#define BATADV_TP_MAX_REVERSE_LENGTH 60000
+
 /**
  * BATADV_TP_AWND - Advertised window by the receiver (in bytes)
  */
@@ -73,6 +88,12 @@
  */
 #define BATADV_TP_RECV_TIMEOUT 1000
 
+/**
+ * BATADV_TP_FREE_WAIT - Interval (in milliseconds) in which the mesh teardown
+ *  checks whether all streams are gone
+ */
+#define BATADV_TP_FREE_WAIT 20
+
 /**
  * BATADV_TP_MAX_RTO - Maximum sender timeout. If the sender RTO gets beyond
  * such amound of milliseconds, the receiver is considered unreachable and the
@@ -93,6 +114,88 @@
 #define BATADV_TP_PLEN (BATADV_TP_PACKET_LEN - ETH_HLEN - \
 			sizeof(struct batadv_unicast_packet))
 
+/**
+ * BATADV_TP_DUPTHRESH - initial number of duplicate ACKs triggering Fast
+ *  Retransmit
+ */
+#define BATADV_TP_DUPTHRESH 3
+
+/**
+ * BATADV_TP_MAX_REORDERING - upper bound of the duplicate ACK threshold raised
+ *  by detected reordering
+ */
+#define BATADV_TP_MAX_REORDERING 16
+
+/**
+ * BATADV_TP_CUBIC_BETA - CUBIC multiplicative decrease factor (scaled by 1024)
+ */
+#define BATADV_TP_CUBIC_BETA 717
+
+/**
+ * BATADV_TP_CUBIC_K_SCALE - msecs^3 needed by the cubic function to grow by
+ *  one segment, hence 1/C with C = 0.4 segments/sec^3
+ */
+#define BATADV_TP_CUBIC_K_SCALE 2500000000ULL
+
+/**
+ * BATADV_TP_CUBIC_MAX_OFFS - maximum distance (msecs) from the plateau used to
+ *  evaluate the cubic function. Keeps the cube within 64 bit
+ */
+#define BATADV_TP_CUBIC_MAX_OFFS 1000000
+
+/**
+ * BATADV_TP_BBR_UNIT - fixed point unit of the BBR gains
+ */
+#define BATADV_TP_BBR_UNIT 256
+
+/**
+ * BATADV_TP_BBR_CWND_GAIN - window size in multiples of the estimated
+ *  bandwidth-delay product
+ */
+#define BATADV_TP_BBR_CWND_GAIN 2
+
+/**
+ * BATADV_TP_BBR_BW_ROUNDS - number of rounds the max delivery rate is kept
+ */
+#define BATADV_TP_BBR_BW_ROUNDS 10
+
+/**
+ * BATADV_TP_BBR_FULL_BW_CNT - rounds without significant delivery rate growth
+ *  after which startup is considered over
+ */
+#define BATADV_TP_BBR_FULL_BW_CNT 3
+
+/**
+ * BATADV_TP_BBR_MIN_RTT_WIN - milliseconds the minimum RTT sample is kept
+ */
+#define BATADV_TP_BBR_MIN_RTT_WIN 10000
+
+/**
+ * BATADV_TP_CBR_MAX_LAG - maximum delay (usecs) a constant bitrate sender may
+ *  catch up on by sending back to back, e.g. after sleeping for too long
+ */
+#define BATADV_TP_CBR_MAX_LAG 1000
+
+/**
+ * BATADV_TP_CBR_SLACK - slack (usecs) granted to the constant bitrate sleep
+ */
+#define BATADV_TP_CBR_SLACK 50
+
+/**
+ * BATADV_TP_CBR_MAX_SLEEP - longest single constant bitrate sleep (usecs)
+ *  before checking whether the stream was stopped
+ */
+#define BATADV_TP_CBR_MAX_SLEEP 100000
+
+/* BBR gain cycle: probe for more bandwidth, drain the queue, cruise */
+static const u32 batadv_tp_bbr_gain[] = {
+	BATADV_TP_BBR_UNIT * 5 / 4,
+	BATADV_TP_BBR_UNIT * 3 / 4,
+	BATADV_TP_BBR_UNIT, BATADV_TP_BBR_UNIT,
+	BATADV_TP_BBR_UNIT, BATADV_TP_BBR_UNIT,
+	BATADV_TP_BBR_UNIT, BATADV_TP_BBR_UNIT,
+};
+
 static u8 batadv_tp_prerandom[4096] __read_mostly;
 
 /**
@@ -139,8 +242,9 @@ static u32 batadv_tp_cwnd(u32 base, u32 increment, u32 min)
 }
 
 /**
- * batadv_tp_updated_cwnd - update the Congestion Windows
+ * batadv_tp_reno_cong_avoid - update the Congestion Windows
  * @tp_vars: the private data of the current TP meter session
+ * @acked: amount of newly acked bytes
  * @mss: maximum segment size of transmission
  *
  * 1) if the session is in Slow Start, the CWND has to be increased by 1
@@ -148,29 +252,334 @@ static u32 batadv_tp_cwnd(u32 base, u32 increment, u32 min)
  * 2) if the session is in Congestion Avoidance, the CWND has to be
  * increased by MSS * MSS / CWND for every unique received ACK
  */
-static void batadv_tp_update_cwnd(struct batadv_tp_vars *tp_vars, u32 mss)
+static void batadv_tp_reno_cong_avoid(struct batadv_tp_vars *tp_vars,
+				      u32 acked, u32 mss)
 {
-	spin_lock_bh(&tp_vars->cwnd_lock);
-
 	/* slow start... */
 	if (tp_vars->cwnd <= tp_vars->ss_threshold) {
 		tp_vars->dec_cwnd = 0;
 		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
-		spin_unlock_bh(&tp_vars->cwnd_lock);
 		return;
 	}
 
 	/* increment CWND at least of 1 (section 3.1 of RFC5681) */
 	tp_vars->dec_cwnd += max_t(u32, 1U << 3,
 				   ((mss * mss) << 6) / (tp_vars->cwnd << 3));
-	if (tp_vars->dec_cwnd < (mss << 3)) {
-		spin_unlock_bh(&tp_vars->cwnd_lock);
+	if (tp_vars->dec_cwnd < (mss << 3))
 		return;
-	}
 
 	tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
 	tp_vars->dec_cwnd = 0;
+}
+
+/**
+ * batadv_tp_reno_ssthresh - halve the window after a loss
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ *
+ * Return: new slow start threshold in bytes
+ */
+static u32 batadv_tp_reno_ssthresh(struct batadv_tp_vars *tp_vars, u32 mss)
+{
+	return tp_vars->cwnd >> 1;
+}
+
+/**
+ * batadv_tp_cbrt - integer cube root
+ * @a: value to compute the cube root of, smaller than 2^63
+ *
+ * Return: largest integer whose cube is not bigger than @a
+ */
+static u32 batadv_tp_cbrt(u64 a)
+{
+	u64 y;
+	u32 x = 0;
+	int b;
+
+	for (b = 20; b >= 0; b--) {
+		y = x | (1U << b);
+		if (y * y * y <= a)
+			x = y;
+	}
+
+	return x;
+}
+
+/**
+ * batadv_tp_cubic_init - initialize the CUBIC state of a new stream
+ * @tp_vars: the private data of the current TP meter session
+ */
+static void batadv_tp_cubic_init(struct batadv_tp_vars *tp_vars)
+{
+	memset(&tp_vars->cc.cubic, 0, sizeof(tp_vars->cc.cubic));
+}
+
+/**
+ * batadv_tp_cubic_cong_avoid - grow the window along the cubic function
+ * @tp_vars: the private data of the current TP meter session
+ * @acked: amount of newly acked bytes
+ * @mss: maximum segment size of transmission
+ *
+ * The window follows W(t) = C * (t - K)^3 + W_max (RFC8312, Section 4.1):
+ * after a reduction it quickly grows back towards the size it had before,
+ * stays around that plateau and only then probes for more. Unlike Reno the
+ * growth depends on the time elapsed since the last loss rather than on the
+ * number of ACKs, which keeps sporadic wireless losses from pinning the
+ * window to a fraction of the path capacity.
+ */
+static void batadv_tp_cubic_cong_avoid(struct batadv_tp_vars *tp_vars,
+				       u32 acked, u32 mss)
+{
+	struct batadv_tp_cubic *cubic = &tp_vars->cc.cubic;
+	u64 offs, delta;
+	u32 target, t;
+	u32 inc;
+
+	if (tp_vars->cwnd <= tp_vars->ss_threshold) {
+		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
+		return;
+	}
+
+	if (!cubic->epoch_start) {
+		cubic->epoch_start = jiffies;
+		if (tp_vars->cwnd < cubic->w_max) {
+			delta = (cubic->w_max - tp_vars->cwnd) / mss;
+			cubic->k = batadv_tp_cbrt(delta *
+						  BATADV_TP_CUBIC_K_SCALE);
+			cubic->origin = cubic->w_max;
+		} else {
+			cubic->k = 0;
+			cubic->origin = tp_vars->cwnd;
+		}
+	}
 
+	/* target window one RTT ahead */
+	t = jiffies_to_msecs(jiffies - cubic->epoch_start);
+	t += tp_vars->srtt >> 3;
+
+	if (t < cubic->k)
+		offs = cubic->k - t;
+	else
+		offs = t - cubic->k;
+	offs = min_t(u64, offs, BATADV_TP_CUBIC_MAX_OFFS);
+
+	delta = div64_u64(offs * offs * offs, BATADV_TP_CUBIC_K_SCALE);
+	delta *= mss;
+
+	if (t >= cubic->k)
+		target = min_t(u64, (u64)cubic->origin + delta,
+			       BATADV_TP_AWND);
+	else if (delta < cubic->origin)
+		target = cubic->origin - delta;
+	else
+		target = 0;
+
+	if (target <= tp_vars->cwnd)
+		return;
+
+	inc = div_u64((u64)(target - tp_vars->cwnd) * acked, tp_vars->cwnd);
+	tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, max_t(u32, inc, 1), mss);
+}
+
+/**
+ * batadv_tp_cubic_ssthresh - multiplicative decrease after a loss
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ *
+ * Return: new slow start threshold in bytes
+ */
+static u32 batadv_tp_cubic_ssthresh(struct batadv_tp_vars *tp_vars, u32 mss)
+{
+	struct batadv_tp_cubic *cubic = &tp_vars->cc.cubic;
+	u32 cwnd = tp_vars->cwnd;
+
+	cubic->epoch_start = 0;
+
+	/* fast convergence: release bandwidth if the plateau went down */
+	if (cwnd < cubic->last_max)
+		cubic->w_max = div_u64((u64)cwnd *
+				       (1024 + BATADV_TP_CUBIC_BETA), 2048);
+	else
+		cubic->w_max = cwnd;
+	cubic->last_max = cwnd;
+
+	cwnd = div_u64((u64)cwnd * BATADV_TP_CUBIC_BETA, 1024);
+
+	return max_t(u32, cwnd, 2 * mss);
+}
+
+/**
+ * batadv_tp_bbr_init - initialize the BBR state of a new stream
+ * @tp_vars: the private data of the current TP meter session
+ */
+static void batadv_tp_bbr_init(struct batadv_tp_vars *tp_vars)
+{
+	struct batadv_tp_bbr *bbr = &tp_vars->cc.bbr;
+
+	memset(bbr, 0, sizeof(*bbr));
+	bbr->round_stamp = jiffies;
+	bbr->min_rtt_stamp = jiffies;
+}
+
+/**
+ * batadv_tp_bbr_round - update the BBR model at the end of a round
+ * @tp_vars: the private data of the current TP meter session
+ * @bw: delivery rate (bytes/sec) measured during the round
+ */
+static void batadv_tp_bbr_round(struct batadv_tp_vars *tp_vars, u64 bw)
+{
+	struct batadv_tp_bbr *bbr = &tp_vars->cc.bbr;
+
+	bbr->round++;
+
+	/* windowed max filter over the last rounds */
+	if (bw >= bbr->bw ||
+	    bbr->round - bbr->bw_round > BATADV_TP_BBR_BW_ROUNDS) {
+		bbr->bw = bw;
+		bbr->bw_round = bbr->round;
+	}
+
+	if (bbr->full_bw_reached) {
+		bbr->cycle_idx++;
+		bbr->cycle_idx %= ARRAY_SIZE(batadv_tp_bbr_gain);
+		return;
+	}
+
+	/* startup is over once the rate stops growing by 25% per round */
+	if (bbr->bw >= bbr->full_bw + (bbr->full_bw >> 2)) {
+		bbr->full_bw = bbr->bw;
+		bbr->full_bw_cnt = 0;
+		return;
+	}
+
+	if (++bbr->full_bw_cnt < BATADV_TP_BBR_FULL_BW_CNT)
+		return;
+
+	/* start with the draining phase of the cycle to empty the queue
+	 * built up during startup
+	 */
+	bbr->full_bw_reached = true;
+	bbr->cycle_idx = 1;
+}
+
+/**
+ * batadv_tp_bbr_cong_avoid - set the window from the path model
+ * @tp_vars: the private data of the current TP meter session
+ * @acked: amount of newly acked bytes
+ * @mss: maximum segment size of transmission
+ *
+ * Once per RTT the delivery rate is sampled. During startup the window grows
+ * exponentially until the delivery rate stops increasing. Afterwards the
+ * window tracks twice the bandwidth-delay product scaled by a gain that
+ * periodically probes for more bandwidth and drains the queue again.
+ */
+static void batadv_tp_bbr_cong_avoid(struct batadv_tp_vars *tp_vars,
+				     u32 acked, u32 mss)
+{
+	struct batadv_tp_bbr *bbr = &tp_vars->cc.bbr;
+	u64 delivered, bw, target;
+	u32 elapsed, inc;
+
+	delivered = atomic64_read(&tp_vars->tot_sent);
+	elapsed = jiffies_to_msecs(jiffies - bbr->round_stamp);
+	if (elapsed && elapsed >= (tp_vars->srtt >> 3)) {
+		bw = div_u64((delivered - bbr->round_delivered) * 1000,
+			     elapsed);
+		batadv_tp_bbr_round(tp_vars, bw);
+		bbr->round_stamp = jiffies;
+		bbr->round_delivered = delivered;
+	}
+
+	if (!bbr->full_bw_reached || !bbr->min_rtt) {
+		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, acked, mss);
+		return;
+	}
+
+	target = bbr->bw * bbr->min_rtt * BATADV_TP_BBR_CWND_GAIN;
+	target *= batadv_tp_bbr_gain[bbr->cycle_idx];
+	target = div_u64(target, USEC_PER_SEC * BATADV_TP_BBR_UNIT);
+	target = clamp_t(u64, target, 4 * mss, BATADV_TP_AWND);
+
+	if (tp_vars->cwnd >= target) {
+		tp_vars->cwnd = target;
+		return;
+	}
+
+	inc = min_t(u64, acked, target - tp_vars->cwnd);
+	tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, inc, mss);
+}
+
+/**
+ * batadv_tp_bbr_ssthresh - keep the window after a loss
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ *
+ * Losses are not interpreted as congestion; the window is driven by the path
+ * model only.
+ *
+ * Return: new slow start threshold in bytes
+ */
+static u32 batadv_tp_bbr_ssthresh(struct batadv_tp_vars *tp_vars, u32 mss)
+{
+	return tp_vars->cwnd;
+}
+
+/**
+ * batadv_tp_bbr_rtt_sample - track the minimum RTT
+ * @tp_vars: the private data of the current TP meter session
+ * @rtt: new RTT sample in usecs
+ *
+ * The sample is kept in usecs, so that links with a sub-millisecond RTT still
+ * get a path model.
+ */
+static void batadv_tp_bbr_rtt_sample(struct batadv_tp_vars *tp_vars, u32 rtt)
+{
+	struct batadv_tp_bbr *bbr = &tp_vars->cc.bbr;
+
+	/* 0 means "no sample" for min_rtt */
+	rtt = max_t(u32, rtt, 1);
+
+	if (bbr->min_rtt && rtt > bbr->min_rtt &&
+	    !batadv_has_timed_out(bbr->min_rtt_stamp,
+				  BATADV_TP_BBR_MIN_RTT_WIN))
+		return;
+
+	bbr->min_rtt = rtt;
+	bbr->min_rtt_stamp = jiffies;
+}
+
+static const struct batadv_tp_cc_ops batadv_tp_cc[NUM_BATADV_TP_CC] = {
+	[BATADV_TP_CC_RENO] = {
+		.name = "reno",
+		.cong_avoid = batadv_tp_reno_cong_avoid,
+		.ssthresh = batadv_tp_reno_ssthresh,
+	},
+	[BATADV_TP_CC_CUBIC] = {
+		.name = "cubic",
+		.init = batadv_tp_cubic_init,
+		.cong_avoid = batadv_tp_cubic_cong_avoid,
+		.ssthresh = batadv_tp_cubic_ssthresh,
+	},
+	[BATADV_TP_CC_BBR] = {
+		.name = "bbr",
+		.init = batadv_tp_bbr_init,
+		.cong_avoid = batadv_tp_bbr_cong_avoid,
+		.ssthresh = batadv_tp_bbr_ssthresh,
+		.rtt_sample = batadv_tp_bbr_rtt_sample,
+	},
+};
+
+/**
+ * batadv_tp_update_cwnd - update the Congestion Windows
+ * @tp_vars: the private data of the current TP meter session
+ * @acked: amount of newly acked bytes
+ * @mss: maximum segment size of transmission
+ */
+static void batadv_tp_update_cwnd(struct batadv_tp_vars *tp_vars, u32 acked,
+				  u32 mss)
+{
+	spin_lock_bh(&tp_vars->cwnd_lock);
+	tp_vars->cc_ops->cong_avoid(tp_vars, acked, mss);
 	spin_unlock_bh(&tp_vars->cwnd_lock);
 }
 
@@ -211,35 +620,141 @@ static void batadv_tp_update_rto(struct batadv_tp_vars *tp_vars,
 }
 
 /**
- * batadv_tp_batctl_notify - send client status result to client
- * @reason: reason for tp meter session stop
- * @dst: destination of tp_meter session
- * @bat_priv: the bat priv with all the soft interface information
- * @start_time: start of transmission in jiffies
- * @total_sent: bytes acked to the receiver
- * @cookie: cookie of tp_meter session
+ * batadv_tp_timestamp - get the current time for tp meter timestamps
+ *
+ * Return: current monotonic time in usecs, truncated to 32 bit
  */
-static void batadv_tp_batctl_notify(enum batadv_tp_meter_reason reason,
-				    const u8 *dst, struct batadv_priv *bat_priv,
-				    unsigned long start_time, u64 total_sent,
-				    u32 cookie)
+static u32 batadv_tp_timestamp(void)
 {
-	u32 test_time;
-	u8 result;
-	u32 total_bytes;
+	return (u32)ktime_to_us(ktime_get());
+}
 
-	if (!batadv_tp_is_error(reason)) {
-		result = BATADV_TP_REASON_COMPLETE;
-		test_time = jiffies_to_msecs(jiffies - start_time);
-		total_bytes = total_sent;
-	} else {
-		result = reason;
-		test_time = 0;
-		total_bytes = 0;
+/**
+ * batadv_tp_hist_bucket - get the histogram bucket of a value
+ * @val: value in usecs
+ *
+ * Return: index of the power of two bucket @val belongs to
+ */
+static unsigned int batadv_tp_hist_bucket(u32 val)
+{
+	return val ? fls(val) - 1 : 0;
+}
+
+/**
+ * batadv_tp_latency_add - account a new RTT sample
+ * @tp_vars: the private data of the current TP meter session
+ * @rtt: the RTT sample in usecs
+ */
+static void batadv_tp_latency_add(struct batadv_tp_vars *tp_vars, u32 rtt)
+{
+	struct batadv_tp_latency *lat = &tp_vars->lat;
+	u32 diff;
+
+	spin_lock_bh(&tp_vars->lat_lock);
+
+	if (!lat->samples || rtt < lat->rtt_min)
+		lat->rtt_min = rtt;
+	lat->rtt_max = max_t(u32, lat->rtt_max, rtt);
+	lat->rtt_sum += rtt;
+	lat->rtt_hist[batadv_tp_hist_bucket(rtt)]++;
+
+	/* J = J + (|D| - J) / 16, see Section 6.4.1 of RFC3550 */
+	if (lat->samples) {
+		diff = abs((s32)(rtt - lat->last_rtt));
+		lat->jitter += diff - (lat->jitter >> 4);
+		lat->jitter_hist[batadv_tp_hist_bucket(diff)]++;
 	}
 
-	batadv_netlink_tpmeter_notify(bat_priv, dst, result, test_time,
-				      total_bytes, cookie);
+	lat->last_rtt = rtt;
+	lat->samples++;
+
+	spin_unlock_bh(&tp_vars->lat_lock);
+}
+
+/**
+ * batadv_tp_latency_merge - combine the RTT statistics of two streams
+ * @lat: statistics to merge into
+ * @src: statistics to merge
+ */
+static void batadv_tp_latency_merge(struct batadv_tp_latency *lat,
+				    const struct batadv_tp_latency *src)
+{
+	u64 jitter;
+	int i;
+
+	if (!src->samples)
+		return;
+
+	if (!lat->samples || src->rtt_min < lat->rtt_min)
+		lat->rtt_min = src->rtt_min;
+	lat->rtt_max = max_t(u32, lat->rtt_max, src->rtt_max);
+	lat->rtt_sum += src->rtt_sum;
+
+	/* average jitter weighted by the number of samples */
+	jitter = (u64)lat->jitter * lat->samples;
+	jitter += (u64)src->jitter * src->samples;
+	lat->samples += src->samples;
+	lat->jitter = div_u64(jitter, lat->samples);
+
+	for (i = 0; i < BATADV_TP_HIST_BUCKETS; i++) {
+		lat->rtt_hist[i] += src->rtt_hist[i];
+		lat->jitter_hist[i] += src->jitter_hist[i];
+	}
+}
+
+/**
+ * batadv_tp_hist_percentile - estimate a percentile of a latency histogram
+ * @hist: histogram with BATADV_TP_HIST_BUCKETS power of two buckets
+ * @pct: the percentile to estimate (0-100)
+ *
+ * The value is interpolated linearly inside the bucket holding the
+ * percentile.
+ *
+ * Return: estimated percentile in usecs, 0 if the histogram is empty
+ */
+u32 batadv_tp_hist_percentile(const u32 *hist, u8 pct)
+{
+	u64 total = 0, target, cum = 0;
+	u64 low, width, val;
+	int i;
+
+	for (i = 0; i < BATADV_TP_HIST_BUCKETS; i++)
+		total += hist[i];
+
+	if (!total)
+		return 0;
+
+	target = max_t(u64, div_u64(total * pct + 99, 100), 1);
+
+	for (i = 0; i < BATADV_TP_HIST_BUCKETS; i++) {
+		if (cum + hist[i] >= target)
+			break;
+
+		cum += hist[i];
+	}
+
+	low = i ? 1ULL << i : 0;
+	width = i ? 1ULL << i : 2;
+	val = low + div_u64(width * (target - cum), hist[i]);
+
+	return min_t(u64, val, U32_MAX);
+}
+
+/**
+ * batadv_tp_session_id - compute the session identifier of a stream
+ * @session: TP session identifier of the first stream
+ * @stream: index of the stream inside the session
+ * @id: buffer receiving the TP session identifier of the stream
+ */
+static void batadv_tp_session_id(const u8 session[2], u8 stream, u8 id[2])
+{
+	u16 base;
+
+	base = (session[0] << 8) | session[1];
+	base += stream;
+
+	id[0] = base >> 8;
+	id[1] = base & 0xff;
 }
 
 /**
@@ -254,7 +769,136 @@ static void batadv_tp_batctl_error_notify(enum batadv_tp_meter_reason reason,
 					  struct batadv_priv *bat_priv,
 					  u32 cookie)
 {
-	batadv_tp_batctl_notify(reason, dst, bat_priv, 0, 0, cookie);
+	batadv_netlink_tpmeter_notify(bat_priv, dst, reason, 0, 0, cookie,
+				      NULL);
+}
+
+/**
+ * batadv_tp_group_release - free a tp meter session group
+ * @ref: kref pointer of the batadv_tp_group
+ */
+static void batadv_tp_group_release(struct kref *ref)
+{
+	struct batadv_tp_group *group;
+
+	group = container_of(ref, struct batadv_tp_group, refcount);
+
+	kfree(group);
+}
+
+/**
+ * batadv_tp_group_put - decrement the batadv_tp_group refcounter and possibly
+ *  release it
+ * @group: the tp meter session group to be free'd
+ */
+static void batadv_tp_group_put(struct batadv_tp_group *group)
+{
+	kref_put(&group->refcount, batadv_tp_group_release);
+}
+
+/**
+ * batadv_tp_group_notify - send the aggregated session result to client
+ * @work: work item of the related batadv_tp_group
+ *
+ * The overall result covers the streams sent towards the remote node: the
+ * acked bytes are summed up, the test time is the one of the longest stream
+ * and the session is reported as complete as soon as one stream completed.
+ * The RTT statistics of all of them are combined. The per stream results,
+ * including the ones of the reverse streams, are attached as well.
+ */
+static void batadv_tp_group_notify(struct work_struct *work)
+{
+	const struct batadv_tp_stream_result *res;
+	struct batadv_tp_group *group;
+	struct batadv_priv *bat_priv;
+	bool put_group = false;
+	u8 reason = 0;
+	u32 test_time = 0;
+	u64 total_bytes = 0;
+	u8 i;
+
+	group = container_of(work, struct batadv_tp_group, notify_work);
+	bat_priv = group->bat_priv;
+
+	if (group->requested)
+		goto out;
+
+	for (i = 0; i < group->num_streams; i++) {
+		res = &group->results[i];
+		if (res->reverse)
+			continue;
+
+		if (!reason || batadv_tp_is_error(reason))
+			reason = res->reason;
+
+		total_bytes += res->bytes;
+		test_time = max_t(u32, test_time, res->test_time);
+		batadv_tp_latency_merge(&group->lat, &res->lat);
+	}
+
+	batadv_netlink_tpmeter_notify(bat_priv, group->other_end,
+				      reason, test_time, total_bytes,
+				      group->cookie, group);
+
+out:
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	/* batadv_tp_meter_free() already took the notification over */
+	if (!hlist_unhashed(&group->list)) {
+		hlist_del_init(&group->list);
+		put_group = true;
+	}
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+
+	if (put_group)
+		batadv_tp_group_put(group);
+}
+
+/**
+ * batadv_tp_stream_done - store the result of a finished stream
+ * @tp_vars: the private data of the finished stream
+ * @bytes: amount of bytes acked or received in order
+ * @test_time: duration of the stream in milliseconds
+ *
+ * Once the last stream of a session is done, the aggregated result is sent
+ * to the client.
+ */
+static void batadv_tp_stream_done(struct batadv_tp_vars *tp_vars, u64 bytes,
+				  u32 test_time)
+{
+	struct batadv_tp_group *group = tp_vars->group;
+	struct batadv_priv *bat_priv = tp_vars->bat_priv;
+	struct batadv_tp_stream_result *res;
+
+	if (!group)
+		return;
+
+	res = &group->results[tp_vars->stream];
+
+	if (!batadv_tp_is_error(tp_vars->reason)) {
+		res->reason = BATADV_TP_REASON_COMPLETE;
+		res->test_time = test_time;
+		res->bytes = bytes;
+	} else {
+		res->reason = tp_vars->reason;
+		res->test_time = 0;
+		res->bytes = 0;
+	}
+
+	if (tp_vars->role == BATADV_TP_SENDER) {
+		spin_lock_bh(&tp_vars->lat_lock);
+		res->lat = tp_vars->lat;
+		spin_unlock_bh(&tp_vars->lat_lock);
+	}
+
+	if (!atomic_dec_and_test(&group->pending))
+		return;
+
+	kref_get(&group->refcount);
+
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	hlist_add_head(&group->list, &bat_priv->tp_notify_list);
+	queue_work(batadv_event_workqueue, &group->notify_work);
+	spin_unlock_bh(&bat_priv->tp_list_lock);
 }
 
 /**
@@ -341,19 +985,14 @@ batadv_tp_list_find_session(struct batadv_priv *bat_priv, const u8 *dst,
 static void batadv_tp_vars_release(struct kref *ref)
 {
 	struct batadv_tp_vars *tp_vars;
-	struct batadv_tp_unacked *un, *safe;
 
 	tp_vars = container_of(ref, struct batadv_tp_vars, refcount);
 
-	/* lock should not be needed because this object is now out of any
-	 * context!
-	 */
-	spin_lock_bh(&tp_vars->unacked_lock);
-	list_for_each_entry_safe(un, safe, &tp_vars->unacked_list, list) {
-		list_del(&un->list);
-		kfree(un);
-	}
-	spin_unlock_bh(&tp_vars->unacked_lock);
+	if (tp_vars->group)
+		batadv_tp_group_put(tp_vars->group);
+
+	if (tp_vars->payload)
+		put_page(tp_vars->payload);
 
 	kfree_rcu(tp_vars, rcu);
 }
@@ -385,8 +1024,6 @@ static void batadv_tp_sender_cleanup(struct batadv_priv *bat_priv,
 	/* drop list reference */
 	batadv_tp_vars_put(tp_vars);
 
-	atomic_dec(&tp_vars->bat_priv->tp_num);
-
 	/* kill the timer and remove its reference */
 	del_timer_sync(&tp_vars->timer);
 	/* the worker might have rearmed itself therefore we kill it again. Note
@@ -396,6 +1033,9 @@ static void batadv_tp_sender_cleanup(struct batadv_priv *bat_priv,
 	 */
 	del_timer(&tp_vars->timer);
 	batadv_tp_vars_put(tp_vars);
+
+	/* the stream no longer touches bat_priv, see batadv_tp_meter_free() */
+	atomic_dec(&bat_priv->tp_num);
 }
 
 /**
@@ -406,7 +1046,7 @@ static void batadv_tp_sender_cleanup(struct batadv_priv *bat_priv,
 static void batadv_tp_sender_end(struct batadv_priv *bat_priv,
 				 struct batadv_tp_vars *tp_vars)
 {
-	u32 session_cookie;
+	u32 test_time;
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 		   "Test towards %pM finished..shutting down (reason=%d)\n",
@@ -417,18 +1057,12 @@ static void batadv_tp_sender_end(struct batadv_priv *bat_priv,
 		   tp_vars->srtt >> 3, tp_vars->rttvar >> 2, tp_vars->rto);
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-		   "Final values: cwnd=%u ss_threshold=%u\n",
-		   tp_vars->cwnd, tp_vars->ss_threshold);
+		   "Final values: cc=%s cwnd=%u ss_threshold=%u\n",
+		   tp_vars->cc_ops->name, tp_vars->cwnd, tp_vars->ss_threshold);
 
-	session_cookie = batadv_tp_session_cookie(tp_vars->session,
-						  tp_vars->icmp_uid);
-
-	batadv_tp_batctl_notify(tp_vars->reason,
-				tp_vars->other_end,
-				bat_priv,
-				tp_vars->start_time,
-				atomic64_read(&tp_vars->tot_sent),
-				session_cookie);
+	test_time = jiffies_to_msecs(jiffies - tp_vars->start_time);
+	batadv_tp_stream_done(tp_vars, atomic64_read(&tp_vars->tot_sent),
+			      test_time);
 }
 
 /**
@@ -509,7 +1143,8 @@ static void batadv_tp_sender_timeout(unsigned long arg)
 
 	spin_lock_bh(&tp_vars->cwnd_lock);
 
-	tp_vars->ss_threshold = tp_vars->cwnd >> 1;
+	tp_vars->ss_threshold = tp_vars->cc_ops->ssthresh(tp_vars,
+							  BATADV_TP_PLEN);
 	if (tp_vars->ss_threshold < BATADV_TP_PLEN * 2)
 		tp_vars->ss_threshold = BATADV_TP_PLEN * 2;
 
@@ -530,35 +1165,31 @@ static void batadv_tp_sender_timeout(unsigned long arg)
 }
 
 /**
- * batadv_tp_fill_prerandom - Fill buffer with prefetched random bytes
- * @tp_vars: the private TP meter data for this session
- * @buf: Buffer to fill with bytes
- * @nbytes: amount of pseudorandom bytes
+ * batadv_tp_payload_alloc - allocate the payload page of a sender stream
+ *
+ * The page is filled once with the prefetched random bytes and afterwards
+ * attached to every sent message as a read-only fragment. Generating a
+ * message therefore neither copies payload nor takes a lock.
+ *
+ * Return: the payload page or NULL if it couldn't be allocated
  */
-static void batadv_tp_fill_prerandom(struct batadv_tp_vars *tp_vars,
-				     u8 *buf, size_t nbytes)
+static struct page *batadv_tp_payload_alloc(void)
 {
-	u32 local_offset;
-	size_t bytes_inbuf;
-	size_t to_copy;
-	size_t pos = 0;
+	struct page *page;
+	u8 *buf;
+	size_t pos;
 
-	spin_lock_bh(&tp_vars->prerandom_lock);
-	local_offset = tp_vars->prerandom_offset;
-	tp_vars->prerandom_offset += nbytes;
-	tp_vars->prerandom_offset %= sizeof(batadv_tp_prerandom);
-	spin_unlock_bh(&tp_vars->prerandom_lock);
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return NULL;
 
-	while (nbytes) {
-		local_offset %= sizeof(batadv_tp_prerandom);
-		bytes_inbuf = sizeof(batadv_tp_prerandom) - local_offset;
-		to_copy = min(nbytes, bytes_inbuf);
+	buf = page_address(page);
+	for (pos = 0; pos < PAGE_SIZE; pos += sizeof(batadv_tp_prerandom))
+		memcpy(&buf[pos], batadv_tp_prerandom,
+		       min_t(size_t, PAGE_SIZE - pos,
+			     sizeof(batadv_tp_prerandom)));
 
-		memcpy(&buf[pos], &batadv_tp_prerandom[local_offset], to_copy);
-		pos += to_copy;
-		nbytes -= to_copy;
-		local_offset = 0;
-	}
+	return page;
 }
 
 /**
@@ -585,11 +1216,17 @@ static int batadv_tp_send_msg(struct batadv_tp_vars *tp_vars, const u8 *src,
 {
 	struct batadv_icmp_tp_packet *icmp;
 	struct sk_buff *skb;
-	int r;
-	u8 *data;
 	size_t data_len;
+	u32 offset;
+	int r;
+
+	BUILD_BUG_ON(BATADV_TP_PLEN > PAGE_SIZE);
 
-	skb = netdev_alloc_skb_ip_align(NULL, len + ETH_HLEN);
+	/* only the header is linear, the payload is a fragment of the stream
+	 * page. The head is small enough to be served by the per-cpu page
+	 * fragment cache of the network stack
+	 */
+	skb = netdev_alloc_skb_ip_align(NULL, sizeof(*icmp) + ETH_HLEN);
 	if (unlikely(!skb))
 		return BATADV_TP_REASON_MEMORY_ERROR;
 
@@ -610,9 +1247,17 @@ static int batadv_tp_send_msg(struct batadv_tp_vars *tp_vars, const u8 *src,
 	icmp->seqno = htonl(seqno);
 	icmp->timestamp = htonl(timestamp);
 
+	/* the seqno moves the payload window over the page so that
+	 * consecutive messages don't carry identical content
+	 */
 	data_len = len - sizeof(*icmp);
-	data = (u8 *)skb_put(skb, data_len);
-	batadv_tp_fill_prerandom(tp_vars, data, data_len);
+	offset = seqno % (PAGE_SIZE - data_len + 1);
+
+	get_page(tp_vars->payload);
+	skb_fill_page_desc(skb, 0, tp_vars->payload, offset, data_len);
+	skb->len += data_len;
+	skb->data_len += data_len;
+	skb->truesize += data_len;
 
 	r = batadv_send_skb_to_orig(skb, orig_node, NULL);
 	if (r == NET_XMIT_SUCCESS)
@@ -621,6 +1266,64 @@ static int batadv_tp_send_msg(struct batadv_tp_vars *tp_vars, const u8 *src,
 	return BATADV_TP_REASON_CANT_SEND;
 }
 
+/**
+ * batadv_tp_sack_update - update the SACK state with the blocks of an ACK
+ * @tp_vars: the private data of the current TP meter session
+ * @skb: the buffer containing the received ACK
+ * @recv_ack: the cumulative ACK carried by @skb
+ *
+ * Only the number of blocks announced in the ACK header is parsed. The blocks
+ * of each ACK replace the previously known ones. A D-SACK for the
+ * segment of the last Fast Retransmit shows that the original segment was
+ * only reordered, hence the duplicate ACK threshold is raised.
+ */
+static void batadv_tp_sack_update(struct batadv_tp_vars *tp_vars,
+				  const struct sk_buff *skb, u32 recv_ack)
+{
+	const struct batadv_icmp_tp_ack_packet *icmp;
+	const struct batadv_icmp_tp_sack *block;
+	struct batadv_icmp_tp_sack buf;
+	size_t offset, len;
+	u32 start, end;
+	u8 i, num_blocks, num = 0;
+
+	icmp = (struct batadv_icmp_tp_ack_packet *)skb->data;
+	num_blocks = min_t(u8, icmp->num_sack, BATADV_TP_MAX_SACK + 1);
+
+	spin_lock_bh(&tp_vars->cwnd_lock);
+	offset = sizeof(*icmp);
+	for (i = 0; i < num_blocks; i++) {
+		len = sizeof(*block);
+		block = skb_header_pointer(skb, offset + i * len, len, &buf);
+		if (!block)
+			break;
+
+		start = ntohl(block->start);
+		end = ntohl(block->end);
+		if (!batadv_seq_before(start, end))
+			continue;
+
+		if (i == 0 && batadv_seq_before(start, recv_ack)) {
+			if (tp_vars->dsack_wait &&
+			    start == tp_vars->dsack_seqno &&
+			    tp_vars->reordering < BATADV_TP_MAX_REORDERING) {
+				tp_vars->reordering++;
+				tp_vars->dsack_wait = false;
+			}
+			continue;
+		}
+
+		if (num == BATADV_TP_MAX_SACK)
+			break;
+
+		tp_vars->sack[num].start = start;
+		tp_vars->sack[num].end = end;
+		num++;
+	}
+	WRITE_ONCE(tp_vars->num_sack, num);
+	spin_unlock_bh(&tp_vars->cwnd_lock);
+}
+
 /**
  * batadv_tp_recv_ack - ACK receiving function
  * @bat_priv: the bat priv with all the soft interface information
@@ -633,17 +1336,20 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 {
 	struct batadv_hard_iface *primary_if = NULL;
 	struct batadv_orig_node *orig_node = NULL;
-	const struct batadv_icmp_tp_packet *icmp;
+	const struct batadv_icmp_tp_ack_packet *icmp;
 	struct batadv_tp_vars *tp_vars;
 	size_t packet_len, mss;
-	u32 rtt, recv_ack, cwnd;
+	u32 rtt, rtt_us, recv_ack, cwnd, acked;
 	unsigned char *dev_addr;
 
 	packet_len = BATADV_TP_PLEN;
 	mss = BATADV_TP_PLEN;
 	packet_len += sizeof(struct batadv_unicast_packet);
 
-	icmp = (struct batadv_icmp_tp_packet *)skb->data;
+	if (!pskb_may_pull(skb, sizeof(*icmp)))
+		return;
+
+	icmp = (struct batadv_icmp_tp_ack_packet *)skb->data;
 
 	/* find the tp_vars */
 	tp_vars = batadv_tp_list_find_session(bat_priv, icmp->orig,
@@ -668,7 +1374,14 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 		goto out;
 
 	/* update RTO with the new sampled RTT, if any */
-	rtt = jiffies_to_msecs(jiffies) - ntohl(icmp->timestamp);
+	rtt_us = batadv_tp_timestamp() - ntohl(icmp->timestamp);
+	if (icmp->timestamp) {
+		batadv_tp_latency_add(tp_vars, rtt_us);
+		if (tp_vars->cc_ops->rtt_sample)
+			tp_vars->cc_ops->rtt_sample(tp_vars, rtt_us);
+	}
+
+	rtt = rtt_us / USEC_PER_MSEC;
 	if (icmp->timestamp && rtt)
 		batadv_tp_update_rto(tp_vars, rtt);
 
@@ -676,21 +1389,24 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 	batadv_tp_reset_sender_timer(tp_vars);
 
 	recv_ack = ntohl(icmp->seqno);
+	batadv_tp_sack_update(tp_vars, skb, recv_ack);
 
 	/* check if this ACK is a duplicate */
 	if (atomic_read(&tp_vars->last_acked) == recv_ack) {
 		atomic_inc(&tp_vars->dup_acks);
-		if (atomic_read(&tp_vars->dup_acks) != 3)
+		if (atomic_read(&tp_vars->dup_acks) != tp_vars->reordering)
 			goto out;
 
 		if (recv_ack >= tp_vars->recover)
 			goto out;
 
-		/* if this is the third duplicate ACK do Fast Retransmit */
+		/* if the duplicate ACK threshold is reached do Fast
+		 * Retransmit
+		 */
 		batadv_tp_send_msg(tp_vars, primary_if->net_dev->dev_addr,
 				   orig_node, recv_ack, packet_len,
 				   icmp->session, icmp->uid,
-				   jiffies_to_msecs(jiffies));
+				   batadv_tp_timestamp());
 
 		spin_lock_bh(&tp_vars->cwnd_lock);
 
@@ -700,13 +1416,15 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 		 * is entered. RFC6582, Section 3.2, step 1
 		 */
 		tp_vars->recover = tp_vars->last_sent;
-		tp_vars->ss_threshold = tp_vars->cwnd >> 1;
+		tp_vars->ss_threshold = tp_vars->cc_ops->ssthresh(tp_vars, mss);
+		tp_vars->dsack_seqno = recv_ack;
+		tp_vars->dsack_wait = true;
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Meter: Fast Recovery, (cur cwnd=%u) ss_thr=%u last_sent=%u recv_ack=%u\n",
 			   tp_vars->cwnd, tp_vars->ss_threshold,
 			   tp_vars->last_sent, recv_ack);
-		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->ss_threshold, 3 * mss,
-					       mss);
+		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->ss_threshold,
+					       tp_vars->reordering * mss, mss);
 		tp_vars->dec_cwnd = 0;
 		tp_vars->last_sent = recv_ack;
 
@@ -730,7 +1448,7 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 						   orig_node, recv_ack,
 						   packet_len, icmp->session,
 						   icmp->uid,
-						   jiffies_to_msecs(jiffies));
+						   batadv_tp_timestamp());
 				tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd,
 							       mss, mss);
 			} else {
@@ -746,8 +1464,9 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 			goto move_twnd;
 		}
 
-		if (recv_ack - atomic_read(&tp_vars->last_acked) >= mss)
-			batadv_tp_update_cwnd(tp_vars, mss);
+		acked = recv_ack - atomic_read(&tp_vars->last_acked);
+		if (acked >= mss)
+			batadv_tp_update_cwnd(tp_vars, acked, mss);
 move_twnd:
 		/* move the Transmit Window */
 		atomic_set(&tp_vars->last_acked, recv_ack);
@@ -775,10 +1494,43 @@ static bool batadv_tp_avail(struct batadv_tp_vars *tp_vars,
 {
 	u32 win_left, win_limit;
 
-	win_limit = atomic_read(&tp_vars->last_acked) + tp_vars->cwnd;
-	win_left = win_limit - tp_vars->last_sent;
+	win_limit = atomic_read(&tp_vars->last_acked) + tp_vars->cwnd;
+
+	/* skipping SACKed data may have moved last_sent past a shrunk window */
+	if (batadv_seq_before(win_limit, tp_vars->last_sent))
+		return false;
+
+	win_left = win_limit - tp_vars->last_sent;
+
+	return win_left >= payload_len;
+}
+
+/**
+ * batadv_tp_sack_skip - skip the data already received by the other end
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * After a retransmission moved last_sent back, the ranges reported in the SACK
+ * blocks don't have to be sent again.
+ */
+static void batadv_tp_sack_skip(struct batadv_tp_vars *tp_vars)
+{
+	struct batadv_tp_sack *sack;
+	u8 i;
+
+	if (!READ_ONCE(tp_vars->num_sack))
+		return;
+
+	spin_lock_bh(&tp_vars->cwnd_lock);
+	for (i = 0; i < tp_vars->num_sack; i++) {
+		sack = &tp_vars->sack[i];
 
-	return win_left >= payload_len;
+		if (batadv_seq_before(tp_vars->last_sent, sack->start) ||
+		    !batadv_seq_before(tp_vars->last_sent, sack->end))
+			continue;
+
+		tp_vars->last_sent = sack->end;
+	}
+	spin_unlock_bh(&tp_vars->cwnd_lock);
 }
 
 /**
@@ -803,6 +1555,38 @@ static int batadv_tp_wait_available(struct batadv_tp_vars *tp_vars, size_t plen)
 	return ret;
 }
 
+/**
+ * batadv_tp_cbr_wait - pace the sender to its constant bitrate
+ * @tp_vars: the private data of the current TP meter session
+ * @len: length of the packet about to be sent
+ *
+ * The congestion window still applies on top, so the offered load is only
+ * constant as long as the path can carry it. Long pauses of low rate streams
+ * are split into slices of at most BATADV_TP_CBR_MAX_SLEEP, so that a stopped
+ * stream does not keep sleeping.
+ */
+static void batadv_tp_cbr_wait(struct batadv_tp_vars *tp_vars, size_t len)
+{
+	ktime_t now = ktime_get();
+	s64 delay, slice;
+
+	/* do not burst to make up for a stall, e.g. a full window */
+	if (ktime_us_delta(now, tp_vars->cbr_next) > BATADV_TP_CBR_MAX_LAG)
+		tp_vars->cbr_next = now;
+
+	delay = ktime_us_delta(tp_vars->cbr_next, now);
+	while (delay > 0 && atomic_read(&tp_vars->sending) != 0) {
+		slice = min_t(s64, delay, BATADV_TP_CBR_MAX_SLEEP);
+		usleep_range(slice, slice + BATADV_TP_CBR_SLACK);
+
+		delay = ktime_us_delta(tp_vars->cbr_next, ktime_get());
+	}
+
+	tp_vars->cbr_next = ktime_add_ns(tp_vars->cbr_next,
+					 div_u64((u64)len * NSEC_PER_SEC,
+						 tp_vars->rate));
+}
+
 /**
  * batadv_tp_send - main sending thread of a tp meter session
  * @arg: address of the related tp_vars
@@ -854,6 +1638,8 @@ static int batadv_tp_send(void *arg)
 			   msecs_to_jiffies(tp_vars->test_length));
 
 	while (atomic_read(&tp_vars->sending) != 0) {
+		batadv_tp_sack_skip(tp_vars);
+
 		if (unlikely(!batadv_tp_avail(tp_vars, payload_len))) {
 			batadv_tp_wait_available(tp_vars, payload_len);
 			continue;
@@ -864,11 +1650,14 @@ static int batadv_tp_send(void *arg)
 		 */
 		packet_len = payload_len + sizeof(struct batadv_unicast_packet);
 
+		if (tp_vars->rate)
+			batadv_tp_cbr_wait(tp_vars, packet_len);
+
 		err = batadv_tp_send_msg(tp_vars, primary_if->net_dev->dev_addr,
 					 orig_node, tp_vars->last_sent,
 					 packet_len,
 					 tp_vars->session, tp_vars->icmp_uid,
-					 jiffies_to_msecs(jiffies));
+					 batadv_tp_timestamp());
 
 		/* something went wrong during the preparation/transmission */
 		if (unlikely(err && err != BATADV_TP_REASON_CANT_SEND)) {
@@ -910,17 +1699,13 @@ static void batadv_tp_start_kthread(struct batadv_tp_vars *tp_vars)
 {
 	struct task_struct *kthread;
 	struct batadv_priv *bat_priv = tp_vars->bat_priv;
-	u32 session_cookie;
 
 	kref_get(&tp_vars->refcount);
 	kthread = kthread_create(batadv_tp_send, tp_vars, "kbatadv_tp_meter");
 	if (IS_ERR(kthread)) {
-		session_cookie = batadv_tp_session_cookie(tp_vars->session,
-							  tp_vars->icmp_uid);
 		pr_err("batadv: cannot create tp meter kthread\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_MEMORY_ERROR,
-					      tp_vars->other_end,
-					      bat_priv, session_cookie);
+		tp_vars->reason = BATADV_TP_REASON_MEMORY_ERROR;
+		batadv_tp_stream_done(tp_vars, 0, 0);
 
 		/* drop reserved reference for kthread */
 		batadv_tp_vars_put(tp_vars);
@@ -934,64 +1719,31 @@ static void batadv_tp_start_kthread(struct batadv_tp_vars *tp_vars)
 }
 
 /**
- * batadv_tp_start - start a new tp meter session
+ * batadv_tp_sender_init - initialize the sender side of a tp meter stream
  * @bat_priv: the bat priv with all the soft interface information
+ * @tp_vars: the private data of the stream to initialize
  * @dst: the receiver MAC address
+ * @session: TP session identifier of the stream
+ * @icmp_uid: icmp pseudo uid of the stream
  * @test_length: test length in milliseconds
- * @cookie: session cookie
+ * @cc: congestion control of the stream (see batadv_tp_meter_cc)
+ * @rate: constant bitrate (bytes/sec) of the stream, 0 if window limited
+ *
+ * The stream is added to the tp_list, therefore bat_priv->tp_list_lock has to
+ * be held by the caller.
  */
-void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
-		     u32 test_length, u32 *cookie)
+static void batadv_tp_sender_init(struct batadv_priv *bat_priv,
+				  struct batadv_tp_vars *tp_vars,
+				  const u8 *dst, const u8 *session,
+				  u8 icmp_uid, u32 test_length, u8 cc,
+				  u32 rate)
 {
-	struct batadv_tp_vars *tp_vars;
-	u8 session_id[2];
-	u8 icmp_uid;
-	u32 session_cookie;
-
-	get_random_bytes(session_id, sizeof(session_id));
-	get_random_bytes(&icmp_uid, 1);
-	session_cookie = batadv_tp_session_cookie(session_id, icmp_uid);
-	*cookie = session_cookie;
-
-	/* look for an already existing test towards this node */
-	spin_lock_bh(&bat_priv->tp_list_lock);
-	tp_vars = batadv_tp_list_find(bat_priv, dst);
-	if (tp_vars) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_tp_vars_put(tp_vars);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: test to or from the same node already ongoing, aborting\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_ALREADY_ONGOING,
-					      dst, bat_priv, session_cookie);
-		return;
-	}
-
-	if (!atomic_add_unless(&bat_priv->tp_num, 1, BATADV_TP_MAX_NUM)) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: too many ongoing sessions, aborting (SEND)\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_TOO_MANY, dst,
-					      bat_priv, session_cookie);
-		return;
-	}
-
-	tp_vars = kmalloc(sizeof(*tp_vars), GFP_ATOMIC);
-	if (!tp_vars) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: %s cannot allocate list elements\n",
-			   __func__);
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_MEMORY_ERROR,
-					      dst, bat_priv, session_cookie);
-		return;
-	}
-
 	/* initialize tp_vars */
 	ether_addr_copy(tp_vars->other_end, dst);
 	kref_init(&tp_vars->refcount);
 	tp_vars->role = BATADV_TP_SENDER;
 	atomic_set(&tp_vars->sending, 1);
-	memcpy(tp_vars->session, session_id, sizeof(session_id));
+	memcpy(tp_vars->session, session, sizeof(tp_vars->session));
 	tp_vars->icmp_uid = icmp_uid;
 
 	tp_vars->last_sent = BATADV_TP_FIRST_SEQ;
@@ -1016,6 +1768,10 @@ void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
 	tp_vars->srtt = 0;
 	tp_vars->rttvar = 0;
 
+	tp_vars->cc_ops = &batadv_tp_cc[cc];
+	if (tp_vars->cc_ops->init)
+		tp_vars->cc_ops->init(tp_vars);
+
 	atomic64_set(&tp_vars->tot_sent, 0);
 
 	kref_get(&tp_vars->refcount);
@@ -1025,38 +1781,421 @@ void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
 	tp_vars->bat_priv = bat_priv;
 	tp_vars->start_time = jiffies;
 
-	init_waitqueue_head(&tp_vars->more_bytes);
+	init_waitqueue_head(&tp_vars->more_bytes);
+
+	spin_lock_init(&tp_vars->cwnd_lock);
+	tp_vars->num_sack = 0;
+	tp_vars->reordering = BATADV_TP_DUPTHRESH;
+	tp_vars->dsack_wait = false;
+
+	tp_vars->rate = rate;
+	tp_vars->cbr_next = ktime_get();
+
+	memset(&tp_vars->lat, 0, sizeof(tp_vars->lat));
+	spin_lock_init(&tp_vars->lat_lock);
+
+	kref_get(&tp_vars->refcount);
+	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
+
+	tp_vars->test_length = test_length;
+
+	/* init work item for finished tp tests */
+	INIT_DELAYED_WORK(&tp_vars->finish_work, batadv_tp_sender_finish);
+}
+
+/**
+ * batadv_tp_reset_receiver_timer - reset the receiver shutdown timer
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * start the receiver shutdown timer or reset it if already started
+ */
+static void batadv_tp_reset_receiver_timer(struct batadv_tp_vars *tp_vars)
+{
+	mod_timer(&tp_vars->timer,
+		  jiffies + msecs_to_jiffies(BATADV_TP_RECV_TIMEOUT));
+}
+
+/**
+ * batadv_tp_receiver_shutdown - stop a tp meter receiver when timeout is
+ *  reached without received ack
+ * @arg: address of the related tp_vars
+ */
+static void batadv_tp_receiver_shutdown(unsigned long arg)
+{
+	struct batadv_tp_vars *tp_vars = (struct batadv_tp_vars *)arg;
+	struct batadv_priv *bat_priv;
+	u32 test_time;
+
+	bat_priv = tp_vars->bat_priv;
+
+	/* if there is recent activity rearm the timer */
+	if (!batadv_has_timed_out(tp_vars->last_recv_time,
+				  BATADV_TP_RECV_TIMEOUT)) {
+		/* reset the receiver shutdown timer */
+		batadv_tp_reset_receiver_timer(tp_vars);
+		return;
+	}
+
+	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+		   "Shutting down for inactivity (more than %dms) from %pM\n",
+		   BATADV_TP_RECV_TIMEOUT, tp_vars->other_end);
+
+	spin_lock_bh(&tp_vars->bat_priv->tp_list_lock);
+	hlist_del_rcu(&tp_vars->list);
+	spin_unlock_bh(&tp_vars->bat_priv->tp_list_lock);
+
+	/* drop list reference */
+	batadv_tp_vars_put(tp_vars);
+
+	/* a reverse stream which never delivered anything did not reach us */
+	tp_vars->reason = BATADV_TP_REASON_COMPLETE;
+	if (tp_vars->last_recv == BATADV_TP_FIRST_SEQ)
+		tp_vars->reason = BATADV_TP_REASON_DST_UNREACHABLE;
+
+	test_time = jiffies_to_msecs(tp_vars->last_recv_time -
+				     tp_vars->start_time);
+	batadv_tp_stream_done(tp_vars,
+			      (u32)(tp_vars->last_recv - BATADV_TP_FIRST_SEQ),
+			      test_time);
+
+	/* drop reference of timer */
+	batadv_tp_vars_put(tp_vars);
+
+	/* the stream no longer touches bat_priv, see batadv_tp_meter_free() */
+	atomic_dec(&bat_priv->tp_num);
+}
+
+/**
+ * batadv_tp_receiver_init - initialize the receiver side of a tp meter stream
+ * @bat_priv: the bat priv with all the soft interface information
+ * @tp_vars: the private data of the stream to initialize
+ * @src: the sender MAC address
+ * @session: TP session identifier of the stream
+ *
+ * The stream is added to the tp_list, therefore bat_priv->tp_list_lock has to
+ * be held by the caller.
+ */
+static void batadv_tp_receiver_init(struct batadv_priv *bat_priv,
+				    struct batadv_tp_vars *tp_vars,
+				    const u8 *src, const u8 *session)
+{
+	ether_addr_copy(tp_vars->other_end, src);
+	tp_vars->role = BATADV_TP_RECEIVER;
+	atomic_set(&tp_vars->sending, 0);
+	memcpy(tp_vars->session, session, sizeof(tp_vars->session));
+	tp_vars->last_recv = BATADV_TP_FIRST_SEQ;
+	tp_vars->bat_priv = bat_priv;
+	tp_vars->start_time = jiffies;
+	tp_vars->last_recv_time = jiffies;
+	tp_vars->payload = NULL;
+	kref_init(&tp_vars->refcount);
+
+	spin_lock_init(&tp_vars->reorder_lock);
+	bitmap_zero(tp_vars->reorder, BATADV_TP_REORDER_WIN);
+
+	kref_get(&tp_vars->refcount);
+	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
+
+	kref_get(&tp_vars->refcount);
+	setup_timer(&tp_vars->timer, batadv_tp_receiver_shutdown,
+		    (unsigned long)tp_vars);
+
+	batadv_tp_reset_receiver_timer(tp_vars);
+}
+
+/**
+ * batadv_tp_send_reverse - ask the remote node to start or stop the streams
+ *  sent back to us
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst: the mac address of the destination originator
+ * @subtype: BATADV_TP_REVERSE_REQ or BATADV_TP_REVERSE_CANCEL
+ * @session: TP session identifier of the first requested stream
+ * @uid: local ICMP "socket" index
+ * @test_length: requested test length in milliseconds
+ * @num_streams: number of requested streams
+ * @cc: congestion control of the requested streams
+ * @rate: constant bitrate (kbit/s) of the requested streams, 0 if none
+ *
+ * Return: 0 on success, a positive integer representing the reason of the
+ * failure otherwise
+ */
+static int batadv_tp_send_reverse(struct batadv_priv *bat_priv, const u8 *dst,
+				  u8 subtype, const u8 *session, u8 uid,
+				  u32 test_length, u8 num_streams, u8 cc,
+				  u32 rate)
+{
+	struct batadv_hard_iface *primary_if = NULL;
+	struct batadv_icmp_tp_req_packet *icmp;
+	struct batadv_orig_node *orig_node;
+	struct sk_buff *skb;
+	int r, ret;
+
+	orig_node = batadv_orig_hash_find(bat_priv, dst);
+	if (unlikely(!orig_node)) {
+		ret = BATADV_TP_REASON_DST_UNREACHABLE;
+		goto out;
+	}
+
+	primary_if = batadv_primary_if_get_selected(bat_priv);
+	if (unlikely(!primary_if)) {
+		ret = BATADV_TP_REASON_DST_UNREACHABLE;
+		goto out;
+	}
+
+	skb = netdev_alloc_skb_ip_align(NULL, sizeof(*icmp) + ETH_HLEN);
+	if (unlikely(!skb)) {
+		ret = BATADV_TP_REASON_MEMORY_ERROR;
+		goto out;
+	}
+
+	skb_reserve(skb, ETH_HLEN);
+	icmp = (struct batadv_icmp_tp_req_packet *)skb_put(skb, sizeof(*icmp));
+	memset(icmp, 0, sizeof(*icmp));
+	icmp->packet_type = BATADV_ICMP;
+	icmp->version = BATADV_COMPAT_VERSION;
+	icmp->ttl = BATADV_TTL;
+	icmp->msg_type = BATADV_TP;
+	ether_addr_copy(icmp->dst, orig_node->orig);
+	ether_addr_copy(icmp->orig, primary_if->net_dev->dev_addr);
+	icmp->uid = uid;
+
+	icmp->subtype = subtype;
+	memcpy(icmp->session, session, sizeof(icmp->session));
+	icmp->test_length = htonl(test_length);
+	icmp->num_streams = num_streams;
+	icmp->cc = cc;
+	icmp->rate = htonl(rate);
+
+	r = batadv_send_skb_to_orig(skb, orig_node, NULL);
+	if (unlikely(r < 0) || (r == NET_XMIT_DROP)) {
+		ret = BATADV_TP_REASON_DST_UNREACHABLE;
+		goto out;
+	}
+	ret = 0;
+
+out:
+	if (likely(orig_node))
+		batadv_orig_node_put(orig_node);
+	if (likely(primary_if))
+		batadv_hardif_put(primary_if);
+
+	return ret;
+}
+
+/**
+ * batadv_tp_session_start - set up and start all streams of a tp meter session
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst: the remote MAC address
+ * @session: TP session identifier of the first stream
+ * @icmp_uid: icmp pseudo uid of the session
+ * @test_length: test length in milliseconds
+ * @num_streams: number of streams sent towards @dst
+ * @num_reverse: number of streams expected back from @dst
+ * @cc: congestion control of the streams sent towards @dst
+ * @rate: constant bitrate (kbit/s) of all streams sent towards @dst together,
+ *  0 if they are only window limited
+ * @requested: true if the session was requested by @dst
+ *
+ * Every stream has its own congestion window, sender thread and session
+ * identifier (consecutive, starting at @session), so that the remote node
+ * handles each of them as an independent session. Streams expected back from
+ * @dst get their receiver state set up immediately so that their results can
+ * be reported together with the others.
+ *
+ * Return: 0 on success, the batadv_tp_meter_reason of the failure otherwise
+ */
+static int batadv_tp_session_start(struct batadv_priv *bat_priv, const u8 *dst,
+				   const u8 *session, u8 icmp_uid,
+				   u32 test_length, u8 num_streams,
+				   u8 num_reverse, u8 cc, u32 rate,
+				   bool requested)
+{
+	struct batadv_tp_vars *streams[2 * BATADV_TP_MAX_STREAMS] = { NULL };
+	u8 num_total = num_streams + num_reverse;
+	struct batadv_tp_group *group;
+	struct batadv_tp_vars *tp_vars;
+	u32 stream_rate;
+	u8 session_id[2];
+	int ret;
+	u8 i;
+
+	if (!test_length)
+		test_length = BATADV_TP_DEF_TEST_LENGTH;
+
+	/* kbit/s shared by all streams to bytes/sec per stream */
+	stream_rate = min_t(u64, div_u64((u64)rate * 125, num_streams),
+			    U32_MAX);
+
+	group = kzalloc(sizeof(*group) + num_total * sizeof(group->results[0]),
+			GFP_KERNEL);
+	if (!group)
+		goto err_alloc;
+
+	for (i = 0; i < num_total; i++) {
+		streams[i] = kmalloc(sizeof(*streams[i]), GFP_KERNEL);
+		if (!streams[i])
+			goto err_alloc;
+
+		streams[i]->payload = NULL;
+		if (i >= num_streams)
+			continue;
+
+		streams[i]->payload = batadv_tp_payload_alloc();
+		if (!streams[i]->payload)
+			goto err_alloc;
+	}
+
+	group->bat_priv = bat_priv;
+	ether_addr_copy(group->other_end, dst);
+	group->cookie = batadv_tp_session_cookie(session, icmp_uid);
+	group->requested = requested;
+	group->num_streams = num_total;
+	atomic_set(&group->pending, num_total);
+	INIT_HLIST_NODE(&group->list);
+	INIT_WORK(&group->notify_work, batadv_tp_group_notify);
+	kref_init(&group->refcount);
+
+	for (i = num_streams; i < num_total; i++)
+		group->results[i].reverse = true;
+
+	/* look for an already existing test towards this node. Streams sent
+	 * back on request of the remote node only have to be unique
+	 */
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	if (requested)
+		tp_vars = batadv_tp_list_find_session(bat_priv, dst, session);
+	else
+		tp_vars = batadv_tp_list_find(bat_priv, dst);
+
+	if (tp_vars) {
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+		batadv_tp_vars_put(tp_vars);
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: test to or from the same node already ongoing, aborting\n");
+		ret = BATADV_TP_REASON_ALREADY_ONGOING;
+		goto err_free;
+	}
+
+	/* every stream creator holds tp_list_lock, therefore all the streams of
+	 * this session can be reserved at once
+	 */
+	if (atomic_read(&bat_priv->tp_num) + num_total > BATADV_TP_MAX_NUM) {
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: too many ongoing sessions, aborting (SEND)\n");
+		ret = BATADV_TP_REASON_TOO_MANY;
+		goto err_free;
+	}
+	atomic_add(num_total, &bat_priv->tp_num);
+
+	for (i = 0; i < num_total; i++) {
+		tp_vars = streams[i];
+		tp_vars->group = group;
+		tp_vars->stream = i;
+		kref_get(&group->refcount);
+
+		batadv_tp_session_id(session, i, session_id);
+		if (i < num_streams)
+			batadv_tp_sender_init(bat_priv, tp_vars, dst,
+					      session_id, icmp_uid,
+					      test_length, cc, stream_rate);
+		else
+			batadv_tp_receiver_init(bat_priv, tp_vars, dst,
+						session_id);
+	}
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+
+	/* start tp kthreads. This way the write() call issued from userspace
+	 * can happily return and avoid to block
+	 */
+	for (i = 0; i < num_total; i++) {
+		if (i < num_streams)
+			batadv_tp_start_kthread(streams[i]);
+
+		/* don't keep reference to new tp_vars */
+		batadv_tp_vars_put(streams[i]);
+	}
+
+	batadv_tp_group_put(group);
+
+	return 0;
+
+err_alloc:
+	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+		   "Meter: %s cannot allocate list elements\n", __func__);
+	ret = BATADV_TP_REASON_MEMORY_ERROR;
+err_free:
+	for (i = 0; i < num_total; i++) {
+		if (!streams[i])
+			continue;
+
+		if (streams[i]->payload)
+			put_page(streams[i]->payload);
+		kfree(streams[i]);
+	}
+	kfree(group);
 
-	spin_lock_init(&tp_vars->unacked_lock);
-	INIT_LIST_HEAD(&tp_vars->unacked_list);
+	return ret;
+}
 
-	spin_lock_init(&tp_vars->cwnd_lock);
+/**
+ * batadv_tp_start - start a new tp meter session
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst: the receiver MAC address
+ * @test_length: test length in milliseconds
+ * @num_streams: number of parallel streams
+ * @bidirectional: whether @dst has to send the same streams back to us
+ * @cc: congestion control of the session (see batadv_tp_meter_cc)
+ * @rate: constant bitrate (kbit/s) of each direction, 0 if window limited
+ * @cookie: session cookie
+ */
+void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
+		     u32 test_length, u8 num_streams, bool bidirectional,
+		     u8 cc, u32 rate, u32 *cookie)
+{
+	u8 reverse_id[2];
+	u8 session_id[2];
+	u8 num_reverse;
+	u8 icmp_uid;
+	u32 session_cookie;
+	int ret;
 
-	tp_vars->prerandom_offset = 0;
-	spin_lock_init(&tp_vars->prerandom_lock);
+	get_random_bytes(session_id, sizeof(session_id));
+	get_random_bytes(&icmp_uid, 1);
+	session_cookie = batadv_tp_session_cookie(session_id, icmp_uid);
+	*cookie = session_cookie;
 
-	kref_get(&tp_vars->refcount);
-	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
-	spin_unlock_bh(&bat_priv->tp_list_lock);
+	num_streams = clamp_t(u8, num_streams, 1, BATADV_TP_MAX_STREAMS);
+	num_reverse = bidirectional ? num_streams : 0;
 
-	tp_vars->test_length = test_length;
-	if (!tp_vars->test_length)
-		tp_vars->test_length = BATADV_TP_DEF_TEST_LENGTH;
+	if (cc >= NUM_BATADV_TP_CC)
+		cc = BATADV_TP_CC_RENO;
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-		   "Meter: starting throughput meter towards %pM (length=%ums)\n",
-		   dst, test_length);
+		   "Meter: starting throughput meter towards %pM (length=%ums, streams=%u, bidirectional=%d, cc=%s, rate=%ukbit/s)\n",
+		   dst, test_length, num_streams, bidirectional,
+		   batadv_tp_cc[cc].name, rate);
+
+	ret = batadv_tp_session_start(bat_priv, dst, session_id, icmp_uid,
+				      test_length, num_streams, num_reverse,
+				      cc, rate, false);
+	if (ret) {
+		batadv_tp_batctl_error_notify(ret, dst, bat_priv,
+					      session_cookie);
+		return;
+	}
 
-	/* init work item for finished tp tests */
-	INIT_DELAYED_WORK(&tp_vars->finish_work, batadv_tp_sender_finish);
+	if (!bidirectional)
+		return;
 
-	/* start tp kthread. This way the write() call issued from userspace can
-	 * happily return and avoid to block
+	/* the reverse streams use the session identifiers following the ones
+	 * of the forward streams. If the request gets lost, the receivers set
+	 * up for them time out and report the destination as unreachable
 	 */
-	batadv_tp_start_kthread(tp_vars);
-
-	/* don't return reference to new tp_vars */
-	batadv_tp_vars_put(tp_vars);
+	batadv_tp_session_id(session_id, num_streams, reverse_id);
+	batadv_tp_send_reverse(bat_priv, dst, BATADV_TP_REVERSE_REQ,
+			       reverse_id, icmp_uid, test_length,
+			       num_reverse, cc, rate);
 }
 
 /**
@@ -1064,12 +2203,18 @@ void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
  * @bat_priv: the bat priv with all the soft interface information
  * @dst: the receiver MAC address
  * @return_value: reason for tp meter session stop
+ *
+ * All the streams sent towards @dst are stopped. If @dst is sending streams
+ * back on our request, it is asked to stop them as well.
  */
 void batadv_tp_stop(struct batadv_priv *bat_priv, const u8 *dst,
 		    u8 return_value)
 {
 	struct batadv_orig_node *orig_node;
 	struct batadv_tp_vars *tp_vars;
+	bool cancel_reverse = false;
+	u8 session[2] = { 0 };
+	bool found = false;
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 		   "Meter: stopping test towards %pM\n", dst);
@@ -1078,74 +2223,32 @@ void batadv_tp_stop(struct batadv_priv *bat_priv, const u8 *dst,
 	if (!orig_node)
 		return;
 
-	tp_vars = batadv_tp_list_find(bat_priv, orig_node->orig);
-	if (!tp_vars) {
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: trying to interrupt an already over connection\n");
-		goto out;
-	}
-
-	batadv_tp_sender_shutdown(tp_vars, return_value);
-	batadv_tp_vars_put(tp_vars);
-out:
-	batadv_orig_node_put(orig_node);
-}
-
-/**
- * batadv_tp_reset_receiver_timer - reset the receiver shutdown timer
- * @tp_vars: the private data of the current TP meter session
- *
- * start the receiver shutdown timer or reset it if already started
- */
-static void batadv_tp_reset_receiver_timer(struct batadv_tp_vars *tp_vars)
-{
-	mod_timer(&tp_vars->timer,
-		  jiffies + msecs_to_jiffies(BATADV_TP_RECV_TIMEOUT));
-}
-
-/**
- * batadv_tp_receiver_shutdown - stop a tp meter receiver when timeout is
- *  reached without received ack
- * @arg: address of the related tp_vars
- */
-static void batadv_tp_receiver_shutdown(unsigned long arg)
-{
-	struct batadv_tp_vars *tp_vars = (struct batadv_tp_vars *)arg;
-	struct batadv_tp_unacked *un, *safe;
-	struct batadv_priv *bat_priv;
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(tp_vars, &bat_priv->tp_list, list) {
+		if (!batadv_compare_eth(tp_vars->other_end, orig_node->orig))
+			continue;
 
-	bat_priv = tp_vars->bat_priv;
+		found = true;
 
-	/* if there is recent activity rearm the timer */
-	if (!batadv_has_timed_out(tp_vars->last_recv_time,
-				  BATADV_TP_RECV_TIMEOUT)) {
-		/* reset the receiver shutdown timer */
-		batadv_tp_reset_receiver_timer(tp_vars);
-		return;
+		if (tp_vars->role == BATADV_TP_SENDER) {
+			batadv_tp_sender_shutdown(tp_vars, return_value);
+		} else if (tp_vars->group) {
+			memcpy(session, tp_vars->session, sizeof(session));
+			cancel_reverse = true;
+		}
 	}
+	rcu_read_unlock();
 
-	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-		   "Shutting down for inactivity (more than %dms) from %pM\n",
-		   BATADV_TP_RECV_TIMEOUT, tp_vars->other_end);
-
-	spin_lock_bh(&tp_vars->bat_priv->tp_list_lock);
-	hlist_del_rcu(&tp_vars->list);
-	spin_unlock_bh(&tp_vars->bat_priv->tp_list_lock);
-
-	/* drop list reference */
-	batadv_tp_vars_put(tp_vars);
-
-	atomic_dec(&bat_priv->tp_num);
+	if (!found)
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: trying to interrupt an already over connection\n");
 
-	spin_lock_bh(&tp_vars->unacked_lock);
-	list_for_each_entry_safe(un, safe, &tp_vars->unacked_list, list) {
-		list_del(&un->list);
-		kfree(un);
-	}
-	spin_unlock_bh(&tp_vars->unacked_lock);
+	if (cancel_reverse)
+		batadv_tp_send_reverse(bat_priv, orig_node->orig,
+				       BATADV_TP_REVERSE_CANCEL, session, 0, 0,
+				       0, 0, 0);
 
-	/* drop reference of timer */
-	batadv_tp_vars_put(tp_vars);
+	batadv_orig_node_put(orig_node);
 }
 
 /**
@@ -1156,18 +2259,23 @@ static void batadv_tp_receiver_shutdown(unsigned long arg)
  * @timestamp: the timestamp to echo back in the ACK
  * @session: session identifier
  * @socket_index: local ICMP socket identifier
+ * @sack: SACK blocks to append to the ACK
+ * @num_sack: number of SACK blocks in @sack
  *
  * Return: 0 on success, a positive integer representing the reason of the
  * failure otherwise
  */
 static int batadv_tp_send_ack(struct batadv_priv *bat_priv, const u8 *dst,
 			      u32 seq, __be32 timestamp, const u8 *session,
-			      int socket_index)
+			      int socket_index,
+			      const struct batadv_icmp_tp_sack *sack,
+			      u8 num_sack)
 {
 	struct batadv_hard_iface *primary_if = NULL;
 	struct batadv_orig_node *orig_node;
-	struct batadv_icmp_tp_packet *icmp;
+	struct batadv_icmp_tp_ack_packet *icmp;
 	struct sk_buff *skb;
+	size_t sack_len;
 	int r, ret;
 
 	orig_node = batadv_orig_hash_find(bat_priv, dst);
@@ -1182,14 +2290,16 @@ static int batadv_tp_send_ack(struct batadv_priv *bat_priv, const u8 *dst,
 		goto out;
 	}
 
-	skb = netdev_alloc_skb_ip_align(NULL, sizeof(*icmp) + ETH_HLEN);
+	sack_len = num_sack * sizeof(*sack);
+	skb = netdev_alloc_skb_ip_align(NULL, sizeof(*icmp) + sack_len +
+					ETH_HLEN);
 	if (unlikely(!skb)) {
 		ret = BATADV_TP_REASON_MEMORY_ERROR;
 		goto out;
 	}
 
 	skb_reserve(skb, ETH_HLEN);
-	icmp = (struct batadv_icmp_tp_packet *)skb_put(skb, sizeof(*icmp));
+	icmp = (struct batadv_icmp_tp_ack_packet *)skb_put(skb, sizeof(*icmp));
 	icmp->packet_type = BATADV_ICMP;
 	icmp->version = BATADV_COMPAT_VERSION;
 	icmp->ttl = BATADV_TTL;
@@ -1202,6 +2312,11 @@ static int batadv_tp_send_ack(struct batadv_priv *bat_priv, const u8 *dst,
 	memcpy(icmp->session, session, sizeof(icmp->session));
 	icmp->seqno = htonl(seq);
 	icmp->timestamp = timestamp;
+	icmp->num_sack = num_sack;
+	memset(icmp->reserved, 0, sizeof(icmp->reserved));
+
+	if (sack_len)
+		memcpy(skb_put(skb, sack_len), sack, sack_len);
 
 	/* send the ack */
 	r = batadv_send_skb_to_orig(skb, orig_node, NULL);
@@ -1223,110 +2338,107 @@ out:
 /**
  * batadv_tp_handle_out_of_order - store an out of order packet
  * @tp_vars: the private data of the current TP meter session
- * @skb: the buffer containing the received packet
+ * @seqno: seqno of the received packet
+ * @len: payload length of the received packet
  *
- * Store the out of order packet in the unacked list for late processing. This
- * packets are kept in this list so that they can be ACKed at once as soon as
- * all the previous packets have been received
+ * Mark the out of order packet in the reorder bitmap for late processing. Each
+ * bit represents a full sized segment following last_recv, therefore only
+ * packets aligned to this grid and inside the reorder window can be stored.
+ * Has to be called with reorder_lock held.
  *
  * Return: true if the packed has been successfully processed, false otherwise
  */
 static bool batadv_tp_handle_out_of_order(struct batadv_tp_vars *tp_vars,
-					  const struct sk_buff *skb)
+					  u32 seqno, u32 len)
 {
-	const struct batadv_icmp_tp_packet *icmp;
-	struct batadv_tp_unacked *un, *new;
-	u32 payload_len;
-	bool added = false;
+	u32 offset = seqno - tp_vars->last_recv;
 
-	new = kmalloc(sizeof(*new), GFP_ATOMIC);
-	if (unlikely(!new))
+	if (len != BATADV_TP_PLEN || offset % BATADV_TP_PLEN)
 		return false;
 
-	icmp = (struct batadv_icmp_tp_packet *)skb->data;
-
-	new->seqno = ntohl(icmp->seqno);
-	payload_len = skb->len - sizeof(struct batadv_unicast_packet);
-	new->len = payload_len;
+	offset /= BATADV_TP_PLEN;
+	if (offset >= BATADV_TP_REORDER_WIN)
+		return false;
 
-	spin_lock_bh(&tp_vars->unacked_lock);
-	/* if the list is empty immediately attach this new object */
-	if (list_empty(&tp_vars->unacked_list)) {
-		list_add(&new->list, &tp_vars->unacked_list);
-		goto out;
-	}
+	__set_bit(offset, tp_vars->reorder);
 
-	/* otherwise loop over the list and either drop the packet because this
-	 * is a duplicate or store it at the right position.
-	 *
-	 * The iteration is done in the reverse way because it is likely that
-	 * the last received packet (the one being processed now) has a bigger
-	 * seqno than all the others already stored.
-	 */
-	list_for_each_entry_reverse(un, &tp_vars->unacked_list, list) {
-		/* check for duplicates */
-		if (new->seqno == un->seqno) {
-			if (new->len > un->len)
-				un->len = new->len;
-			kfree(new);
-			added = true;
-			break;
-		}
+	return true;
+}
 
-		/* look for the right position */
-		if (batadv_seq_before(new->seqno, un->seqno))
-			continue;
+/**
+ * batadv_tp_ack_unordered - update number received bytes in current stream
+ *  without gaps
+ * @tp_vars: the private data of the current TP meter session
+ * @len: payload length of the in order packet just received
+ *
+ * Has to be called with reorder_lock held.
+ */
+static void batadv_tp_ack_unordered(struct batadv_tp_vars *tp_vars, u32 len)
+{
+	unsigned long shift;
 
-		/* as soon as an entry having a bigger seqno is found, the new
-		 * one is attached _after_ it. In this way the list is kept in
-		 * ascending order
-		 */
-		list_add_tail(&new->list, &un->list);
-		added = true;
-		break;
+	/* a packet not matching the segment size shifts the grid of the
+	 * reorder window. Forget about the stored packets, they are resent
+	 */
+	if (unlikely(len != BATADV_TP_PLEN)) {
+		tp_vars->last_recv += len;
+		bitmap_zero(tp_vars->reorder, BATADV_TP_REORDER_WIN);
+		return;
 	}
 
-	/* received packet with smallest seqno out of order; add it to front */
-	if (!added)
-		list_add(&new->list, &tp_vars->unacked_list);
-
-out:
-	spin_unlock_bh(&tp_vars->unacked_lock);
+	/* the packet fills the first slot of the window. All the segments
+	 * following it without a gap can be ACKed as well
+	 */
+	__set_bit(0, tp_vars->reorder);
+	shift = find_first_zero_bit(tp_vars->reorder, BATADV_TP_REORDER_WIN);
 
-	return true;
+	tp_vars->last_recv += shift * BATADV_TP_PLEN;
+	bitmap_shift_right(tp_vars->reorder, tp_vars->reorder, shift,
+			   BATADV_TP_REORDER_WIN);
 }
 
 /**
- * batadv_tp_ack_unordered - update number received bytes in current stream
- *  without gaps
+ * batadv_tp_sack_fill - build the SACK blocks of the next ACK
  * @tp_vars: the private data of the current TP meter session
+ * @dup_seqno: seqno of a duplicate packet to report, ignored if @dup_len is 0
+ * @dup_len: payload length of the duplicate packet
+ * @sack: buffer for BATADV_TP_MAX_SACK blocks
+ *
+ * The blocks following the D-SACK are the lowest received ranges above
+ * last_recv, which are the ones preceding the holes the sender has to fill
+ * first. Has to be called with reorder_lock held.
+ *
+ * Return: number of blocks written to @sack
  */
-static void batadv_tp_ack_unordered(struct batadv_tp_vars *tp_vars)
+static u8 batadv_tp_sack_fill(struct batadv_tp_vars *tp_vars, u32 dup_seqno,
+			      u32 dup_len, struct batadv_icmp_tp_sack *sack)
 {
-	struct batadv_tp_unacked *un, *safe;
-	u32 to_ack;
+	unsigned long start, end = 0;
+	u8 num = 0;
 
-	/* go through the unacked packet list and possibly ACK them as
-	 * well
-	 */
-	spin_lock_bh(&tp_vars->unacked_lock);
-	list_for_each_entry_safe(un, safe, &tp_vars->unacked_list, list) {
-		/* the list is ordered, therefore it is possible to stop as soon
-		 * there is a gap between the last acked seqno and the seqno of
-		 * the packet under inspection
-		 */
-		if (batadv_seq_before(tp_vars->last_recv, un->seqno))
-			break;
+	if (dup_len) {
+		sack[num].start = htonl(dup_seqno);
+		sack[num].end = htonl(dup_seqno + dup_len);
+		num++;
+	}
 
-		to_ack = un->seqno + un->len - tp_vars->last_recv;
+	while (num < BATADV_TP_MAX_SACK) {
+		start = find_next_bit(tp_vars->reorder, BATADV_TP_REORDER_WIN,
+				      end);
+		if (start >= BATADV_TP_REORDER_WIN)
+			break;
 
-		if (batadv_seq_before(tp_vars->last_recv, un->seqno + un->len))
-			tp_vars->last_recv += to_ack;
+		end = find_next_zero_bit(tp_vars->reorder,
+					 BATADV_TP_REORDER_WIN, start);
 
-		list_del(&un->list);
-		kfree(un);
+		sack[num].start = htonl(tp_vars->last_recv +
+					start * BATADV_TP_PLEN);
+		sack[num].end = htonl(tp_vars->last_recv +
+				      end * BATADV_TP_PLEN);
+		num++;
 	}
-	spin_unlock_bh(&tp_vars->unacked_lock);
+
+	return num;
 }
 
 /**
@@ -1358,24 +2470,8 @@ batadv_tp_init_recv(struct batadv_priv *bat_priv,
 	if (!tp_vars)
 		goto out_unlock;
 
-	ether_addr_copy(tp_vars->other_end, icmp->orig);
-	tp_vars->role = BATADV_TP_RECEIVER;
-	memcpy(tp_vars->session, icmp->session, sizeof(tp_vars->session));
-	tp_vars->last_recv = BATADV_TP_FIRST_SEQ;
-	tp_vars->bat_priv = bat_priv;
-	kref_init(&tp_vars->refcount);
-
-	spin_lock_init(&tp_vars->unacked_lock);
-	INIT_LIST_HEAD(&tp_vars->unacked_list);
-
-	kref_get(&tp_vars->refcount);
-	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
-
-	kref_get(&tp_vars->refcount);
-	setup_timer(&tp_vars->timer, batadv_tp_receiver_shutdown,
-		    (unsigned long)tp_vars);
-
-	batadv_tp_reset_receiver_timer(tp_vars);
+	tp_vars->group = NULL;
+	batadv_tp_receiver_init(bat_priv, tp_vars, icmp->orig, icmp->session);
 
 out_unlock:
 	spin_unlock_bh(&bat_priv->tp_list_lock);
@@ -1393,10 +2489,12 @@ out_unlock:
 static void batadv_tp_recv_msg(struct batadv_priv *bat_priv,
 			       const struct sk_buff *skb)
 {
+	struct batadv_icmp_tp_sack sack[BATADV_TP_MAX_SACK];
 	const struct batadv_icmp_tp_packet *icmp;
 	struct batadv_tp_vars *tp_vars;
-	size_t packet_size;
-	u32 seqno;
+	u32 seqno, last_recv, packet_size;
+	u32 dup_len = 0;
+	u8 num_sack;
 
 	icmp = (struct batadv_icmp_tp_packet *)skb->data;
 
@@ -1430,44 +2528,192 @@ static void batadv_tp_recv_msg(struct batadv_priv *bat_priv,
 	}
 
 	tp_vars->last_recv_time = jiffies;
+	packet_size = skb->len - sizeof(struct batadv_unicast_packet);
+
+	spin_lock_bh(&tp_vars->reorder_lock);
 
 	/* if the packet is a duplicate, it may be the case that an ACK has been
-	 * lost. Resend the ACK
+	 * lost. Resend the ACK and report the duplicate
 	 */
-	if (batadv_seq_before(seqno, tp_vars->last_recv))
+	if (batadv_seq_before(seqno, tp_vars->last_recv)) {
+		dup_len = packet_size;
 		goto send_ack;
+	}
 
 	/* if the packet is out of order enqueue it */
-	if (ntohl(icmp->seqno) != tp_vars->last_recv) {
+	if (seqno != tp_vars->last_recv) {
 		/* exit immediately (and do not send any ACK) if the packet has
 		 * not been enqueued correctly
 		 */
-		if (!batadv_tp_handle_out_of_order(tp_vars, skb))
+		if (!batadv_tp_handle_out_of_order(tp_vars, seqno,
+						   packet_size)) {
+			spin_unlock_bh(&tp_vars->reorder_lock);
 			goto out;
+		}
 
 		/* send a duplicate ACK */
 		goto send_ack;
 	}
 
-	/* if everything was fine count the ACKed bytes */
-	packet_size = skb->len - sizeof(struct batadv_unicast_packet);
-	tp_vars->last_recv += packet_size;
-
-	/* check if this ordered message filled a gap.... */
-	batadv_tp_ack_unordered(tp_vars);
+	/* count the ACKed bytes and check if this ordered message filled a
+	 * gap....
+	 */
+	batadv_tp_ack_unordered(tp_vars, packet_size);
 
 send_ack:
+	num_sack = batadv_tp_sack_fill(tp_vars, seqno, dup_len, sack);
+	last_recv = tp_vars->last_recv;
+	spin_unlock_bh(&tp_vars->reorder_lock);
+
 	/* send the ACK. If the received packet was out of order, the ACK that
 	 * is going to be sent is a duplicate (the sender will count them and
-	 * possibly enter Fast Retransmit as soon as it has reached 3)
+	 * possibly enter Fast Retransmit as soon as it has reached its
+	 * threshold)
 	 */
-	batadv_tp_send_ack(bat_priv, icmp->orig, tp_vars->last_recv,
-			   icmp->timestamp, icmp->session, icmp->uid);
+	batadv_tp_send_ack(bat_priv, icmp->orig, last_recv, icmp->timestamp,
+			   icmp->session, icmp->uid, sack, num_sack);
 out:
 	if (likely(tp_vars))
 		batadv_tp_vars_put(tp_vars);
 }
 
+/**
+ * batadv_tp_reverse_start - start the streams requested by a remote node
+ * @work: work item of the related batadv_tp_reverse_req
+ */
+static void batadv_tp_reverse_start(struct work_struct *work)
+{
+	struct batadv_tp_reverse_req *req;
+	struct batadv_priv *bat_priv;
+	bool free_req = false;
+	int ret;
+
+	req = container_of(work, struct batadv_tp_reverse_req, work);
+	bat_priv = req->bat_priv;
+
+	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+		   "Meter: starting %u reverse streams towards %pM (length=%ums)\n",
+		   req->num_streams, req->other_end, req->test_length);
+
+	ret = batadv_tp_session_start(bat_priv, req->other_end, req->session,
+				      req->icmp_uid, req->test_length,
+				      req->num_streams, 0, req->cc, req->rate,
+				      true);
+	if (ret)
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: cannot start reverse streams towards %pM (reason=%d)\n",
+			   req->other_end, ret);
+
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	/* batadv_tp_meter_free() already took the request over */
+	if (!hlist_unhashed(&req->list)) {
+		hlist_del_init(&req->list);
+		free_req = true;
+	}
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+
+	if (free_req)
+		kfree(req);
+}
+
+/**
+ * batadv_tp_recv_reverse_req - process a request to send streams back
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the buffer containing the received packet
+ *
+ * The sender threads cannot be created in the receive path, therefore the
+ * streams are started from the event workqueue. Requests are only accepted if
+ * tp_reverse is enabled and only one of them can be pending per originator.
+ */
+static void batadv_tp_recv_reverse_req(struct batadv_priv *bat_priv,
+				       struct sk_buff *skb)
+{
+	const struct batadv_icmp_tp_req_packet *icmp;
+	struct batadv_tp_reverse_req *req, *pos;
+
+	if (!pskb_may_pull(skb, sizeof(*icmp)))
+		return;
+
+	icmp = (struct batadv_icmp_tp_req_packet *)skb->data;
+
+	if (!atomic_read(&bat_priv->tp_reverse)) {
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: ignoring reverse request from %pM (tp_reverse disabled)\n",
+			   icmp->orig);
+		return;
+	}
+
+	if (icmp->num_streams == 0 ||
+	    icmp->num_streams > BATADV_TP_MAX_STREAMS ||
+	    icmp->cc >= NUM_BATADV_TP_CC) {
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: invalid reverse request from %pM (streams=%u, cc=%u)\n",
+			   icmp->orig, icmp->num_streams, icmp->cc);
+		return;
+	}
+
+	req = kmalloc(sizeof(*req), GFP_ATOMIC);
+	if (!req)
+		return;
+
+	INIT_WORK(&req->work, batadv_tp_reverse_start);
+	req->bat_priv = bat_priv;
+	ether_addr_copy(req->other_end, icmp->orig);
+	memcpy(req->session, icmp->session, sizeof(req->session));
+	req->icmp_uid = icmp->uid;
+	req->test_length = min_t(u32, ntohl(icmp->test_length),
+				 BATADV_TP_MAX_REVERSE_LENGTH);
+	req->num_streams = icmp->num_streams;
+	req->cc = icmp->cc;
+	req->rate = ntohl(icmp->rate);
+
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	hlist_for_each_entry(pos, &bat_priv->tp_reverse_list, list) {
+		if (!batadv_compare_eth(pos->other_end, req->other_end))
+			continue;
+
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: reverse request from %pM already pending, ignoring\n",
+			   req->other_end);
+		kfree(req);
+		return;
+	}
+
+	hlist_add_head(&req->list, &bat_priv->tp_reverse_list);
+	queue_work(batadv_event_workqueue, &req->work);
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+}
+
+/**
+ * batadv_tp_recv_reverse_cancel - stop the streams requested by a remote node
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the buffer containing the received packet
+ */
+static void batadv_tp_recv_reverse_cancel(struct batadv_priv *bat_priv,
+					  const struct sk_buff *skb)
+{
+	const struct batadv_icmp_tp_req_packet *icmp;
+	struct batadv_tp_vars *tp_vars;
+
+	icmp = (struct batadv_icmp_tp_req_packet *)skb->data;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(tp_vars, &bat_priv->tp_list, list) {
+		if (!batadv_compare_eth(tp_vars->other_end, icmp->orig))
+			continue;
+
+		if (tp_vars->role != BATADV_TP_SENDER)
+			continue;
+
+		if (!tp_vars->group->requested)
+			continue;
+
+		batadv_tp_sender_shutdown(tp_vars, BATADV_TP_REASON_CANCEL);
+	}
+	rcu_read_unlock();
+}
+
 /**
  * batadv_tp_meter_recv - main TP Meter receiving function
  * @bat_priv: the bat priv with all the soft interface information
@@ -1486,6 +2732,12 @@ void batadv_tp_meter_recv(struct batadv_priv *bat_priv, struct sk_buff *skb)
 	case BATADV_TP_ACK:
 		batadv_tp_recv_ack(bat_priv, skb);
 		break;
+	case BATADV_TP_REVERSE_REQ:
+		batadv_tp_recv_reverse_req(bat_priv, skb);
+		break;
+	case BATADV_TP_REVERSE_CANCEL:
+		batadv_tp_recv_reverse_cancel(bat_priv, skb);
+		break;
 	default:
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Received unknown TP Metric packet type %u\n",
@@ -1494,6 +2746,64 @@ void batadv_tp_meter_recv(struct batadv_priv *bat_priv, struct sk_buff *skb)
 	consume_skb(skb);
 }
 
+/**
+ * batadv_tp_meter_free - stop all tp meter sessions of a mesh interface
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Pending reverse requests are dropped and all senders are stopped. Receivers
+ * shut down after BATADV_TP_RECV_TIMEOUT msecs without traffic. Once all the
+ * streams are gone, the pending result notifications are cancelled.
+ */
+void batadv_tp_meter_free(struct batadv_priv *bat_priv)
+{
+	struct batadv_tp_reverse_req *req;
+	struct batadv_tp_vars *tp_vars;
+	struct batadv_tp_group *group;
+
+	while (true) {
+		spin_lock_bh(&bat_priv->tp_list_lock);
+		req = hlist_entry_safe(bat_priv->tp_reverse_list.first,
+				       struct batadv_tp_reverse_req, list);
+		if (req)
+			hlist_del_init(&req->list);
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+
+		if (!req)
+			break;
+
+		cancel_work_sync(&req->work);
+		kfree(req);
+	}
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(tp_vars, &bat_priv->tp_list, list) {
+		if (tp_vars->role != BATADV_TP_SENDER)
+			continue;
+
+		batadv_tp_sender_shutdown(tp_vars, BATADV_TP_REASON_CANCEL);
+		wake_up(&tp_vars->more_bytes);
+	}
+	rcu_read_unlock();
+
+	while (atomic_read(&bat_priv->tp_num))
+		msleep(BATADV_TP_FREE_WAIT);
+
+	while (true) {
+		spin_lock_bh(&bat_priv->tp_list_lock);
+		group = hlist_entry_safe(bat_priv->tp_notify_list.first,
+					 struct batadv_tp_group, list);
+		if (group)
+			hlist_del_init(&group->list);
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+
+		if (!group)
+			break;
+
+		cancel_work_sync(&group->notify_work);
+		batadv_tp_group_put(group);
+	}
+}
+
 /**
  * batadv_tp_meter_init - initialize global tp_meter structures
  */
@@ -25,8 +25,11 @@
 struct sk_buff;
 
 void batadv_tp_meter_init(void);
+void batadv_tp_meter_free(struct batadv_priv *bat_priv);
 void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
-		     u32 test_length, u32 *cookie);
+		     u32 test_length, u8 num_streams, bool bidirectional,
+		     u8 cc, u32 rate, u32 *cookie);
+u32 batadv_tp_hist_percentile(const u32 *hist, u8 pct);
 void batadv_tp_stop(struct batadv_priv *bat_priv, const u8 *dst,
 		    u8 return_value);
 void batadv_tp_meter_recv(struct batadv_priv *bat_priv, struct sk_buff *skb);
@@ -0,0 +1,274 @@
+/* Copyright (C) 2017  B.A.T.M.A.N. contributors:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_NET_BATMAN_ADV_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _NET_BATMAN_ADV_TRACE_H_
+
+#include "main.h"
+
+#include <linux/compiler.h>
+#include <linux/if_ether.h>
+#include <linux/netdevice.h>
+#include <linux/string.h>
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+
+#include "packet.h"
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM batadv
+
+/* provide dummy functions when tracing is disabled */
+#if !defined(CONFIG_BATMAN_ADV_TRACING)
+
+#undef TRACE_EVENT
+#define TRACE_EVENT(name, proto, ...) \
+	static inline void trace_ ## name(proto) {}
+
+#endif /* CONFIG_BATMAN_ADV_TRACING */
+
+TRACE_EVENT(batadv_v_ogm_process_start,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 struct batadv_hard_iface *if_incoming, const u8 *neigh_addr,
+		 const struct batadv_ogm2_packet *ogm_packet),
+
+	TP_ARGS(bat_priv, if_incoming, neigh_addr, ogm_packet),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__string(hard_iface, if_incoming->net_dev->name)
+		__array(u8, orig, ETH_ALEN)
+		__array(u8, neigh, ETH_ALEN)
+		__field(u32, seqno)
+		__field(u32, throughput)
+		__field(u8, ttl)
+		__field(u16, tvlv_len)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		__assign_str(hard_iface, if_incoming->net_dev->name);
+		memcpy(__entry->orig, ogm_packet->orig, ETH_ALEN);
+		memcpy(__entry->neigh, neigh_addr, ETH_ALEN);
+		__entry->seqno = ntohl(ogm_packet->seqno);
+		__entry->throughput = ntohl(ogm_packet->throughput);
+		__entry->ttl = ogm_packet->ttl;
+		__entry->tvlv_len = ntohs(ogm_packet->tvlv_len);
+	),
+
+	TP_printk("%s: orig %pM seqno %u via %pM on %s throughput %u ttl %u tvlv_len %u",
+		  __get_str(mesh), __entry->orig, __entry->seqno,
+		  __entry->neigh, __get_str(hard_iface), __entry->throughput,
+		  __entry->ttl, __entry->tvlv_len)
+);
+
+TRACE_EVENT(batadv_v_ogm_verify,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 const struct batadv_ogm2_packet *ogm_packet, bool valid),
+
+	TP_ARGS(bat_priv, ogm_packet, valid),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__array(u8, orig, ETH_ALEN)
+		__field(u32, seqno)
+		__field(bool, valid)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		memcpy(__entry->orig, ogm_packet->orig, ETH_ALEN);
+		__entry->seqno = ntohl(ogm_packet->seqno);
+		__entry->valid = valid;
+	),
+
+	TP_printk("%s: orig %pM seqno %u signature %s",
+		  __get_str(mesh), __entry->orig, __entry->seqno,
+		  __entry->valid ? "valid" : "invalid")
+);
+
+TRACE_EVENT(batadv_v_ogm_process_end,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 const struct batadv_ogm2_packet *ogm_packet, bool accepted),
+
+	TP_ARGS(bat_priv, ogm_packet, accepted),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__array(u8, orig, ETH_ALEN)
+		__field(u32, seqno)
+		__field(bool, accepted)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		memcpy(__entry->orig, ogm_packet->orig, ETH_ALEN);
+		__entry->seqno = ntohl(ogm_packet->seqno);
+		__entry->accepted = accepted;
+	),
+
+	TP_printk("%s: orig %pM seqno %u %s",
+		  __get_str(mesh), __entry->orig, __entry->seqno,
+		  __entry->accepted ? "accepted" : "dropped")
+);
+
+TRACE_EVENT(batadv_route_update,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 struct batadv_orig_node *orig_node,
+		 struct batadv_hard_iface *recv_if,
+		 struct batadv_neigh_node *old_router,
+		 struct batadv_neigh_node *new_router),
+
+	TP_ARGS(bat_priv, orig_node, recv_if, old_router, new_router),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__string(outif, recv_if ? recv_if->net_dev->name : "default")
+		__array(u8, orig, ETH_ALEN)
+		__array(u8, old_router, ETH_ALEN)
+		__array(u8, new_router, ETH_ALEN)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		__assign_str(outif,
+			     recv_if ? recv_if->net_dev->name : "default");
+		memcpy(__entry->orig, orig_node->orig, ETH_ALEN);
+		if (old_router)
+			memcpy(__entry->old_router, old_router->addr, ETH_ALEN);
+		else
+			memset(__entry->old_router, 0, ETH_ALEN);
+		if (new_router)
+			memcpy(__entry->new_router, new_router->addr, ETH_ALEN);
+		else
+			memset(__entry->new_router, 0, ETH_ALEN);
+	),
+
+	TP_printk("%s: orig %pM outif %s router %pM -> %pM",
+		  __get_str(mesh), __entry->orig, __get_str(outif),
+		  __entry->old_router, __entry->new_router)
+);
+
+TRACE_EVENT(batadv_tt_global_add,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 struct batadv_orig_node *orig_node,
+		 const unsigned char *tt_addr, unsigned short vid, u16 flags,
+		 u8 ttvn, bool added),
+
+	TP_ARGS(bat_priv, orig_node, tt_addr, vid, flags, ttvn, added),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__array(u8, client, ETH_ALEN)
+		__array(u8, orig, ETH_ALEN)
+		__field(int, vid)
+		__field(u16, flags)
+		__field(u8, ttvn)
+		__field(bool, added)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		memcpy(__entry->client, tt_addr, ETH_ALEN);
+		memcpy(__entry->orig, orig_node->orig, ETH_ALEN);
+		__entry->vid = batadv_print_vid(vid);
+		__entry->flags = flags;
+		__entry->ttvn = ttvn;
+		__entry->added = added;
+	),
+
+	TP_printk("%s: client %pM vid %d via %pM flags %#.4x ttvn %u %s",
+		  __get_str(mesh), __entry->client, __entry->vid,
+		  __entry->orig, __entry->flags, __entry->ttvn,
+		  __entry->added ? "added" : "ignored")
+);
+
+TRACE_EVENT(batadv_frag_merge,
+
+	TP_PROTO(const u8 *orig, u16 seqno, u16 total_size, u8 num_frags,
+		 bool merged),
+
+	TP_ARGS(orig, seqno, total_size, num_frags, merged),
+
+	TP_STRUCT__entry(
+		__array(u8, orig, ETH_ALEN)
+		__field(u16, seqno)
+		__field(u16, total_size)
+		__field(u8, num_frags)
+		__field(bool, merged)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->orig, orig, ETH_ALEN);
+		__entry->seqno = seqno;
+		__entry->total_size = total_size;
+		__entry->num_frags = num_frags;
+		__entry->merged = merged;
+	),
+
+	TP_printk("orig %pM seqno %u total_size %u fragments %u %s",
+		  __entry->orig, __entry->seqno, __entry->total_size,
+		  __entry->num_frags, __entry->merged ? "merged" : "dropped")
+);
+
+TRACE_EVENT(batadv_nc_code,
+
+	TP_PROTO(struct batadv_priv *bat_priv,
+		 const struct batadv_coded_packet *coded_packet,
+		 const u8 *first_dest, unsigned int hold_time),
+
+	TP_ARGS(bat_priv, coded_packet, first_dest, hold_time),
+
+	TP_STRUCT__entry(
+		__string(mesh, bat_priv->soft_iface->name)
+		__array(u8, first_dest, ETH_ALEN)
+		__array(u8, second_dest, ETH_ALEN)
+		__field(u32, first_crc)
+		__field(u32, second_crc)
+		__field(u16, coded_len)
+		__field(unsigned int, hold_time)
+	),
+
+	TP_fast_assign(
+		__assign_str(mesh, bat_priv->soft_iface->name);
+		memcpy(__entry->first_dest, first_dest, ETH_ALEN);
+		memcpy(__entry->second_dest, coded_packet->second_dest,
+		       ETH_ALEN);
+		__entry->first_crc = ntohl(coded_packet->first_crc);
+		__entry->second_crc = ntohl(coded_packet->second_crc);
+		__entry->coded_len = ntohs(coded_packet->coded_len);
+		__entry->hold_time = hold_time;
+	),
+
+	TP_printk("%s: coded %#.8x to %pM with %#.8x to %pM len %u held %u ms",
+		  __get_str(mesh), __entry->first_crc, __entry->first_dest,
+		  __entry->second_crc, __entry->second_dest,
+		  __entry->coded_len, __entry->hold_time)
+);
+
+#endif /* _NET_BATMAN_ADV_TRACE_H_ || TRACE_HEADER_MULTI_READ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
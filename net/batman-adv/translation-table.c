@@ -55,11 +55,13 @@
 #include "bridge_loop_avoidance.h"
 #include "hard-interface.h"
 #include "hash.h"
+#include "latency.h"
 #include "log.h"
 #include "netlink.h"
 #include "originator.h"
 #include "packet.h"
 #include "soft-interface.h"
+#include "trace.h"
 #include "tvlv.h"
 
 static struct kmem_cache *batadv_tl_cache __read_mostly;
@@ -203,7 +205,7 @@ batadv_tt_local_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
  * Return: a pointer to the corresponding tt_global_entry struct if the client
  * is found, NULL otherwise.
  */
-static struct batadv_tt_global_entry *
+struct batadv_tt_global_entry *
 batadv_tt_global_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 			   unsigned short vid)
 {
@@ -298,7 +300,7 @@ static void batadv_tt_global_entry_release(struct kref *ref)
  *  possibly release it
  * @tt_global_entry: tt_global_entry to be free'd
  */
-static void
+void
 batadv_tt_global_entry_put(struct batadv_tt_global_entry *tt_global_entry)
 {
 	kref_put(&tt_global_entry->common.refcount,
@@ -610,6 +612,29 @@ static int batadv_tt_local_init(struct batadv_priv *bat_priv)
 	return 0;
 }
 
+/**
+ * batadv_tt_global_notify_del - send a TT_DEL event for a global entry
+ * @bat_priv: the bat priv with all the soft interface information
+ * @tt_global: the global entry which is removed
+ *
+ * One event is sent for every originator still announcing the client.
+ */
+static void
+batadv_tt_global_notify_del(struct batadv_priv *bat_priv,
+			    struct batadv_tt_global_entry *tt_global)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_entry, &tt_global->orig_list, list)
+		batadv_netlink_tt_notify(bat_priv, BATADV_EVENT_TT_DEL,
+					 tt_global->common.addr,
+					 tt_global->common.vid,
+					 orig_entry->orig_node->orig,
+					 tt_global->common.flags);
+	rcu_read_unlock();
+}
+
 static void batadv_tt_global_free(struct batadv_priv *bat_priv,
 				  struct batadv_tt_global_entry *tt_global,
 				  const char *message)
@@ -618,6 +643,7 @@ static void batadv_tt_global_free(struct batadv_priv *bat_priv,
 		   "Deleting global tt entry %pM (vid: %d): %s\n",
 		   tt_global->common.addr,
 		   batadv_print_vid(tt_global->common.vid), message);
+	batadv_tt_global_notify_del(bat_priv, tt_global);
 
 	batadv_hash_remove(bat_priv->tt.global_hash, batadv_compare_tt,
 			   batadv_choose_tt, &tt_global->common);
@@ -1184,6 +1210,7 @@ batadv_tt_local_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
  * @portid: Port making netlink request
  * @seq: Sequence number of netlink message
  * @bat_priv: The bat priv with all the soft interface information
+ * @filter: filter selecting the entries to dump
  * @head: Pointer to the list containing the local tt entries
  * @idx_s: Number of entries to skip
  *
@@ -1192,6 +1219,7 @@ batadv_tt_local_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 static int
 batadv_tt_local_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 			    struct batadv_priv *bat_priv,
+			    const struct batadv_netlink_filter *filter,
 			    struct hlist_head *head, int *idx_s)
 {
 	struct batadv_tt_common_entry *common;
@@ -1202,6 +1230,11 @@ batadv_tt_local_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 		if (idx++ < *idx_s)
 			continue;
 
+		if (!batadv_netlink_filter_vid(filter, common->vid) ||
+		    !batadv_netlink_filter_prefix(filter, common->addr,
+						  ETH_ALEN))
+			continue;
+
 		if (batadv_tt_local_dump_entry(msg, portid, seq, bat_priv,
 					       common)) {
 			rcu_read_unlock();
@@ -1225,6 +1258,7 @@ batadv_tt_local_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 int batadv_tt_local_dump(struct sk_buff *msg, struct netlink_callback *cb)
 {
 	struct net *net = sock_net(cb->skb->sk);
+	struct batadv_netlink_filter filter;
 	struct net_device *soft_iface;
 	struct batadv_priv *bat_priv;
 	struct batadv_hard_iface *primary_if = NULL;
@@ -1240,6 +1274,9 @@ int batadv_tt_local_dump(struct sk_buff *msg, struct netlink_callback *cb)
 	if (!ifindex)
 		return -EINVAL;
 
+	if (batadv_netlink_filter_get(cb->nlh, &filter))
+		return -EINVAL;
+
 	soft_iface = dev_get_by_index(net, ifindex);
 	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
 		ret = -ENODEV;
@@ -1254,13 +1291,21 @@ int batadv_tt_local_dump(struct sk_buff *msg, struct netlink_callback *cb)
 		goto out;
 	}
 
+	/* all local clients are announced by our own primary address */
+	if (!batadv_netlink_filter_orig(&filter,
+					primary_if->net_dev->dev_addr)) {
+		ret = msg->len;
+		goto out;
+	}
+
 	hash = bat_priv->tt.local_hash;
+	cb->seq = batadv_hash_dump_seq(hash);
 
 	while (bucket < hash->size) {
 		head = &hash->table[bucket];
 
 		if (batadv_tt_local_dump_bucket(msg, portid, cb->nlh->nlmsg_seq,
-						bat_priv, head, &idx))
+						bat_priv, &filter, head, &idx))
 			break;
 
 		bucket++;
@@ -1549,11 +1594,21 @@ batadv_tt_global_entry_has_orig(const struct batadv_tt_global_entry *entry,
 	return found;
 }
 
-static void
+/**
+ * batadv_tt_global_orig_entry_add - add or update a global entry orig_entry
+ * @tt_global: the global entry announced by orig_node
+ * @orig_node: the originator announcing the client
+ * @ttvn: the tt version number of the announcement
+ *
+ * Return: true if a new orig_entry has been created, false if an existing one
+ *  has only been refreshed or the allocation failed
+ */
+static bool
 batadv_tt_global_orig_entry_add(struct batadv_tt_global_entry *tt_global,
 				struct batadv_orig_node *orig_node, int ttvn)
 {
 	struct batadv_tt_orig_list_entry *orig_entry;
+	bool added = false;
 
 	orig_entry = batadv_tt_global_orig_entry_find(tt_global, orig_node);
 	if (orig_entry) {
@@ -1580,11 +1635,15 @@ batadv_tt_global_orig_entry_add(struct batadv_tt_global_entry *tt_global,
 	hlist_add_head_rcu(&orig_entry->list,
 			   &tt_global->orig_list);
 	spin_unlock_bh(&tt_global->list_lock);
+	atomic_inc(&orig_node->bat_priv->tt.global_hash->generation);
 	atomic_inc(&tt_global->orig_list_count);
+	added = true;
 
 out:
 	if (orig_entry)
 		batadv_tt_orig_list_entry_put(orig_entry);
+
+	return added;
 }
 
 /**
@@ -1606,14 +1665,14 @@ out:
  *
  * Return: true if the new entry has been added, false otherwise
  */
-static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
-				 struct batadv_orig_node *orig_node,
-				 const unsigned char *tt_addr,
-				 unsigned short vid, u16 flags, u8 ttvn)
+bool batadv_tt_global_add(struct batadv_priv *bat_priv,
+			  struct batadv_orig_node *orig_node,
+			  const unsigned char *tt_addr,
+			  unsigned short vid, u16 flags, u8 ttvn)
 {
 	struct batadv_tt_global_entry *tt_global_entry;
 	struct batadv_tt_local_entry *tt_local_entry;
-	bool ret = false;
+	bool ret = false, notify = false;
 	int hash_added;
 	struct batadv_tt_common_entry *common;
 	u16 local_flags;
@@ -1687,6 +1746,7 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 			if (batadv_tt_global_entry_has_orig(tt_global_entry,
 							    orig_node))
 				goto out_remove;
+			batadv_tt_global_notify_del(bat_priv, tt_global_entry);
 			batadv_tt_global_del_orig_list(tt_global_entry);
 			goto add_orig_entry;
 		}
@@ -1698,6 +1758,7 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 		 * is a non-temporary entry is preferred.
 		 */
 		if (common->flags & BATADV_TT_CLIENT_TEMP) {
+			batadv_tt_global_notify_del(bat_priv, tt_global_entry);
 			batadv_tt_global_del_orig_list(tt_global_entry);
 			common->flags &= ~BATADV_TT_CLIENT_TEMP;
 		}
@@ -1716,6 +1777,7 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 		 * new one.
 		 */
 		if (common->flags & BATADV_TT_CLIENT_ROAM) {
+			batadv_tt_global_notify_del(bat_priv, tt_global_entry);
 			batadv_tt_global_del_orig_list(tt_global_entry);
 			common->flags &= ~BATADV_TT_CLIENT_ROAM;
 			tt_global_entry->roam_at = 0;
@@ -1723,7 +1785,8 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 	}
 add_orig_entry:
 	/* add the new orig_entry (if needed) or update it */
-	batadv_tt_global_orig_entry_add(tt_global_entry, orig_node, ttvn);
+	notify = batadv_tt_global_orig_entry_add(tt_global_entry, orig_node,
+						 ttvn);
 
 	batadv_dbg(BATADV_DBG_TT, bat_priv,
 		   "Creating new global tt entry: %pM (vid: %d, via %pM)\n",
@@ -1751,6 +1814,13 @@ out_remove:
 		tt_global_entry->common.flags &= ~BATADV_TT_CLIENT_ROAM;
 
 out:
+	trace_batadv_tt_global_add(bat_priv, orig_node, tt_addr, vid, flags,
+				   ttvn, ret);
+	/* refreshing a known client is not an event */
+	if (notify)
+		batadv_netlink_tt_notify(bat_priv, BATADV_EVENT_TT_ADD, tt_addr,
+					 vid, orig_node->orig, flags);
+
 	if (tt_global_entry)
 		batadv_tt_global_entry_put(tt_global_entry);
 	if (tt_local_entry)
@@ -1995,6 +2065,7 @@ batadv_tt_global_dump_subentry(struct sk_buff *msg, u32 portid, u32 seq,
  * @portid: Port making netlink request
  * @seq: Sequence number of netlink message
  * @bat_priv: The bat priv with all the soft interface information
+ * @filter: filter selecting the originators to dump
  * @common: tt local & tt global common data
  * @sub_s: Number of entries to skip
  *
@@ -2005,6 +2076,7 @@ batadv_tt_global_dump_subentry(struct sk_buff *msg, u32 portid, u32 seq,
 static int
 batadv_tt_global_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 			    struct batadv_priv *bat_priv,
+			    const struct batadv_netlink_filter *filter,
 			    struct batadv_tt_common_entry *common, int *sub_s)
 {
 	struct batadv_tt_orig_list_entry *orig_entry, *best_entry;
@@ -2021,6 +2093,10 @@ batadv_tt_global_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
 		if (sub++ < *sub_s)
 			continue;
 
+		if (!batadv_netlink_filter_orig(filter,
+						orig_entry->orig_node->orig))
+			continue;
+
 		best = (orig_entry == best_entry);
 
 		if (batadv_tt_global_dump_subentry(msg, portid, seq, common,
@@ -2040,15 +2116,17 @@ batadv_tt_global_dump_entry(struct sk_buff *msg, u32 portid, u32 seq,
  * @portid: Port making netlink request
  * @seq: Sequence number of netlink message
  * @bat_priv: The bat priv with all the soft interface information
+ * @filter: filter selecting the entries to dump
  * @head: Pointer to the list containing the global tt entries
  * @idx_s: Number of entries to skip
  * @sub: Number of entries to skip
  *
  * Return: Error code, or 0 on success
  */
-static int
+int
 batadv_tt_global_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 			     struct batadv_priv *bat_priv,
+			     const struct batadv_netlink_filter *filter,
 			     struct hlist_head *head, int *idx_s, int *sub)
 {
 	struct batadv_tt_common_entry *common;
@@ -2059,8 +2137,13 @@ batadv_tt_global_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 		if (idx++ < *idx_s)
 			continue;
 
+		if (!batadv_netlink_filter_vid(filter, common->vid) ||
+		    !batadv_netlink_filter_prefix(filter, common->addr,
+						  ETH_ALEN))
+			continue;
+
 		if (batadv_tt_global_dump_entry(msg, portid, seq, bat_priv,
-						common, sub)) {
+						filter, common, sub)) {
 			rcu_read_unlock();
 			*idx_s = idx - 1;
 			return -EMSGSIZE;
@@ -2083,6 +2166,7 @@ batadv_tt_global_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
 int batadv_tt_global_dump(struct sk_buff *msg, struct netlink_callback *cb)
 {
 	struct net *net = sock_net(cb->skb->sk);
+	struct batadv_netlink_filter filter;
 	struct net_device *soft_iface;
 	struct batadv_priv *bat_priv;
 	struct batadv_hard_iface *primary_if = NULL;
@@ -2099,6 +2183,9 @@ int batadv_tt_global_dump(struct sk_buff *msg, struct netlink_callback *cb)
 	if (!ifindex)
 		return -EINVAL;
 
+	if (batadv_netlink_filter_get(cb->nlh, &filter))
+		return -EINVAL;
+
 	soft_iface = dev_get_by_index(net, ifindex);
 	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
 		ret = -ENODEV;
@@ -2114,13 +2201,14 @@ int batadv_tt_global_dump(struct sk_buff *msg, struct netlink_callback *cb)
 	}
 
 	hash = bat_priv->tt.global_hash;
+	cb->seq = batadv_hash_dump_seq(hash);
 
 	while (bucket < hash->size) {
 		head = &hash->table[bucket];
 
 		if (batadv_tt_global_dump_bucket(msg, portid,
 						 cb->nlh->nlmsg_seq, bat_priv,
-						 head, &idx, &sub))
+						 &filter, head, &idx, &sub))
 			break;
 
 		bucket++;
@@ -2214,8 +2302,13 @@ batadv_tt_global_del_orig_node(struct batadv_priv *bat_priv,
 				   orig_node->orig,
 				   tt_global_entry->common.addr,
 				   batadv_print_vid(vid), message);
+			batadv_netlink_tt_notify(bat_priv, BATADV_EVENT_TT_DEL,
+						 tt_global_entry->common.addr,
+						 vid, orig_node->orig,
+						 tt_global_entry->common.flags);
 			_batadv_tt_global_del_orig_entry(tt_global_entry,
 							 orig_entry);
+			atomic_inc(&bat_priv->tt.global_hash->generation);
 		}
 	}
 	spin_unlock_bh(&tt_global_entry->list_lock);
@@ -2295,6 +2388,10 @@ static void batadv_tt_global_del(struct batadv_priv *bat_priv,
 		goto out;
 	}
 
+	batadv_netlink_tt_notify(bat_priv, BATADV_EVENT_TT_ROAM, addr, vid,
+				 orig_node->orig,
+				 tt_global_entry->common.flags);
+
 	/* if we are deleting a global entry due to a roam
 	 * event, there are two possibilities:
 	 * 1) the client roamed from node A to node B => if there
@@ -2313,6 +2410,7 @@ static void batadv_tt_global_del(struct batadv_priv *bat_priv,
 						vid);
 	if (local_entry) {
 		/* local entry exists, case 2: client roamed to us. */
+		batadv_tt_global_notify_del(bat_priv, tt_global_entry);
 		batadv_tt_global_del_orig_list(tt_global_entry);
 		batadv_tt_global_free(bat_priv, tt_global_entry, message);
 	} else {
@@ -2379,6 +2477,7 @@ void batadv_tt_global_del_orig(struct batadv_priv *bat_priv,
 					   tt_global->common.addr,
 					   batadv_print_vid(vid), message);
 				hlist_del_rcu(&tt_common_entry->hash_entry);
+				atomic_inc(&hash->generation);
 				batadv_tt_global_entry_put(tt_global);
 			}
 		}
@@ -2409,7 +2508,7 @@ static bool batadv_tt_global_to_purge(struct batadv_tt_global_entry *tt_global,
 	return purge;
 }
 
-static void batadv_tt_global_purge(struct batadv_priv *bat_priv)
+void batadv_tt_global_purge(struct batadv_priv *bat_priv)
 {
 	struct batadv_hashtable *hash = bat_priv->tt.global_hash;
 	struct hlist_head *head;
@@ -2439,8 +2538,10 @@ static void batadv_tt_global_purge(struct batadv_priv *bat_priv)
 				   tt_global->common.addr,
 				   batadv_print_vid(tt_global->common.vid),
 				   msg);
+			batadv_tt_global_notify_del(bat_priv, tt_global);
 
 			hlist_del_rcu(&tt_common->hash_entry);
+			atomic_inc(&hash->generation);
 
 			batadv_tt_global_entry_put(tt_global);
 		}
@@ -2523,6 +2624,7 @@ struct batadv_orig_node *batadv_transtable_search(struct batadv_priv *bat_priv,
 {
 	struct batadv_tt_local_entry *tt_local_entry = NULL;
 	struct batadv_tt_global_entry *tt_global_entry = NULL;
+	u64 start = batadv_latency_start(bat_priv);
 	struct batadv_orig_node *orig_node = NULL;
 	struct batadv_tt_orig_list_entry *best_entry;
 
@@ -2559,6 +2661,8 @@ out:
 	if (tt_local_entry)
 		batadv_tt_local_entry_put(tt_local_entry);
 
+	batadv_latency_end(bat_priv, BATADV_STATS_TT_LOOKUP, start);
+
 	return orig_node;
 }
 
@@ -3779,6 +3883,7 @@ static void batadv_tt_local_purge_pending_clients(struct batadv_priv *bat_priv)
 
 			batadv_tt_local_size_dec(bat_priv, tt_common->vid);
 			hlist_del_rcu(&tt_common->hash_entry);
+			atomic_inc(&hash->generation);
 			tt_local = container_of(tt_common,
 						struct batadv_tt_local_entry,
 						common);
@@ -4260,7 +4365,8 @@ int batadv_tt_init(struct batadv_priv *bat_priv)
 
 	batadv_tvlv_handler_register(bat_priv, batadv_tt_tvlv_ogm_handler_v1,
 				     batadv_tt_tvlv_unicast_handler_v1,
-				     BATADV_TVLV_TT, 1, BATADV_NO_FLAGS);
+				     BATADV_TVLV_TT, 1,
+				     BATADV_TVLV_HANDLER_OGM_REPEAT);
 
 	batadv_tvlv_handler_register(bat_priv, NULL,
 				     batadv_roam_tvlv_unicast_handler_v1,
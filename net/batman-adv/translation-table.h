@@ -22,6 +22,8 @@
 
 #include <linux/types.h>
 
+struct batadv_netlink_filter;
+struct hlist_head;
 struct netlink_callback;
 struct net_device;
 struct seq_file;
@@ -37,11 +39,26 @@ int batadv_tt_local_seq_print_text(struct seq_file *seq, void *offset);
 int batadv_tt_global_seq_print_text(struct seq_file *seq, void *offset);
 int batadv_tt_local_dump(struct sk_buff *msg, struct netlink_callback *cb);
 int batadv_tt_global_dump(struct sk_buff *msg, struct netlink_callback *cb);
+int
+batadv_tt_global_dump_bucket(struct sk_buff *msg, u32 portid, u32 seq,
+			     struct batadv_priv *bat_priv,
+			     const struct batadv_netlink_filter *filter,
+			     struct hlist_head *head, int *idx_s, int *sub);
+bool batadv_tt_global_add(struct batadv_priv *bat_priv,
+			  struct batadv_orig_node *orig_node,
+			  const unsigned char *tt_addr,
+			  unsigned short vid, u16 flags, u8 ttvn);
+void batadv_tt_global_purge(struct batadv_priv *bat_priv);
 void batadv_tt_global_del_orig(struct batadv_priv *bat_priv,
 			       struct batadv_orig_node *orig_node,
 			       s32 match_vid, const char *message);
 int batadv_tt_global_hash_count(struct batadv_priv *bat_priv,
 				const u8 *addr, unsigned short vid);
+struct batadv_tt_global_entry *
+batadv_tt_global_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
+			   unsigned short vid);
+void
+batadv_tt_global_entry_put(struct batadv_tt_global_entry *tt_global_entry);
 struct batadv_orig_node *batadv_transtable_search(struct batadv_priv *bat_priv,
 						  const u8 *src, const u8 *addr,
 						  unsigned short vid);
@@ -18,9 +18,12 @@
 #include "main.h"
 
 #include <linux/byteorder/generic.h>
+#include <linux/compiler.h>
+#include <linux/crc32c.h>
 #include <linux/etherdevice.h>
 #include <linux/fs.h>
 #include <linux/if_ether.h>
+#include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/list.h>
@@ -65,34 +68,47 @@ static void batadv_tvlv_handler_put(struct batadv_tvlv_handler *tvlv_handler)
 }
 
 /**
- * batadv_tvlv_handler_get - retrieve tvlv handler from the tvlv handler list
+ * batadv_tvlv_handler_lookup - look up tvlv handler in the tvlv handler table
  *  based on the provided type and version (both need to match)
  * @bat_priv: the bat priv with all the soft interface information
  * @type: tvlv handler type to look for
  * @version: tvlv handler version to look for
  *
+ * No reference is taken, the returned handler may only be used within the
+ * same RCU read side critical section.
+ *
  * Return: tvlv handler if found or NULL otherwise.
  */
 static struct batadv_tvlv_handler *
-batadv_tvlv_handler_get(struct batadv_priv *bat_priv, u8 type, u8 version)
+batadv_tvlv_handler_lookup(struct batadv_priv *bat_priv, u8 type, u8 version)
 {
-	struct batadv_tvlv_handler *tvlv_handler_tmp, *tvlv_handler = NULL;
+	struct batadv_tvlv_handler *tvlv_handler;
 
-	rcu_read_lock();
-	hlist_for_each_entry_rcu(tvlv_handler_tmp,
-				 &bat_priv->tvlv.handler_list, list) {
-		if (tvlv_handler_tmp->type != type)
-			continue;
+	tvlv_handler = rcu_dereference(bat_priv->tvlv.handler_table[type]);
+	while (tvlv_handler && tvlv_handler->version != version)
+		tvlv_handler = rcu_dereference(tvlv_handler->next);
 
-		if (tvlv_handler_tmp->version != version)
-			continue;
+	return tvlv_handler;
+}
 
-		if (!kref_get_unless_zero(&tvlv_handler_tmp->refcount))
-			continue;
+/**
+ * batadv_tvlv_handler_get - retrieve tvlv handler from the tvlv handler table
+ *  based on the provided type and version (both need to match)
+ * @bat_priv: the bat priv with all the soft interface information
+ * @type: tvlv handler type to look for
+ * @version: tvlv handler version to look for
+ *
+ * Return: tvlv handler if found or NULL otherwise.
+ */
+static struct batadv_tvlv_handler *
+batadv_tvlv_handler_get(struct batadv_priv *bat_priv, u8 type, u8 version)
+{
+	struct batadv_tvlv_handler *tvlv_handler;
 
-		tvlv_handler = tvlv_handler_tmp;
-		break;
-	}
+	rcu_read_lock();
+	tvlv_handler = batadv_tvlv_handler_lookup(bat_priv, type, version);
+	if (tvlv_handler && !kref_get_unless_zero(&tvlv_handler->refcount))
+		tvlv_handler = NULL;
 	rcu_read_unlock();
 
 	return tvlv_handler;
@@ -203,6 +219,32 @@ static void batadv_tvlv_container_remove(struct batadv_priv *bat_priv,
 	batadv_tvlv_container_put(tvlv);
 }
 
+/**
+ * batadv_tvlv_container_changed - mark the serialized container list outdated
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * The serialized list is rebuilt lazily by the next OGM. Once the last
+ * container is gone it is released right away since there might be no further
+ * OGM to do so.
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (tvlv.container_list_lock).
+ */
+static void batadv_tvlv_container_changed(struct batadv_priv *bat_priv)
+{
+	lockdep_assert_held(&bat_priv->tvlv.container_list_lock);
+
+	bat_priv->tvlv.container_dirty = true;
+
+	if (!hlist_empty(&bat_priv->tvlv.container_list))
+		return;
+
+	kfree(bat_priv->tvlv.container_buff);
+	bat_priv->tvlv.container_buff = NULL;
+	bat_priv->tvlv.container_buff_len = 0;
+	bat_priv->tvlv.container_dirty = false;
+}
+
 /**
  * batadv_tvlv_container_unregister - unregister tvlv container based on the
  *  provided type and version (both need to match)
@@ -218,6 +260,8 @@ void batadv_tvlv_container_unregister(struct batadv_priv *bat_priv,
 	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
 	tvlv = batadv_tvlv_container_get(bat_priv, type, version);
 	batadv_tvlv_container_remove(bat_priv, tvlv);
+	if (tvlv)
+		batadv_tvlv_container_changed(bat_priv);
 	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
 }
 
@@ -231,17 +275,32 @@ void batadv_tvlv_container_unregister(struct batadv_priv *bat_priv,
  * @tvlv_value_len: tvlv container content length
  *
  * If a container of the same type and version was already registered the new
- * content is going to replace the old one.
+ * content is going to replace the old one. Registering the same content again
+ * leaves the serialized container list untouched.
  */
 void batadv_tvlv_container_register(struct batadv_priv *bat_priv,
 				    u8 type, u8 version,
 				    void *tvlv_value, u16 tvlv_value_len)
 {
 	struct batadv_tvlv_container *tvlv_old, *tvlv_new;
+	bool unchanged;
 
 	if (!tvlv_value)
 		tvlv_value_len = 0;
 
+	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
+	tvlv_old = batadv_tvlv_container_get(bat_priv, type, version);
+	unchanged = tvlv_old &&
+		    ntohs(tvlv_old->tvlv_hdr.len) == tvlv_value_len &&
+		    (!tvlv_value_len ||
+		     !memcmp(tvlv_old + 1, tvlv_value, tvlv_value_len));
+	if (tvlv_old)
+		batadv_tvlv_container_put(tvlv_old);
+	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+
+	if (unchanged)
+		return;
+
 	tvlv_new = kzalloc(sizeof(*tvlv_new) + tvlv_value_len, GFP_ATOMIC);
 	if (!tvlv_new)
 		return;
@@ -260,6 +319,7 @@ void batadv_tvlv_container_register(struct batadv_priv *bat_priv,
 
 	kref_get(&tvlv_new->refcount);
 	hlist_add_head(&tvlv_new->list, &bat_priv->tvlv.container_list);
+	batadv_tvlv_container_changed(bat_priv);
 	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
 
 	/* don't return reference to new tvlv_container */
@@ -299,6 +359,49 @@ static bool batadv_tvlv_realloc_packet_buff(unsigned char **packet_buff,
 	return true;
 }
 
+/**
+ * batadv_tvlv_container_serialize - rebuild the serialized container list
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * If the new buffer can't be allocated the outdated one is kept and the
+ * rebuild is retried with the next OGM.
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (tvlv.container_list_lock).
+ */
+static void batadv_tvlv_container_serialize(struct batadv_priv *bat_priv)
+{
+	struct batadv_tvlv_container *tvlv;
+	struct batadv_tvlv_hdr *tvlv_hdr;
+	unsigned char *buff;
+	u16 tvlv_value_len;
+	void *tvlv_value;
+
+	lockdep_assert_held(&bat_priv->tvlv.container_list_lock);
+
+	tvlv_value_len = batadv_tvlv_container_list_size(bat_priv);
+	buff = kmalloc(tvlv_value_len, GFP_ATOMIC);
+	if (!buff)
+		return;
+
+	tvlv_value = buff;
+
+	hlist_for_each_entry(tvlv, &bat_priv->tvlv.container_list, list) {
+		tvlv_hdr = tvlv_value;
+		tvlv_hdr->type = tvlv->tvlv_hdr.type;
+		tvlv_hdr->version = tvlv->tvlv_hdr.version;
+		tvlv_hdr->len = tvlv->tvlv_hdr.len;
+		tvlv_value = tvlv_hdr + 1;
+		memcpy(tvlv_value, tvlv + 1, ntohs(tvlv->tvlv_hdr.len));
+		tvlv_value = (u8 *)tvlv_value + ntohs(tvlv->tvlv_hdr.len);
+	}
+
+	kfree(bat_priv->tvlv.container_buff);
+	bat_priv->tvlv.container_buff = buff;
+	bat_priv->tvlv.container_buff_len = tvlv_value_len;
+	bat_priv->tvlv.container_dirty = false;
+}
+
 /**
  * batadv_tvlv_container_ogm_append - append tvlv container content to given
  *  OGM packet buffer
@@ -309,7 +412,9 @@ static bool batadv_tvlv_realloc_packet_buff(unsigned char **packet_buff,
  * @packet_min_len: ogm header size to be preserved for the OGM itself
  *
  * The ogm packet might be enlarged or shrunk depending on the current size
- * and the size of the to-be-appended tvlv containers.
+ * and the size of the to-be-appended tvlv containers. The containers are
+ * copied from the serialized list which is only rebuilt after a container
+ * changed.
  *
  * Return: size of all appended tvlv containers in bytes.
  */
@@ -317,35 +422,33 @@ u16 batadv_tvlv_container_ogm_append(struct batadv_priv *bat_priv,
 				     unsigned char **packet_buff,
 				     int *packet_buff_len, int packet_min_len)
 {
-	struct batadv_tvlv_container *tvlv;
-	struct batadv_tvlv_hdr *tvlv_hdr;
 	u16 tvlv_value_len;
-	void *tvlv_value;
 	bool ret;
 
 	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
-	tvlv_value_len = batadv_tvlv_container_list_size(bat_priv);
-
-	ret = batadv_tvlv_realloc_packet_buff(packet_buff, packet_buff_len,
-					      packet_min_len, tvlv_value_len);
-
-	if (!ret)
-		goto end;
+	if (bat_priv->tvlv.container_dirty)
+		batadv_tvlv_container_serialize(bat_priv);
+
+	tvlv_value_len = bat_priv->tvlv.container_buff_len;
+
+	if (*packet_buff_len != packet_min_len + tvlv_value_len) {
+		ret = batadv_tvlv_realloc_packet_buff(packet_buff,
+						      packet_buff_len,
+						      packet_min_len,
+						      tvlv_value_len);
+
+		/* the buffer still holds the containers of the last OGM */
+		if (!ret) {
+			tvlv_value_len = *packet_buff_len - packet_min_len;
+			goto end;
+		}
+	}
 
 	if (!tvlv_value_len)
 		goto end;
 
-	tvlv_value = (*packet_buff) + packet_min_len;
-
-	hlist_for_each_entry(tvlv, &bat_priv->tvlv.container_list, list) {
-		tvlv_hdr = tvlv_value;
-		tvlv_hdr->type = tvlv->tvlv_hdr.type;
-		tvlv_hdr->version = tvlv->tvlv_hdr.version;
-		tvlv_hdr->len = tvlv->tvlv_hdr.len;
-		tvlv_value = tvlv_hdr + 1;
-		memcpy(tvlv_value, tvlv + 1, ntohs(tvlv->tvlv_hdr.len));
-		tvlv_value = (u8 *)tvlv_value + ntohs(tvlv->tvlv_hdr.len);
-	}
+	memcpy(*packet_buff + packet_min_len, bat_priv->tvlv.container_buff,
+	       tvlv_value_len);
 
 end:
 	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
@@ -406,6 +509,34 @@ static int batadv_tvlv_call_handler(struct batadv_priv *bat_priv,
 	return NET_RX_SUCCESS;
 }
 
+/**
+ * batadv_tvlv_ogm_unchanged - check whether the ogm tvlv containers of an
+ *  originator are the same as the ones processed the last time
+ * @orig_node: orig node emitting the ogm packet
+ * @tvlv_value: tvlv content
+ * @tvlv_value_len: tvlv content length
+ *
+ * Unchanged containers are processed again every BATADV_TVLV_DIGEST_TIMEOUT
+ * nevertheless, giving handlers which failed to apply them another chance.
+ *
+ * Return: true if the handlers already got the very same containers
+ */
+static bool batadv_tvlv_ogm_unchanged(struct batadv_orig_node *orig_node,
+				      void *tvlv_value, u16 tvlv_value_len)
+{
+	unsigned long digest_time = READ_ONCE(orig_node->tvlv_digest_time);
+	u32 digest = crc32c(0, tvlv_value, tvlv_value_len);
+
+	if (digest_time && digest == READ_ONCE(orig_node->tvlv_digest) &&
+	    !batadv_has_timed_out(digest_time, BATADV_TVLV_DIGEST_TIMEOUT))
+		return true;
+
+	WRITE_ONCE(orig_node->tvlv_digest, digest);
+	WRITE_ONCE(orig_node->tvlv_digest_time, jiffies);
+
+	return false;
+}
+
 /**
  * batadv_tvlv_containers_process - parse the given tvlv buffer to call the
  *  appropriate handlers
@@ -417,6 +548,11 @@ static int batadv_tvlv_call_handler(struct batadv_priv *bat_priv,
  * @tvlv_value: tvlv content
  * @tvlv_value_len: tvlv content length
  *
+ * The handlers are called from within an RCU read side critical section which
+ * keeps them alive, hence no reference is taken for the dispatch. If the ogm
+ * tvlv containers did not change since the previous ogm of the originator only
+ * the handlers flagged with BATADV_TVLV_HANDLER_OGM_REPEAT are called.
+ *
  * Return: success when processing an OGM or the return value of all called
  * handler callbacks.
  */
@@ -431,7 +567,13 @@ int batadv_tvlv_containers_process(struct batadv_priv *bat_priv,
 	u16 tvlv_value_cont_len;
 	u8 cifnotfound = BATADV_TVLV_HANDLER_OGM_CIFNOTFND;
 	int ret = NET_RX_SUCCESS;
+	bool unchanged = false;
+
+	if (ogm_source && orig_node)
+		unchanged = batadv_tvlv_ogm_unchanged(orig_node, tvlv_value,
+						      tvlv_value_len);
 
+	rcu_read_lock();
 	while (tvlv_value_len >= sizeof(*tvlv_hdr)) {
 		tvlv_hdr = tvlv_value;
 		tvlv_value_cont_len = ntohs(tvlv_hdr->len);
@@ -441,26 +583,33 @@ int batadv_tvlv_containers_process(struct batadv_priv *bat_priv,
 		if (tvlv_value_cont_len > tvlv_value_len)
 			break;
 
-		tvlv_handler = batadv_tvlv_handler_get(bat_priv,
-						       tvlv_hdr->type,
-						       tvlv_hdr->version);
+		tvlv_handler = batadv_tvlv_handler_lookup(bat_priv,
+							  tvlv_hdr->type,
+							  tvlv_hdr->version);
+		if (unchanged && tvlv_handler &&
+		    !(tvlv_handler->flags & BATADV_TVLV_HANDLER_OGM_REPEAT))
+			tvlv_handler = NULL;
 
 		ret |= batadv_tvlv_call_handler(bat_priv, tvlv_handler,
 						ogm_source, orig_node,
 						src, dst, tvlv_value,
 						tvlv_value_cont_len);
-		if (tvlv_handler)
-			batadv_tvlv_handler_put(tvlv_handler);
 		tvlv_value = (u8 *)tvlv_value + tvlv_value_cont_len;
 		tvlv_value_len -= tvlv_value_cont_len;
 	}
 
-	if (!ogm_source)
+	if (!ogm_source) {
+		rcu_read_unlock();
 		return ret;
+	}
 
-	rcu_read_lock();
 	hlist_for_each_entry_rcu(tvlv_handler,
 				 &bat_priv->tvlv.handler_list, list) {
+		/* the handler was told about the missing container already */
+		if (unchanged &&
+		    !(tvlv_handler->flags & BATADV_TVLV_HANDLER_OGM_REPEAT))
+			continue;
+
 		if ((tvlv_handler->flags & BATADV_TVLV_HANDLER_OGM_CIFNOTFND) &&
 		    !(tvlv_handler->flags & BATADV_TVLV_HANDLER_OGM_CALLED))
 			tvlv_handler->ogm_handler(bat_priv, orig_node,
@@ -526,6 +675,8 @@ void batadv_tvlv_handler_register(struct batadv_priv *bat_priv,
 					      u16 tvlv_value_len),
 				  u8 type, u8 version, u8 flags)
 {
+	spinlock_t *lock = &bat_priv->tvlv.handler_list_lock;
+	struct batadv_tvlv_handler __rcu **slot;
 	struct batadv_tvlv_handler *tvlv_handler;
 
 	tvlv_handler = batadv_tvlv_handler_get(bat_priv, type, version);
@@ -546,10 +697,17 @@ void batadv_tvlv_handler_register(struct batadv_priv *bat_priv,
 	kref_init(&tvlv_handler->refcount);
 	INIT_HLIST_NODE(&tvlv_handler->list);
 
-	spin_lock_bh(&bat_priv->tvlv.handler_list_lock);
+	spin_lock_bh(lock);
 	kref_get(&tvlv_handler->refcount);
 	hlist_add_head_rcu(&tvlv_handler->list, &bat_priv->tvlv.handler_list);
-	spin_unlock_bh(&bat_priv->tvlv.handler_list_lock);
+
+	/* the handler is completely initialized before it gets published */
+	slot = &bat_priv->tvlv.handler_table[type];
+	RCU_INIT_POINTER(tvlv_handler->next,
+			 rcu_dereference_protected(*slot,
+						   lockdep_is_held(lock)));
+	rcu_assign_pointer(*slot, tvlv_handler);
+	spin_unlock_bh(lock);
 
 	/* don't return reference to new tvlv_handler */
 	batadv_tvlv_handler_put(tvlv_handler);
@@ -565,16 +723,32 @@ void batadv_tvlv_handler_register(struct batadv_priv *bat_priv,
 void batadv_tvlv_handler_unregister(struct batadv_priv *bat_priv,
 				    u8 type, u8 version)
 {
-	struct batadv_tvlv_handler *tvlv_handler;
+	spinlock_t *lock = &bat_priv->tvlv.handler_list_lock;
+	struct batadv_tvlv_handler __rcu **slot;
+	struct batadv_tvlv_handler *tvlv_handler, *tmp;
 
 	tvlv_handler = batadv_tvlv_handler_get(bat_priv, type, version);
 	if (!tvlv_handler)
 		return;
 
 	batadv_tvlv_handler_put(tvlv_handler);
-	spin_lock_bh(&bat_priv->tvlv.handler_list_lock);
+	spin_lock_bh(lock);
 	hlist_del_rcu(&tvlv_handler->list);
-	spin_unlock_bh(&bat_priv->tvlv.handler_list_lock);
+
+	/* unlink the handler from the chain of its type */
+	slot = &bat_priv->tvlv.handler_table[type];
+	tmp = rcu_dereference_protected(*slot, lockdep_is_held(lock));
+	while (tmp && tmp != tvlv_handler) {
+		slot = &tmp->next;
+		tmp = rcu_dereference_protected(*slot, lockdep_is_held(lock));
+	}
+
+	if (tmp) {
+		tmp = rcu_dereference_protected(tmp->next,
+						lockdep_is_held(lock));
+		rcu_assign_pointer(*slot, tmp);
+	}
+	spin_unlock_bh(lock);
 	batadv_tvlv_handler_put(tvlv_handler);
 }
 
@@ -27,9 +27,12 @@
 #include <linux/compiler.h>
 #include <linux/if_ether.h>
 #include <linux/kref.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/sched.h> /* for linux/wait.h */
+#include <linux/seqlock.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/wait.h>
@@ -39,6 +42,8 @@
 #include "packet.h"
 #include "ed25519.h"
 
+struct batadv_tp_vars;
+struct page;
 struct seq_file;
 
 #ifdef CONFIG_BATMAN_ADV_DAT
@@ -153,6 +158,8 @@ enum batadv_hard_iface_wifi_flags {
  * @debug_dir: dentry for nc subdir in batman-adv directory in debugfs
  * @neigh_list: list of unique single hop neighbors via this interface
  * @neigh_list_lock: lock protecting neigh_list
+ * @counters: per cpu control plane traffic counters (see
+ *  batadv_hardif_counter)
  */
 struct batadv_hard_iface {
 	struct list_head list;
@@ -174,6 +181,7 @@ struct batadv_hard_iface {
 	struct hlist_head neigh_list;
 	/* neigh_list_lock protects: neigh_list */
 	spinlock_t neigh_list_lock;
+	u64 __percpu *counters;
 };
 
 /**
@@ -209,6 +217,7 @@ struct batadv_orig_ifinfo {
  * @fragment_list: head of list with fragments
  * @lock: lock to protect the list of fragments
  * @timestamp: time (jiffie) of last received fragment
+ * @start_time: arrival of the first fragment (see batadv_latency_start())
  * @seqno: sequence number of the fragments in the list
  * @size: accumulated size of packets in list
  * @total_size: expected size of the assembled packet
@@ -217,6 +226,7 @@ struct batadv_frag_table_entry {
 	struct hlist_head fragment_list;
 	spinlock_t lock; /* protects fragment_list */
 	unsigned long timestamp;
+	u64 start_time;
 	u16 seqno;
 	u16 size;
 	u16 total_size;
@@ -295,6 +305,8 @@ struct batadv_orig_bat_iv {
  * @capabilities: announced capabilities of this originator
  * @capa_initialized: bitfield to remember whether a capability was initialized
  * @last_ttvn: last seen translation table version number
+ * @tvlv_digest: checksum of the ogm tvlv containers processed the last time
+ * @tvlv_digest_time: time (jiffies) @tvlv_digest was recorded, 0 if none
  * @tt_buff: last tt changeset this node received from the orig node
  * @tt_buff_len: length of the last tt changeset this node received from the
  *  orig node
@@ -344,6 +356,8 @@ struct batadv_orig_node {
 	unsigned long capabilities;
 	unsigned long capa_initialized;
 	atomic_t last_ttvn;
+	u32 tvlv_digest;
+	unsigned long tvlv_digest_time;
 	unsigned char *tt_buff;
 	s16 tt_buff_len;
 	spinlock_t tt_buff_lock; /* protects tt_buff & tt_buff_len */
@@ -389,6 +403,22 @@ enum batadv_orig_capabilities {
 	BATADV_ORIG_CAPA_HAS_MCAST,
 };
 
+/**
+ * struct batadv_gw_client - DHCP client bound to a gateway
+ * @addr: MAC address of the DHCP client
+ * @gw_addr: originator address of the gateway serving the client
+ * @lasttime: last time a DHCP request of the client was sent to the gateway
+ * @hash_entry: hlist node for batadv_priv_gw::client_hash
+ * @rcu: struct used for freeing in an RCU-safe manner
+ */
+struct batadv_gw_client {
+	u8 addr[ETH_ALEN];
+	u8 gw_addr[ETH_ALEN];
+	unsigned long lasttime;
+	struct hlist_node hash_entry;
+	struct rcu_head rcu;
+};
+
 /**
  * struct batadv_gw_node - structure for orig nodes announcing gw capabilities
  * @list: list node for batadv_priv_gw::list
@@ -531,15 +561,26 @@ struct batadv_neigh_ifinfo {
 
 /**
  * struct batadv_bcast_duplist_entry - structure for LAN broadcast suppression
- * @orig: mac address of orig node orginating the broadcast
- * @crc: crc32 checksum of broadcast payload
+ * @key: payload fingerprint (upper 32 bits) and hash of the mac address of
+ *  the orig node originating the broadcast (lower 32 bits)
  * @entrytime: time when the broadcast packet was received
  */
 struct batadv_bcast_duplist_entry {
-	u8 orig[ETH_ALEN];
-	__be32 crc;
+	atomic64_t key;
 	unsigned long entrytime;
 };
+
+/**
+ * struct batadv_bcast_duplist - lock-free LAN broadcast duplicate filter
+ * @mask: mask selecting a bucket from a payload fingerprint
+ * @rcu: struct used for freeing in an RCU-safe manner
+ * @entries: slots, grouped into buckets of BATADV_DUPLIST_WAYS entries
+ */
+struct batadv_bcast_duplist {
+	u32 mask;
+	struct rcu_head rcu;
+	struct batadv_bcast_duplist_entry entries[];
+};
 #endif
 
 /**
@@ -567,6 +608,13 @@ struct batadv_bcast_duplist_entry {
  * @BATADV_CNT_TT_RESPONSE_RX: received tt resp traffic packet counter
  * @BATADV_CNT_TT_ROAM_ADV_TX: transmitted tt roam traffic packet counter
  * @BATADV_CNT_TT_ROAM_ADV_RX: received tt roam traffic packet counter
+ * @BATADV_CNT_OGM2_SIGN: counter for signed own OGM2s
+ * @BATADV_CNT_OGM2_VERIFY: counter for signature verifications of received
+ *  OGM2s
+ * @BATADV_CNT_OGM2_VERIFY_FAILED: counter for received OGM2s with an invalid
+ *  signature
+ * @BATADV_CNT_OGM2_KEY_CHANGE: counter for received OGM2s whose public key
+ *  differs from the one first seen for their originator
  * @BATADV_CNT_DAT_GET_TX: transmitted dht GET traffic packet counter
  * @BATADV_CNT_DAT_GET_RX: received dht GET traffic packet counter
  * @BATADV_CNT_DAT_PUT_TX: transmitted dht PUT traffic packet counter
@@ -610,6 +658,12 @@ enum batadv_counters {
 	BATADV_CNT_TT_RESPONSE_RX,
 	BATADV_CNT_TT_ROAM_ADV_TX,
 	BATADV_CNT_TT_ROAM_ADV_RX,
+#ifdef CONFIG_BATMAN_ADV_BATMAN_V
+	BATADV_CNT_OGM2_SIGN,
+	BATADV_CNT_OGM2_VERIFY,
+	BATADV_CNT_OGM2_VERIFY_FAILED,
+	BATADV_CNT_OGM2_KEY_CHANGE,
+#endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 	BATADV_CNT_DAT_GET_TX,
 	BATADV_CNT_DAT_GET_RX,
@@ -682,27 +736,33 @@ struct batadv_priv_tt {
  * struct batadv_priv_bla - per mesh interface bridge loope avoidance data
  * @num_requests: number of bla requests in flight
  * @claim_hash: hash table containing mesh nodes this host has claimed
+ * @claim_hash_seq: sequence counter bumped while the claim hash is resized
+ * @claim_hash_lock: lock excluding claim hash writers (read side) from
+ *  resizing (write side)
+ * @num_claims: number of entries in the claim hash
  * @backbone_hash: hash table containing all detected backbone gateways
  * @loopdetect_addr: MAC address used for own loopdetection frames
  * @loopdetect_lasttime: time when the loopdetection frames were sent
  * @loopdetect_next: how many periods to wait for the next loopdetect process
- * @bcast_duplist: recently received broadcast packets array (for broadcast
+ * @bcast_duplist: recently received broadcast packets table (for broadcast
  *  duplicate suppression)
- * @bcast_duplist_curr: index of last broadcast packet added to bcast_duplist
- * @bcast_duplist_lock: lock protecting bcast_duplist & bcast_duplist_curr
+ * @bcast_duplist_lock: lock serializing replacements of bcast_duplist
  * @claim_dest: local claim data (e.g. claim group)
  * @work: work queue callback item for cleanups & bla announcements
  */
 struct batadv_priv_bla {
 	atomic_t num_requests;
-	struct batadv_hashtable *claim_hash;
+	struct batadv_hashtable __rcu *claim_hash;
+	seqcount_t claim_hash_seq;
+	/* excludes claim hash writers from resizing */
+	rwlock_t claim_hash_lock;
+	atomic_t num_claims;
 	struct batadv_hashtable *backbone_hash;
 	u8 loopdetect_addr[ETH_ALEN];
 	unsigned long loopdetect_lasttime;
 	atomic_t loopdetect_next;
-	struct batadv_bcast_duplist_entry bcast_duplist[BATADV_DUPLIST_SIZE];
-	int bcast_duplist_curr;
-	/* protects bcast_duplist & bcast_duplist_curr */
+	struct batadv_bcast_duplist __rcu *bcast_duplist;
+	/* serializes replacements of bcast_duplist */
 	spinlock_t bcast_duplist_lock;
 	struct batadv_bla_claim_dst claim_dest;
 	struct delayed_work work;
@@ -711,19 +771,39 @@ struct batadv_priv_bla {
 
 #ifdef CONFIG_BATMAN_ADV_DEBUG
 
+/**
+ * struct batadv_log_ring - per-CPU ring of binary debug log records
+ * @buff: record storage (batadv_priv_debug_log::size bytes)
+ * @head: byte position of the next record to write (owning CPU only)
+ * @tail: byte position of the next record to read (reader only)
+ * @dropped: number of records discarded because the ring was full
+ * @dropped_seen: value of @dropped already reported to the reader
+ */
+struct batadv_log_ring {
+	u8 *buff;
+	unsigned long head;
+	unsigned long tail;
+	unsigned long dropped;
+	unsigned long dropped_seen;
+};
+
 /**
  * struct batadv_priv_debug_log - debug logging data
- * @log_buff: buffer holding the logs (ring bufer)
- * @log_start: index of next character to read
- * @log_end: index of next character to write
- * @lock: lock protecting log_buff, log_start & log_end
+ * @rings: per-CPU record rings, written locklessly by their own CPU
+ * @size: size of each ring buffer in bytes (power of 2)
+ * @line: decoded line handed out to the reader
+ * @line_pos: number of bytes of @line already copied to the reader
+ * @line_len: length of the decoded line in @line
+ * @read_lock: lock serializing readers and protecting @line
  * @queue_wait: log reader's wait queue
  */
 struct batadv_priv_debug_log {
-	char log_buff[BATADV_LOG_BUF_LEN];
-	unsigned long log_start;
-	unsigned long log_end;
-	spinlock_t lock; /* protects log_buff, log_start and log_end */
+	struct batadv_log_ring __percpu *rings;
+	unsigned long size;
+	char line[BATADV_LOG_PREFIX_LEN + BATADV_LOG_LINE_LEN];
+	size_t line_pos;
+	size_t line_len;
+	struct mutex read_lock; /* protects line, line_pos and line_len */
 	wait_queue_head_t queue_wait;
 };
 #endif
@@ -738,6 +818,9 @@ struct batadv_priv_debug_log {
  * @bandwidth_down: advertised uplink download bandwidth (if gw_mode server)
  * @bandwidth_up: advertised uplink upload bandwidth (if gw_mode server)
  * @reselect: bool indicating a gateway re-selection is in progress
+ * @client_hash: DHCP clients bound to a gateway (if gw_distribute is enabled)
+ * @client_lock: lock protecting client_hash & num_clients
+ * @num_clients: number of DHCP clients in client_hash
  */
 struct batadv_priv_gw {
 	struct hlist_head gateway_list;
@@ -748,6 +831,9 @@ struct batadv_priv_gw {
 	atomic_t bandwidth_down;
 	atomic_t bandwidth_up;
 	atomic_t reselect;
+	struct hlist_head client_hash[BATADV_GW_CLIENT_HASH_SIZE];
+	spinlock_t client_lock; /* protects client_hash & num_clients */
+	unsigned int num_clients;
 };
 
 /**
@@ -756,12 +842,22 @@ struct batadv_priv_gw {
  * @handler_list: list of the various tvlv content handlers
  * @container_list_lock: protects tvlv container list access
  * @handler_list_lock: protects handler list access
+ * @container_buff: serialized content of the container list as appended to
+ *  the OGMs
+ * @container_buff_len: length of @container_buff
+ * @container_dirty: true if @container_buff doesn't reflect the container list
+ * @handler_table: handlers of handler_list indexed by tvlv type, each chaining
+ *  the handlers of the other versions of this type
  */
 struct batadv_priv_tvlv {
 	struct hlist_head container_list;
 	struct hlist_head handler_list;
-	spinlock_t container_list_lock; /* protects container_list */
+	spinlock_t container_list_lock; /* protects container_list & buff */
 	spinlock_t handler_list_lock; /* protects handler_list */
+	unsigned char *container_buff;
+	u16 container_buff_len;
+	bool container_dirty;
+	struct batadv_tvlv_handler __rcu *handler_table[BATADV_TVLV_TYPE_NUM];
 };
 
 #ifdef CONFIG_BATMAN_ADV_DAT
@@ -793,7 +889,7 @@ struct batadv_mcast_querier_state {
 
 /**
  * struct batadv_priv_mcast - per mesh interface mcast data
- * @mla_list: list of multicast addresses we are currently announcing via TT
+ * @mla_hash: hash of multicast addresses we are currently announcing via TT
  * @want_all_unsnoopables_list: a list of orig_nodes wanting all unsnoopable
  *  multicast traffic
  * @want_all_ipv4_list: a list of orig_nodes wanting all IPv4 multicast traffic
@@ -807,12 +903,15 @@ struct batadv_mcast_querier_state {
  * @num_want_all_unsnoopables: number of nodes wanting unsnoopable IP traffic
  * @num_want_all_ipv4: counter for items in want_all_ipv4_list
  * @num_want_all_ipv6: counter for items in want_all_ipv6_list
+ * @num_no_mc_ptype_capa: number of nodes without the
+ *  BATADV_MCAST_HAVE_MC_PTYPE_CAPA flag
  * @want_lists_lock: lock for protecting modifications to mcast want lists
  *  (traversals are rcu-locked)
  * @work: work queue callback item for multicast TT and TVLV updates
  */
 struct batadv_priv_mcast {
-	struct hlist_head mla_list; /* see __batadv_mcast_mla_update() */
+	/* see __batadv_mcast_mla_update() */
+	struct hlist_head mla_hash[BATADV_MCAST_MLA_HASH_SIZE];
 	struct hlist_head want_all_unsnoopables_list;
 	struct hlist_head want_all_ipv4_list;
 	struct hlist_head want_all_ipv6_list;
@@ -825,6 +924,7 @@ struct batadv_priv_mcast {
 	atomic_t num_want_all_unsnoopables;
 	atomic_t num_want_all_ipv4;
 	atomic_t num_want_all_ipv6;
+	atomic_t num_no_mc_ptype_capa;
 	/* protects want_all_{unsnoopables,ipv4,ipv6}_list */
 	spinlock_t want_lists_lock;
 	struct delayed_work work;
@@ -861,19 +961,13 @@ struct batadv_priv_nc {
 };
 
 /**
- * struct batadv_tp_unacked - unacked packet meta-information
- * @seqno: seqno of the unacked packet
- * @len: length of the packet
- * @list: list node for batadv_tp_vars::unacked_list
- *
- * This struct is supposed to represent a buffer unacked packet. However, since
- * the purpose of the TP meter is to count the traffic only, there is no need to
- * store the entire sk_buff, the starting offset and the length are enough
+ * struct batadv_tp_sack - range selectively acknowledged by the receiver
+ * @start: seqno of the first received byte of the range
+ * @end: seqno following the last received byte of the range
  */
-struct batadv_tp_unacked {
-	u32 seqno;
-	u16 len;
-	struct list_head list;
+struct batadv_tp_sack {
+	u32 start;
+	u32 end;
 };
 
 /**
@@ -887,7 +981,162 @@ enum batadv_tp_meter_role {
 };
 
 /**
- * struct batadv_tp_vars - tp meter private variables per session
+ * struct batadv_tp_latency - RTT statistics of tp meter streams
+ * @rtt_min: smallest RTT sample (usecs)
+ * @rtt_max: biggest RTT sample (usecs)
+ * @rtt_sum: sum of all RTT samples (usecs)
+ * @samples: number of RTT samples
+ * @last_rtt: last RTT sample (usecs)
+ * @jitter: smoothed RTT variation (usecs) as in RFC3550, scaled by 2^4
+ * @rtt_hist: RTT samples, bucket i counts values in [2^i, 2^(i + 1))
+ * @jitter_hist: differences between consecutive RTT samples, same buckets
+ */
+struct batadv_tp_latency {
+	u32 rtt_min;
+	u32 rtt_max;
+	u64 rtt_sum;
+	u32 samples;
+	u32 last_rtt;
+	u32 jitter;
+	u32 rtt_hist[BATADV_TP_HIST_BUCKETS];
+	u32 jitter_hist[BATADV_TP_HIST_BUCKETS];
+};
+
+/**
+ * struct batadv_tp_stream_result - outcome of a single tp meter stream
+ * @bytes: amount of bytes acked (forward) or received (reverse) in order
+ * @test_time: duration of the stream in milliseconds
+ * @reason: reason for the stream stop (see batadv_tp_meter_reason)
+ * @reverse: true if the stream was sent by the remote node
+ * @lat: RTT statistics of a forward stream
+ */
+struct batadv_tp_stream_result {
+	u64 bytes;
+	u32 test_time;
+	u8 reason;
+	bool reverse;
+	struct batadv_tp_latency lat;
+};
+
+/**
+ * struct batadv_tp_group - streams belonging to the same tp meter session
+ * @bat_priv: pointer to the mesh object
+ * @other_end: mac address of remote
+ * @cookie: session cookie reported to the netlink client
+ * @requested: true if the session was started on behalf of the remote node and
+ *  its results are not reported locally
+ * @num_streams: number of entries in @results
+ * @pending: number of streams which did not finish yet
+ * @list: list node for bat_priv::tp_notify_list
+ * @notify_work: work item reporting the results once all streams finished
+ * @refcount: number of contexts where the object is used
+ * @lat: RTT statistics of all forward streams, filled once all finished
+ * @results: per stream results, forward streams first
+ */
+struct batadv_tp_group {
+	struct batadv_priv *bat_priv;
+	u8 other_end[ETH_ALEN];
+	u32 cookie;
+	bool requested;
+	u8 num_streams;
+	atomic_t pending;
+	struct hlist_node list;
+	struct work_struct notify_work;
+	struct kref refcount;
+	struct batadv_tp_latency lat;
+	struct batadv_tp_stream_result results[];
+};
+
+/**
+ * struct batadv_tp_reverse_req - pending request to send streams back
+ * @list: list node for bat_priv::tp_reverse_list
+ * @work: work item starting the requested streams in process context
+ * @bat_priv: pointer to the mesh object
+ * @other_end: mac address of the requester
+ * @session: TP session identifier of the first requested stream
+ * @icmp_uid: ICMP "socket" index of the requester
+ * @test_length: requested test length in milliseconds
+ * @num_streams: number of requested streams
+ * @cc: congestion control of the requested streams
+ * @rate: constant bitrate (kbit/s) of the requested streams, 0 if none
+ */
+struct batadv_tp_reverse_req {
+	struct hlist_node list;
+	struct work_struct work;
+	struct batadv_priv *bat_priv;
+	u8 other_end[ETH_ALEN];
+	u8 session[2];
+	u8 icmp_uid;
+	u32 test_length;
+	u8 num_streams;
+	u8 cc;
+	u32 rate;
+};
+
+/**
+ * struct batadv_tp_cubic - CUBIC congestion control state
+ * @epoch_start: start of the current growth epoch in jiffies, 0 if none
+ * @origin: window size (bytes) at the plateau of the cubic function
+ * @k: time (msecs) needed to grow back to @origin
+ * @w_max: window size (bytes) before the last reduction
+ * @last_max: @w_max before the last reduction, for fast convergence
+ */
+struct batadv_tp_cubic {
+	unsigned long epoch_start;
+	u32 origin;
+	u32 k;
+	u32 w_max;
+	u32 last_max;
+};
+
+/**
+ * struct batadv_tp_bbr - delivery rate based congestion control state
+ * @min_rtt: minimum RTT (usecs) seen in the last BATADV_TP_BBR_MIN_RTT_WIN
+ * @min_rtt_stamp: time (jiffies) @min_rtt was sampled
+ * @bw: max delivery rate (bytes/sec) of the last BATADV_TP_BBR_BW_ROUNDS
+ * @bw_round: round in which @bw was sampled
+ * @full_bw: delivery rate at the last significant increase during startup
+ * @full_bw_cnt: rounds without significant delivery rate increase
+ * @full_bw_reached: true once startup is over
+ * @round: number of rounds (RTTs) since session start
+ * @round_stamp: time (jiffies) the current round started
+ * @round_delivered: bytes delivered when the current round started
+ * @cycle_idx: current phase of the bandwidth probing gain cycle
+ */
+struct batadv_tp_bbr {
+	u32 min_rtt;
+	unsigned long min_rtt_stamp;
+	u64 bw;
+	u32 bw_round;
+	u64 full_bw;
+	u8 full_bw_cnt;
+	bool full_bw_reached;
+	u32 round;
+	unsigned long round_stamp;
+	u64 round_delivered;
+	u8 cycle_idx;
+};
+
+/**
+ * struct batadv_tp_cc_ops - tp meter congestion control
+ * @name: name of the congestion control
+ * @init: initialize the congestion control state of a new stream (optional)
+ * @cong_avoid: grow the window on a new cumulative ACK
+ * @ssthresh: return the new slow start threshold after a loss
+ * @rtt_sample: process a new RTT sample in usecs (optional)
+ *
+ * @cong_avoid and @ssthresh are called with batadv_tp_vars::cwnd_lock held.
+ */
+struct batadv_tp_cc_ops {
+	const char *name;
+	void (*init)(struct batadv_tp_vars *tp_vars);
+	void (*cong_avoid)(struct batadv_tp_vars *tp_vars, u32 acked, u32 mss);
+	u32 (*ssthresh)(struct batadv_tp_vars *tp_vars, u32 mss);
+	void (*rtt_sample)(struct batadv_tp_vars *tp_vars, u32 rtt);
+};
+
+/**
+ * struct batadv_tp_vars - tp meter private variables per stream
  * @list: list node for bat_priv::tp_list
  * @timer: timer for ack (receiver) and retry (sender)
  * @bat_priv: pointer to the mesh object
@@ -900,9 +1149,15 @@ enum batadv_tp_meter_role {
  * @test_length: test length in milliseconds
  * @session: TP session identifier
  * @icmp_uid: local ICMP "socket" index
+ * @group: session this stream belongs to, NULL for remotely started receivers
+ * @stream: index of this stream inside batadv_tp_group::results
  * @dec_cwnd: decimal part of the cwnd used during linear growth
  * @cwnd: current size of the congestion window
- * @cwnd_lock: lock do protect @cwnd & @dec_cwnd
+ * @cwnd_lock: lock do protect @cwnd & @dec_cwnd and the SACK state
+ * @cc_ops: congestion control of this stream
+ * @cc: congestion control specific state
+ * @cc.cubic: state of BATADV_TP_CC_CUBIC
+ * @cc.bbr: state of BATADV_TP_CC_BBR
  * @ss_threshold: Slow Start threshold. Once cwnd exceeds this value the
  *  connection switches to the Congestion Avoidance state
  * @last_acked: last acked byte
@@ -915,11 +1170,20 @@ enum batadv_tp_meter_role {
  * @srtt: smoothed RTT scaled by 2^3
  * @rttvar: RTT variation scaled by 2^2
  * @more_bytes: waiting queue anchor when waiting for more ack/retry timeout
- * @prerandom_offset: offset inside the prerandom buffer
- * @prerandom_lock: spinlock protecting access to prerandom_offset
+ * @sack: ranges above last_acked already received, in ascending order
+ * @num_sack: number of valid entries in @sack
+ * @reordering: number of duplicate ACKs triggering Fast Retransmit
+ * @dsack_wait: true if a D-SACK for @dsack_seqno would prove the last Fast
+ *  Retransmit spurious
+ * @dsack_seqno: seqno of the last Fast Retransmit
+ * @payload: page holding the random payload attached to each sent message
+ * @rate: constant bitrate (bytes/sec) of the stream, 0 if window limited
+ * @cbr_next: time the next packet is due in constant bitrate mode
+ * @lat: RTT statistics of the stream
+ * @lat_lock: spinlock protecting @lat
  * @last_recv: last in-order received packet
- * @unacked_list: list of unacked packets (meta-info only)
- * @unacked_lock: protect unacked_list
+ * @reorder: segments received after last_recv, one bit per segment
+ * @reorder_lock: protect last_recv and reorder
  * @last_recv_time: time time (jiffies) a msg was received
  * @refcount: number of context where the object is used
  * @rcu: struct used for freeing in an RCU-safe manner
@@ -937,11 +1201,18 @@ struct batadv_tp_vars {
 	u32 test_length;
 	u8 session[2];
 	u8 icmp_uid;
+	struct batadv_tp_group *group;
+	u8 stream;
 
 	/* sender variables */
 	u16 dec_cwnd;
 	u32 cwnd;
-	spinlock_t cwnd_lock; /* Protects cwnd & dec_cwnd */
+	spinlock_t cwnd_lock; /* Protects cwnd, dec_cwnd & sack */
+	const struct batadv_tp_cc_ops *cc_ops;
+	union {
+		struct batadv_tp_cubic cubic;
+		struct batadv_tp_bbr bbr;
+	} cc;
 	u32 ss_threshold;
 	atomic_t last_acked;
 	u32 last_sent;
@@ -953,13 +1224,21 @@ struct batadv_tp_vars {
 	u32 srtt;
 	u32 rttvar;
 	wait_queue_head_t more_bytes;
-	u32 prerandom_offset;
-	spinlock_t prerandom_lock; /* Protects prerandom_offset */
+	struct batadv_tp_sack sack[BATADV_TP_MAX_SACK];
+	u8 num_sack;
+	u8 reordering;
+	bool dsack_wait;
+	u32 dsack_seqno;
+	struct page *payload;
+	u32 rate;
+	ktime_t cbr_next;
+	struct batadv_tp_latency lat;
+	spinlock_t lat_lock; /* Protects lat */
 
 	/* receiver variables */
 	u32 last_recv;
-	struct list_head unacked_list;
-	spinlock_t unacked_lock; /* Protects unacked_list */
+	DECLARE_BITMAP(reorder, BATADV_TP_REORDER_WIN);
+	spinlock_t reorder_lock; /* Protects last_recv & reorder */
 	unsigned long last_recv_time;
 	struct kref refcount;
 	struct rcu_head rcu;
@@ -1001,24 +1280,152 @@ struct batadv_priv_bat_v {
 	struct delayed_work ogm_wq;
 };
 
+/**
+ * struct batadv_latency_hist - latency histogram of a single stage
+ * @count: number of samples
+ * @sum: sum of all samples in nsecs
+ * @buckets: sample counters, entry i counts latencies in [2^i, 2^(i + 1))
+ *  nsecs
+ */
+struct batadv_latency_hist {
+	u64 count;
+	u64 sum;
+	u64 buckets[BATADV_LATENCY_BUCKETS];
+};
+
+/**
+ * struct batadv_ping_dest - per destination results of a ping session
+ * @addr: originator address of the destination
+ * @sent: number of probes sent to the destination
+ * @received: number of replies received from the destination
+ * @rtt_sum: sum of all RTTs (nsecs)
+ * @rtt_min: smallest RTT (nsecs)
+ * @rtt_max: biggest RTT (nsecs)
+ */
+struct batadv_ping_dest {
+	u8 addr[ETH_ALEN];
+	u32 sent;
+	u32 received;
+	u64 rtt_sum;
+	u64 rtt_min;
+	u64 rtt_max;
+};
+
+/**
+ * struct batadv_ping_vars - kernel driven ping session
+ * @list: list node for batadv_priv::ping_list
+ * @bat_priv: pointer to the mesh object
+ * @cookie: cookie identifying the session
+ * @count: number of probes sent to each destination
+ * @interval: time (msecs) between two probe rounds
+ * @size: size of a single probe
+ * @round: number of probe rounds sent so far
+ * @cancelled: whether the session was cancelled
+ * @work: work item sending the probe rounds and finishing the session
+ * @lock: lock protecting the per destination results
+ * @refcount: number of contexts the object is used
+ * @rcu: struct used for freeing in an RCU-safe manner
+ * @num_dests: number of destinations
+ * @dests: per destination results
+ */
+struct batadv_ping_vars {
+	struct hlist_node list;
+	struct batadv_priv *bat_priv;
+	u32 cookie;
+	u32 count;
+	u32 interval;
+	u16 size;
+	u32 round;
+	bool cancelled;
+	struct delayed_work work;
+	spinlock_t lock; /* protects dests */
+	struct kref refcount;
+	struct rcu_head rcu;
+	u16 num_dests;
+	struct batadv_ping_dest dests[];
+};
+
+#ifdef CONFIG_BATMAN_ADV_BENCH
+
+/**
+ * enum batadv_bench_table - tables measured by the table benchmark
+ * @BATADV_BENCH_ORIG: originator table
+ * @BATADV_BENCH_TT_GLOBAL: global translation table
+ * @BATADV_BENCH_DAT: distributed ARP table cache
+ * @BATADV_BENCH_NUM: number of measured tables
+ */
+enum batadv_bench_table {
+	BATADV_BENCH_ORIG,
+	BATADV_BENCH_TT_GLOBAL,
+	BATADV_BENCH_DAT,
+	BATADV_BENCH_NUM,
+};
+
+/**
+ * struct batadv_bench_result - costs of a single table measured by a run
+ * @entries: number of synthetic entries which could be added
+ * @add_ns: mean time to add an entry
+ * @find_ns: mean time to look up an existing entry
+ * @miss_ns: mean time to look up an entry which does not exist
+ * @purge_ns: time of a purge pass divided by the number of entries
+ * @dump_ns: time to render the table as netlink dump divided by the number
+ *  of entries
+ * @entry_size: memory allocated for a single entry in bytes
+ */
+struct batadv_bench_result {
+	u32 entries;
+	u64 add_ns;
+	u64 find_ns;
+	u64 miss_ns;
+	u64 purge_ns;
+	u64 dump_ns;
+	size_t entry_size;
+};
+
+/**
+ * struct batadv_priv_bench - per mesh interface table benchmark data
+ * @lock: serializes the runs and protects the results
+ * @running: true while a run is in progress, protected by the RTNL lock
+ * @size: number of entries requested by the last run, 0 if none ran yet
+ * @results: results of the last run, one per batadv_bench_table
+ */
+struct batadv_priv_bench {
+	struct mutex lock; /* serializes runs, protects size & results */
+	bool running;
+	u32 size;
+	struct batadv_bench_result results[BATADV_BENCH_NUM];
+};
+
+#endif /* CONFIG_BATMAN_ADV_BENCH */
+
 /**
  * struct batadv_priv - per mesh interface data
  * @mesh_state: current status of the mesh (inactive/active/deactivating)
  * @soft_iface: net device which holds this struct as private data
  * @stats: structure holding the data for the ndo_get_stats() call
  * @bat_counters: mesh internal traffic statistic counters (see batadv_counters)
+ * @latency: per-CPU latency histograms, one per batadv_stats_stage
+ * @latency_stats: bool indicating whether latency statistics are collected
  * @aggregated_ogms: bool indicating whether OGM aggregation is enabled
  * @bonding: bool indicating whether traffic bonding is enabled
+ * @gw_distribute: bool indicating whether DHCP clients are distributed over
+ *  all gateways instead of all using the selected one
+ * @tp_reverse: bool indicating whether remote nodes may ask this node to send
+ *  tp meter streams back to them
  * @fragmentation: bool indicating whether traffic fragmentation is enabled
  * @packet_size_max: max packet size that can be transmitted via
  *  multiple fragmented skbs or a single frame if fragmentation is disabled
  * @frag_seqno: incremental counter to identify chains of egress fragments
  * @bridge_loop_avoidance: bool indicating whether bridge loop avoidance is
  *  enabled
+ * @bla_duplist_size: number of recently received LAN broadcasts remembered for
+ *  duplicate suppression
  * @distributed_arp_table: bool indicating whether distributed ARP table is
  *  enabled
  * @multicast_mode: Enable or disable multicast optimizations on this node's
  *  sender/originating side
+ * @multicast_fanout: maximum number of destinations a multicast packet is
+ *  sent to via a batman-adv multicast packet before falling back to flooding
  * @orig_interval: OGM broadcast interval in milliseconds
  * @hop_penalty: penalty which will be applied to an OGM's tq-field on every hop
  * @log_level: configured log level (see batadv_dbg_level)
@@ -1026,6 +1433,7 @@ struct batadv_priv_bat_v {
  * @isolation_mark_mask: bitmask identifying the bits in skb->mark to be used
  *  for the isolation mark
  * @bcast_seqno: last sent broadcast packet sequence number
+ * @event_seqno: last sequence number used for a netlink mesh event
  * @bcast_queue_left: number of remaining buffered broadcast packet slots
  * @batman_queue_left: number of remaining OGM packet slots
  * @num_ifaces: number of interfaces assigned to this mesh interface
@@ -1035,10 +1443,15 @@ struct batadv_priv_bat_v {
  * @forw_bcast_list: list of broadcast packets that will be rebroadcasted
  * @tp_list: list of tp sessions
  * @tp_num: number of currently active tp sessions
+ * @tp_reverse_list: list of pending requests to send tp meter streams back
+ * @tp_notify_list: list of tp meter session groups with a pending notification
+ * @ping_list: list of kernel driven ping sessions
  * @orig_hash: hash table containing mesh participants (orig nodes)
  * @forw_bat_list_lock: lock protecting forw_bat_list
  * @forw_bcast_list_lock: lock protecting forw_bcast_list
- * @tp_list_lock: spinlock protecting @tp_list
+ * @tp_list_lock: spinlock protecting @tp_list, @tp_reverse_list &
+ *  @tp_notify_list
+ * @ping_list_lock: spinlock protecting @ping_list
  * @orig_work: work queue callback item for orig node purging
  * @primary_if: one of the hard-interfaces assigned to this mesh interface
  *  becomes the primary interface
@@ -1056,25 +1469,32 @@ struct batadv_priv_bat_v {
  * @network_coding: bool indicating whether network coding is enabled
  * @nc: network coding data
  * @bat_v: B.A.T.M.A.N. V per soft-interface private data
+ * @bench: table benchmark data
  */
 struct batadv_priv {
 	atomic_t mesh_state;
 	struct net_device *soft_iface;
 	struct net_device_stats stats;
 	u64 __percpu *bat_counters; /* Per cpu counters */
+	struct batadv_latency_hist __percpu *latency;
+	atomic_t latency_stats;
 	atomic_t aggregated_ogms;
 	atomic_t bonding;
+	atomic_t gw_distribute;
+	atomic_t tp_reverse;
 	atomic_t fragmentation;
 	atomic_t packet_size_max;
 	atomic_t frag_seqno;
 #ifdef CONFIG_BATMAN_ADV_BLA
 	atomic_t bridge_loop_avoidance;
+	atomic_t bla_duplist_size;
 #endif
 #ifdef CONFIG_BATMAN_ADV_DAT
 	atomic_t distributed_arp_table;
 #endif
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	atomic_t multicast_mode;
+	atomic_t multicast_fanout;
 #endif
 	atomic_t orig_interval;
 	atomic_t hop_penalty;
@@ -1084,6 +1504,7 @@ struct batadv_priv {
 	u32 isolation_mark;
 	u32 isolation_mark_mask;
 	atomic_t bcast_seqno;
+	atomic_t event_seqno;
 	atomic_t bcast_queue_left;
 	atomic_t batman_queue_left;
 	char num_ifaces;
@@ -1095,8 +1516,12 @@ struct batadv_priv {
 	struct batadv_hashtable *orig_hash;
 	spinlock_t forw_bat_list_lock; /* protects forw_bat_list */
 	spinlock_t forw_bcast_list_lock; /* protects forw_bcast_list */
-	spinlock_t tp_list_lock; /* protects tp_list */
+	spinlock_t tp_list_lock; /* protects tp_list & reverse/notify lists */
 	atomic_t tp_num;
+	struct hlist_head tp_reverse_list;
+	struct hlist_head tp_notify_list;
+	struct hlist_head ping_list;
+	spinlock_t ping_list_lock; /* protects ping_list */
 	struct delayed_work orig_work;
 	struct batadv_hard_iface __rcu *primary_if;  /* rcu protected pointer */
 	struct batadv_algo_ops *algo_ops;
@@ -1124,38 +1549,32 @@ struct batadv_priv {
 #ifdef CONFIG_BATMAN_ADV_BATMAN_V
 	struct batadv_priv_bat_v bat_v;
 #endif
+#ifdef CONFIG_BATMAN_ADV_BENCH
+	struct batadv_priv_bench bench;
+#endif
 };
 
 /**
  * struct batadv_socket_client - layer2 icmp socket client data
- * @queue_list: packet queue for packets destined for this socket client
- * @queue_len: number of packets in the packet queue (queue_list)
+ * @ring: ring header followed by the packet slots, shared with userspace
+ * @head: number of packets written to the ring, kept apart from
+ *  batadv_icmp_ring::head because userspace may modify the mapped header
  * @index: socket client's index in the batadv_socket_client_hash
- * @lock: lock protecting queue_list, queue_len & index
+ * @lock: lock protecting the producer side of the ring & index
+ * @read_lock: lock serializing the readers of the ring
  * @queue_wait: socket client's wait queue
  * @bat_priv: pointer to soft_iface this client belongs to
  */
 struct batadv_socket_client {
-	struct list_head queue_list;
-	unsigned int queue_len;
+	struct batadv_icmp_ring *ring;
+	u32 head;
 	unsigned char index;
-	spinlock_t lock; /* protects queue_list, queue_len & index */
+	spinlock_t lock; /* protects head, the ring slots & index */
+	struct mutex read_lock; /* serializes ring readers */
 	wait_queue_head_t queue_wait;
 	struct batadv_priv *bat_priv;
 };
 
-/**
- * struct batadv_socket_packet - layer2 icmp packet for socket client
- * @list: list node for batadv_socket_client::queue_list
- * @icmp_len: size of the layer2 icmp packet
- * @icmp_packet: layer2 icmp packet
- */
-struct batadv_socket_packet {
-	struct list_head list;
-	size_t icmp_len;
-	u8 icmp_packet[BATADV_ICMP_MAX_PACKET_SIZE];
-};
-
 #ifdef CONFIG_BATMAN_ADV_BLA
 
 /**
@@ -1398,6 +1817,7 @@ struct batadv_skb_cb {
  * @packet_len: size of aggregated OGM packet inside the skb buffer
  * @direct_link_flags: direct link flags for aggregated OGM packets
  * @num_packets: counter for bcast packet retransmission
+ * @queue_time: time the packet was queued (see batadv_latency_start())
  * @delayed_work: work queue callback item for packet sending
  * @if_incoming: pointer to incoming hard-iface or primary iface if
  *  locally generated packet
@@ -1414,6 +1834,7 @@ struct batadv_forw_packet {
 	u16 packet_len;
 	u32 direct_link_flags;
 	u8 num_packets;
+	u64 queue_time;
 	struct delayed_work delayed_work;
 	struct batadv_hard_iface *if_incoming;
 	struct batadv_hard_iface *if_outgoing;
@@ -1501,6 +1922,8 @@ struct batadv_algo_orig_ops {
  *  (optional)
  * @is_eligible: check if a newly discovered GW is a potential candidate for
  *  the election as best GW (optional)
+ * @get_weight: compute the share of DHCP clients a GW should serve when
+ *  clients are distributed over all GWs, 0 if it should serve none (optional)
  * @print: print the gateway table (optional)
  * @dump: dump gateways to a netlink socket (optional)
  */
@@ -1514,6 +1937,8 @@ struct batadv_algo_gw_ops {
 	bool (*is_eligible)(struct batadv_priv *bat_priv,
 			    struct batadv_orig_node *curr_gw_orig,
 			    struct batadv_orig_node *orig_node);
+	u32 (*get_weight)(struct batadv_priv *bat_priv,
+			  struct batadv_gw_node *gw_node);
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 	void (*print)(struct batadv_priv *bat_priv, struct seq_file *seq);
 #endif
@@ -1598,6 +2023,7 @@ struct batadv_tvlv_container {
 /**
  * struct batadv_tvlv_handler - handler for specific tvlv type and version
  * @list: hlist node for batadv_priv_tvlv::handler_list
+ * @next: next handler of the same type in batadv_priv_tvlv::handler_table
  * @ogm_handler: handler callback which is given the tvlv payload to process on
  *  incoming OGM packets
  * @unicast_handler: handler callback which is given the tvlv payload to process
@@ -1610,6 +2036,7 @@ struct batadv_tvlv_container {
  */
 struct batadv_tvlv_handler {
 	struct hlist_node list;
+	struct batadv_tvlv_handler __rcu *next;
 	void (*ogm_handler)(struct batadv_priv *bat_priv,
 			    struct batadv_orig_node *orig,
 			    u8 flags, void *tvlv_value, u16 tvlv_value_len);
@@ -1630,10 +2057,14 @@ struct batadv_tvlv_handler {
  * @BATADV_TVLV_HANDLER_OGM_CALLED: interval tvlv handling flag - the API marks
  *  a handler as being called, so it won't be called if the
  *  BATADV_TVLV_HANDLER_OGM_CIFNOTFND flag was set
+ * @BATADV_TVLV_HANDLER_OGM_REPEAT: tvlv ogm processing function will call
+ *  this handler even if the tvlv containers of the originator did not change
+ *  since the previous ogm
  */
 enum batadv_tvlv_handler_flags {
 	BATADV_TVLV_HANDLER_OGM_CIFNOTFND = BIT(1),
 	BATADV_TVLV_HANDLER_OGM_CALLED = BIT(2),
+	BATADV_TVLV_HANDLER_OGM_REPEAT = BIT(3),
 };
 
 /**
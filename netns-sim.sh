@@ -0,0 +1,357 @@
+#! /bin/sh
+
+set -e
+
+NODES=10
+TOPOLOGY="line"
+DEGREE=3
+SEED=1
+ALGO="BATMAN_V"
+THROUGHPUT=""
+NETEM=""
+ORIG_INTERVAL=""
+ELP_INTERVAL=""
+TIMEOUT=120
+WINDOW=30
+MODULE=""
+PREFIX="bsim"
+OUTPUT=""
+KEEP=0
+
+usage() {
+	cat << EOF
+Usage: ${0} [options]
+
+Build a batman-adv mesh out of network namespaces joined by veth pairs
+and measure convergence time, control overhead and CPU cost per node.
+
+  -n NODES       number of nodes (default: ${NODES})
+  -t TOPOLOGY    line, ring, grid, random or a file with one edge per line:
+                 "A B [THROUGHPUT [NETEM ARGS...]]", nodes counted from 0
+                 (default: ${TOPOLOGY})
+  -d DEGREE      average node degree of the random topology (default: ${DEGREE})
+  -s SEED        seed of the random topology (default: ${SEED})
+  -a ALGO        routing algorithm, BATMAN_IV or BATMAN_V (default: ${ALGO})
+  -p THROUGHPUT  default throughput_override of each link, e.g. 10mbit
+  -e NETEM       default netem arguments of each link, e.g. "delay 5ms"
+  -i INTERVAL    originator interval in ms
+  -l INTERVAL    ELP interval in ms (BATMAN_V only)
+  -T SECONDS     convergence timeout (default: ${TIMEOUT})
+  -w SECONDS     overhead measurement window (default: ${WINDOW})
+  -m MODULE      batman-adv.ko to insert instead of running modprobe
+  -P PREFIX      network namespace name prefix (default: ${PREFIX})
+  -o FILE        write per node results as CSV to FILE
+  -k             keep the namespaces after the run
+  -h             show this help
+EOF
+}
+
+while getopts "n:t:d:s:a:p:e:i:l:T:w:m:P:o:kh" OPT; do
+	case "${OPT}" in
+	n) NODES="${OPTARG}" ;;
+	t) TOPOLOGY="${OPTARG}" ;;
+	d) DEGREE="${OPTARG}" ;;
+	s) SEED="${OPTARG}" ;;
+	a) ALGO="${OPTARG}" ;;
+	p) THROUGHPUT="${OPTARG}" ;;
+	e) NETEM="${OPTARG}" ;;
+	i) ORIG_INTERVAL="${OPTARG}" ;;
+	l) ELP_INTERVAL="${OPTARG}" ;;
+	T) TIMEOUT="${OPTARG}" ;;
+	w) WINDOW="${OPTARG}" ;;
+	m) MODULE="${OPTARG}" ;;
+	P) PREFIX="${OPTARG}" ;;
+	o) OUTPUT="${OPTARG}" ;;
+	k) KEEP=1 ;;
+	h) usage; exit 0 ;;
+	*) usage >&2; exit 1 ;;
+	esac
+done
+
+if [ "$(id -u)" != "0" ]; then
+	echo "${0}: must be run as root" >&2
+	exit 1
+fi
+
+for TOOL in ip tc batctl ethtool awk; do
+	if ! command -v "${TOOL}" > /dev/null 2>&1; then
+		echo "${0}: ${TOOL} not found" >&2
+		exit 1
+	fi
+done
+
+PARAM="/sys/module/batman_adv/parameters/routing_algo"
+WORKDIR="$(mktemp -d)"
+EDGES="${WORKDIR}/edges"
+OLD_ALGO=""
+
+nsx() {
+	NODE="${1}"
+	shift
+	ip netns exec "${PREFIX}${NODE}" "$@"
+}
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+cleanup() {
+	if [ "${KEEP}" = "0" ]; then
+		for NS in $(ip netns list | awk '{ print $1 }'); do
+			case "${NS}" in
+			"${PREFIX}"[0-9]*) ip netns del "${NS}" ;;
+			esac
+		done
+	fi
+
+	if [ -n "${OLD_ALGO}" ]; then
+		echo "${OLD_ALGO}" > "${PARAM}" 2> /dev/null || true
+	fi
+
+	rm -rf "${WORKDIR}"
+}
+
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+# build the edge list: "A B THROUGHPUT NETEM..." with "-" for no value
+gen_edges() {
+	awk -v n="${NODES}" -v topo="${TOPOLOGY}" -v deg="${DEGREE}" \
+	    -v seed="${SEED}" '
+	function edge(a, b) {
+		if (a == b)
+			return
+		if (a > b) {
+			t = a; a = b; b = t
+		}
+		if ((a, b) in seen)
+			return
+		seen[a, b] = 1
+		count++
+		print a, b
+	}
+	BEGIN {
+		srand(seed)
+		if (topo == "line" || topo == "ring") {
+			for (i = 0; i < n - 1; i++)
+				edge(i, i + 1)
+			if (topo == "ring" && n > 2)
+				edge(n - 1, 0)
+		} else if (topo == "grid") {
+			w = int(sqrt(n))
+			if (w * w < n)
+				w++
+			for (i = 0; i < n; i++) {
+				if ((i + 1) % w != 0 && i + 1 < n)
+					edge(i, i + 1)
+				if (i + w < n)
+					edge(i, i + w)
+			}
+		} else if (topo == "random") {
+			# spanning tree first to keep the mesh connected
+			for (i = 1; i < n; i++)
+				edge(i, int(rand() * i))
+			want = int(n * deg / 2)
+			max = n * (n - 1) / 2
+			if (want > max)
+				want = max
+			while (count < want)
+				edge(int(rand() * n), int(rand() * n))
+		} else {
+			exit 1
+		}
+	}'
+}
+
+case "${TOPOLOGY}" in
+line|ring|grid|random)
+	gen_edges > "${EDGES}" || {
+		echo "${0}: cannot generate ${TOPOLOGY} topology" >&2
+		exit 1
+	}
+	;;
+*)
+	if [ ! -r "${TOPOLOGY}" ]; then
+		echo "${0}: unknown topology ${TOPOLOGY}" >&2
+		exit 1
+	fi
+	awk '!/^[ \t]*(#|$)/' "${TOPOLOGY}" > "${EDGES}"
+	FILE_NODES="$(awk '{ if ($1 > m) m = $1; if ($2 > m) m = $2 }
+			   END { print m + 1 }' "${EDGES}")"
+	if [ "${FILE_NODES}" -gt "${NODES}" ]; then
+		NODES="${FILE_NODES}"
+	fi
+	;;
+esac
+
+echo "nodes: ${NODES}, links: $(wc -l < "${EDGES}"), algorithm: ${ALGO}"
+
+# load the module and select the routing algorithm for new meshes
+if [ ! -d /sys/module/batman_adv ]; then
+	if [ -n "${MODULE}" ]; then
+		insmod "${MODULE}"
+	else
+		modprobe batman-adv
+	fi
+fi
+
+OLD_ALGO="$(cat "${PARAM}")"
+echo "${ALGO}" > "${PARAM}"
+
+I=0
+while [ "${I}" -lt "${NODES}" ]; do
+	ip netns add "${PREFIX}${I}"
+	nsx "${I}" ip link set lo up
+	nsx "${I}" ip link add bat0 type batadv
+	if [ -n "${ORIG_INTERVAL}" ]; then
+		nsx "${I}" sh -c "echo ${ORIG_INTERVAL} > \
+			/sys/class/net/bat0/mesh/orig_interval"
+	fi
+	I=$((I + 1))
+done
+
+# veth "v<B>" inside node A faces node B and vice versa
+while read -r A B LINK_TP LINK_NETEM; do
+	LINK_TP="${LINK_TP:-${THROUGHPUT}}"
+	LINK_NETEM="${LINK_NETEM:-${NETEM}}"
+
+	ip link add "v${B}" netns "${PREFIX}${A}" type veth \
+		peer name "v${A}" netns "${PREFIX}${B}"
+
+	for END in "${A} ${B}" "${B} ${A}"; do
+		set -- ${END}
+		nsx "${1}" ip link set "v${2}" mtu 1532
+		nsx "${1}" ip link set "v${2}" master bat0
+		nsx "${1}" ip link set "v${2}" up
+
+		SYSFS="/sys/class/net/v${2}/batman_adv"
+		if [ -n "${LINK_TP}" ] && [ "${LINK_TP}" != "-" ]; then
+			nsx "${1}" sh -c "echo ${LINK_TP} > \
+				${SYSFS}/throughput_override"
+		fi
+		if [ -n "${ELP_INTERVAL}" ]; then
+			nsx "${1}" sh -c "echo ${ELP_INTERVAL} > \
+				${SYSFS}/elp_interval"
+		fi
+		if [ -n "${LINK_NETEM}" ] && [ "${LINK_NETEM}" != "-" ]; then
+			nsx "${1}" tc qdisc add dev "v${2}" root netem \
+				${LINK_NETEM}
+		fi
+	done
+done < "${EDGES}"
+
+# convergence: every node has a best route towards every other node
+START="$(now_ms)"
+I=0
+while [ "${I}" -lt "${NODES}" ]; do
+	nsx "${I}" ip link set bat0 up
+	echo "-" > "${WORKDIR}/conv.${I}"
+	I=$((I + 1))
+done
+
+PENDING="${NODES}"
+while [ "${PENDING}" -gt 0 ]; do
+	ELAPSED=$(($(now_ms) - START))
+	if [ "${ELAPSED}" -gt $((TIMEOUT * 1000)) ]; then
+		echo "${PENDING} nodes not converged after ${TIMEOUT}s" >&2
+		break
+	fi
+
+	PENDING=0
+	I=0
+	while [ "${I}" -lt "${NODES}" ]; do
+		if [ "$(cat "${WORKDIR}/conv.${I}")" = "-" ]; then
+			ORIGS="$(nsx "${I}" batctl o -H 2> /dev/null | \
+				 awk '/^ *\*/ { n++ } END { print n + 0 }')"
+			if [ "${ORIGS}" -ge $((NODES - 1)) ]; then
+				echo $(($(now_ms) - START)) > \
+					"${WORKDIR}/conv.${I}"
+			else
+				PENDING=$((PENDING + 1))
+			fi
+		fi
+		I=$((I + 1))
+	done
+	sleep 0.2
+done
+
+# overhead: soft interface and link counters over a quiet window
+counters() {
+	nsx "${1}" ethtool -S bat0 | awk -F: '
+		{ gsub(/ /, "", $1); gsub(/ /, "", $2); c[$1] = $2 }
+		END {
+			print c["mgmt_tx"] + 0, c["mgmt_tx_bytes"] + 0,
+			      c["mgmt_rx_bytes"] + 0, c["ogm2_sign"] + 0,
+			      c["ogm2_verify"] + 0
+		}'
+	nsx "${1}" sh -c 'cat /sys/class/net/v*/statistics/tx_bytes' | \
+		awk '{ n += $1 } END { print n + 0 }'
+}
+
+cpu_busy() {
+	awk '$1 == "cpu" { print $2 + $3 + $4 + $7 + $8 }' /proc/stat
+}
+
+I=0
+while [ "${I}" -lt "${NODES}" ]; do
+	counters "${I}" | tr '\n' ' ' > "${WORKDIR}/start.${I}"
+	I=$((I + 1))
+done
+CPU_START="$(cpu_busy)"
+
+sleep "${WINDOW}"
+
+CPU_END="$(cpu_busy)"
+I=0
+while [ "${I}" -lt "${NODES}" ]; do
+	counters "${I}" | tr '\n' ' ' > "${WORKDIR}/end.${I}"
+	I=$((I + 1))
+done
+
+# kernel work of all meshes is shared by the same CPUs, so the per node
+# CPU cost is the busy time of the box divided by the number of nodes
+HZ="$(getconf CLK_TCK)"
+CPU_MS=$(((CPU_END - CPU_START) * 1000 / HZ))
+
+I=0
+while [ "${I}" -lt "${NODES}" ]; do
+	echo "${I} $(cat "${WORKDIR}/conv.${I}") \
+	      $(cat "${WORKDIR}/start.${I}") $(cat "${WORKDIR}/end.${I}")"
+	I=$((I + 1))
+done | awk -v w="${WINDOW}" -v cpu="${CPU_MS}" -v out="${OUTPUT}" '
+	{
+		node = $1; conv = $2
+		ogm = $9 - $3; tx = $10 - $4; rx = $11 - $5
+		sign = $12 - $6; verify = $13 - $7; link = $14 - $8
+		if (out != "") {
+			if (NR == 1)
+				print "node,converge_ms,ogm_tx,ogm_tx_bytes," \
+				      "ogm_rx_bytes,ogm2_sign,ogm2_verify," \
+				      "link_tx_bytes" > out
+			print node "," conv "," ogm "," tx "," rx "," \
+			      sign "," verify "," link > out
+		}
+		if (conv == "-") {
+			lost++
+		} else if (conv > conv_max) {
+			conv_max = conv
+		}
+		conv_sum += conv
+		ogm_sum += tx; link_sum += link
+		sign_sum += sign; verify_sum += verify
+		n++
+	}
+	END {
+		if (n == 0)
+			exit
+		printf "converged: %d/%d nodes, max %d ms, mean %d ms\n",
+		       n - lost, n, conv_max,
+		       n > lost ? conv_sum / (n - lost) : 0
+		printf "ogm overhead: %.1f bytes/s per node\n",
+		       ogm_sum / n / w
+		printf "link overhead (ogm, elp, tt): %.1f bytes/s per node\n",
+		       link_sum / n / w
+		printf "ogm2 sign/verify: %.1f/%.1f per second per node\n",
+		       sign_sum / n / w, verify_sum / n / w
+		printf "cpu: %.2f ms/s per node\n", cpu / n / w
+	}'